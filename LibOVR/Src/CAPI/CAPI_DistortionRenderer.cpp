@@ -102,7 +102,10 @@ double DistortionRenderer::WaitTillTime(double absTime)
 {
     double initialTime = ovr_GetTimeInSeconds();
     if (initialTime >= absTime)
+    {
+        TimeManager.TraceTimewarpWait(absTime, initialTime, initialTime);
         return 0.0;
+    }
 
     double newTime = initialTime;
 
@@ -149,6 +152,8 @@ double DistortionRenderer::WaitTillTime(double absTime)
         newTime = ovr_GetTimeInSeconds();
     }
 
+    TimeManager.TraceTimewarpWait(absTime, initialTime, newTime);
+
     // How long we waited
     return newTime - initialTime;
 }
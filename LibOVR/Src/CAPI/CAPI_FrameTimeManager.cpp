@@ -25,6 +25,7 @@ limitations under the License.
 ************************************************************************************/
 
 #include "CAPI_FrameTimeManager.h"
+#include "CAPI_HMDState.h"
 
 #include "../Kernel/OVR_Log.h"
 
@@ -36,6 +37,7 @@ namespace OVR { namespace CAPI {
     
 
 FrameLatencyTracker::FrameLatencyTracker()
+  : pTraceRecorder(NULL)
 {
    Reset();
 }
@@ -164,6 +166,17 @@ void FrameLatencyTracker::MatchRecord(const Util::FrameTimeRecordSet &r)
                     if (!renderFrame.MatchedRecord)
                     {
                         double deltaSeconds = scanoutFrame.TimeSeconds - renderFrame.TimeSeconds;
+                        if (pTraceRecorder)
+                        {
+                            FrameTimeTraceRecord record(FrameTimeTrace_LatencyMatch, renderFrame.ReadbackIndex);
+                            record.Values[0] = scanoutFrame.TimeSeconds;
+                            record.Values[1] = renderFrame.TimeSeconds;
+                            record.Values[2] = renderFrame.RenderIMUTimeSeconds;
+                            record.Values[3] = renderFrame.TimewarpIMUTimeSeconds;
+                            record.Values[4] = deltaSeconds;
+                            record.Values[5] = (deltaSeconds > 0.0) ? 1.0 : 0.0;
+                            pTraceRecorder->Record(record);
+                        }
                         if (deltaSeconds > 0.0)
                         {
                             FrameDeltas.AddTimeDelta(deltaSeconds);
@@ -230,7 +243,7 @@ void FrameLatencyTracker::GetLatencyTimings(float& latencyRender, float& latency
 FrameTimeManager::FrameTimeManager(bool vsyncEnabled) :
     RenderInfo(),
     FrameTimeDeltas(),
-    DistortionRenderTimes(),
+    TimewarpScheduler(),
     ScreenLatencyTracker(),
     VsyncEnabled(vsyncEnabled),
     DynamicPrediction(true),
@@ -242,7 +255,8 @@ FrameTimeManager::FrameTimeManager(bool vsyncEnabled) :
     FrameTiming(),
     LocklessTiming(),
     RenderIMUTimeSeconds(0.0),
-    TimewarpIMUTimeSeconds(0.0)
+    TimewarpIMUTimeSeconds(0.0),
+    pTraceRecorder(NULL)
 {
     // If driver is in use,
     DirectToRift = !Display::InCompatibilityMode(false);
@@ -261,6 +275,11 @@ FrameTimeManager::FrameTimeManager(bool vsyncEnabled) :
         VSyncToScanoutDelay = 0.013f;
     }
     NoVSyncToScanoutDelay = 0.004f;
+
+    // Distortion time measurements include the GPU flush, so the margin only has to cover
+    // leaving the spin wait and submitting the distortion work.
+    TimewarpScheduler.SetSafetyMargin(0.002f);
+    TimewarpScheduler.SetTargetMissProbability(OVR_DEFAULT_TIMEWARP_MISS_PROBABILITY);
 }
 
 void FrameTimeManager::Init(HmdRenderInfo& renderInfo)
@@ -281,7 +300,7 @@ void FrameTimeManager::ResetFrameTiming(unsigned frameIndex,
     SdkRender           = sdkRender;
 
     FrameTimeDeltas.Clear();
-    DistortionRenderTimes.Clear();
+    TimewarpScheduler.Reset();
     ScreenLatencyTracker.Reset();
     //Revisit dynamic pre-Timewarp delay adjustment logic
     //TimewarpAdjuster.Reset();
@@ -358,9 +377,9 @@ double FrameTimeManager::calcTimewarpWaitDelta() const
 
     if (SdkRender)
     {
-        if (NeedDistortionTimeMeasurement())
+        if (!TimewarpScheduler.IsReady())
             return 0.0;
-        return -(DistortionRenderTimes.GetMedianTimeDelta() + 0.0035);
+        return -TimewarpScheduler.GetLeadTime();
 
         //Revisit dynamic pre-Timewarp delay adjustment logic
         /*return -(DistortionRenderTimes.GetMedianTimeDelta() + 0.002 +
@@ -481,6 +500,18 @@ double FrameTimeManager::BeginFrame(unsigned frameIndex)
     FrameTiming.InitTimingFromInputs(FrameTiming.Inputs, RenderInfo.Shutter.Type,
                                      thisFrameTime, frameIndex);
 
+    if (pTraceRecorder)
+    {
+        FrameTimeTraceRecord record(FrameTimeTrace_BeginFrame, frameIndex);
+        record.Values[0] = FrameTiming.ThisFrameTime;
+        record.Values[1] = FrameTiming.TimewarpPointTime;
+        record.Values[2] = FrameTiming.MidpointTime;
+        record.Values[3] = FrameTiming.EyeRenderTimes[0];
+        record.Values[4] = FrameTiming.EyeRenderTimes[1];
+        record.Values[5] = FrameTiming.Inputs.FrameDelta;
+        pTraceRecorder->Record(record);
+    }
+
     return FrameTiming.ThisFrameTime;
 }
 
@@ -505,10 +536,38 @@ void FrameTimeManager::EndFrame()
         FrameTiming.Inputs.FrameDelta = calcFrameDelta();
     }
 
+    // Picks up changes to the miss probability as well as new measurements.
+    FrameTiming.Inputs.TimewarpWaitDelta = calcTimewarpWaitDelta();
+
+    if (pTraceRecorder)
+    {
+        FrameTimeTraceRecord record(FrameTimeTrace_EndFrame, FrameTiming.FrameIndex);
+        record.Values[0] = FrameTiming.NextFrameTime;
+        record.Values[1] = (FrameTiming.ThisFrameTime > 0.0) ?
+                           (FrameTiming.NextFrameTime - FrameTiming.ThisFrameTime) : 0.0;
+        record.Values[2] = FrameTiming.Inputs.FrameDelta;
+        record.Values[3] = FrameTiming.Inputs.ScreenDelay;
+        record.Values[4] = FrameTiming.Inputs.TimewarpWaitDelta;
+        pTraceRecorder->Record(record);
+    }
+
     // Write to Lock-less
     LocklessTiming.SetState(FrameTiming);
 }
 
+
+void FrameTimeManager::TraceTimewarpWait(double targetTime, double waitStartTime, double waitEndTime)
+{
+    if (pTraceRecorder)
+    {
+        FrameTimeTraceRecord record(FrameTimeTrace_TimewarpWait, FrameTiming.FrameIndex);
+        record.Values[0] = targetTime;
+        record.Values[1] = waitStartTime;
+        record.Values[2] = waitEndTime;
+        pTraceRecorder->Record(record);
+    }
+}
+
 // Thread-safe function to query timing for a future frame
 
 FrameTimeManager::Timing FrameTimeManager::GetFrameTiming(unsigned frameIndex)
@@ -622,10 +681,11 @@ void FrameTimeManager::GetTimewarpMatrices(ovrHmd hmd, ovrEyeType eyeId,
 	timewarpStartEnd[0] += debugTimingOffsetInSeconds;
 	timewarpStartEnd[1] += debugTimingOffsetInSeconds;
 
-      
-    //HMDState* p = (HMDState*)hmd;
-    ovrTrackingState startState = ovrHmd_GetTrackingState(hmd, timewarpStartEnd[0]);
-    ovrTrackingState endState   = ovrHmd_GetTrackingState(hmd, timewarpStartEnd[1]);
+
+    // Both poses from the same sensor state, so start and end can't straddle a new sample
+    HMDState* p = (HMDState*)hmd->Handle;
+    Posef startEndPoses[2];
+    p->PredictedPoses(timewarpStartEnd, startEndPoses, 2);
 
     if (TimewarpIMUTimeSeconds == 0.0)
     {
@@ -634,8 +694,8 @@ void FrameTimeManager::GetTimewarpMatrices(ovrHmd hmd, ovrEyeType eyeId,
         TimewarpIMUTimeSeconds = ovr_GetTimeInSeconds();
     }
 
-    Quatf quatFromStart = startState.HeadPose.ThePose.Orientation;
-    Quatf quatFromEnd   = endState.HeadPose.ThePose.Orientation;
+    Quatf quatFromStart = startEndPoses[0].Rotation;
+    Quatf quatFromEnd   = startEndPoses[1].Rotation;
     Quatf quatFromEye   = renderPose.Orientation; //EyeRenderPoses[eyeId].Orientation;
     quatFromEye.Invert();   // because we need the view matrix, not the camera matrix
     
@@ -685,13 +745,21 @@ bool  FrameTimeManager::NeedDistortionTimeMeasurement() const
 {
     if (!VsyncEnabled)
         return false;
-    return DistortionRenderTimes.GetCount() < DistortionRenderTimes.Capacity;
+    return TimewarpScheduler.NeedMeasurement();
 }
 
 
 void  FrameTimeManager::AddDistortionTimeMeasurement(double distortionTimeSeconds)
 {
-    DistortionRenderTimes.AddTimeDelta(distortionTimeSeconds);
+    TimewarpScheduler.AddMeasurement((float)distortionTimeSeconds);
+
+    if (pTraceRecorder)
+    {
+        FrameTimeTraceRecord record(FrameTimeTrace_DistortionTime, FrameTiming.FrameIndex);
+        record.Values[0] = distortionTimeSeconds;
+        record.Values[1] = TimewarpScheduler.GetLeadTime();
+        pTraceRecorder->Record(record);
+    }
 
     //Revisit dynamic pre-Timewarp delay adjustment logic
     //updateTimewarpTiming();
@@ -31,6 +31,7 @@ limitations under the License.
 #include "../Kernel/OVR_Timer.h"
 #include "../Kernel/OVR_Math.h"
 #include "../Util/Util_Render_Stereo.h"
+#include "CAPI_FrameTimeTrace.h"
 
 namespace OVR { namespace CAPI {
 
@@ -94,6 +95,9 @@ public:
 
     void Reset();
 
+    // Latency matches are reported to the recorder, if set.
+    void SetTraceRecorder(FrameTimeTraceRecorder* recorder) { pTraceRecorder = recorder; }
+
 public:
 
     struct FrameTimeRecordEx : public Util::FrameTimeRecord
@@ -122,6 +126,8 @@ public:
     double                RenderLatencySeconds;
     double                TimewarpLatencySeconds;
     double                LatencyRecordTime;
+
+    FrameTimeTraceRecorder* pTraceRecorder;
 };
 
 
@@ -208,6 +214,11 @@ public:
     bool    NeedDistortionTimeMeasurement() const;
     void    AddDistortionTimeMeasurement(double distortionTimeSeconds);
 
+    // Fraction of frames for which the timewarp wait may be too long for distortion to finish
+    // before vsync. Lower values wait less and so add latency. Takes effect on the next EndFrame.
+    void    SetTimewarpMissProbability(float probability) { TimewarpScheduler.SetTargetMissProbability(probability); }
+    float   GetTimewarpMissProbability() const            { return TimewarpScheduler.GetTargetMissProbability(); }
+
     
     // DK2 Latency test interface
     
@@ -231,6 +242,17 @@ public:
 
     const Timing& GetFrameTiming() const { return FrameTiming; }
 
+    // Frame timing events are recorded to the given recorder, which must remain valid
+    // while frames are being timed. The recorder only writes while it is started.
+    void    SetTraceRecorder(FrameTimeTraceRecorder* recorder)
+    {
+        pTraceRecorder = recorder;
+        ScreenLatencyTracker.SetTraceRecorder(recorder);
+    }
+
+    // Called by the renderer after waiting for the timewarp point of the current frame.
+    void    TraceTimewarpWait(double targetTime, double waitStartTime, double waitEndTime);
+
 private:
     double  calcFrameDelta() const;
     double  calcScreenDelay() const;
@@ -290,7 +312,8 @@ private:
     HmdRenderInfo       RenderInfo;
     // Timings are collected through a median filter, to avoid outliers.
     TimeDeltaCollector  FrameTimeDeltas;
-    TimeDeltaCollector  DistortionRenderTimes;
+    // Distribution of SDK distortion render times, which sets the timewarp wait.
+    Util::Render::TimewarpWaitScheduler TimewarpScheduler;
     FrameLatencyTracker ScreenLatencyTracker;
 
     // Timing changes if we have no Vsync (all prediction is reduced to fixed interval).
@@ -319,6 +342,8 @@ private:
     // IMU Read timings
     double              RenderIMUTimeSeconds;
     double              TimewarpIMUTimeSeconds;
+
+    FrameTimeTraceRecorder* pTraceRecorder;
 };
 
 
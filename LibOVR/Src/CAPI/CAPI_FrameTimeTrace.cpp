@@ -0,0 +1,373 @@
+/************************************************************************************
+
+Filename    :   CAPI_FrameTimeTrace.cpp
+Content     :   Low-overhead binary trace of frame timing events
+Created     :   October 17, 2014
+
+Copyright   :   Copyright 2014 Oculus VR, LLC All Rights reserved.
+
+Licensed under the Oculus VR Rift SDK License Version 3.2 (the "License");
+you may not use the Oculus VR Rift SDK except in compliance with the License,
+which is provided at the time of installation or download, or which
+otherwise accompanies this software in either electronic or hard copy form.
+
+You may obtain a copy of the License at
+
+http://www.oculusvr.com/licenses/LICENSE-3.2
+
+Unless required by applicable law or agreed to in writing, the Oculus VR SDK
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+************************************************************************************/
+
+#include "CAPI_FrameTimeTrace.h"
+
+#include "../OVR_CAPI.h"
+#include "../OVR_Profile.h"
+#include "../Kernel/OVR_Log.h"
+#include "../Kernel/OVR_Alg.h"
+#include "../Kernel/OVR_Std.h"
+
+namespace OVR { namespace CAPI {
+
+
+//-------------------------------------------------------------------------------------
+// ***** FrameTimeTraceWriter
+
+// How often the writer thread drains the ring.
+static const unsigned FrameTimeTraceDrainIntervalMs = 10;
+
+class FrameTimeTraceWriter : public Thread
+{
+public:
+    FrameTimeTraceWriter(FrameTimeTraceRecorder* recorder) : pRecorder(recorder) { }
+
+    virtual int Run()
+    {
+        SetThreadName("FrameTimeTrace");
+
+        while (!GetExitFlag())
+        {
+            pRecorder->drain();
+            Thread::MSleep(FrameTimeTraceDrainIntervalMs);
+        }
+
+        // Catch everything recorded before Stop.
+        pRecorder->drain();
+        return 0;
+    }
+
+private:
+    FrameTimeTraceRecorder* pRecorder;
+};
+
+
+//-------------------------------------------------------------------------------------
+// ***** FrameTimeTraceRecorder
+
+FrameTimeTraceRecorder::FrameTimeTraceRecorder()
+  : pRing(NULL)
+  , Head(0)
+  , Tail(0)
+  , Dropped(0)
+  , Active(0)
+{
+}
+
+FrameTimeTraceRecorder::~FrameTimeTraceRecorder()
+{
+    Stop();
+
+    if (pRing)
+    {
+        OVR_FREE(pRing);
+    }
+}
+
+bool FrameTimeTraceRecorder::Start(const String& fileName)
+{
+    Mutex::Locker locker(&ControlLock);
+
+    if (pWriter)
+    {
+        Active.Store_Release(0);
+        pWriter->SetExitFlag(true);
+        pWriter->Join();
+        pWriter.Clear();
+        TraceFile.Close();
+    }
+
+    if (!pRing)
+    {
+        pRing = (FrameTimeTraceRecord*)OVR_ALLOC(sizeof(FrameTimeTraceRecord) * RingSize);
+        if (!pRing)
+            return false;
+    }
+
+    String path = GetBaseOVRPath(true);
+    path.AppendString("/");
+    path.AppendString(fileName);
+
+    if (!TraceFile.Open(path, File::Open_Write | File::Open_Create | File::Open_Truncate, File::Mode_Write))
+    {
+        LogError("{ERR-101} [FrameTimeTrace] Unable to create %s", path.ToCStr());
+        return false;
+    }
+
+    FrameTimeTraceFileHeader header;
+    header.Magic      = FrameTimeTraceMagic;
+    header.Version    = FrameTimeTraceVersion;
+    header.RecordSize = sizeof(FrameTimeTraceRecord);
+    header.Reserved   = 0;
+    TraceFile.Write((const uint8_t*)&header, sizeof(header));
+
+    // Anything left in the ring belongs to a previous trace. A record pushed concurrently
+    // with Start may still land in the new trace; that is harmless.
+    Tail.Store_Release(Head.Load_Acquire());
+    Dropped.Store_Release(0);
+
+    pWriter = *new FrameTimeTraceWriter(this);
+    if (!pWriter->Start())
+    {
+        pWriter.Clear();
+        TraceFile.Close();
+        return false;
+    }
+
+    Active.Store_Release(1);
+    return true;
+}
+
+bool FrameTimeTraceRecorder::Stop()
+{
+    Mutex::Locker locker(&ControlLock);
+
+    if (!pWriter)
+        return false;
+
+    Active.Store_Release(0);
+    pWriter->SetExitFlag(true);
+    pWriter->Join();
+    pWriter.Clear();
+
+    TraceFile.Flush();
+    TraceFile.Close();
+    return true;
+}
+
+void FrameTimeTraceRecorder::push(FrameTimeTraceRecord& record)
+{
+    record.Time = ovr_GetTimeInSeconds();
+
+    // Only this thread writes Head, and the ring is never freed while the recorder exists,
+    // so a push racing with Stop is safe; the record is simply not written.
+    uint32_t head = Head.Load_Acquire();
+    if (head - Tail.Load_Acquire() >= (uint32_t)RingSize)
+    {
+        Dropped.ExchangeAdd_NoSync(1);
+        return;
+    }
+
+    pRing[head & (RingSize - 1)] = record;
+    Head.Store_Release(head + 1);
+}
+
+void FrameTimeTraceRecorder::drain()
+{
+    uint32_t tail = Tail.Load_Acquire();
+    uint32_t head = Head.Load_Acquire();
+
+    // Write the queued records in at most two contiguous pieces.
+    while (tail != head)
+    {
+        uint32_t index = tail & (RingSize - 1);
+        uint32_t count = Alg::Min(head - tail, (uint32_t)RingSize - index);
+
+        TraceFile.Write((const uint8_t*)(pRing + index), (int)(count * sizeof(FrameTimeTraceRecord)));
+        tail += count;
+    }
+    Tail.Store_Release(tail);
+
+    uint32_t dropped = Dropped.Exchange_Sync(0);
+    if (dropped != 0)
+    {
+        FrameTimeTraceRecord record(FrameTimeTrace_Dropped, 0);
+        record.Time      = ovr_GetTimeInSeconds();
+        record.Values[0] = (double)dropped;
+        TraceFile.Write((const uint8_t*)&record, sizeof(record));
+    }
+}
+
+
+//-------------------------------------------------------------------------------------
+// ***** Reading traces
+
+static bool openFrameTimeTrace(SysFile& file, const char* tracePath)
+{
+    if (!file.Open(tracePath, File::Open_Read, File::Mode_Read))
+        return false;
+
+    FrameTimeTraceFileHeader header;
+    return file.Read((uint8_t*)&header, sizeof(header)) == (int)sizeof(header) &&
+           header.Magic == FrameTimeTraceMagic &&
+           header.Version == FrameTimeTraceVersion &&
+           header.RecordSize == sizeof(FrameTimeTraceRecord);
+}
+
+bool LoadFrameTimeTrace(const char* tracePath, Array<FrameTimeTraceRecord>& records)
+{
+    SysFile in;
+    if (!openFrameTimeTrace(in, tracePath))
+        return false;
+
+    int length = in.GetLength() - (int)sizeof(FrameTimeTraceFileHeader);
+    int count  = Alg::Max(length, 0) / (int)sizeof(FrameTimeTraceRecord);
+
+    // A trace cut short by a crash may end in a partial record; it is ignored.
+    records.Resize(count);
+    if (count > 0)
+    {
+        int bytes = count * (int)sizeof(FrameTimeTraceRecord);
+        if (in.Read((uint8_t*)&records[0], bytes) != bytes)
+        {
+            records.Clear();
+            return false;
+        }
+    }
+    return true;
+}
+
+
+//-------------------------------------------------------------------------------------
+// ***** Chrome trace conversion
+
+// Thread ids used to lay out the trace in the viewer.
+enum
+{
+    ChromeTraceTid_Frame    = 1,
+    ChromeTraceTid_Timewarp = 2,
+    ChromeTraceTid_Scanout  = 3
+};
+
+static void writeChromeEvent(SysFile& out, bool& first, const char* format, ...)
+{
+    char buffer[512];
+
+    va_list argList;
+    va_start(argList, format);
+    int length = OVR_vsprintf(buffer, sizeof(buffer), format, argList);
+    va_end(argList);
+
+    if (!first)
+        out.Write((const uint8_t*)",\n", 2);
+    first = false;
+
+    if (length > 0)
+        out.Write((const uint8_t*)buffer, (int)Alg::Min(length, (int)sizeof(buffer) - 1));
+}
+
+bool ConvertFrameTimeTraceToChromeJSON(const char* tracePath, const char* jsonPath)
+{
+    SysFile in;
+    if (!openFrameTimeTrace(in, tracePath))
+        return false;
+
+    SysFile out;
+    if (!out.Open(jsonPath, File::Open_Write | File::Open_Create | File::Open_Truncate, File::Mode_Write))
+        return false;
+
+    static const char prologue[] = "{\"traceEvents\":[\n";
+    out.Write((const uint8_t*)prologue, sizeof(prologue) - 1);
+
+    bool first = true;
+    writeChromeEvent(out, first, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"Frame\"}}", ChromeTraceTid_Frame);
+    writeChromeEvent(out, first, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"Timewarp\"}}", ChromeTraceTid_Timewarp);
+    writeChromeEvent(out, first, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"Scanout\"}}", ChromeTraceTid_Scanout);
+
+    // Chrome expects microseconds; make them relative to the first record to keep precision.
+    double baseTime    = -1.0;
+    bool   frameOpen   = false;
+
+    FrameTimeTraceRecord r;
+    while (in.Read((uint8_t*)&r, sizeof(r)) == (int)sizeof(r))
+    {
+        if (baseTime < 0.0)
+            baseTime = r.Time;
+
+        const double ts = (r.Time - baseTime) * 1e6;
+
+        switch (r.Type)
+        {
+        case FrameTimeTrace_BeginFrame:
+            if (frameOpen)
+                writeChromeEvent(out, first, "{\"name\":\"Frame\",\"ph\":\"E\",\"ts\":%.3f,\"pid\":1,\"tid\":%d}", ts, ChromeTraceTid_Frame);
+            writeChromeEvent(out, first,
+                "{\"name\":\"Frame\",\"ph\":\"B\",\"ts\":%.3f,\"pid\":1,\"tid\":%d,\"args\":{\"frame\":%u,"
+                "\"timewarpPointMs\":%.3f,\"frameDeltaMs\":%.3f}}",
+                ts, ChromeTraceTid_Frame, r.FrameIndex,
+                (r.Values[1] - r.Time) * 1e3, r.Values[5] * 1e3);
+            writeChromeEvent(out, first,
+                "{\"name\":\"PredictedScanout\",\"ph\":\"i\",\"s\":\"t\",\"ts\":%.3f,\"pid\":1,\"tid\":%d,\"args\":{\"frame\":%u}}",
+                (r.Values[2] - baseTime) * 1e6, ChromeTraceTid_Scanout, r.FrameIndex);
+            frameOpen = true;
+            break;
+
+        case FrameTimeTrace_EndFrame:
+            if (frameOpen)
+                writeChromeEvent(out, first, "{\"name\":\"Frame\",\"ph\":\"E\",\"ts\":%.3f,\"pid\":1,\"tid\":%d}", ts, ChromeTraceTid_Frame);
+            writeChromeEvent(out, first,
+                "{\"name\":\"Timing\",\"ph\":\"C\",\"ts\":%.3f,\"pid\":1,\"args\":{\"measuredFrameDeltaMs\":%.3f,"
+                "\"frameDeltaMs\":%.3f,\"screenDelayMs\":%.3f,\"timewarpWaitDeltaMs\":%.3f}}",
+                ts, r.Values[1] * 1e3, r.Values[2] * 1e3, r.Values[3] * 1e3, r.Values[4] * 1e3);
+            frameOpen = false;
+            break;
+
+        case FrameTimeTrace_TimewarpWait:
+            writeChromeEvent(out, first,
+                "{\"name\":\"TimewarpWait\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%d,"
+                "\"args\":{\"frame\":%u,\"lateMs\":%.3f}}",
+                (r.Values[1] - baseTime) * 1e6, (r.Values[2] - r.Values[1]) * 1e6, ChromeTraceTid_Timewarp,
+                r.FrameIndex, (r.Values[1] - r.Values[0]) * 1e3);
+            break;
+
+        case FrameTimeTrace_LatencyMatch:
+            writeChromeEvent(out, first,
+                "{\"name\":\"Scanout\",\"ph\":\"i\",\"s\":\"t\",\"ts\":%.3f,\"pid\":1,\"tid\":%d,"
+                "\"args\":{\"renderLatencyMs\":%.3f,\"timewarpLatencyMs\":%.3f,\"accepted\":%d}}",
+                (r.Values[0] - baseTime) * 1e6, ChromeTraceTid_Scanout,
+                (r.Values[0] - r.Values[2]) * 1e3, (r.Values[0] - r.Values[3]) * 1e3, r.Values[5] != 0.0 ? 1 : 0);
+            writeChromeEvent(out, first,
+                "{\"name\":\"Latency\",\"ph\":\"C\",\"ts\":%.3f,\"pid\":1,\"args\":{\"presentToScanoutMs\":%.3f}}",
+                (r.Values[0] - baseTime) * 1e6, r.Values[4] * 1e3);
+            break;
+
+        case FrameTimeTrace_DistortionTime:
+            writeChromeEvent(out, first,
+                "{\"name\":\"Distortion\",\"ph\":\"C\",\"ts\":%.3f,\"pid\":1,\"args\":{\"distortionMs\":%.3f,"
+                "\"timewarpLeadMs\":%.3f}}",
+                ts, r.Values[0] * 1e3, r.Values[1] * 1e3);
+            break;
+
+        case FrameTimeTrace_Dropped:
+            writeChromeEvent(out, first,
+                "{\"name\":\"Dropped %u records\",\"ph\":\"i\",\"s\":\"g\",\"ts\":%.3f,\"pid\":1,\"tid\":%d}",
+                (unsigned)r.Values[0], ts, ChromeTraceTid_Frame);
+            break;
+
+        default:
+            // Unknown record types from newer writers are skipped.
+            break;
+        }
+    }
+
+    static const char epilogue[] = "\n],\"displayTimeUnit\":\"ms\"}\n";
+    out.Write((const uint8_t*)epilogue, sizeof(epilogue) - 1);
+    out.Close();
+    return true;
+}
+
+
+}} // namespace OVR::CAPI
@@ -0,0 +1,164 @@
+/************************************************************************************
+
+Filename    :   CAPI_FrameTimeTrace.h
+Content     :   Low-overhead binary trace of frame timing events
+Created     :   October 17, 2014
+
+Copyright   :   Copyright 2014 Oculus VR, LLC All Rights reserved.
+
+Licensed under the Oculus VR Rift SDK License Version 3.2 (the "License");
+you may not use the Oculus VR Rift SDK except in compliance with the License,
+which is provided at the time of installation or download, or which
+otherwise accompanies this software in either electronic or hard copy form.
+
+You may obtain a copy of the License at
+
+http://www.oculusvr.com/licenses/LICENSE-3.2
+
+Unless required by applicable law or agreed to in writing, the Oculus VR SDK
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+************************************************************************************/
+
+#ifndef OVR_CAPI_FrameTimeTrace_h
+#define OVR_CAPI_FrameTimeTrace_h
+
+#include "../Kernel/OVR_Types.h"
+#include "../Kernel/OVR_Atomic.h"
+#include "../Kernel/OVR_Threads.h"
+#include "../Kernel/OVR_SysFile.h"
+#include "../Kernel/OVR_String.h"
+#include "../Kernel/OVR_Array.h"
+
+namespace OVR { namespace CAPI {
+
+
+//-------------------------------------------------------------------------------------
+// ***** Trace file format
+//
+// A trace file is a FrameTimeTraceFileHeader followed by FrameTimeTraceRecords until the
+// end of the file. All times are absolute ovr_GetTimeInSeconds() values; all values are
+// stored in the native (little-endian) byte order.
+
+enum FrameTimeTraceEventType
+{
+    // Values: ThisFrameTime, TimewarpPointTime, MidpointTime (predicted scanout),
+    //         EyeRenderTimes[0], EyeRenderTimes[1], Inputs.FrameDelta
+    FrameTimeTrace_BeginFrame   = 1,
+    // Values: NextFrameTime (actual end of frame), measured frame delta,
+    //         new Inputs.FrameDelta, Inputs.ScreenDelay, Inputs.TimewarpWaitDelta
+    FrameTimeTrace_EndFrame     = 2,
+    // Values: target time, wait start time, wait end time
+    FrameTimeTrace_TimewarpWait = 3,
+    // FrameIndex is the latency tester readback index rather than a frame index.
+    // Values: scanout time, end frame time, render IMU time, timewarp IMU time,
+    //         present to scanout delta, 1.0 if the sample was accepted
+    FrameTimeTrace_LatencyMatch = 4,
+    // Values: number of records lost because the ring was full
+    FrameTimeTrace_Dropped      = 5,
+    // Values: measured distortion render time, timewarp lead time scheduled from it
+    FrameTimeTrace_DistortionTime = 6
+};
+
+struct FrameTimeTraceRecord
+{
+    enum { NumValues = 6 };
+
+    uint32_t    Type;                   // FrameTimeTraceEventType
+    uint32_t    FrameIndex;
+    double      Time;                   // When the record was made
+    double      Values[NumValues];      // Meaning depends on Type, unused values are zero
+
+    FrameTimeTraceRecord() { memset(this, 0, sizeof(*this)); }
+
+    FrameTimeTraceRecord(FrameTimeTraceEventType type, unsigned frameIndex)
+    {
+        memset(this, 0, sizeof(*this));
+        Type       = (uint32_t)type;
+        FrameIndex = (uint32_t)frameIndex;
+    }
+};
+
+OVR_COMPILER_ASSERT(sizeof(FrameTimeTraceRecord) == 64);
+
+static const uint32_t FrameTimeTraceMagic   = 0x54544646; // "FFTT"
+static const uint32_t FrameTimeTraceVersion = 1;
+
+struct FrameTimeTraceFileHeader
+{
+    uint32_t    Magic;                  // FrameTimeTraceMagic
+    uint32_t    Version;                // FrameTimeTraceVersion
+    uint32_t    RecordSize;             // sizeof(FrameTimeTraceRecord)
+    uint32_t    Reserved;
+};
+
+
+//-------------------------------------------------------------------------------------
+// ***** FrameTimeTraceRecorder
+
+// Records frame timing events into a fixed-size lock-free ring, which a background thread
+// drains to a file. Recording costs a timer read and a 64-byte copy, so it can stay on in
+// shipping builds. If the writer falls behind, records are dropped rather than blocking the
+// render thread, and the number dropped is written to the trace.
+//
+// Record must be called from a single thread at a time (the thread calling BeginFrame and
+// EndFrame). Start and Stop may be called from any thread.
+
+class FrameTimeTraceRecorder
+{
+public:
+    // Ring capacity in records; a power of two. 4096 records is over ten seconds of frames.
+    enum { RingSize = 4096 };
+
+    FrameTimeTraceRecorder();
+    ~FrameTimeTraceRecorder();
+
+    // Starts tracing to fileName under GetBaseOVRPath(). An existing trace is stopped first.
+    bool    Start(const String& fileName);
+    // Stops tracing, writing out all pending records. Returns false if not tracing.
+    bool    Stop();
+
+    bool    IsActive() const { return Active.Load_Acquire() != 0; }
+
+    // Timestamps and queues a record. Does nothing if not tracing.
+    void    Record(FrameTimeTraceRecord& record)
+    {
+        if (IsActive())
+            push(record);
+    }
+
+private:
+    friend class FrameTimeTraceWriter;
+
+    void    push(FrameTimeTraceRecord& record);
+    // Writes out all queued records; called by the writer thread.
+    void    drain();
+
+    FrameTimeTraceRecord*   pRing;      // OVR_ALLOC'd on first Start, kept until destruction
+    AtomicInt<uint32_t>     Head;       // Next record to write, advanced by the producer
+    AtomicInt<uint32_t>     Tail;       // Next record to drain, advanced by the writer
+    AtomicInt<uint32_t>     Dropped;
+    AtomicInt<int>          Active;
+
+    Mutex                   ControlLock;
+    Ptr<Thread>             pWriter;
+    SysFile                 TraceFile;
+};
+
+
+// Reads all records of a binary trace. Returns false if the file isn't a readable trace.
+bool LoadFrameTimeTrace(const char* tracePath, Array<FrameTimeTraceRecord>& records);
+
+// Converts a binary trace into the Chrome trace event JSON format (chrome://tracing).
+// Frames, timewarp waits and latency matches become duration and instant events, and
+// frame delta, screen delay and latency become counters. Returns false if the trace
+// can't be read or the output can't be written.
+bool ConvertFrameTimeTraceToChromeJSON(const char* tracePath, const char* jsonPath);
+
+
+}} // namespace OVR::CAPI
+
+#endif // OVR_CAPI_FrameTimeTrace_h
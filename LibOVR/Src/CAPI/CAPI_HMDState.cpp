@@ -27,6 +27,7 @@ limitations under the License.
 #include "CAPI_HMDState.h"
 #include "../OVR_Profile.h"
 #include "../Service/Service_NetClient.h"
+#include "../Util/Util_DistortionMeshCache.h"
 #ifdef OVR_OS_WIN32
 #include "../Displays/OVR_Win32_ShimFunctions.h"
 #endif
@@ -57,6 +58,7 @@ HMDState::HMDState(const OVR::Service::HMDNetworkInfo& netInfo,
     EnabledHmdCaps(0),
     EnabledServiceHmdCaps(0),
     SharedStateReader(),
+    SharedHistoryReader(),
     TheSensorStateReader(),
     TheLatencyTestStateReader(),
     LatencyTestActive(false),
@@ -93,6 +95,7 @@ HMDState::HMDState(const OVR::HMDInfo& hmdInfo, Profile* profile) :
     EnabledHmdCaps(0),
     EnabledServiceHmdCaps(0),
     SharedStateReader(),
+    SharedHistoryReader(),
     TheSensorStateReader(),
     TheLatencyTestStateReader(),
     LatencyTestActive(false),
@@ -226,18 +229,23 @@ void HMDState::UpdateRenderProfile(Profile* profile)
 
     if (pClient)
     {
+        // Sent to the server as one batch
+        Array<ValueRequest> values;
+
         // Center pupil depth
-        float centerPupilDepth = GetCenterPupilDepthFromRenderInfo(&RenderState.RenderInfo);
-        pClient->SetNumberValue(GetNetId(), "CenterPupilDepth", centerPupilDepth);
+        ValueRequest centerPupilDepth(NetSessionCommon::ESetNumberValue, GetNetId(), "CenterPupilDepth");
+        centerPupilDepth.NumberValue = GetCenterPupilDepthFromRenderInfo(&RenderState.RenderInfo);
+        values.PushBack(centerPupilDepth);
 
         // Neck model
         Vector3f neckModel = GetNeckModelFromProfile(profile);
-        double neckModelArray[3] = {
-            neckModel.x,
-            neckModel.y,
-            neckModel.z
-        };
-        pClient->SetNumberValues(GetNetId(), "NeckModelVector3f", neckModelArray, 3);
+        ValueRequest neckModelVector(NetSessionCommon::ESetNumberValues, GetNetId(), "NeckModelVector3f");
+        neckModelVector.NumberValues.PushBack(neckModel.x);
+        neckModelVector.NumberValues.PushBack(neckModel.y);
+        neckModelVector.NumberValues.PushBack(neckModel.z);
+        values.PushBack(neckModelVector);
+
+        pClient->SetValues(values);
 
         double camerastate[7];
         if (profile->GetDoubleValues(OVR_KEY_CAMERA_POSITION, camerastate, 7) == 0)
@@ -284,6 +292,14 @@ HMDState* HMDState::CreateHMDState(NetClient* client, const HMDNetworkInfo& netI
     }
 
     hmds->TheSensorStateReader.SetUpdater(hmds->SharedStateReader.Get());
+
+    // The pose history is optional; older services do not publish it.
+    String historyName = netInfo.SharedMemoryName + Tracking::SensorStateHistoryNameSuffix;
+    if (hmds->SharedHistoryReader.Open(historyName.ToCStr()))
+    {
+        hmds->TheSensorStateReader.SetHistory(hmds->SharedHistoryReader.Get());
+    }
+
     hmds->TheLatencyTestStateReader.SetUpdater(hmds->SharedStateReader.Get());
 
     return hmds;
@@ -344,6 +360,11 @@ ovrTrackingState HMDState::PredictedTrackingState(double absTime)
     return ss;
 }
 
+bool HMDState::PredictedPoses(const double* absTimes, Posef* poses, int count)
+{
+    return TheSensorStateReader.GetPosesAtTimes(absTimes, poses, count);
+}
+
 void HMDState::SetEnabledHmdCaps(unsigned hmdCaps)
 {
     if (OurHMDInfo.HmdType < HmdType_DK2)
@@ -423,7 +444,15 @@ unsigned HMDState::SetEnabledHmdCaps()
 
 bool HMDState::getBoolValue(const char* propertyName, bool defaultVal)
 {
-    if (NetSessionCommon::IsServiceProperty(NetSessionCommon::EGetBoolValue, propertyName))
+    if (OVR_strcmp(propertyName, OVR_KEY_DISTORTION_MESH_CACHE) == 0)
+    {
+        return DistortionMeshCache::GetInstance()->IsEnabled();
+    }
+    else if (OVR_strcmp(propertyName, OVR_KEY_PROFILE_BINARY_CACHE) == 0)
+    {
+        return ProfileManager::GetInstance()->IsBinaryCacheEnabled();
+    }
+    else if (NetSessionCommon::IsServiceProperty(NetSessionCommon::EGetBoolValue, propertyName))
     {
        return NetClient::GetInstance()->GetBoolValue(GetNetId(), propertyName, defaultVal);
     }
@@ -436,6 +465,19 @@ bool HMDState::getBoolValue(const char* propertyName, bool defaultVal)
 
 bool HMDState::setBoolValue(const char* propertyName, bool value)
 {
+    if (OVR_strcmp(propertyName, OVR_KEY_DISTORTION_MESH_CACHE) == 0)
+    {
+        // Process-wide: affects meshes created for every HMD.
+        DistortionMeshCache::GetInstance()->SetEnabled(value);
+        return true;
+    }
+    if (OVR_strcmp(propertyName, OVR_KEY_PROFILE_BINARY_CACHE) == 0)
+    {
+        // Process-wide: ProfileDB.bin is shared by every HMD, and stays enabled for later processes.
+        ProfileManager::GetInstance()->SetBinaryCacheEnabled(value);
+        return true;
+    }
+
 	if (NetSessionCommon::IsServiceProperty(NetSessionCommon::ESetBoolValue, propertyName))
 	{
 		return NetClient::GetInstance()->SetBoolValue(GetNetId(), propertyName, value);
@@ -481,6 +523,10 @@ float HMDState::getFloatValue(const char* propertyName, float defaultVal)
     {
         return OurHMDInfo.Shutter.PixelPersistence;
     }
+    else if (OVR_strcmp(propertyName, OVR_KEY_TIMEWARP_MISS_PROBABILITY) == 0)
+    {
+        return TimeManager.GetTimewarpMissProbability();
+    }
     else if (NetSessionCommon::IsServiceProperty(NetSessionCommon::EGetNumberValue, propertyName))
     {
        return (float)NetClient::GetInstance()->GetNumberValue(GetNetId(), propertyName, defaultVal);
@@ -495,6 +541,12 @@ float HMDState::getFloatValue(const char* propertyName, float defaultVal)
 
 bool HMDState::setFloatValue(const char* propertyName, float value)
 {
+    if (OVR_strcmp(propertyName, OVR_KEY_TIMEWARP_MISS_PROBABILITY) == 0)
+    {
+        TimeManager.SetTimewarpMissProbability(value);
+        return true;
+    }
+
 	if (NetSessionCommon::IsServiceProperty(NetSessionCommon::ESetNumberValue, propertyName))
 	{
 		return NetClient::GetInstance()->SetNumberValue(GetNetId(), propertyName, value);
@@ -765,8 +817,8 @@ ovrBool ovrHmd_CreateDistortionMeshInternal( ovrHmdStruct *  hmd,
         return 0;
     HMDState* hmds = (HMDState*)hmd;
 
-    // Not used now, but Chromatic flag or others could possibly be checked for in the future.
-    OVR_UNUSED1(distortionCaps); 
+    // Not used for generation now, but Chromatic flag or others could possibly be checked for in the future.
+    // It is already part of the mesh cache key below.
    
 #if defined (OVR_CC_MSVC)
     static_assert(sizeof(DistortionMeshVertexData) == sizeof(ovrDistortionVertex), "DistortionMeshVertexData size mismatch");
@@ -791,13 +843,49 @@ ovrBool ovrHmd_CreateDistortionMeshInternal( ovrHmdStruct *  hmd,
     // Find the mapping from TanAngle space to target NDC space.
     ScaleAndOffset2D      eyeToSourceNDC = CreateNDCScaleAndOffsetFromFov(fov);
 
+    // Meshes only depend on the parameters in the key, so an identical mesh generated earlier,
+    // possibly by another process, can be copied instead. A custom distortion function
+    // isn't part of the key, so its meshes are neither looked up nor shared.
+    const int              gridSizeLog2 = DistortionMeshDefaultGridSizeLog2;
+    DistortionMeshCacheKey cacheKey(gridSizeLog2, (stereoEye == StereoEye_Right),
+                                    distortionCaps, hmdri, distortion, fov);
+    const bool             useCache = !CustomDistortion && !CustomDistortionInv;
+
+    Ptr<DistortionMeshCache::Entry> cached;
+    if (useCache)
+    {
+        cached = DistortionMeshCache::GetInstance()->Find(cacheKey);
+    }
+    if (cached)
+    {
+        // The caller frees the mesh with ovrHmd_DestroyDistortionMesh, so it needs its own copy.
+        size_t vertexBytes = cached->GetNumVertices() * sizeof(DistortionMeshVertexData);
+        size_t indexBytes  = cached->GetNumIndices() * sizeof(uint16_t);
+        meshData->pVertexData = (ovrDistortionVertex*)OVR_ALLOC(vertexBytes);
+        meshData->pIndexData  = (unsigned short*)OVR_ALLOC(indexBytes);
+
+        if (meshData->pVertexData && meshData->pIndexData)
+        {
+            memcpy(meshData->pVertexData, cached->GetVertices(), vertexBytes);
+            memcpy(meshData->pIndexData, cached->GetIndices(), indexBytes);
+            meshData->IndexCount  = cached->GetNumIndices();
+            meshData->VertexCount = cached->GetNumVertices();
+            return 1;
+        }
+
+        DistortionMeshDestroy((DistortionMeshVertexData*)meshData->pVertexData, meshData->pIndexData);
+        meshData->pVertexData = NULL;
+        meshData->pIndexData  = NULL;
+        return 0;
+    }
+
     int triangleCount = 0;
     int vertexCount = 0;
 
     DistortionMeshCreate((DistortionMeshVertexData**)&meshData->pVertexData,
                          (uint16_t**)&meshData->pIndexData,
                           &vertexCount, &triangleCount,
-                          (stereoEye == StereoEye_Right),
+                          gridSizeLog2, (stereoEye == StereoEye_Right),
                           hmdri, distortion, eyeToSourceNDC);
 
     if (meshData->pVertexData)
@@ -805,6 +893,13 @@ ovrBool ovrHmd_CreateDistortionMeshInternal( ovrHmdStruct *  hmd,
         // Convert to index
         meshData->IndexCount = triangleCount * 3;
         meshData->VertexCount = vertexCount;
+
+        if (useCache)
+        {
+            DistortionMeshCache::GetInstance()->Store(cacheKey,
+                                                      (const DistortionMeshVertexData*)meshData->pVertexData, vertexCount,
+                                                      meshData->pIndexData, meshData->IndexCount);
+        }
         return 1;
     }
 
@@ -150,6 +150,8 @@ public:
     void            ResetTracking();
 	void			RecenterPose();
     ovrTrackingState PredictedTrackingState(double absTime);
+    // Predicted head poses at several times, from a single sensor state.
+    bool            PredictedPoses(const double* absTimes, Posef* poses, int count);
 
     // Changes HMD Caps.
     // Capability bits that are not directly or logically tied to one system (such as sensor)
@@ -245,6 +247,7 @@ public:
     
     // *** Sensor
     Tracking::CombinedSharedStateReader SharedStateReader;
+    Tracking::SensorStateHistoryReader  SharedHistoryReader;
     Tracking::SensorStateReader         TheSensorStateReader;
     Util::RecordStateReader             TheLatencyTestStateReader;
 
@@ -258,6 +261,7 @@ public:
     FrameTimeManager        TimeManager;
     LagStatsCalculator      LagStats;
     LatencyStatisticsCSV    LagStatsCSV;
+    FrameTimeTraceRecorder  TimeTrace;
     HMDRenderState          RenderState;
     Ptr<DistortionRenderer> pRenderer;
 
@@ -27,6 +27,7 @@ limitations under the License.
 #include "CAPI_LatencyStatistics.h"
 
 #include "../Kernel/OVR_Log.h"
+#include "../Kernel/OVR_Alg.h"
 #include "../Kernel/OVR_Threads.h"
 #include "../Util/Util_SystemInfo.h"
 
@@ -160,6 +161,90 @@ void LatencyStatisticsCSV::OnResults(LatencyStatisticsResults *results)
 {
     WriteResultsV1(results);
 }
+//-------------------------------------------------------------------------------------
+// ***** LatencyHistogram
+
+int LatencyHistogram::getBucketIndex(uint32_t microseconds)
+{
+    if (microseconds < 2 * SubBucketHalf)
+    {
+        return (int)microseconds;
+    }
+
+    // Keep the top SubBucketBits bits; the bucket is the shift plus those bits.
+    int shift = Alg::UpperBit(microseconds) - (SubBucketBits - 1);
+    return shift * SubBucketHalf + (int)(microseconds >> shift);
+}
+
+uint32_t LatencyHistogram::getBucketHighestValue(int index)
+{
+    if (index < 2 * SubBucketHalf)
+    {
+        return (uint32_t)index;
+    }
+
+    int      shift    = index / SubBucketHalf - 1;
+    uint32_t mantissa = (uint32_t)(index - shift * SubBucketHalf);
+    return ((mantissa + 1) << shift) - 1;
+}
+
+void LatencyHistogram::Reset()
+{
+    memset(Counts, 0, sizeof(Counts));
+    TotalCount = 0;
+    MaxSeconds = 0.;
+}
+
+void LatencyHistogram::Record(double seconds)
+{
+    if (!(seconds > 0.))    // Also rejects NaN
+    {
+        seconds = 0.;
+    }
+
+    double   microseconds = seconds * 1000000. + 0.5;
+    uint32_t value        = (microseconds < (double)MaxMicroseconds) ? (uint32_t)microseconds : (uint32_t)MaxMicroseconds;
+
+    Counts[getBucketIndex(value)]++;
+    TotalCount++;
+    MaxSeconds = Alg::Max(MaxSeconds, seconds);
+}
+
+double LatencyHistogram::GetPercentile(double fraction) const
+{
+    if (TotalCount == 0)
+    {
+        return 0.;
+    }
+
+    // Rank of the sample we want, 1-based.
+    int target = (int)ceil(fraction * TotalCount);
+    target = Alg::Clamp(target, 1, TotalCount);
+
+    int cumulative = 0;
+    for (int i = 0; i < BucketCount; ++i)
+    {
+        cumulative += (int)Counts[i];
+        if (cumulative >= target)
+        {
+            // Never report more than was actually seen.
+            return Alg::Min(getBucketHighestValue(i) * 0.000001, MaxSeconds);
+        }
+    }
+
+    return MaxSeconds;
+}
+
+void LatencyPercentiles::Set(const LatencyHistogram& histogram)
+{
+    P50  = histogram.GetPercentile(0.5);
+    P90  = histogram.GetPercentile(0.9);
+    P99  = histogram.GetPercentile(0.99);
+    P999 = histogram.GetPercentile(0.999);
+    Max  = histogram.GetMax();
+}
+
+
 //-------------------------------------------------------------------------------------
 // ***** LatencyStatisticsCalculator
     
@@ -196,6 +281,13 @@ void LagStatsCalculator::resetPerfStats(double resetTime)
     latencyStatisticsData.LatencyPostPresent = 0;
     latencyStatisticsData.LatencyVisionProc = 0;
     latencyStatisticsData.LatencyVisionFrame = 0;
+
+    EndFrameHistogram.Reset();
+    RenderHistogram.Reset();
+    TimewarpHistogram.Reset();
+    PostPresentHistogram.Reset();
+    VisionProcHistogram.Reset();
+    VisionFrameHistogram.Reset();
 }
 
 void LagStatsCalculator::GetLatestResults(LatencyStatisticsResults* results)
@@ -224,6 +316,10 @@ void LagStatsCalculator::InstrumentLatencyTimings(FrameTimeManager& ftm)
 	latencyStatisticsData.LatencyRender += latencyRender;
 	latencyStatisticsData.LatencyTimewarp += latencyTimewarp;
 	latencyStatisticsData.LatencyPostPresent += latencyPostPresent;
+
+    RenderHistogram.Record(latencyRender);
+    TimewarpHistogram.Record(latencyTimewarp);
+    PostPresentHistogram.Record(latencyPostPresent);
 }
 
 void LagStatsCalculator::InstrumentEndFrameEnd(double timestamp)
@@ -243,6 +339,9 @@ void LagStatsCalculator::InstrumentEyePose(const ovrTrackingState& state)
         {
             latencyStatisticsData.LatencyVisionProc += state.LastVisionProcessingTime;
             latencyStatisticsData.LatencyVisionFrame += state.LastVisionFrameLatency;
+
+            VisionProcHistogram.Record(state.LastVisionProcessingTime);
+            VisionFrameHistogram.Record(state.LastVisionFrameLatency);
         }
         ++VisionFrames;
 
@@ -268,6 +367,7 @@ void LagStatsCalculator::calculateResults()
 
     // Incorporate EndFrame() duration into the running sum
     latencyStatisticsData.EndFrameExecutionTime += endFrameDuration;
+    EndFrameHistogram.Record(endFrameDuration);
 
     //for (int i = 0; i < 3; ++i)
     //{
@@ -300,6 +400,14 @@ void LagStatsCalculator::calculateResults()
         results.LatencyVisionProc = latencyStatisticsData.LatencyVisionProc * invVisionFrameCount;
         results.LatencyVisionFrame = latencyStatisticsData.LatencyVisionFrame * invVisionFrameCount;
 
+        // Distributions
+        results.EndFrameExecutionTimePercentiles.Set(EndFrameHistogram);
+        results.LatencyRenderPercentiles.Set(RenderHistogram);
+        results.LatencyTimewarpPercentiles.Set(TimewarpHistogram);
+        results.LatencyPostPresentPercentiles.Set(PostPresentHistogram);
+        results.LatencyVisionProcPercentiles.Set(VisionProcHistogram);
+        results.LatencyVisionFramePercentiles.Set(VisionFrameHistogram);
+
         Results.SetState(results);
 
         {
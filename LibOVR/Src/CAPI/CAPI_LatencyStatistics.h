@@ -42,6 +42,58 @@ namespace OVR { namespace CAPI {
 #define OVR_LAG_STATS_RESET_LIMIT 2.0 /* seconds */
 
 
+//-------------------------------------------------------------------------------------
+// ***** LatencyHistogram
+
+// Log-bucketed histogram of durations, in the style of HdrHistogram.  Values are kept in
+// microseconds, exactly below 64us and otherwise in 32 linear sub-buckets per power of two,
+// so reported percentiles are within about 3% of the true value up to MaxMicroseconds.
+// Record() is O(1) and the histogram never allocates, so it is safe to use on the frame path.
+class LatencyHistogram
+{
+public:
+    enum
+    {
+        SubBucketBits   = 6,
+        SubBucketHalf   = 1 << (SubBucketBits - 1),
+        MaxValueBits    = 26,                                   // About 67 seconds
+        BucketCount     = (MaxValueBits - SubBucketBits + 2) * SubBucketHalf,
+        MaxMicroseconds = (1 << MaxValueBits) - 1
+    };
+
+    LatencyHistogram() { Reset(); }
+
+    void     Reset();
+    void     Record(double seconds);
+
+    int      GetCount() const { return TotalCount; }
+    double   GetMax() const   { return MaxSeconds; }
+    // Returns the value that the given fraction of samples are at or below, e.g. 0.99 for p99.
+    // It is rounded up to the top of its bucket, but never exceeds GetMax(). Returns 0 if empty.
+    double   GetPercentile(double fraction) const;
+
+private:
+    static int      getBucketIndex(uint32_t microseconds);
+    static uint32_t getBucketHighestValue(int index);
+
+    uint32_t    Counts[BucketCount];
+    int         TotalCount;
+    double      MaxSeconds;
+};
+
+// Distribution of one metric over a statistics epoch, in seconds.
+struct LatencyPercentiles
+{
+    double P50;
+    double P90;
+    double P99;
+    double P999;
+    double Max;
+
+    void Set(const LatencyHistogram& histogram);
+};
+
+
 //-------------------------------------------------------------------------------------
 // ***** LatencyStatisticsResults
 
@@ -71,6 +123,15 @@ struct LatencyStatisticsResults
 
     // Measures the time from exposure until the pose is available for the frame, including processing time.
     double LatencyVisionFrame;
+
+    // Distributions of the above over the epoch. Averages hide the occasional long frame;
+    // these do not.
+    LatencyPercentiles EndFrameExecutionTimePercentiles;
+    LatencyPercentiles LatencyRenderPercentiles;
+    LatencyPercentiles LatencyTimewarpPercentiles;
+    LatencyPercentiles LatencyPostPresentPercentiles;
+    LatencyPercentiles LatencyVisionProcPercentiles;
+    LatencyPercentiles LatencyVisionFramePercentiles;
 };
 
 //-----------------------------------------------------------------------------
@@ -142,6 +203,14 @@ class LagStatsCalculator
     // Count of vision frames
     int                 VisionFrames;
 
+    // Per-frame distributions for this stats epoch
+    LatencyHistogram    EndFrameHistogram;
+    LatencyHistogram    RenderHistogram;
+    LatencyHistogram    TimewarpHistogram;
+    LatencyHistogram    PostPresentHistogram;
+    LatencyHistogram    VisionProcHistogram;
+    LatencyHistogram    VisionFrameHistogram;
+
     // Statistics results:
 
     LocklessUpdater<LatencyStatisticsResults, LatencyStatisticsResults> Results;
@@ -0,0 +1,888 @@
+/************************************************************************************
+
+Filename    :   OVR_AsyncLog.cpp
+Content     :   Asynchronous logging through per-thread lock-free queues
+Created     :   October 17, 2014
+Notes       :
+
+Copyright   :   Copyright 2014 Oculus VR, LLC All Rights reserved.
+
+Licensed under the Oculus VR Rift SDK License Version 3.2 (the "License");
+you may not use the Oculus VR Rift SDK except in compliance with the License,
+which is provided at the time of installation or download, or which
+otherwise accompanies this software in either electronic or hard copy form.
+
+You may obtain a copy of the License at
+
+http://www.oculusvr.com/licenses/LICENSE-3.2
+
+Unless required by applicable law or agreed to in writing, the Oculus VR SDK
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*************************************************************************************/
+
+#include "OVR_AsyncLog.h"
+#include "OVR_Atomic.h"
+#include "OVR_Threads.h"
+#include "OVR_System.h"
+#include "OVR_Timer.h"
+#include "OVR_String.h"
+#include "OVR_Std.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#if defined(OVR_OS_MS)
+ #include <Windows.h>
+#else
+ #include <pthread.h>
+#endif
+
+#if defined(OVR_CC_MSVC)
+    #define OVR_ASYNCLOG_THREAD_LOCAL __declspec(thread)
+#else
+    #define OVR_ASYNCLOG_THREAD_LOCAL __thread
+#endif
+
+namespace OVR {
+
+
+//-----------------------------------------------------------------------------------
+// ***** Format parsing
+
+// How a conversion takes its value from the argument list.
+enum AsyncLogArgKind
+{
+    AsyncArg_Percent,       // "%%", takes no argument
+    AsyncArg_Int,
+    AsyncArg_Long,
+    AsyncArg_LongLong,
+    AsyncArg_SizeT,
+    AsyncArg_PtrDiff,
+    AsyncArg_IntMax,
+    AsyncArg_Double,
+    AsyncArg_Pointer,
+    AsyncArg_String,
+    AsyncArg_Unsupported    // Formatted on the calling thread
+};
+
+struct AsyncLogSpec
+{
+    const char*     Start;          // The '%'
+    const char*     End;            // Just past the conversion character
+    int             Stars;          // int arguments for '*' width and precision, before the value
+    bool            StarPrecision;  // The last star is the precision
+    int             Precision;      // Fixed precision, or -1
+    AsyncLogArgKind Kind;
+};
+
+// Finds the first conversion specification at or after p. Returns false if there is none.
+static bool findConversion(const char* p, AsyncLogSpec& spec)
+{
+    p = strchr(p, '%');
+    if (!p)
+        return false;
+
+    spec.Start         = p++;
+    spec.Stars         = 0;
+    spec.StarPrecision = false;
+    spec.Precision     = -1;
+
+    if (*p == '%')
+    {
+        spec.Kind = AsyncArg_Percent;
+        spec.End  = p + 1;
+        return true;
+    }
+
+    while (*p && strchr("-+ #0'", *p))
+        p++;
+
+    if (*p == '*')
+    {
+        spec.Stars++;
+        p++;
+    }
+    else
+    {
+        while (*p >= '0' && *p <= '9')
+            p++;
+    }
+
+    if (*p == '.')
+    {
+        p++;
+        if (*p == '*')
+        {
+            spec.Stars++;
+            spec.StarPrecision = true;
+            p++;
+        }
+        else
+        {
+            spec.Precision = 0;
+            while (*p >= '0' && *p <= '9')
+                spec.Precision = spec.Precision * 10 + (*p++ - '0');
+        }
+    }
+
+    // Length modifiers, including the Microsoft I, I32 and I64
+    AsyncLogArgKind integerKind = AsyncArg_Int;
+    bool            plain       = true;     // No modifier that changes a double or a string
+    switch (*p)
+    {
+    case 'h':
+        p += (p[1] == 'h') ? 2 : 1;
+        break;
+    case 'l':
+        if (p[1] == 'l') { integerKind = AsyncArg_LongLong; p += 2; plain = false; }
+        else             { integerKind = AsyncArg_Long; p++; }
+        break;
+    case 'q': integerKind = AsyncArg_LongLong; p++; plain = false; break;
+    case 'j': integerKind = AsyncArg_IntMax;   p++; plain = false; break;
+    case 'z': integerKind = AsyncArg_SizeT;    p++; plain = false; break;
+    case 't': integerKind = AsyncArg_PtrDiff;  p++; plain = false; break;
+    case 'L': integerKind = AsyncArg_Unsupported; p++; plain = false; break;
+    case 'w': integerKind = AsyncArg_Unsupported; p++; plain = false; break;
+    case 'I':
+        if (p[1] == '6' && p[2] == '4')      { integerKind = AsyncArg_LongLong; p += 3; }
+        else if (p[1] == '3' && p[2] == '2') { p += 3; }
+        else                                 { integerKind = AsyncArg_SizeT; p++; }
+        plain = false;
+        break;
+    }
+    const bool longModifier = (integerKind == AsyncArg_Long);
+
+    switch (*p)
+    {
+    case 'd': case 'i': case 'u': case 'o': case 'x': case 'X':
+        spec.Kind = integerKind;
+        break;
+    case 'c':
+        spec.Kind = (plain && !longModifier) ? AsyncArg_Int : AsyncArg_Unsupported;
+        break;
+    case 'e': case 'E': case 'f': case 'F': case 'g': case 'G': case 'a': case 'A':
+        spec.Kind = plain ? AsyncArg_Double : AsyncArg_Unsupported;
+        break;
+    case 's':
+        spec.Kind = (plain && !longModifier) ? AsyncArg_String : AsyncArg_Unsupported;
+        break;
+    case 'p':
+        spec.Kind = AsyncArg_Pointer;
+        break;
+    default: // %n, wide %S and %C, and anything unknown
+        spec.Kind = AsyncArg_Unsupported;
+        break;
+    }
+
+    spec.End = *p ? p + 1 : p;
+    return true;
+}
+
+
+//-----------------------------------------------------------------------------------
+// ***** Records
+
+// A record is followed by ArgCount AsyncLogArgs and a copy of the format, then the copied
+// strings; or, for Formatted records, by the formatted message.
+struct AsyncLogRecord
+{
+    uint32_t    Size;           // Bytes up to the next record, a multiple of 8
+    uint16_t    MessageType;    // 0 for the padding that fills the end of a queue
+    uint8_t     ArgCount;
+    uint8_t     Formatted;
+    double      Time;
+};
+
+union AsyncLogArg
+{
+    int64_t     Int;
+    double      Double;
+    const void* Pointer;
+    uint32_t    StringOffset;   // From the start of the record; 0 for a NULL string
+};
+
+// Room for the copied strings' terminators past MaxRecordSize
+static const uint32_t AsyncLogBufferSize = AsyncLog::MaxRecordSize + AsyncLog::MaxArguments + 8;
+
+static uint32_t alignRecordSize(size_t size)
+{
+    return (uint32_t)((size + 7) & ~(size_t)7);
+}
+
+// Writes the record for a message into buffer and returns its size.
+static uint32_t captureRecord(uint64_t* buffer, LogMessageType messageType, const char* fmt, va_list argList)
+{
+    AsyncLogRecord* record = (AsyncLogRecord*)buffer;
+    char*           base   = (char*)buffer;
+
+    record->MessageType = (uint16_t)messageType;
+    record->ArgCount    = 0;
+    record->Formatted   = 0;
+    record->Time        = Timer::GetSeconds();
+
+    // Check that every conversion can be captured before taking any arguments
+    AsyncLogSpec spec;
+    int          argCount  = 0;
+    bool         supported = true;
+    for (const char* p = fmt; supported && findConversion(p, spec); p = spec.End)
+    {
+        if (spec.Kind == AsyncArg_Unsupported)
+            supported = false;
+        else if (spec.Kind != AsyncArg_Percent)
+            argCount += spec.Stars + 1;
+    }
+
+    size_t used          = sizeof(AsyncLogRecord) + argCount * sizeof(AsyncLogArg);
+    size_t formatLength  = strlen(fmt);
+    if (argCount > AsyncLog::MaxArguments || used + formatLength >= AsyncLog::MaxRecordSize)
+        supported = false;
+
+    if (!supported)
+    {
+        char*  text     = (char*)(record + 1);
+        size_t capacity = AsyncLog::MaxRecordSize - sizeof(AsyncLogRecord);
+        int    length   = OVR_vsnprintf(text, capacity, fmt, argList);
+
+        if (length < 0)
+        {
+            text[0] = 0;
+            length  = 0;
+        }
+        else if ((size_t)length >= capacity)
+        {
+            length = (int)capacity - 1;
+        }
+
+        record->Formatted = 1;
+        record->Size      = alignRecordSize(sizeof(AsyncLogRecord) + length + 1);
+        return record->Size;
+    }
+
+    AsyncLogArg* args = (AsyncLogArg*)(record + 1);
+    memcpy(base + used, fmt, formatLength + 1);
+    used += formatLength + 1;
+
+    int arg = 0;
+    for (const char* p = fmt; findConversion(p, spec); p = spec.End)
+    {
+        if (spec.Kind == AsyncArg_Percent)
+            continue;
+
+        for (int i = 0; i < spec.Stars; i++)
+            args[arg++].Int = va_arg(argList, int);
+
+        const int precision = spec.StarPrecision ? (int)args[arg - 1].Int : spec.Precision;
+
+        switch (spec.Kind)
+        {
+        case AsyncArg_Int:      args[arg].Int     = va_arg(argList, int);        break;
+        case AsyncArg_Long:     args[arg].Int     = va_arg(argList, long);       break;
+        case AsyncArg_LongLong: args[arg].Int     = va_arg(argList, long long);  break;
+        case AsyncArg_SizeT:    args[arg].Int     = (int64_t)va_arg(argList, size_t);    break;
+        case AsyncArg_PtrDiff:  args[arg].Int     = (int64_t)va_arg(argList, ptrdiff_t); break;
+        case AsyncArg_IntMax:   args[arg].Int     = (int64_t)va_arg(argList, intmax_t);  break;
+        case AsyncArg_Double:   args[arg].Double  = va_arg(argList, double);     break;
+        case AsyncArg_Pointer:  args[arg].Pointer = va_arg(argList, const void*); break;
+        case AsyncArg_String:
+            {
+                const char* str = va_arg(argList, const char*);
+                args[arg].Int = 0;
+                if (str)
+                {
+                    // Copy no more than the precision, which needn't be within a terminated string
+                    size_t limit  = (used < AsyncLog::MaxRecordSize) ? AsyncLog::MaxRecordSize - used : 0;
+                    size_t length = 0;
+                    if (precision >= 0 && (size_t)precision < limit)
+                        limit = (size_t)precision;
+                    while (length < limit && str[length])
+                        length++;
+
+                    memcpy(base + used, str, length);
+                    base[used + length] = 0;
+                    args[arg].StringOffset = (uint32_t)used;
+                    used += length + 1;
+                }
+            }
+            break;
+        default:
+            OVR_ASSERT(false);
+            break;
+        }
+        arg++;
+    }
+
+    record->ArgCount = (uint8_t)argCount;
+    record->Size     = alignRecordSize(used);
+    return record->Size;
+}
+
+template<class T>
+static void appendArgument(StringBuffer& text, const char* spec, int stars, const AsyncLogArg* starArgs, T value)
+{
+    switch (stars)
+    {
+    case 0:  text.AppendFormat(spec, value); break;
+    case 1:  text.AppendFormat(spec, (int)starArgs[0].Int, value); break;
+    default: text.AppendFormat(spec, (int)starArgs[0].Int, (int)starArgs[1].Int, value); break;
+    }
+}
+
+// Formats a record the way OVR_vsnprintf would have formatted the original message.
+static void formatRecord(const AsyncLogRecord* record, StringBuffer& text)
+{
+    text.Clear();
+
+    if (record->Formatted)
+    {
+        text.AppendString((const char*)(record + 1));
+        return;
+    }
+
+    const AsyncLogArg* args = (const AsyncLogArg*)(record + 1);
+    const char*        base = (const char*)record;
+    const char*        p    = (const char*)(args + record->ArgCount);
+    int                arg  = 0;
+    AsyncLogSpec       spec;
+    char               specBuffer[64];
+
+    for (; findConversion(p, spec); p = spec.End)
+    {
+        text.AppendString(p, spec.Start - p);
+
+        if (spec.Kind == AsyncArg_Percent)
+        {
+            text.AppendChar('%');
+            continue;
+        }
+
+        const size_t       specLength = spec.End - spec.Start;
+        const AsyncLogArg* starArgs   = args + arg;
+        const AsyncLogArg& value      = args[arg + spec.Stars];
+        arg += spec.Stars + 1;
+
+        if (specLength >= sizeof(specBuffer))
+        {
+            text.AppendString(spec.Start, specLength);
+            continue;
+        }
+        memcpy(specBuffer, spec.Start, specLength);
+        specBuffer[specLength] = 0;
+
+        switch (spec.Kind)
+        {
+        case AsyncArg_Int:      appendArgument(text, specBuffer, spec.Stars, starArgs, (int)value.Int);        break;
+        case AsyncArg_Long:     appendArgument(text, specBuffer, spec.Stars, starArgs, (long)value.Int);       break;
+        case AsyncArg_LongLong: appendArgument(text, specBuffer, spec.Stars, starArgs, (long long)value.Int);  break;
+        case AsyncArg_SizeT:    appendArgument(text, specBuffer, spec.Stars, starArgs, (size_t)value.Int);     break;
+        case AsyncArg_PtrDiff:  appendArgument(text, specBuffer, spec.Stars, starArgs, (ptrdiff_t)value.Int);  break;
+        case AsyncArg_IntMax:   appendArgument(text, specBuffer, spec.Stars, starArgs, (intmax_t)value.Int);   break;
+        case AsyncArg_Double:   appendArgument(text, specBuffer, spec.Stars, starArgs, value.Double);          break;
+        case AsyncArg_Pointer:  appendArgument(text, specBuffer, spec.Stars, starArgs, value.Pointer);         break;
+        case AsyncArg_String:
+            appendArgument(text, specBuffer, spec.Stars, starArgs,
+                           value.StringOffset ? base + value.StringOffset : "(null)");
+            break;
+        default:
+            break;
+        }
+    }
+
+    text.AppendString(p);
+}
+
+
+//-----------------------------------------------------------------------------------
+// ***** AsyncLogQueue
+
+class AsyncLogDispatcher;
+
+// Single producer, single consumer ring of records. Head and Tail count bytes and are
+// only written by the producer and the consumer respectively. When its thread exits the
+// queue is handed, with whatever it still holds, to the next thread that logs.
+class AsyncLogQueue : public NewOverrideBase
+{
+public:
+    AsyncLogQueue(AsyncLogDispatcher* owner) :
+        pOwner(owner),
+        InUse(true),
+        Buffer((uint8_t*)OVR_ALLOC_ALIGNED(AsyncLog::QueueSize, 8)),
+        Head(0),
+        Dropped(0),
+        Tail(0)
+    {
+    }
+
+    ~AsyncLogQueue()
+    {
+        OVR_FREE_ALIGNED(Buffer);
+    }
+
+    // Producer
+    void Write(const void* record, uint32_t size)
+    {
+        const uint32_t head   = Head;
+        const uint32_t tail   = AtomicOps<uint32_t>::Load_Acquire(&Tail);
+        const uint32_t offset = head & (AsyncLog::QueueSize - 1);
+        const uint32_t toEnd  = AsyncLog::QueueSize - offset;
+
+        // Records don't wrap; the end of the queue is skipped with a padding record instead
+        const uint32_t padding = (toEnd < size) ? toEnd : 0;
+        if (padding + size > AsyncLog::QueueSize - (head - tail))
+        {
+            Dropped = Dropped + 1;
+            return;
+        }
+
+        if (padding)
+        {
+            AsyncLogRecord* pad = (AsyncLogRecord*)(Buffer + offset);
+            pad->Size        = padding;
+            pad->MessageType = 0;
+        }
+
+        memcpy(Buffer + ((head + padding) & (AsyncLog::QueueSize - 1)), record, size);
+        AtomicOps<uint32_t>::Store_Release(&Head, head + padding + size);
+    }
+
+    // Consumer: the oldest record, or NULL if the queue is empty.
+    const AsyncLogRecord* Peek()
+    {
+        const uint32_t head = AtomicOps<uint32_t>::Load_Acquire(&Head);
+        uint32_t       tail = Tail;
+
+        while (tail != head)
+        {
+            const AsyncLogRecord* record = (const AsyncLogRecord*)(Buffer + (tail & (AsyncLog::QueueSize - 1)));
+            if (record->MessageType != 0)
+                return record;
+
+            tail += record->Size;
+            AtomicOps<uint32_t>::Store_Release(&Tail, tail);
+        }
+        return NULL;
+    }
+
+    // Consumer: releases the record returned by Peek.
+    void Pop(const AsyncLogRecord* record)
+    {
+        AtomicOps<uint32_t>::Store_Release(&Tail, Tail + record->Size);
+    }
+
+    uint32_t GetHead() const    { return AtomicOps<uint32_t>::Load_Acquire(&Head); }
+    uint32_t GetTail() const    { return AtomicOps<uint32_t>::Load_Acquire(&Tail); }
+    uint32_t GetDropped() const { return Dropped; }
+
+    // Consumer: true if there is nothing to Peek, apart from padding.
+    bool IsEmpty() const        { return GetHead() == Tail; }
+    // Bytes free for the producer.
+    uint32_t GetRoom() const    { return AsyncLog::QueueSize - (GetHead() - GetTail()); }
+
+    AsyncLogDispatcher* pOwner;
+    bool                InUse;  // Owned by a running thread; guarded by the dispatcher's QueueLock
+
+private:
+    uint8_t*            Buffer;
+
+    // Kept on separate cache lines, since they are written by different threads
+    volatile uint32_t   Head;
+    volatile uint32_t   Dropped;
+    uint8_t             _PAD_0_[64 - 2 * sizeof(uint32_t)];
+    volatile uint32_t   Tail;
+    uint8_t             _PAD_1_[64 - sizeof(uint32_t)];
+};
+
+
+//-----------------------------------------------------------------------------------
+// ***** AsyncLogDispatcher
+
+static volatile bool     AsyncLogRunning = false;
+static volatile uint32_t AsyncLogGeneration = 1;    // Changes when the queues are freed
+
+static OVR_ASYNCLOG_THREAD_LOCAL AsyncLogQueue* pThreadQueue = NULL;
+static OVR_ASYNCLOG_THREAD_LOCAL uint32_t       ThreadQueueGeneration = 0;
+
+#if defined(OVR_OS_MS)
+static VOID WINAPI threadExitCallback(PVOID data);
+#else
+static void threadExitCallback(void* data);
+#endif
+
+class AsyncLogDispatcher : public NewOverrideBase, public SystemSingletonBase<AsyncLogDispatcher>
+{
+    OVR_DECLARE_SINGLETON(AsyncLogDispatcher);
+
+    class DispatchThread : public Thread
+    {
+    public:
+        DispatchThread(AsyncLogDispatcher* dispatcher) : pDispatcher(dispatcher) { }
+        virtual int Run();
+
+        AsyncLogDispatcher* pDispatcher;
+    };
+
+    // Queues are only freed with the dispatcher, so the dispatch thread reads them without the lock
+    Lock                QueueLock;
+    AsyncLogQueue*      Queues[AsyncLog::MaxQueues];
+    volatile uint32_t   QueueCount;
+    uintptr_t           ThreadKey;      // Calls threadExitCallback with the thread's queue
+    volatile bool       ShuttingDown;
+
+    Lock                ThreadLock;
+    Ptr<Thread>         pThread;
+    volatile ThreadId   DispatchThreadId;
+
+    // Used by the dispatch thread only
+    StringBuffer        Text;
+    uint64_t            ReportedDropCount;
+
+public:
+    virtual void        OnThreadDestroy();
+
+    bool                Start();
+    void                Stop();
+    void                Flush();
+
+    // Returns a queue for the calling thread, reusing one whose thread has exited.
+    AsyncLogQueue*      AcquireQueue();
+    // Called on a thread that is exiting with its queue.
+    void                ReleaseQueue(AsyncLogQueue* queue);
+    uint64_t            GetDropCount() const;
+
+    // Delivers every queued message. Returns false if there were none.
+    bool                Dispatch();
+};
+
+AsyncLogDispatcher::AsyncLogDispatcher() :
+    QueueCount(0),
+    ThreadKey(0),
+    ShuttingDown(false),
+    DispatchThreadId(0),
+    ReportedDropCount(0)
+{
+#if defined(OVR_OS_MS)
+    ThreadKey = (uintptr_t)FlsAlloc(threadExitCallback);
+#else
+    pthread_key_t key;
+    if (pthread_key_create(&key, threadExitCallback) == 0)
+    {
+        ThreadKey = (uintptr_t)key + 1;
+    }
+#endif
+
+    PushDestroyCallbacks();
+}
+
+AsyncLogDispatcher::~AsyncLogDispatcher()
+{
+    // Thread exit callbacks from here on leave the queues alone
+    ShuttingDown = true;
+
+#if defined(OVR_OS_MS)
+    if (ThreadKey != FLS_OUT_OF_INDEXES)
+        FlsFree((DWORD)ThreadKey);
+#else
+    if (ThreadKey)
+        pthread_key_delete((pthread_key_t)(ThreadKey - 1));
+#endif
+
+    for (uint32_t i = 0; i < QueueCount; i++)
+        delete Queues[i];
+
+    // Threads that logged must not use the freed queues after a new System::Init
+    AsyncLogGeneration = AsyncLogGeneration + 1;
+}
+
+void AsyncLogDispatcher::OnThreadDestroy()
+{
+    Stop();
+}
+
+void AsyncLogDispatcher::OnSystemDestroy()
+{
+    delete this;
+}
+
+int AsyncLogDispatcher::DispatchThread::Run()
+{
+    SetThreadName("OVR::AsyncLog");
+    pDispatcher->DispatchThreadId = GetCurrentThreadId();
+
+    while (!GetExitFlag())
+    {
+        if (!pDispatcher->Dispatch())
+            Thread::MSleep(2);
+    }
+
+    // Deliver what was logged before Stop
+    pDispatcher->Dispatch();
+    return 0;
+}
+
+bool AsyncLogDispatcher::Start()
+{
+    Lock::Locker locker(&ThreadLock);
+
+    if (pThread)
+        return true;
+
+    pThread = *new DispatchThread(this);
+    if (!pThread->Start())
+    {
+        pThread.Clear();
+        return false;
+    }
+
+    AsyncLogRunning = true;
+    return true;
+}
+
+void AsyncLogDispatcher::Stop()
+{
+    Lock::Locker locker(&ThreadLock);
+
+    if (!pThread)
+        return;
+
+    // New messages are logged synchronously from here on
+    AsyncLogRunning = false;
+
+    pThread->SetExitFlag(true);
+    pThread->Join();
+    pThread.Clear();
+    DispatchThreadId = 0;
+}
+
+void AsyncLogDispatcher::Flush()
+{
+    // The dispatch thread can't wait for itself, e.g. from a log observer
+    if (GetCurrentThreadId() == DispatchThreadId)
+        return;
+
+    uint32_t heads[AsyncLog::MaxQueues];
+    const uint32_t count = AtomicOps<uint32_t>::Load_Acquire(&QueueCount);
+    for (uint32_t i = 0; i < count; i++)
+        heads[i] = Queues[i]->GetHead();
+
+    while (AsyncLogRunning)
+    {
+        bool flushed = true;
+        for (uint32_t i = 0; i < count && flushed; i++)
+            flushed = (int32_t)(Queues[i]->GetTail() - heads[i]) >= 0;
+
+        if (flushed)
+            break;
+        Thread::MSleep(1);
+    }
+}
+
+AsyncLogQueue* AsyncLogDispatcher::AcquireQueue()
+{
+    AsyncLogQueue* queue = NULL;
+    {
+        Lock::Locker locker(&QueueLock);
+
+        // Take the queue of an exited thread with the most room. Its remaining messages
+        // are delivered in order with the new thread's, since records are only appended.
+        // A new queue is created instead while the best one is more than half full.
+        AsyncLogQueue* released = NULL;
+        uint32_t       room     = 0;
+        for (uint32_t i = 0; i < QueueCount; i++)
+        {
+            if (!Queues[i]->InUse && (!released || Queues[i]->GetRoom() > room))
+            {
+                released = Queues[i];
+                room     = released->GetRoom();
+            }
+        }
+
+        if (released && (room >= AsyncLog::QueueSize / 2 || QueueCount == AsyncLog::MaxQueues))
+        {
+            queue = released;
+        }
+        else if (QueueCount < AsyncLog::MaxQueues)
+        {
+            queue = new AsyncLogQueue(this);
+            Queues[QueueCount] = queue;
+            AtomicOps<uint32_t>::Store_Release(&QueueCount, QueueCount + 1);
+        }
+        else
+        {
+            return NULL;
+        }
+        queue->InUse = true;
+    }
+
+#if defined(OVR_OS_MS)
+    if (ThreadKey != FLS_OUT_OF_INDEXES)
+        FlsSetValue((DWORD)ThreadKey, queue);
+#else
+    if (ThreadKey)
+        pthread_setspecific((pthread_key_t)(ThreadKey - 1), queue);
+#endif
+
+    return queue;
+}
+
+void AsyncLogDispatcher::ReleaseQueue(AsyncLogQueue* queue)
+{
+    if (ShuttingDown)
+        return;
+
+    // Anything the thread logs after this gets a queue again
+    if (pThreadQueue == queue)
+        pThreadQueue = NULL;
+
+    Lock::Locker locker(&QueueLock);
+    queue->InUse = false;
+}
+
+#if defined(OVR_OS_MS)
+static VOID WINAPI threadExitCallback(PVOID data)
+#else
+static void threadExitCallback(void* data)
+#endif
+{
+    AsyncLogQueue* queue = (AsyncLogQueue*)data;
+    if (queue)
+    {
+        queue->pOwner->ReleaseQueue(queue);
+    }
+}
+
+uint64_t AsyncLogDispatcher::GetDropCount() const
+{
+    uint64_t       dropped = 0;
+    const uint32_t count   = AtomicOps<uint32_t>::Load_Acquire(&QueueCount);
+    for (uint32_t i = 0; i < count; i++)
+        dropped += Queues[i]->GetDropped();
+    return dropped;
+}
+
+bool AsyncLogDispatcher::Dispatch()
+{
+    const uint32_t count      = AtomicOps<uint32_t>::Load_Acquire(&QueueCount);
+    bool           dispatched = false;
+
+    // Only the queues with messages are merged; idle and released queues are skipped
+    // until the next call.
+    AsyncLogQueue* active[AsyncLog::MaxQueues];
+    uint32_t       activeCount = 0;
+    for (uint32_t i = 0; i < count; i++)
+    {
+        if (!Queues[i]->IsEmpty())
+            active[activeCount++] = Queues[i];
+    }
+
+    while (activeCount)
+    {
+        // Deliver the oldest message of all the queues first
+        AsyncLogQueue*        oldestQueue  = NULL;
+        const AsyncLogRecord* oldestRecord = NULL;
+        for (uint32_t i = 0; i < activeCount; )
+        {
+            const AsyncLogRecord* record = active[i]->Peek();
+            if (!record)
+            {
+                active[i] = active[--activeCount];
+                continue;
+            }
+            if (!oldestRecord || record->Time < oldestRecord->Time)
+            {
+                oldestQueue  = active[i];
+                oldestRecord = record;
+            }
+            i++;
+        }
+
+        if (!oldestRecord)
+            break;
+
+        const LogMessageType messageType = (LogMessageType)oldestRecord->MessageType;
+        formatRecord(oldestRecord, Text);
+        Log::LogMessageSync(messageType, "%s", Text.ToCStr());
+
+        // Only now, so that Flush doesn't return before the message is delivered
+        oldestQueue->Pop(oldestRecord);
+        dispatched = true;
+    }
+
+    const uint64_t dropCount = GetDropCount();
+    if (dropCount != ReportedDropCount)
+    {
+        Log::LogMessageSync(Log_Text, "[AsyncLog] %u messages dropped because a log queue was full\n",
+                            (unsigned)(dropCount - ReportedDropCount));
+        ReportedDropCount = dropCount;
+    }
+
+    return dispatched;
+}
+
+} // namespace OVR
+
+OVR_DEFINE_SINGLETON(AsyncLogDispatcher);
+
+namespace OVR {
+
+
+//-----------------------------------------------------------------------------------
+// ***** AsyncLog
+
+bool AsyncLog::Start()
+{
+    if (!System::IsInitialized())
+        return false;
+
+    return AsyncLogDispatcher::GetInstance()->Start();
+}
+
+void AsyncLog::Stop()
+{
+    if (AsyncLogRunning)
+        AsyncLogDispatcher::GetInstance()->Stop();
+}
+
+bool AsyncLog::IsRunning()
+{
+    return AsyncLogRunning;
+}
+
+void AsyncLog::Flush()
+{
+    if (AsyncLogRunning)
+        AsyncLogDispatcher::GetInstance()->Flush();
+}
+
+uint64_t AsyncLog::GetDropCount()
+{
+    return System::IsInitialized() ? AsyncLogDispatcher::GetInstance()->GetDropCount() : 0;
+}
+
+bool AsyncLog::Push(LogMessageType messageType, const char* fmt, va_list argList)
+{
+    if (!AsyncLogRunning)
+        return false;
+
+    AsyncLogQueue* queue = pThreadQueue;
+    if (!queue || ThreadQueueGeneration != AsyncLogGeneration)
+    {
+        // The first message from this thread
+        queue = AsyncLogDispatcher::GetInstance()->AcquireQueue();
+        if (!queue)
+            return false;
+
+        pThreadQueue          = queue;
+        ThreadQueueGeneration = AsyncLogGeneration;
+    }
+
+    uint64_t record[AsyncLogBufferSize / sizeof(uint64_t)];
+    uint32_t size = captureRecord(record, messageType, fmt, argList);
+    queue->Write(record, size);
+    return true;
+}
+
+
+} // namespace OVR
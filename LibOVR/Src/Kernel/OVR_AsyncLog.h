@@ -0,0 +1,88 @@
+/************************************************************************************
+
+Filename    :   OVR_AsyncLog.h
+Content     :   Asynchronous logging through per-thread lock-free queues
+Created     :   October 17, 2014
+Notes       :
+
+Copyright   :   Copyright 2014 Oculus VR, LLC All Rights reserved.
+
+Licensed under the Oculus VR Rift SDK License Version 3.2 (the "License");
+you may not use the Oculus VR Rift SDK except in compliance with the License,
+which is provided at the time of installation or download, or which
+otherwise accompanies this software in either electronic or hard copy form.
+
+You may obtain a copy of the License at
+
+http://www.oculusvr.com/licenses/LICENSE-3.2
+
+Unless required by applicable law or agreed to in writing, the Oculus VR SDK
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*************************************************************************************/
+
+#ifndef OVR_AsyncLog_h
+#define OVR_AsyncLog_h
+
+#include "OVR_Types.h"
+#include "OVR_Log.h"
+#include <stdarg.h>
+
+namespace OVR {
+
+
+//-----------------------------------------------------------------------------------
+// ***** AsyncLog
+
+// AsyncLog moves the formatting and output of the global logging functions (LogText,
+// LogError and the debug variants) off the threads that log. While it is running, each
+// of those calls only appends a compact record - time, message type, the raw arguments
+// and copies of the format and %s strings - to a lock-free queue owned by the calling
+// thread. A background thread merges the queues in time order, formats the messages and
+// passes them to Log::LogMessageSync, which calls the log observers and the global Log.
+//
+// A thread's queue is taken, under a lock, the first time it logs, and handed on to
+// another thread when it exits; after that logging takes no locks and doesn't allocate. A message that doesn't fit in the queue is dropped
+// and counted, and the background thread reports the count. Messages are delivered a few
+// milliseconds late, so a thread that is about to crash or exit should call Flush.
+//
+// Formats with wide strings, %n or more than MaxArguments arguments are formatted on the
+// calling thread into the record instead, still without locks or allocation.
+
+class AsyncLog
+{
+public:
+    enum
+    {
+        QueueSize       = 64 * 1024,    // Bytes of queue per logging thread
+        MaxQueues       = 64,           // Threads beyond this many at once log synchronously
+        MaxArguments    = 16,
+        MaxRecordSize   = 2048          // Longer messages and strings are truncated
+    };
+
+    // Starts the background thread. Requires System to be initialized; it is stopped
+    // automatically when System is destroyed.
+    static bool     Start();
+    // Delivers everything queued and stops the background thread.
+    static void     Stop();
+    static bool     IsRunning();
+
+    // Waits until all messages logged before the call have been delivered.
+    static void     Flush();
+
+    // Messages dropped because a queue was full, since the start of the process.
+    static uint64_t GetDropCount();
+
+    // Internal
+    // Queues the message if AsyncLog is running and returns true; otherwise returns false
+    // without using argList, and the caller logs the message itself.
+    static bool     Push(LogMessageType messageType, const char* fmt, va_list argList);
+};
+
+
+} // OVR
+
+#endif
@@ -31,6 +31,7 @@ limitations under the License.
 #include "OVR_Threads.h"
 #include "OVR_Timer.h"
 #include "OVR_Log.h"
+#include "../Tracking/Tracking_SensorState.h"
 
 namespace OVR { namespace LocklessTest {
 
@@ -200,10 +201,171 @@ class Producer : public Thread
 };
 
 
+//-------------------------------------------------------------------------------------
+// ***** Reader Benchmark
+
+// One producer publishes at roughly the IMU rate while N consumers poll as fast as
+// they can; reports reads per second per consumer and extra slot copies per read.
+
+const double BenchmarkSeconds       = 2.0;
+const double BenchmarkUpdatePeriod  = 0.001;
+const int    BenchmarkMaxConsumers  = 16;
+
+volatile bool BenchmarkStop = false;
+
+// The benchmark runs TestData through both updaters, and the sensor state through the
+// LocklessSensorState/LocklessSensorStatePadding pair the tracker publishes with.
+using Tracking::LocklessSensorState;
+using Tracking::LocklessSensorStatePadding;
+
+typedef LocklessUpdater<TestData, TestData>                                                 PlainBenchUpdater;
+typedef LocklessCacheAlignedUpdater<TestData, TestData>                                     AlignedBenchUpdater;
+typedef LocklessUpdater<LocklessSensorState, LocklessSensorStatePadding>                    PlainSensorBenchUpdater;
+typedef LocklessCacheAlignedUpdater<LocklessSensorState, LocklessSensorStatePadding>        AlignedSensorBenchUpdater;
+
+OVR_ALIGNAS(64) PlainBenchUpdater         PlainBenchData;
+OVR_ALIGNAS(64) AlignedBenchUpdater       AlignedBenchData;
+OVR_ALIGNAS(64) PlainSensorBenchUpdater   PlainSensorBenchData;
+OVR_ALIGNAS(64) AlignedSensorBenchUpdater AlignedSensorBenchData;
+
+// Fills a state with values derived from val, and checks one for consistency.
+inline void SetBenchState(TestData& d, int val)
+{
+    d.Set(val);
+}
+
+inline int CheckBenchState(const TestData& d, int prevValue)
+{
+    return d.ReadAndCheckConsistency(prevValue);
+}
+
+inline void SetBenchState(LocklessSensorState& s, int val)
+{
+    s.WorldFromImu.TimeInSeconds = (double)val;
+    s.StatusFlags                = (uint32_t)val;
+    s.LastCameraFrameCounter     = (uint32_t)val;
+}
+
+inline int CheckBenchState(const LocklessSensorState& s, int prevValue)
+{
+    const int val = (int)s.StatusFlags;
+    if ((s.WorldFromImu.TimeInSeconds != (double)val || (int)s.LastCameraFrameCounter != val) &&
+        prevValue != val)
+    {
+        LogText("LocklessTest Fail - torn sensor state %d\n", val);
+    }
+    return val;
+}
+
+
+template<class T, class UpdaterType>
+class BenchConsumer : public Thread
+{
+public:
+    BenchConsumer(const UpdaterType* updater) :
+        pUpdater(updater), Reads(0), Retries(0)
+    { }
+
+    const UpdaterType* pUpdater;
+    uint64_t           Reads;
+    uint64_t           Retries;
+
+    virtual int Run()
+    {
+        int oldValue = 0;
+
+        while (!BenchmarkStop)
+        {
+            int     retries = 0;
+            const T d       = pUpdater->GetState(&retries);
+
+            oldValue = CheckBenchState(d, oldValue);
+            Reads++;
+            Retries += retries;
+        }
+        return 0;
+    }
+};
+
+template<class T, class UpdaterType>
+class BenchProducer : public Thread
+{
+public:
+    BenchProducer(UpdaterType* updater) : pUpdater(updater) { }
+
+    UpdaterType* pUpdater;
+
+    virtual int Run()
+    {
+        double nextUpdate = Timer::GetSeconds();
+
+        for (int testVal = 0; !BenchmarkStop; testVal++)
+        {
+            T d;
+            SetBenchState(d, testVal);
+            pUpdater->SetState(d);
+
+            // Busy-wait rather than sleep to keep the update period tight
+            nextUpdate += BenchmarkUpdatePeriod;
+            while (!BenchmarkStop && Timer::GetSeconds() < nextUpdate)
+            {
+                Dummy2 = testVal;
+            }
+        }
+        return 0;
+    }
+};
+
+template<class T, class UpdaterType>
+void RunReaderBenchmark(const char* name, UpdaterType* updater)
+{
+    for (int consumerCount = 1; consumerCount <= BenchmarkMaxConsumers; consumerCount *= 2)
+    {
+        Ptr<BenchConsumer<T, UpdaterType> > consumers[BenchmarkMaxConsumers];
+        Ptr<BenchProducer<T, UpdaterType> > producer = *new BenchProducer<T, UpdaterType>(updater);
+
+        BenchmarkStop = false;
+        producer->Start();
+        for (int i = 0; i < consumerCount; i++)
+        {
+            consumers[i] = *new BenchConsumer<T, UpdaterType>(updater);
+            consumers[i]->Start();
+        }
+
+        Thread::MSleep((unsigned)(BenchmarkSeconds * 1000));
+        BenchmarkStop = true;
+
+        producer->Join();
+        uint64_t reads = 0, retries = 0;
+        for (int i = 0; i < consumerCount; i++)
+        {
+            consumers[i]->Join();
+            reads   += consumers[i]->Reads;
+            retries += consumers[i]->Retries;
+        }
+
+        LogText("LocklessBenchmark %-18s %2d consumers: %12.0f reads/s per consumer, %8.5f retries/read\n",
+                name, consumerCount,
+                (double)reads / (BenchmarkSeconds * consumerCount),
+                reads ? (double)retries / (double)reads : 0.0);
+    }
+}
+
+
 } // namespace LocklessTest
 
 
 
+void StartLocklessBenchmark()
+{
+    using namespace LocklessTest;
+    RunReaderBenchmark<TestData>("Updater", &PlainBenchData);
+    RunReaderBenchmark<TestData>("CacheAligned", &AlignedBenchData);
+    RunReaderBenchmark<LocklessSensorState>("SensorUpdater", &PlainSensorBenchData);
+    RunReaderBenchmark<LocklessSensorState>("SensorCacheAligned", &AlignedSensorBenchData);
+}
+
+
 void StartLocklessTest()
 {
     // These threads will release themselves once done
@@ -59,13 +59,15 @@ public:
         OVR_COMPILER_ASSERT(sizeof(T) <= sizeof(SlotType));
     }
 
-	T GetState() const
+	// retryCount, if provided, receives the number of extra slot copies this read needed.
+	T GetState(int* retryCount = NULL) const
 	{
 		// Copy the state out, then retry with the alternate slot
 		// if we determine that our copy may have been partially
 		// stepped on by a new update.
 		T	state;
 		int	begin, end, final;
+		int	retries = 0;
 
 		for(;;)
 		{
@@ -80,6 +82,7 @@ public:
 
 			// The producer is potentially blocked while only having partially
 			// written the update, so copy out the other slot.
+			retries++;
             state = Slots[ (begin & 1) ^ 1 ];
             final = UpdateBegin.Load_Acquire();
 			if ( final == begin ) {
@@ -88,6 +91,10 @@ public:
 
 			// The producer completed the last update and started a new one before
 			// we got it copied out, so try fetching the current buffer again.
+			retries++;
+		}
+		if ( retryCount ) {
+			*retryCount = retries;
 		}
 		return state;
 	}
@@ -106,8 +113,291 @@ public:
 };
 
 
+// ***** LocklessCacheAlignedUpdater
+
+// Same single producer protocol as LocklessUpdater, laid out for many concurrent
+// consumers, typically other processes polling shared memory at IMU rates.
+//
+// Each counter and each slot occupies its own cache line(s), so consumers spinning
+// on UpdateEnd do not keep invalidating the line the producer is writing slot data
+// into, and reading the counters never shares a line with the slot payload.  The
+// layout is padded explicitly rather than with alignment specifiers so that it is
+// identical for 32-bit and 64-bit processes; place the object at a cache line
+// aligned address (shared memory mappings always are) to get the full benefit.
+//
+// The copy out of a slot goes through T's assignment from SlotType, so only the
+// data words are moved when SlotType is a larger padded type.
+// Not layout compatible with LocklessUpdater.
+
+static const int LocklessCacheLineSize = 64;
+
+// Pads Type up to a multiple of the cache line size.
+template<class Type, int PadBytes = (LocklessCacheLineSize - (int)(sizeof(Type) % LocklessCacheLineSize)) % LocklessCacheLineSize>
+struct LocklessCacheLinePadded
+{
+    Type    Value;
+    uint8_t _PAD_[PadBytes];
+};
+
+template<class Type>
+struct LocklessCacheLinePadded<Type, 0>
+{
+    Type    Value;
+};
+
+template<class T, class SlotType>
+class LocklessCacheAlignedUpdater
+{
+public:
+    LocklessCacheAlignedUpdater()
+    {
+        OVR_COMPILER_ASSERT(sizeof(T) <= sizeof(SlotType));
+        OVR_COMPILER_ASSERT(sizeof(Counter) % LocklessCacheLineSize == 0);
+        OVR_COMPILER_ASSERT(sizeof(Slot) % LocklessCacheLineSize == 0);
+
+        UpdateBegin.Value.Store_Release(0);
+        UpdateEnd.Value.Store_Release(0);
+    }
+
+    // retryCount, if provided, receives the number of extra slot copies this read needed.
+    T GetState(int* retryCount = NULL) const
+    {
+        T   state;
+        int begin, end, final;
+        int retries = 0;
+
+        for(;;)
+        {
+            end   = UpdateEnd.Value.Load_Acquire();
+            state = Slots[end & 1].Value;
+            begin = UpdateBegin.Value.Load_Acquire();
+            if (begin == end)
+            {
+                break;
+            }
+
+            // The producer is potentially blocked while only having partially
+            // written the update, so copy out the other slot.
+            retries++;
+            state = Slots[(begin & 1) ^ 1].Value;
+            final = UpdateBegin.Value.Load_Acquire();
+            if (final == begin)
+            {
+                break;
+            }
+
+            // The producer completed the last update and started a new one before
+            // we got it copied out, so try fetching the current buffer again.
+            retries++;
+        }
+
+        if (retryCount)
+        {
+            *retryCount = retries;
+        }
+        return state;
+    }
+
+    void SetState(const T& state)
+    {
+        // Single producer: nobody else writes the counters, so a plain load suffices.
+        // The full barrier on the begin marker keeps the slot stores behind it.
+        const int next = UpdateBegin.Value.Load_Acquire() + 1;
+        UpdateBegin.Value.Exchange_Sync(next);
+        Slots[next & 1].Value = state;
+        UpdateEnd.Value.Store_Release(next);
+    }
+
+protected:
+    typedef LocklessCacheLinePadded< AtomicInt<int> > Counter;
+    typedef LocklessCacheLinePadded< SlotType >       Slot;
+
+    Counter UpdateBegin;
+    Counter UpdateEnd;
+    Slot    Slots[2];
+};
+
+
+// ***** LocklessHistory
+
+// For single producer cases where consumers need to look back in time rather than
+// only at the most recent update (pose interpolation for timewarp and late latching).
+// The last Capacity updates are retained in a ring, each tagged with a timestamp.
+//
+// Every slot carries its own sequence number, so a consumer only ever validates the
+// slot it copied: it is not forced to retry because the producer started writing
+// some other slot, which is what happens to LocklessUpdater readers when updates
+// arrive faster than a copy completes.
+//
+// Like LocklessUpdater, the layout is fixed-size and suitable for shared memory
+// between 32-bit and 64-bit processes.  Capacity must be a power of two so that the
+// 32-bit update counter wraps cleanly onto slot indices.
+
+template<class T, class SlotType, int Capacity>
+class LocklessHistory
+{
+public:
+    LocklessHistory() : UpdateCount(0), _PAD_0_(0)
+    {
+        OVR_COMPILER_ASSERT(sizeof(T) <= sizeof(SlotType));
+        OVR_COMPILER_ASSERT(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0);
+
+        for (int i = 0; i < Capacity; ++i)
+        {
+            Slots[i].Sequence.Store_Release(0);
+            Slots[i]._PAD_0_       = 0;
+            Slots[i].TimeInSeconds = 0.0;
+        }
+    }
+
+    // Producer: appends a state, overwriting the oldest one once the ring is full.
+    // Timestamps are expected to be non-decreasing.
+    void Push(const T& state, double timeInSeconds)
+    {
+        const uint32_t index = UpdateCount.Load_Acquire();
+        Slot&          slot  = Slots[index & (Capacity - 1)];
+
+        // An odd sequence marks the slot as being written.  The full barrier keeps
+        // the data stores below from becoming visible before the marker.
+        slot.Sequence.Exchange_Sync(index * 2 + 1);
+        slot.TimeInSeconds = timeInSeconds;
+        slot.Data          = state;
+        slot.Sequence.Store_Release(index * 2 + 2);
+
+        UpdateCount.Store_Release(index + 1);
+    }
+
+    // Number of updates pushed so far (wraps at 2^32).
+    // Update indices in [count - Capacity + 1, count - 1] are normally readable;
+    // the oldest of the Capacity slots is the next one the producer overwrites.
+    uint32_t GetUpdateCount() const
+    {
+        return UpdateCount.Load_Acquire();
+    }
+
+    // Copies out the update with the given index.  Returns false if that update has
+    // not been published yet or has already been overwritten by the producer.
+    bool GetState(uint32_t index, T& state, double* timeInSeconds = NULL) const
+    {
+        const Slot&    slot     = Slots[index & (Capacity - 1)];
+        const uint32_t expected = index * 2 + 2;
+
+        if (slot.Sequence.Load_Acquire() != expected)
+        {
+            return false;
+        }
+
+        const double time = slot.TimeInSeconds;
+        state = slot.Data;
+
+        if (slot.Sequence.Load_Acquire() != expected)
+        {
+            return false;
+        }
+
+        if (timeInSeconds)
+        {
+            *timeInSeconds = time;
+        }
+        return true;
+    }
+
+    // Reads only the timestamp of an update; same validation rules as GetState().
+    bool GetTime(uint32_t index, double& timeInSeconds) const
+    {
+        const Slot&    slot     = Slots[index & (Capacity - 1)];
+        const uint32_t expected = index * 2 + 2;
+
+        if (slot.Sequence.Load_Acquire() != expected)
+        {
+            return false;
+        }
+
+        const double time = slot.TimeInSeconds;
+
+        if (slot.Sequence.Load_Acquire() != expected)
+        {
+            return false;
+        }
+
+        timeInSeconds = time;
+        return true;
+    }
+
+    // Finds the two consecutive updates whose timestamps bracket absoluteTime, so
+    // that olderTime <= absoluteTime <= newerTime, and copies both of them out.
+    // Returns false if absoluteTime is outside of the retained history (the caller
+    // should extrapolate from the latest state instead) or if the producer lapped
+    // the search before the copies completed.
+    bool GetBracketingStates(double absoluteTime,
+                             T& older, double& olderTime,
+                             T& newer, double& newerTime) const
+    {
+        const uint32_t count = GetUpdateCount();
+        if (count < 2)
+        {
+            return false;
+        }
+
+        // Oldest index that the producer is not about to overwrite.
+        const uint32_t available = (count < (uint32_t)Capacity) ? count : (uint32_t)(Capacity - 1);
+        uint32_t       lo        = count - available;
+        uint32_t       hi        = count - 1;
+        double         loTime, hiTime;
+
+        if (!GetTime(lo, loTime) || !GetTime(hi, hiTime) ||
+            absoluteTime < loTime || absoluteTime > hiTime)
+        {
+            return false;
+        }
+
+        // Binary search for the last update at or before absoluteTime.
+        // Invariant: time(lo) <= absoluteTime <= time(hi).
+        while (hi - lo > 1)
+        {
+            const uint32_t mid = lo + (hi - lo) / 2;
+            double         midTime;
+
+            if (!GetTime(mid, midTime))
+            {
+                return false;
+            }
+
+            if (midTime <= absoluteTime)
+            {
+                lo = mid;
+            }
+            else
+            {
+                hi = mid;
+            }
+        }
+
+        return GetState(lo, older, &olderTime) &&
+               GetState(hi, newer, &newerTime);
+    }
+
+protected:
+    struct Slot
+    {
+        AtomicInt<uint32_t> Sequence;   // 2*index+1 while being written, 2*index+2 when complete
+        uint32_t            _PAD_0_;
+        double              TimeInSeconds;
+        SlotType            Data;
+    };
+
+    AtomicInt<uint32_t> UpdateCount;
+    uint32_t            _PAD_0_;
+    Slot                Slots[Capacity];
+};
+
+
 #ifdef OVR_LOCKLESS_TEST
 void StartLocklessTest();
+
+// Measures reader throughput and retry rates of LocklessUpdater versus
+// LocklessCacheAlignedUpdater with one producer and 1-16 consumers.
+void StartLocklessBenchmark();
 #endif
 
 
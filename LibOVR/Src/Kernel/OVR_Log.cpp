@@ -25,6 +25,7 @@ limitations under the License.
 ************************************************************************************/
 
 #include "OVR_Log.h"
+#include "OVR_AsyncLog.h"
 #include "OVR_Std.h"
 #include <stdarg.h>
 #include <stdio.h>
@@ -333,37 +334,46 @@ Log* Log::GetDefaultLog()
 //-----------------------------------------------------------------------------------
 // ***** Global Logging functions
 
+// Passes a message to the observers and the global log on the calling thread.
+static void logMessageSyncVarg(LogMessageType messageType, const char* fmt, va_list argList)
+{
+    if (OVR_GlobalLog)
+    {
 #if !defined(OVR_CC_MSVC)
-// The reason for va_copy is because you can't use va_start twice on Linux
-#define OVR_LOG_FUNCTION_IMPL(Name)  \
-    void Log##Name(const char* fmt, ...) \
-    {                                                                    \
-        if (OVR_GlobalLog)                                               \
-        {                                                                \
-            va_list argList1;                                             \
-            va_start(argList1, fmt);                                     \
-            va_list argList2;                                             \
-            va_copy(argList2, argList1);                                 \
-            OVR_GlobalLog->LogMessageVargInt(Log_##Name, fmt, argList2); \
-            va_end(argList2);                                             \
-            OVR_GlobalLog->LogMessageVarg(Log_##Name, fmt, argList1);    \
-            va_end(argList1);                                            \
-        }                                                                \
-    }
+        // The reason for va_copy is because you can't use a va_list twice on Linux
+        va_list argList2;
+        va_copy(argList2, argList);
+        OVR_GlobalLog->LogMessageVargInt(messageType, fmt, argList2);
+        va_end(argList2);
 #else
+        OVR_GlobalLog->LogMessageVargInt(messageType, fmt, argList);
+#endif
+        OVR_GlobalLog->LogMessageVarg(messageType, fmt, argList);
+    }
+}
+
+//static
+void Log::LogMessageSync(LogMessageType messageType, const char* fmt, ...)
+{
+    va_list argList;
+    va_start(argList, fmt);
+    logMessageSyncVarg(messageType, fmt, argList);
+    va_end(argList);
+}
+
+// While AsyncLog is running, the message is queued for its thread instead.
 #define OVR_LOG_FUNCTION_IMPL(Name)  \
     void Log##Name(const char* fmt, ...) \
     {                                                                    \
         if (OVR_GlobalLog)                                               \
         {                                                                \
-            va_list argList1;                                             \
-            va_start(argList1, fmt);                                     \
-            OVR_GlobalLog->LogMessageVargInt(Log_##Name, fmt, argList1); \
-            OVR_GlobalLog->LogMessageVarg(Log_##Name, fmt, argList1);    \
-            va_end(argList1);                                            \
+            va_list argList;                                             \
+            va_start(argList, fmt);                                      \
+            if (!AsyncLog::Push(Log_##Name, fmt, argList))               \
+                logMessageSyncVarg(Log_##Name, fmt, argList);            \
+            va_end(argList);                                             \
         }                                                                \
     }
-#endif // #if !defined(OVR_OS_WIN32)
 
 OVR_LOG_FUNCTION_IMPL(Text)
 OVR_LOG_FUNCTION_IMPL(Error)
@@ -124,6 +124,8 @@ public:
 	// Internal
 	// Invokes observers, then calls LogMessageVarg()
 	static void    LogMessageVargInt(LogMessageType messageType, const char* fmt, va_list argList);
+	// Invokes observers and the global log on the calling thread, bypassing AsyncLog
+	static void    LogMessageSync(LogMessageType messageType, const char* fmt, ...) OVR_LOG_VAARG_ATTRIBUTE(2, 3);
 
     // This virtual function receives all the messages,
     // developers should override this function in order to do custom logging
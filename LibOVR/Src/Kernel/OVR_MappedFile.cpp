@@ -0,0 +1,198 @@
+/************************************************************************************
+
+Filename    :   OVR_MappedFile.cpp
+Content     :   Read-only memory mapping of a whole file
+Created     :   October 17, 2014
+Notes       :
+
+Copyright   :   Copyright 2014 Oculus VR, LLC All Rights reserved.
+
+Licensed under the Oculus VR Rift SDK License Version 3.2 (the "License");
+you may not use the Oculus VR Rift SDK except in compliance with the License,
+which is provided at the time of installation or download, or which
+otherwise accompanies this software in either electronic or hard copy form.
+
+You may obtain a copy of the License at
+
+http://www.oculusvr.com/licenses/LICENSE-3.2
+
+Unless required by applicable law or agreed to in writing, the Oculus VR SDK
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+************************************************************************************/
+
+#include "OVR_MappedFile.h"
+#include "OVR_UTF8Util.h"
+
+#if defined(OVR_OS_MS)
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <stdio.h>
+#endif
+
+namespace OVR {
+
+
+//-----------------------------------------------------------------------------
+// ***** MappedFile
+
+MappedFile::MappedFile() :
+#if defined(OVR_OS_MS)
+    hFile(INVALID_HANDLE_VALUE),
+    hMapping(NULL),
+#endif
+    pData(NULL),
+    Size(0)
+{
+}
+
+MappedFile::~MappedFile()
+{
+    Close();
+}
+
+#if defined(OVR_OS_MS)
+
+// Wide copy of a UTF8 path, freed with OVR_FREE
+static wchar_t* DecodePath(const String& path)
+{
+    wchar_t* pwpath = (wchar_t*)OVR_ALLOC((UTF8Util::GetLength(path.ToCStr()) + 1) * sizeof(wchar_t));
+    if (pwpath)
+        UTF8Util::DecodeString(pwpath, path.ToCStr());
+    return pwpath;
+}
+
+bool MappedFile::Open(const String& path)
+{
+    Close();
+
+    wchar_t* pwpath = DecodePath(path);
+    if (!pwpath)
+        return false;
+    hFile = CreateFileW(pwpath, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                        NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    OVR_FREE(pwpath);
+    if (hFile == INVALID_HANDLE_VALUE)
+        return false;
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(hFile, &size) || size.QuadPart == 0 || size.HighPart != 0)
+    {
+        Close();
+        return false;
+    }
+
+    hMapping = CreateFileMappingW(hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (hMapping != NULL)
+        pData = (const uint8_t*)MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0);
+    if (pData == NULL)
+    {
+        Close();
+        return false;
+    }
+
+    Size = (size_t)size.QuadPart;
+    return true;
+}
+
+void MappedFile::Close()
+{
+    if (pData)
+        UnmapViewOfFile(pData);
+    if (hMapping != NULL)
+        CloseHandle(hMapping);
+    if (hFile != INVALID_HANDLE_VALUE)
+        CloseHandle(hFile);
+
+    hFile    = INVALID_HANDLE_VALUE;
+    hMapping = NULL;
+    pData    = NULL;
+    Size     = 0;
+}
+
+bool ReplaceFileWith(const String& path, const String& newPath)
+{
+    wchar_t* pwpath = DecodePath(path);
+    wchar_t* pwnew  = DecodePath(newPath);
+
+    bool result = pwpath && pwnew && MoveFileExW(pwnew, pwpath, MOVEFILE_REPLACE_EXISTING) != 0;
+    if (!result && pwnew)
+        DeleteFileW(pwnew);
+
+    OVR_FREE(pwpath);
+    OVR_FREE(pwnew);
+    return result;
+}
+
+bool RemoveFile(const String& path)
+{
+    wchar_t* pwpath = DecodePath(path);
+    bool result = pwpath && DeleteFileW(pwpath) != 0;
+    OVR_FREE(pwpath);
+    return result;
+}
+
+#else
+
+bool MappedFile::Open(const String& path)
+{
+    Close();
+
+    int fd = open(path.ToCStr(), O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    struct stat fileStat;
+    if (fstat(fd, &fileStat) != 0 || fileStat.st_size <= 0 || (uint64_t)fileStat.st_size > 0xFFFFFFFFu)
+    {
+        close(fd);
+        return false;
+    }
+
+    void* data = mmap(NULL, (size_t)fileStat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED)
+        return false;
+
+    pData = (const uint8_t*)data;
+    Size  = (size_t)fileStat.st_size;
+    return true;
+}
+
+void MappedFile::Close()
+{
+    if (pData)
+        munmap((void*)pData, Size);
+
+    pData = NULL;
+    Size  = 0;
+}
+
+bool ReplaceFileWith(const String& path, const String& newPath)
+{
+    // Processes that have the old file mapped keep it, since rename() only moves the name
+    if (rename(newPath.ToCStr(), path.ToCStr()) != 0)
+    {
+        unlink(newPath.ToCStr());
+        return false;
+    }
+    return true;
+}
+
+bool RemoveFile(const String& path)
+{
+    return unlink(path.ToCStr()) == 0;
+}
+
+#endif
+
+
+} // namespace OVR
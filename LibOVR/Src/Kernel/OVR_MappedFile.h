@@ -0,0 +1,81 @@
+/************************************************************************************
+
+PublicHeader:   Kernel
+Filename    :   OVR_MappedFile.h
+Content     :   Read-only memory mapping of a whole file
+Created     :   October 17, 2014
+Notes       :
+
+Copyright   :   Copyright 2014 Oculus VR, LLC All Rights reserved.
+
+Licensed under the Oculus VR Rift SDK License Version 3.2 (the "License");
+you may not use the Oculus VR Rift SDK except in compliance with the License,
+which is provided at the time of installation or download, or which
+otherwise accompanies this software in either electronic or hard copy form.
+
+You may obtain a copy of the License at
+
+http://www.oculusvr.com/licenses/LICENSE-3.2
+
+Unless required by applicable law or agreed to in writing, the Oculus VR SDK
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+************************************************************************************/
+
+#ifndef OVR_MappedFile_h
+#define OVR_MappedFile_h
+
+#include "OVR_Types.h"
+#include "OVR_Allocator.h"
+#include "OVR_String.h"
+
+namespace OVR {
+
+
+//-----------------------------------------------------------------------------
+// ***** MappedFile
+
+// Maps a whole file read-only, for formats that are used in place rather than read
+// into memory.  Other processes may go on reading, replacing or deleting the file while
+// it is mapped; on Windows a replaced or deleted file keeps its name until it is closed.
+// Empty files and files of 4GB or more can't be mapped.
+class MappedFile : public NewOverrideBase
+{
+    OVR_NON_COPYABLE(MappedFile);
+
+public:
+    MappedFile();
+    ~MappedFile();
+
+    bool            Open(const String& path);
+    void            Close();
+
+    bool            IsOpen() const  { return pData != NULL; }
+    const uint8_t*  GetData() const { return pData; }
+    size_t          GetSize() const { return Size; }
+
+protected:
+#if defined(OVR_OS_MS)
+    void*           hFile;          // HANDLE
+    void*           hMapping;
+#endif
+    const uint8_t*  pData;
+    size_t          Size;
+};
+
+
+// Moves a newly written file over path.  The old file stays intact for processes that
+// have it mapped, although on Windows that makes the move fail.  The new file is
+// removed if it can't be moved.
+bool ReplaceFileWith(const String& path, const String& newPath);
+
+// Deletes a file.  Returns false if it doesn't exist or can't be deleted.
+bool RemoveFile(const String& path);
+
+
+} // namespace OVR
+
+#endif // OVR_MappedFile_h
@@ -201,6 +201,7 @@ class Math<float>
 {
 public:
      typedef double OtherFloatType;
+     static inline float MaxValue() { return MATH_FLOAT_MAXVALUE; }
 };
 
 // Double-precision Math constants class.
@@ -209,6 +210,7 @@ class Math<double>
 {
 public:
     typedef float OtherFloatType;
+    static inline double MaxValue() { return MATH_DOUBLE_MAXVALUE; }
 };
 
 
@@ -743,8 +745,8 @@ public:
 
 	void Clear()
 	{
-		b[0].x = b[0].y = b[0].z = Math<T>::MaxValue;
-		b[1].x = b[1].y = b[1].z = -Math<T>::MaxValue;
+		b[0].x = b[0].y = b[0].z = Math<T>::MaxValue();
+		b[1].x = b[1].y = b[1].z = -Math<T>::MaxValue();
 	}
 
 	void AddPoint( const Vector3<T> & v )
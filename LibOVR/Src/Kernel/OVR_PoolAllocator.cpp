@@ -0,0 +1,734 @@
+/************************************************************************************
+
+Filename    :   OVR_PoolAllocator.cpp
+Content     :   Allocator with per-thread size-class caches and frame arenas
+Created     :   October 17, 2014
+Notes       :
+
+Copyright   :   Copyright 2014 Oculus VR, LLC All Rights reserved.
+
+Licensed under the Oculus VR Rift SDK License Version 3.2 (the "License");
+you may not use the Oculus VR Rift SDK except in compliance with the License,
+which is provided at the time of installation or download, or which
+otherwise accompanies this software in either electronic or hard copy form.
+
+You may obtain a copy of the License at
+
+http://www.oculusvr.com/licenses/LICENSE-3.2
+
+Unless required by applicable law or agreed to in writing, the Oculus VR SDK
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*************************************************************************************/
+
+#include "OVR_PoolAllocator.h"
+#include "OVR_Timer.h"
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(OVR_OS_MS)
+ #include <malloc.h>
+ #include <Windows.h>
+#elif defined(OVR_OS_MAC)
+ #include <malloc/malloc.h>
+ #include <pthread.h>
+ #include <sys/mman.h>
+#else
+ #include <malloc.h>
+ #include <pthread.h>
+ #include <sys/mman.h>
+#endif
+
+#if defined(OVR_CC_MSVC)
+    #define OVR_POOL_THREAD_LOCAL __declspec(thread)
+#else
+    #define OVR_POOL_THREAD_LOCAL __thread
+#endif
+
+namespace OVR {
+
+
+//-----------------------------------------------------------------------------------
+// ***** Size classes
+
+// Every class is a multiple of 16; from 128 on, classes are spaced by a quarter of the
+// previous power of two, which bounds the rounding waste to 25%.
+static const uint32_t SizeClassSizes[] =
+{
+      16,   32,   48,   64,   80,   96,  112,  128,
+     160,  192,  224,  256,  320,  384,  448,  512,
+     640,  768,  896, 1024, 1280, 1536, 1792, 2048,
+    2560, 3072, 3584, 4096
+};
+
+static const int SizeClassCount = sizeof(SizeClassSizes) / sizeof(SizeClassSizes[0]);
+
+OVR_COMPILER_ASSERT(SizeClassCount <= PoolAllocatorStats::MaxSizeClasses);
+
+// Size class of each size in 16 byte steps, up to MaxPoolSize
+static uint8_t SizeClassIndex[PoolAllocator::MaxPoolSize / 16 + 1];
+
+// Blocks moved between a thread cache and the central list at a time
+static uint32_t SizeClassBatch[SizeClassCount];
+
+static void initSizeClasses()
+{
+    int sizeClass = 0;
+    for (int i = 0; i <= PoolAllocator::MaxPoolSize / 16; i++)
+    {
+        while (SizeClassSizes[sizeClass] < (uint32_t)i * 16)
+            sizeClass++;
+        SizeClassIndex[i] = (uint8_t)sizeClass;
+    }
+
+    for (int i = 0; i < SizeClassCount; i++)
+    {
+        const uint32_t batch = 8192 / SizeClassSizes[i];
+        SizeClassBatch[i] = (batch < 4) ? 4 : (batch > 64) ? 64 : batch;
+    }
+}
+
+static inline int getSizeClass(size_t size)
+{
+    return SizeClassIndex[(size + 15) >> 4];
+}
+
+
+//-----------------------------------------------------------------------------------
+// ***** Platform helpers
+
+// Address range to commit spans from, or NULL.
+static uint8_t* reserveRegion(size_t size)
+{
+#if defined(OVR_OS_MS)
+    return (uint8_t*)VirtualAlloc(NULL, size, MEM_RESERVE, PAGE_NOACCESS);
+#else
+    int flags = MAP_PRIVATE | MAP_ANON;
+    #if defined(MAP_NORESERVE)
+        flags |= MAP_NORESERVE;
+    #endif
+    void* result = mmap(NULL, size, PROT_NONE, flags, -1, 0);
+    return (result == MAP_FAILED) ? NULL : (uint8_t*)result;
+#endif
+}
+
+static bool commitRegion(uint8_t* p, size_t size)
+{
+#if defined(OVR_OS_MS)
+    return VirtualAlloc(p, size, MEM_COMMIT, PAGE_READWRITE) != NULL;
+#else
+    return mprotect(p, size, PROT_READ | PROT_WRITE) == 0;
+#endif
+}
+
+static void releaseRegion(uint8_t* p, size_t size)
+{
+#if defined(OVR_OS_MS)
+    OVR_UNUSED(size);
+    VirtualFree(p, 0, MEM_RELEASE);
+#else
+    munmap(p, size);
+#endif
+}
+
+// Bytes the heap actually set aside for a malloc block.
+static size_t getHeapBlockSize(void* p)
+{
+#if defined(OVR_OS_MS)
+    return _msize(p);
+#elif defined(OVR_OS_MAC)
+    return malloc_size(p);
+#else
+    return malloc_usable_size(p);
+#endif
+}
+
+
+//-----------------------------------------------------------------------------------
+// ***** ThreadCache
+
+struct FrameChunk
+{
+    FrameChunk* pNext;
+    size_t      Size;
+};
+
+struct PoolAllocator::ThreadCache
+{
+    struct ClassCache
+    {
+        void*       Head;       // Free blocks, linked through their first word
+        uint32_t    Count;
+        uint64_t    Allocs;
+        uint64_t    Frees;
+    };
+
+    PoolAllocator*  pOwner;
+    ThreadCache*    pNext;
+    bool            InUse;      // Caches of exited threads are reused
+
+    ClassCache      Classes[SizeClassCount];
+
+    uint64_t        LargeAllocs;
+    uint64_t        LargeBytesAllocated;
+    uint64_t        LargeBytesFreed;
+
+    // Frame arena; the newest chunk is first
+    FrameChunk*     pFrameChunks;
+    uint8_t*        pFrameCurrent;
+    uint8_t*        pFrameEnd;
+    size_t          FrameBytes;
+};
+
+static volatile uint32_t PoolAllocatorGeneration = 0;
+
+static OVR_POOL_THREAD_LOCAL PoolAllocator::ThreadCache* pThreadCache = NULL;
+static OVR_POOL_THREAD_LOCAL uint32_t                    ThreadCacheGeneration = 0;
+
+#if defined(OVR_OS_MS)
+static VOID WINAPI threadExitCallback(PVOID data)
+#else
+static void threadExitCallback(void* data)
+#endif
+{
+    PoolAllocator::ThreadCache* cache = (PoolAllocator::ThreadCache*)data;
+    if (cache)
+    {
+        cache->pOwner->ReleaseThreadCache(cache);
+    }
+}
+
+
+//-----------------------------------------------------------------------------------
+// ***** PoolAllocator
+
+PoolAllocator::PoolAllocator() :
+    pRegion(NULL),
+    RegionSize(0),
+    RegionUsed(0),
+    SpanClasses(NULL),
+    pCaches(NULL),
+    ThreadKey(0),
+    ShuttingDown(false)
+{
+    initSizeClasses();
+
+    for (int i = 0; i < SizeClassCount; i++)
+    {
+        Central[i].Head  = NULL;
+        Central[i].Count = 0;
+        Central[i].Spans = 0;
+    }
+
+    Generation = AtomicOps<uint32_t>::ExchangeAdd_Sync(&PoolAllocatorGeneration, 1) + 1;
+
+#if defined(OVR_OS_MS)
+    ThreadKey = (uintptr_t)FlsAlloc(threadExitCallback);
+#else
+    pthread_key_t key;
+    if (pthread_key_create(&key, threadExitCallback) == 0)
+    {
+        ThreadKey = (uintptr_t)key + 1;
+    }
+#endif
+
+    // Address space is cheap on 64 bit systems; take less of it elsewhere, and less
+    // again if that fails. Without a region everything goes to malloc.
+#if defined(OVR_64BIT_POINTERS)
+    size_t regionSize = (size_t)4 << 30;
+#else
+    size_t regionSize = (size_t)256 << 20;
+#endif
+    for (; regionSize >= ((size_t)16 << 20); regionSize /= 2)
+    {
+        SpanClasses = (uint8_t*)malloc(regionSize >> SpanShift);
+        pRegion     = SpanClasses ? reserveRegion(regionSize) : NULL;
+        if (pRegion)
+        {
+            RegionSize = regionSize;
+            break;
+        }
+        free(SpanClasses);
+        SpanClasses = NULL;
+    }
+}
+
+PoolAllocator::~PoolAllocator()
+{
+    // Thread exit callbacks from here on leave the caches alone
+    ShuttingDown = true;
+
+#if defined(OVR_OS_MS)
+    if (ThreadKey != FLS_OUT_OF_INDEXES)
+        FlsFree((DWORD)ThreadKey);
+#else
+    if (ThreadKey)
+        pthread_key_delete((pthread_key_t)(ThreadKey - 1));
+#endif
+
+    while (pCaches)
+    {
+        ThreadCache* cache = pCaches;
+        pCaches = cache->pNext;
+
+        while (cache->pFrameChunks)
+        {
+            FrameChunk* chunk = cache->pFrameChunks;
+            cache->pFrameChunks = chunk->pNext;
+            free(chunk);
+        }
+        free(cache);
+    }
+
+    if (pRegion)
+        releaseRegion(pRegion, RegionSize);
+    free(SpanClasses);
+}
+
+PoolAllocator::ThreadCache* PoolAllocator::getThreadCache()
+{
+    ThreadCache* cache = pThreadCache;
+    if (cache && ThreadCacheGeneration == Generation)
+        return cache;
+    return createThreadCache();
+}
+
+PoolAllocator::ThreadCache* PoolAllocator::createThreadCache()
+{
+    ThreadCache* cache = NULL;
+    {
+        Lock::Locker locker(&CacheLock);
+
+        for (cache = pCaches; cache && cache->InUse; cache = cache->pNext)
+            ;
+
+        if (!cache)
+        {
+            // From malloc, since it may be needed to allocate anything
+            cache = (ThreadCache*)malloc(sizeof(ThreadCache));
+            if (!cache)
+                return NULL;
+
+            memset(cache, 0, sizeof(ThreadCache));
+            cache->pOwner = this;
+            cache->pNext  = pCaches;
+            pCaches       = cache;
+        }
+
+        cache->InUse = true;
+    }
+
+    pThreadCache          = cache;
+    ThreadCacheGeneration = Generation;
+
+#if defined(OVR_OS_MS)
+    if (ThreadKey != FLS_OUT_OF_INDEXES)
+        FlsSetValue((DWORD)ThreadKey, cache);
+#else
+    if (ThreadKey)
+        pthread_setspecific((pthread_key_t)(ThreadKey - 1), cache);
+#endif
+
+    return cache;
+}
+
+void PoolAllocator::ReleaseThreadCache(ThreadCache* cache)
+{
+    if (ShuttingDown)
+        return;
+
+    for (int i = 0; i < SizeClassCount; i++)
+    {
+        if (cache->Classes[i].Count)
+            releaseToCentral(cache, i, cache->Classes[i].Count);
+    }
+
+    while (cache->pFrameChunks)
+    {
+        FrameChunk* chunk = cache->pFrameChunks;
+        cache->pFrameChunks = chunk->pNext;
+        free(chunk);
+    }
+    cache->pFrameCurrent = NULL;
+    cache->pFrameEnd     = NULL;
+    cache->FrameBytes    = 0;
+
+    // Called on the exiting thread; anything it frees after this gets a new cache.
+    // The counts stay with the cache, so its next thread continues them.
+    if (pThreadCache == cache)
+        pThreadCache = NULL;
+
+    Lock::Locker locker(&CacheLock);
+    cache->InUse = false;
+}
+
+// Takes a batch of blocks from the central list into the cache, carving a new span
+// if the list is empty, and returns one of them.
+void* PoolAllocator::allocFromCentral(ThreadCache* cache, int sizeClass)
+{
+    CentralList&   central = Central[sizeClass];
+    const uint32_t size    = SizeClassSizes[sizeClass];
+
+    Lock::Locker locker(&central.ListLock);
+
+    if (central.Count == 0)
+    {
+        uint8_t* span = NULL;
+        {
+            Lock::Locker regionLocker(&RegionLock);
+            if (RegionUsed + SpanSize <= RegionSize && commitRegion(pRegion + RegionUsed, SpanSize))
+            {
+                span = pRegion + RegionUsed;
+                SpanClasses[RegionUsed >> SpanShift] = (uint8_t)sizeClass;
+                RegionUsed += SpanSize;
+            }
+        }
+        if (!span)
+            return NULL;
+
+        const uint32_t count = SpanSize / size;
+        for (uint32_t i = 0; i < count - 1; i++)
+            *(void**)(span + i * size) = span + (i + 1) * size;
+        *(void**)(span + (count - 1) * size) = central.Head;
+
+        central.Head   = span;
+        central.Count += count;
+        central.Spans++;
+    }
+
+    uint32_t batch = SizeClassBatch[sizeClass];
+    if (batch > central.Count)
+        batch = central.Count;
+
+    void* block = central.Head;
+    void* last  = block;
+    for (uint32_t i = 1; i < batch; i++)
+        last = *(void**)last;
+
+    central.Head   = *(void**)last;
+    central.Count -= batch;
+
+    ThreadCache::ClassCache& classCache = cache->Classes[sizeClass];
+    *(void**)last   = classCache.Head;
+    classCache.Head = *(void**)block;
+    classCache.Count += batch - 1;
+    return block;
+}
+
+// Moves count blocks from the front of the cache to the central list.
+void PoolAllocator::releaseToCentral(ThreadCache* cache, int sizeClass, uint32_t count)
+{
+    ThreadCache::ClassCache& classCache = cache->Classes[sizeClass];
+
+    void* first = classCache.Head;
+    void* last  = first;
+    for (uint32_t i = 1; i < count; i++)
+        last = *(void**)last;
+
+    classCache.Head   = *(void**)last;
+    classCache.Count -= count;
+
+    CentralList& central = Central[sizeClass];
+    Lock::Locker locker(&central.ListLock);
+    *(void**)last  = central.Head;
+    central.Head   = first;
+    central.Count += count;
+}
+
+void* PoolAllocator::allocBlock(int sizeClass)
+{
+    ThreadCache* cache = getThreadCache();
+    if (!cache)
+        return NULL;
+
+    ThreadCache::ClassCache& classCache = cache->Classes[sizeClass];
+    void* block = classCache.Head;
+    if (block)
+    {
+        classCache.Head = *(void**)block;
+        classCache.Count--;
+    }
+    else
+    {
+        block = allocFromCentral(cache, sizeClass);
+        if (!block)
+            return NULL;
+    }
+
+    classCache.Allocs++;
+    return block;
+}
+
+void* PoolAllocator::allocLarge(ThreadCache* cache, size_t size)
+{
+    void* p = malloc(size ? size : 1);
+    if (p && cache)
+    {
+        cache->LargeAllocs++;
+        cache->LargeBytesAllocated += getHeapBlockSize(p);
+    }
+    return p;
+}
+
+void PoolAllocator::freeLarge(ThreadCache* cache, void* p)
+{
+    if (cache)
+        cache->LargeBytesFreed += getHeapBlockSize(p);
+    free(p);
+}
+
+void* PoolAllocator::Alloc(size_t size)
+{
+    if (size <= MaxPoolSize && pRegion)
+    {
+        void* p = allocBlock(getSizeClass(size));
+        if (p)
+            return p;
+    }
+    return allocLarge(getThreadCache(), size);
+}
+
+void* PoolAllocator::Realloc(void* p, size_t newSize)
+{
+    if (!p)
+        return Alloc(newSize);
+
+    if (ownsBlock(p))
+    {
+        // Blocks never shrink, so a smaller size always keeps the block
+        const size_t size = SizeClassSizes[getBlockClass(p)];
+        if (newSize <= size)
+            return p;
+
+        void* newP = Alloc(newSize);
+        if (newP)
+        {
+            memcpy(newP, p, size);
+            Free(p);
+        }
+        return newP;
+    }
+
+    // realloc may free the block for a size of 0, but Realloc must not
+    ThreadCache* cache = getThreadCache();
+    const size_t oldHeapSize = getHeapBlockSize(p);
+    void* newP = realloc(p, newSize ? newSize : 1);
+    if (newP && cache)
+    {
+        cache->LargeBytesFreed     += oldHeapSize;
+        cache->LargeBytesAllocated += getHeapBlockSize(newP);
+    }
+    return newP;
+}
+
+void PoolAllocator::Free(void* p)
+{
+    if (!p)
+        return;
+
+    ThreadCache* cache = getThreadCache();
+
+    if (!ownsBlock(p))
+    {
+        freeLarge(cache, p);
+        return;
+    }
+
+    const int sizeClass = getBlockClass(p);
+    if (!cache)
+    {
+        CentralList& central = Central[sizeClass];
+        Lock::Locker locker(&central.ListLock);
+        *(void**)p   = central.Head;
+        central.Head = p;
+        central.Count++;
+        return;
+    }
+
+    ThreadCache::ClassCache& classCache = cache->Classes[sizeClass];
+    *(void**)p      = classCache.Head;
+    classCache.Head = p;
+    classCache.Count++;
+    classCache.Frees++;
+
+    // Keep a batch for the next allocations and pass the rest on to other threads
+    const uint32_t batch = SizeClassBatch[sizeClass];
+    if (classCache.Count > 2 * batch)
+        releaseToCentral(cache, sizeClass, batch);
+}
+
+void* PoolAllocator::AllocAligned(size_t size, size_t align)
+{
+    OVR_ASSERT((align & (align-1)) == 0);
+
+    // A class whose size is a multiple of align has aligned blocks
+    if (size <= MaxPoolSize && pRegion)
+    {
+        for (int sizeClass = getSizeClass(size); sizeClass < SizeClassCount; sizeClass++)
+        {
+            if ((SizeClassSizes[sizeClass] & (align - 1)) == 0)
+            {
+                void* p = allocBlock(sizeClass);
+                if (p)
+                    return p;
+                break;
+            }
+        }
+    }
+
+    // Otherwise pad a large allocation as Allocator::AllocAligned does
+    align = (align > sizeof(size_t)) ? align : sizeof(size_t);
+    size_t p = (size_t)allocLarge(getThreadCache(), size + align);
+    size_t aligned = 0;
+    if (p)
+    {
+        aligned = (p + align - 1) & ~(align - 1);
+        if (aligned == p)
+            aligned += align;
+        *(((size_t*)aligned) - 1) = aligned - p;
+    }
+    return (void*)aligned;
+}
+
+void PoolAllocator::FreeAligned(void* p)
+{
+    if (!p)
+        return;
+
+    if (ownsBlock(p))
+    {
+        Free(p);
+        return;
+    }
+
+    freeLarge(getThreadCache(), (void*)(size_t(p) - *(((size_t*)p) - 1)));
+}
+
+void* PoolAllocator::AllocFrame(size_t size, size_t align)
+{
+    OVR_ASSERT((align & (align-1)) == 0);
+
+    ThreadCache* cache = getThreadCache();
+    if (!cache)
+        return NULL;
+
+    uint8_t* p = (uint8_t*)(((size_t)cache->pFrameCurrent + align - 1) & ~(align - 1));
+    if (!cache->pFrameCurrent || p > cache->pFrameEnd || size > (size_t)(cache->pFrameEnd - p))
+    {
+        size_t chunkSize = sizeof(FrameChunk) + size + align;
+        if (chunkSize < FrameChunkSize)
+            chunkSize = FrameChunkSize;
+
+        FrameChunk* chunk = (FrameChunk*)malloc(chunkSize);
+        if (!chunk)
+            return NULL;
+
+        chunk->pNext        = cache->pFrameChunks;
+        chunk->Size         = chunkSize;
+        cache->pFrameChunks = chunk;
+        cache->pFrameEnd    = (uint8_t*)chunk + chunkSize;
+        cache->FrameBytes  += chunkSize;
+
+        p = (uint8_t*)(((size_t)(chunk + 1) + align - 1) & ~(align - 1));
+    }
+
+    cache->pFrameCurrent = p + size;
+    return p;
+}
+
+void PoolAllocator::ResetFrame()
+{
+    ThreadCache* cache = getThreadCache();
+    if (!cache || !cache->pFrameChunks)
+        return;
+
+    // A frame that needed several chunks gets one chunk as large as all of them, so the
+    // next frame like it allocates nothing. The arena only grows, to the largest frame.
+    FrameChunk* chunk = cache->pFrameChunks;
+    if (chunk->pNext)
+    {
+        const size_t mergedSize = cache->FrameBytes;
+
+        while (cache->pFrameChunks)
+        {
+            chunk = cache->pFrameChunks;
+            cache->pFrameChunks = chunk->pNext;
+            free(chunk);
+        }
+        cache->FrameBytes    = 0;
+        cache->pFrameCurrent = NULL;
+        cache->pFrameEnd     = NULL;
+
+        // Without it, AllocFrame starts over with chunks of the default size
+        chunk = (FrameChunk*)malloc(mergedSize);
+        if (!chunk)
+            return;
+
+        chunk->pNext      = NULL;
+        chunk->Size       = mergedSize;
+        cache->FrameBytes = mergedSize;
+    }
+
+    cache->pFrameChunks  = chunk;
+    cache->pFrameCurrent = (uint8_t*)(chunk + 1);
+    cache->pFrameEnd     = (uint8_t*)chunk + chunk->Size;
+}
+
+void PoolAllocator::GetStats(PoolAllocatorStats* stats)
+{
+    memset(stats, 0, sizeof(PoolAllocatorStats));
+    stats->Time           = Timer::GetSeconds();
+    stats->SizeClassCount = SizeClassCount;
+
+    uint64_t largeBytesAllocated = 0;
+    uint64_t largeBytesFreed     = 0;
+    {
+        Lock::Locker locker(&CacheLock);
+        for (ThreadCache* cache = pCaches; cache; cache = cache->pNext)
+        {
+            for (int i = 0; i < SizeClassCount; i++)
+            {
+                stats->SizeClasses[i].Allocs += cache->Classes[i].Allocs;
+                stats->SizeClasses[i].Frees  += cache->Classes[i].Frees;
+            }
+            stats->LargeAllocs         += cache->LargeAllocs;
+            stats->FrameBytesReserved  += cache->FrameBytes;
+            largeBytesAllocated        += cache->LargeBytesAllocated;
+            largeBytesFreed            += cache->LargeBytesFreed;
+        }
+    }
+
+    for (int i = 0; i < SizeClassCount; i++)
+    {
+        PoolAllocatorStats::SizeClass& sizeClass = stats->SizeClasses[i];
+        sizeClass.BlockSize     = SizeClassSizes[i];
+        sizeClass.BytesInUse    = (size_t)(sizeClass.Allocs - sizeClass.Frees) * sizeClass.BlockSize;
+        sizeClass.BytesReserved = (size_t)Central[i].Spans * SpanSize;
+
+        stats->BytesInUse    += sizeClass.BytesInUse;
+        stats->BytesReserved += sizeClass.BytesReserved;
+    }
+
+    stats->LargeBytesInUse = (size_t)(largeBytesAllocated - largeBytesFreed);
+    stats->BytesInUse     += stats->LargeBytesInUse;
+    stats->BytesReserved  += stats->LargeBytesInUse;
+}
+
+
+//-----------------------------------------------------------------------------------
+// ***** PoolAllocatorStats
+
+double PoolAllocatorStats::GetAllocRate(const PoolAllocatorStats& earlier, int sizeClass) const
+{
+    const double elapsed = Time - earlier.Time;
+    if (elapsed <= 0. || sizeClass < 0 || sizeClass >= SizeClassCount)
+        return 0.;
+
+    return (double)(SizeClasses[sizeClass].Allocs - earlier.SizeClasses[sizeClass].Allocs) / elapsed;
+}
+
+
+} // OVR
@@ -0,0 +1,166 @@
+/************************************************************************************
+
+Filename    :   OVR_PoolAllocator.h
+Content     :   Allocator with per-thread size-class caches and frame arenas
+Created     :   October 17, 2014
+Notes       :
+
+Copyright   :   Copyright 2014 Oculus VR, LLC All Rights reserved.
+
+Licensed under the Oculus VR Rift SDK License Version 3.2 (the "License");
+you may not use the Oculus VR Rift SDK except in compliance with the License,
+which is provided at the time of installation or download, or which
+otherwise accompanies this software in either electronic or hard copy form.
+
+You may obtain a copy of the License at
+
+http://www.oculusvr.com/licenses/LICENSE-3.2
+
+Unless required by applicable law or agreed to in writing, the Oculus VR SDK
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*************************************************************************************/
+
+#ifndef OVR_PoolAllocator_h
+#define OVR_PoolAllocator_h
+
+#include "OVR_Allocator.h"
+#include "OVR_Atomic.h"
+
+namespace OVR {
+
+
+//-----------------------------------------------------------------------------------
+// ***** PoolAllocatorStats
+
+struct PoolAllocatorStats
+{
+    enum { MaxSizeClasses = 32 };
+
+    struct SizeClass
+    {
+        size_t      BlockSize;
+        uint64_t    Allocs;         // Since the allocator was created
+        uint64_t    Frees;
+        size_t      BytesInUse;     // BlockSize for each block allocated and not freed
+        size_t      BytesReserved;  // Spans given to this size class
+    };
+
+    double      Time;               // Timer::GetSeconds() when the stats were taken
+    size_t      BytesInUse;         // Pool blocks and large allocations
+    size_t      BytesReserved;      // Committed spans and large allocations
+    uint64_t    LargeAllocs;
+    size_t      LargeBytesInUse;    // Allocations above MaxPoolSize, as the heap reports them
+    size_t      FrameBytesReserved; // Held by the frame arenas of all threads
+    int         SizeClassCount;
+    SizeClass   SizeClasses[MaxSizeClasses];
+
+    // Allocations per second of a size class between earlier stats and these.
+    double      GetAllocRate(const PoolAllocatorStats& earlier, int sizeClass) const;
+};
+
+
+//-----------------------------------------------------------------------------------
+// ***** PoolAllocator
+
+// PoolAllocator is an Allocator for long-running processes that make many small
+// allocations, such as the JSON nodes, Strings and reference counted objects of LibOVR.
+// Allocations up to MaxPoolSize are rounded up to one of a few size classes and carved
+// from 64 KB spans of a single reserved address range, each span holding blocks of one
+// class, so blocks of different sizes don't fragment each other. Each thread keeps a
+// short free list per class and takes and returns blocks in batches from lists shared
+// by all threads, so most allocations take no lock. Larger allocations go to malloc.
+//
+// Blocks are aligned to the largest power of two that divides their size class, so
+// AllocAligned up to MaxPoolSize picks a suitably aligned class instead of padding.
+//
+// Each thread also has a frame arena: AllocFrame returns memory that stays valid until
+// the thread calls ResetFrame, for temporaries that live no longer than a frame. That
+// memory must not be passed to Free. ResetFrame keeps enough memory for the largest
+// frame so far in one chunk, so steady frames don't allocate from the system.
+//
+// Only one PoolAllocator should exist at a time. Install it through System::Init:
+//
+//     System::Init(Log::ConfigureDefaultLog(), PoolAllocator::InitSystemSingleton());
+
+class PoolAllocator : public Allocator_SingletonSupport<PoolAllocator>
+{
+public:
+    enum
+    {
+        SpanShift       = 16,
+        SpanSize        = 1 << SpanShift,
+        MaxPoolSize     = 4096,             // Larger allocations go to malloc
+        FrameChunkSize  = 64 * 1024         // Default size of the frame arena's chunks
+    };
+
+    PoolAllocator();
+    virtual ~PoolAllocator();
+
+    virtual void*   Alloc(size_t size);
+    virtual void*   Realloc(void* p, size_t newSize);
+    virtual void    Free(void* p);
+
+    virtual void*   AllocAligned(size_t size, size_t align);
+    virtual void    FreeAligned(void* p);
+
+    // Memory from the calling thread's frame arena, valid until it calls ResetFrame.
+    void*           AllocFrame(size_t size, size_t align = 16);
+    // Releases everything the calling thread allocated with AllocFrame.
+    void            ResetFrame();
+
+    // Gathers the counts of all threads; approximate while other threads allocate.
+    void            GetStats(PoolAllocatorStats* stats);
+
+    // Internal
+    struct ThreadCache;
+    void            ReleaseThreadCache(ThreadCache* cache);
+
+private:
+    struct CentralList
+    {
+        Lock        ListLock;
+        void*       Head;
+        uint32_t    Count;
+        uint32_t    Spans;
+    };
+
+    ThreadCache*    getThreadCache();
+    ThreadCache*    createThreadCache();
+    void*           allocBlock(int sizeClass);
+    void*           allocFromCentral(ThreadCache* cache, int sizeClass);
+    void            releaseToCentral(ThreadCache* cache, int sizeClass, uint32_t count);
+    void*           allocLarge(ThreadCache* cache, size_t size);
+    void            freeLarge(ThreadCache* cache, void* p);
+    bool            ownsBlock(const void* p) const
+    {
+        return (size_t)((const uint8_t*)p - pRegion) < RegionSize;
+    }
+    int             getBlockClass(const void* p) const
+    {
+        return SpanClasses[(size_t)((const uint8_t*)p - pRegion) >> SpanShift];
+    }
+
+    // Reserved address range from which spans are committed
+    uint8_t*        pRegion;
+    size_t          RegionSize;
+    size_t          RegionUsed;
+    Lock            RegionLock;
+    uint8_t*        SpanClasses;            // Size class of each span
+
+    CentralList     Central[PoolAllocatorStats::MaxSizeClasses];
+
+    Lock            CacheLock;
+    ThreadCache*    pCaches;                // Every cache created, in use or not
+    uint32_t        Generation;             // Tells apart allocators at the same address
+    uintptr_t       ThreadKey;              // Notifies of thread exit
+    volatile bool   ShuttingDown;
+};
+
+
+} // OVR
+
+#endif
@@ -34,27 +34,39 @@ namespace OVR { namespace Net {
 
 static const int LENGTH_FIELD_BYTES = 4;
 
+// Initial receive ring size; it grows to fit the largest message received.
+static const uint32_t RECV_RING_INITIAL_SIZE = 16 * 1024;
+
 
 //-----------------------------------------------------------------------------
 // PacketizedTCPSocket
 
 PacketizedTCPSocket::PacketizedTCPSocket()
 {
-	pRecvBuff = 0;
-	pRecvBuffSize = 0;
+	pRecvRing = 0;
+	RecvRingSize = 0;
+	RecvHead = 0;
+	RecvTail = 0;
+	pRecvScratch = 0;
+	RecvScratchSize = 0;
 	Transport = TransportType_PacketizedTCP;
 }
 
 PacketizedTCPSocket::PacketizedTCPSocket(SocketHandle _sock, bool isListenSocket) : PacketizedTCPSocketBase(_sock, isListenSocket)
 {
-	pRecvBuff = 0;
-	pRecvBuffSize = 0;
+	pRecvRing = 0;
+	RecvRingSize = 0;
+	RecvHead = 0;
+	RecvTail = 0;
+	pRecvScratch = 0;
+	RecvScratchSize = 0;
 	Transport = TransportType_PacketizedTCP;
 }
 
 PacketizedTCPSocket::~PacketizedTCPSocket()
 {
-	OVR_FREE(pRecvBuff);
+	OVR_FREE(pRecvRing);
+	OVR_FREE(pRecvScratch);
 }
 
 int PacketizedTCPSocket::Send(const void* pData, int bytes)
@@ -118,97 +130,167 @@ int PacketizedTCPSocket::SendAndConcatenate(const void** pDataArray, int* dataLe
 	return s;
 }
 
+bool PacketizedTCPSocket::growRecvRing(uint32_t minSize)
+{
+	uint32_t newSize = RecvRingSize ? RecvRingSize : RECV_RING_INITIAL_SIZE;
+	while (newSize < minSize)
+	{
+		if (newSize >= 0x40000000)
+			return false;
+		newSize <<= 1;
+	}
+	if (newSize == RecvRingSize)
+		return true;
+
+	uint8_t* pNewRing = (uint8_t*)OVR_ALLOC(newSize);
+	if (!pNewRing)
+		return false;
+
+	// Unwrap the queued data to the start of the new ring
+	uint32_t queued = RecvTail - RecvHead;
+	if (queued > 0)
+	{
+		uint32_t mask  = RecvRingSize - 1;
+		uint32_t start = RecvHead & mask;
+		uint32_t first = (queued < RecvRingSize - start) ? queued : (RecvRingSize - start);
+		memcpy(pNewRing, pRecvRing + start, first);
+		memcpy(pNewRing + first, pRecvRing, queued - first);
+	}
+
+	OVR_FREE(pRecvRing);
+	pRecvRing = pNewRing;
+	RecvRingSize = newSize;
+	RecvHead = 0;
+	RecvTail = queued;
+	return true;
+}
+
+uint32_t PacketizedTCPSocket::peekRecvRingLength() const
+{
+	// The length field itself may wrap
+	uint8_t lengthBytes[LENGTH_FIELD_BYTES];
+	uint32_t mask = RecvRingSize - 1;
+	for (int i = 0; i < LENGTH_FIELD_BYTES; i++)
+		lengthBytes[i] = pRecvRing[(RecvHead + i) & mask];
+
+	return (uint32_t)lengthBytes[0] | ((uint32_t)lengthBytes[1] << 8) | ((uint32_t)lengthBytes[2] << 16) | ((uint32_t)lengthBytes[3] << 24);
+}
+
+uint8_t* PacketizedTCPSocket::GetRecvBuffer(int* pCapacity)
+{
+	Lock::Locker locker(&recvBuffLock);
+
+	// When the ring is full of a partial message, make room for the rest of it
+	if (RecvTail - RecvHead == RecvRingSize && !growRecvRing(RecvRingSize * 2))
+	{
+		*pCapacity = 0;
+		return NULL;
+	}
+	if (!pRecvRing && !growRecvRing(RECV_RING_INITIAL_SIZE))
+	{
+		*pCapacity = 0;
+		return NULL;
+	}
+
+	// Largest contiguous free span after the tail
+	uint32_t mask   = RecvRingSize - 1;
+	uint32_t offset = RecvTail & mask;
+	uint32_t unused = RecvRingSize - (RecvTail - RecvHead);
+	uint32_t span   = RecvRingSize - offset;
+
+	*pCapacity = (int)(unused < span ? unused : span);
+	return pRecvRing + offset;
+}
+
 void PacketizedTCPSocket::OnRecv(SocketEvent_TCP* eventHandler, uint8_t* pData, int bytesRead)
 {
-	uint8_t* dataSource = NULL;
-	int dataSourceSize = 0;
+	Lock::Locker locker(&recvBuffLock);
 
-	recvBuffLock.DoLock();
+	if (bytesRead <= 0)
+		return;
 
-	if (pRecvBuff == NULL)
+	if (pRecvRing && pData == pRecvRing + (RecvTail & (RecvRingSize - 1)))
 	{
-		dataSource = pData;
-		dataSourceSize = bytesRead;
+		// Received in place by the poller, via GetRecvBuffer()
+		RecvTail += (uint32_t)bytesRead;
 	}
 	else
 	{
-		uint8_t* pRecvBuffNew = (uint8_t*)OVR_REALLOC(pRecvBuff, bytesRead + pRecvBuffSize);
-		if (!pRecvBuffNew)
+		// Received into some other buffer; queue a copy
+		uint32_t queued = RecvTail - RecvHead;
+		if (!growRecvRing(queued + (uint32_t)bytesRead))
 		{
-			OVR_FREE(pRecvBuff);
-			pRecvBuff = NULL;
-			pRecvBuffSize = 0;
-			recvBuffLock.Unlock();
+			// Out of memory: the stream can no longer be framed, so drop what we have
+			RecvHead = RecvTail = 0;
 			return;
 		}
-		else
-		{
-			pRecvBuff = pRecvBuffNew;
-
-			memcpy(pRecvBuff + pRecvBuffSize, pData, bytesRead);
 
-			dataSourceSize = pRecvBuffSize + bytesRead;
-			dataSource = pRecvBuff;
-		}
+		uint32_t mask   = RecvRingSize - 1;
+		uint32_t offset = RecvTail & mask;
+		uint32_t first  = ((uint32_t)bytesRead < RecvRingSize - offset) ? (uint32_t)bytesRead : (RecvRingSize - offset);
+		memcpy(pRecvRing + offset, pData, first);
+		memcpy(pRecvRing, pData + first, bytesRead - first);
+		RecvTail += (uint32_t)bytesRead;
 	}
 
-	int bytesReadFromStream;
-	while (bytesReadFromStream = BytesFromStream(dataSource, dataSourceSize),
-		   LENGTH_FIELD_BYTES + bytesReadFromStream <= dataSourceSize)
+	// Hand out every complete message
+	while (RecvTail - RecvHead >= (uint32_t)LENGTH_FIELD_BYTES)
 	{
-		dataSource += LENGTH_FIELD_BYTES;
-		dataSourceSize -= LENGTH_FIELD_BYTES;
+		uint32_t messageBytes = peekRecvRingLength();
+		uint32_t frameBytes   = LENGTH_FIELD_BYTES + messageBytes;
 
-		TCPSocket::OnRecv(eventHandler, dataSource, bytesReadFromStream);
+		if (RecvTail - RecvHead < frameBytes)
+		{
+			// Incomplete; make sure the whole message will fit before receiving more
+			if (frameBytes > RecvRingSize && !growRecvRing(frameBytes))
+			{
+				RecvHead = RecvTail = 0;
+			}
+			break;
+		}
 
-		dataSource += bytesReadFromStream;
-		dataSourceSize -= bytesReadFromStream;
-	}
+		uint32_t mask  = RecvRingSize - 1;
+		uint32_t start = (RecvHead + LENGTH_FIELD_BYTES) & mask;
+		uint8_t* pMessage;
 
-	if (dataSourceSize > 0)
-	{
-        if (dataSource != NULL)
-        {
-            if (pRecvBuff == NULL)
-            {
-                pRecvBuff = (uint8_t*)OVR_ALLOC(dataSourceSize);
-                if (!pRecvBuff)
-                {
-                    pRecvBuffSize = 0;
-                    recvBuffLock.Unlock();
-                    return;
-                }
-                else
-                {
-                    memcpy(pRecvBuff, dataSource, dataSourceSize);
-                }
-            }
-            else
-            {
-                memmove(pRecvBuff, dataSource, dataSourceSize);
-            }
-        }
-	}
-	else
-	{
-		if (pRecvBuff != NULL)
-			OVR_FREE(pRecvBuff);
+		if (start + messageBytes <= RecvRingSize)
+		{
+			pMessage = pRecvRing + start;
+		}
+		else
+		{
+			// The message wraps around the end of the ring; this is the only case that copies
+			if (RecvScratchSize < (int)messageBytes)
+			{
+				uint8_t* pNewScratch = (uint8_t*)OVR_REALLOC(pRecvScratch, messageBytes);
+				if (!pNewScratch)
+				{
+					RecvHead = RecvTail = 0;
+					break;
+				}
+				pRecvScratch = pNewScratch;
+				RecvScratchSize = (int)messageBytes;
+			}
+
+			uint32_t first = RecvRingSize - start;
+			memcpy(pRecvScratch, pRecvRing + start, first);
+			memcpy(pRecvScratch + first, pRecvRing, messageBytes - first);
+			pMessage = pRecvScratch;
+		}
 
-		pRecvBuff = NULL;
-	}
-	pRecvBuffSize = dataSourceSize;
+		// The message stays valid for the duration of the call; nothing is received
+		// into the ring until OnRecv returns.
+		TCPSocket::OnRecv(eventHandler, pMessage, (int)messageBytes);
 
-	recvBuffLock.Unlock();
-}
+		RecvHead += frameBytes;
+	}
 
-int PacketizedTCPSocket::BytesFromStream(uint8_t* pData, int bytesRead)
-{
-	if (pData != 0 && bytesRead >= LENGTH_FIELD_BYTES)
+	// Start over at the beginning of the ring whenever it empties, so that the next
+	// receive gets the largest contiguous span and messages rarely wrap.
+	if (RecvHead == RecvTail)
 	{
-		return pData[0] | ((uint32_t)pData[1] << 8) | ((uint32_t)pData[2] << 16) | ((uint32_t)pData[3] << 24);
+		RecvHead = RecvTail = 0;
 	}
-
-	return 0;
 }
 
 
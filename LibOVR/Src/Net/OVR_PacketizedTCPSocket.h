@@ -71,14 +71,24 @@ public:
 
 protected:
 	virtual void OnRecv(SocketEvent_TCP* eventHandler, uint8_t* pData, int bytesRead);
+	virtual uint8_t* GetRecvBuffer(int* pCapacity);
 
-	int BytesFromStream(uint8_t* pData, int bytesRead);
+	bool growRecvRing(uint32_t minSize);
+	uint32_t peekRecvRingLength() const;
 
     Lock   sendLock;
     Lock   recvBuffLock;
 
-	uint8_t* pRecvBuff;     // Queued receive buffered data
-	int    pRecvBuffSize; // Size of receive queue in bytes
+	// Received data is queued in a ring buffer that the poller receives into directly.
+	// Messages are handed to the event handler in place; only messages that wrap around
+	// the end of the ring are copied, into pRecvScratch. Head and tail are free-running
+	// byte counts, masked by the ring size (a power of two) to get offsets.
+	uint8_t* pRecvRing;
+	uint32_t RecvRingSize;
+	uint32_t RecvHead;       // First byte not yet handed out
+	uint32_t RecvTail;       // One past the last byte received
+	uint8_t* pRecvScratch;
+	int      RecvScratchSize;
 };
 
 
@@ -40,56 +40,354 @@ enum {
 	CALL_BLOCKING,
 	RPC_ERROR_FUNCTION_NOT_REGISTERED,
 	ID_RPC4_RETURN,
+
+	// Same as the above, followed by a uint32_t request ID. Needs RPCCapability_TaggedCalls
+	CALL_TAGGED,
+	RPC_ERROR_TAGGED_FUNCTION_NOT_REGISTERED,
+	ID_RPC4_TAGGED_RETURN,
+
+	// Need RPCCapability_NameIDs
+	ID_RPC4_NAME_TABLE,		// uint16_t count, then count (uint16_t ID, String name) pairs
+	ID_RPC4_SIGNAL_BY_ID,	// Same as ID_RPC4_SIGNAL, with a uint16_t ID instead of the name
+	CALL_TAGGED_BY_ID,		// Same as CALL_TAGGED, with a uint16_t ID instead of the name
 };
 
+// Older peers only understand untagged calls, which they answer in the order received
+static bool SupportsTaggedCalls(const Connection* conn)
+{
+	return (conn->RemoteCapabilities & RPCCapability_TaggedCalls) != 0;
+}
+
+static bool SupportsNameIDs(const Connection* conn)
+{
+	return (conn->RemoteCapabilities & RPCCapability_NameIDs) != 0;
+}
+
+
+//-----------------------------------------------------------------------------
+// RPCCall
+
+RPCCall::RPCCall(const String& uniqueID, Connection* conn, RPCCompletionDelegate completion) :
+	UniqueID(uniqueID),
+	RequestID(0),
+	Tagged(true),
+	pConnection(conn),
+	State(State_Pending),
+	Completion(completion)
+{
+}
+
+bool RPCCall::Wait(unsigned delayMs)
+{
+	return DoneEvent.Wait(delayMs);
+}
+
 
 //-----------------------------------------------------------------------------
 // RPC1
 
 RPC1::RPC1()
 {
-	blockingOnThisConnection = 0;
-	blockingReturnValue = new BitStream();
+	nextRequestID = 0;
 }
 
 RPC1::~RPC1()
 {
 	slotHash.Clear();
-	delete blockingReturnValue;
+
+	for (unsigned i = 0; i < remoteIDTables.GetSize(); ++i)
+	{
+		delete remoteIDTables[i];
+	}
+
+	// Release anyone still waiting
+	Lock::Locker locker(&pendingCallsLock);
+	for (unsigned i = 0; i < pendingCalls.GetSize(); ++i)
+	{
+		finishCall(pendingCalls[i], NULL);
+	}
+	pendingCalls.Clear();
 }
 
 void RPC1::RegisterSlot(OVR::String sharedIdentifier,  OVR::Observer<RPCSlot>* rpcSlotObserver )
 {
 	slotHash.AddObserverToSubject(sharedIdentifier, rpcSlotObserver);
+
+	bool isNew;
+	uint16_t id;
+	{
+		Lock::Locker locker(&registrationLock);
+		id = internName(sharedIdentifier, &isNew);
+		localEntries[id].Slot = slotHash.GetSubject(sharedIdentifier);
+	}
+
+	if (isNew)
+	{
+		announceName(id);
+	}
 }
 
 bool RPC1::RegisterBlockingFunction(OVR::String uniqueID, RPCDelegate blockingFunction)
 {
-	if (registeredBlockingFunctions.Get(uniqueID))
-		return false;
+	bool isNew;
+	uint16_t id;
+	{
+		Lock::Locker locker(&registrationLock);
 
-	registeredBlockingFunctions.Set(uniqueID, blockingFunction);
+		uint16_t* existing = localIDs.Get(uniqueID);
+		if (existing && localEntries[*existing].Function.IsValid())
+			return false;
+
+		id = internName(uniqueID, &isNew);
+		localEntries[id].Function = blockingFunction;
+	}
+
+	if (isNew)
+	{
+		announceName(id);
+	}
 	return true;
 }
 
 void RPC1::UnregisterBlockingFunction(OVR::String uniqueID)
 {
-	registeredBlockingFunctions.Remove(uniqueID);
+	// The ID stays reserved for the name, as peers may already know it
+	Lock::Locker locker(&registrationLock);
+
+	uint16_t* id = localIDs.Get(uniqueID);
+	if (id)
+	{
+		localEntries[*id].Function.Invalidate();
+	}
+}
+
+// Returns the ID of a name, assigning a new one if needed. Must hold registrationLock
+uint16_t RPC1::internName(const String& name, bool* isNew)
+{
+	uint16_t* existing = localIDs.Get(name);
+	*isNew = (existing == NULL);
+	if (existing)
+	{
+		return *existing;
+	}
+
+	OVR_ASSERT(localEntries.GetSize() < 0xFFFF);
+	uint16_t id = (uint16_t)localEntries.GetSize();
+
+	LocalEntry entry;
+	entry.Name = name;
+	entry.Function.Invalidate();
+	localEntries.PushBack(entry);
+	localIDs.Set(name, id);
+	return id;
+}
+
+// Tells peers that are already connected about a new name. Anyone connecting later gets the whole table
+void RPC1::announceName(uint16_t id)
+{
+	if (!pSession)
+	{
+		return;
+	}
+
+	OVR::Net::BitStream out;
+	{
+		Lock::Locker locker(&registrationLock);
+		writeNameTable(out, id, id + 1);
+	}
+
+	// Only peers that exchange name tables want to hear about it
+	const int connectionCount = pSession->GetConnectionCount();
+	for (int i = 0; i < connectionCount; ++i)
+	{
+		Ptr<Connection> conn = pSession->GetConnectionAtIndex(i);
+		if (conn && SupportsNameIDs(conn))
+		{
+			SendParameters sp(conn, out.GetData(), out.GetNumberOfBytesUsed());
+			pSession->Send(&sp);
+		}
+	}
+}
+
+bool RPC1::getLocalEntry(uint16_t id, LocalEntry* entry)
+{
+	Lock::Locker locker(&registrationLock);
+
+	if (id >= localEntries.GetSize())
+	{
+		return false;
+	}
+
+	entry->Function = localEntries[id].Function;
+	entry->Slot = localEntries[id].Slot;
+	return true;
+}
+
+bool RPC1::getLocalEntry(const String& name, LocalEntry* entry)
+{
+	Lock::Locker locker(&registrationLock);
+
+	uint16_t* id = localIDs.Get(name);
+	if (!id)
+	{
+		return false;
+	}
+
+	entry->Function = localEntries[*id].Function;
+	entry->Slot = localEntries[*id].Slot;
+	return true;
+}
+
+bool RPC1::getRemoteID(Connection* conn, const String& name, uint16_t* id)
+{
+	Lock::Locker locker(&remoteIDsLock);
+
+	for (unsigned i = 0; i < remoteIDTables.GetSize(); ++i)
+	{
+		if (remoteIDTables[i]->pConnection == conn)
+		{
+			uint16_t* remoteID = remoteIDTables[i]->IDs.Get(name);
+			if (remoteID)
+			{
+				*id = *remoteID;
+				return true;
+			}
+			break;
+		}
+	}
+
+	return false;
+}
+
+// Writes the names with IDs in [firstID, endID). Must hold registrationLock
+void RPC1::writeNameTable(OVR::Net::BitStream& out, unsigned firstID, unsigned endID)
+{
+	out.Write((MessageID) OVRID_RPC1);
+	out.Write((MessageID) ID_RPC4_NAME_TABLE);
+	out.Write((uint16_t)(endID - firstID));
+	for (unsigned id = firstID; id < endID; ++id)
+	{
+		out.Write((uint16_t)id);
+		out.Write(localEntries[id].Name);
+	}
+}
+
+void RPC1::sendNameTable(Connection* conn)
+{
+	OVR::Net::BitStream out;
+	{
+		Lock::Locker locker(&registrationLock);
+		if (localEntries.GetSize() == 0)
+		{
+			return;
+		}
+		writeNameTable(out, 0, localEntries.GetSize());
+	}
+
+	SendParameters sp(conn, out.GetData(), out.GetNumberOfBytesUsed());
+	pSession->Send(&sp);
+}
+
+void RPC1::readNameTable(Connection* conn, OVR::Net::BitStream& bsIn)
+{
+	Lock::Locker locker(&remoteIDsLock);
+
+	RemoteIDTable* table = NULL;
+	for (unsigned i = 0; i < remoteIDTables.GetSize(); ++i)
+	{
+		if (remoteIDTables[i]->pConnection == conn)
+		{
+			table = remoteIDTables[i];
+			break;
+		}
+	}
+	if (!table)
+	{
+		table = new RemoteIDTable;
+		table->pConnection = conn;
+		remoteIDTables.PushBack(table);
+	}
+
+	uint16_t count = 0;
+	bsIn.Read(count);
+	for (uint16_t i = 0; i < count; ++i)
+	{
+		uint16_t id;
+		OVR::String name;
+		if (!bsIn.Read(id) || !bsIn.Read(name))
+		{
+			break;
+		}
+		table->IDs.Set(name, id);
+	}
 }
 
 bool RPC1::CallBlocking( OVR::String uniqueID, OVR::Net::BitStream* bitStream, Ptr<Connection> pConnection, OVR::Net::BitStream* returnData )
+{
+    if (returnData)
+    {
+        returnData->Reset();
+    }
+
+    Ptr<RPCCall> call = CallAsync(uniqueID, bitStream, pConnection);
+    if (!call)
+    {
+        return false;
+    }
+
+    call->Wait();
+
+    if (!call->Succeeded())
+    {
+        return false;
+    }
+
+    if (returnData)
+    {
+        returnData->Write(call->GetResult());
+        returnData->ResetReadPointer();
+    }
+
+	return true;
+}
+
+Ptr<RPCCall> RPC1::CallAsync( OVR::String uniqueID, OVR::Net::BitStream* bitStream, Ptr<Connection> pConnection, RPCCompletionDelegate completion )
 {
     // If invalid parameters,
     if (!pConnection)
     {
         // Note: This may happen if the endpoint disconnects just before the call
-        return false;
+        return NULL;
     }
 
+	Ptr<RPCCall> call = *new RPCCall(uniqueID, pConnection, completion);
+	call->Tagged = SupportsTaggedCalls(pConnection);
+
 	OVR::Net::BitStream out;
 	out.Write((MessageID) OVRID_RPC1);
-	out.Write((MessageID) CALL_BLOCKING);
-	out.Write(uniqueID);
+	if (call->Tagged)
+	{
+		call->RequestID = nextRequestID.ExchangeAdd_NoSync(1);
+
+		uint16_t remoteID;
+		if (getRemoteID(pConnection, uniqueID, &remoteID))
+		{
+			out.Write((MessageID) CALL_TAGGED_BY_ID);
+			out.Write(call->RequestID);
+			out.Write(remoteID);
+		}
+		else
+		{
+			out.Write((MessageID) CALL_TAGGED);
+			out.Write(call->RequestID);
+			out.Write(uniqueID);
+		}
+	}
+	else
+	{
+		out.Write((MessageID) CALL_BLOCKING);
+		out.Write(uniqueID);
+	}
 	if (bitStream)
 	{
 		bitStream->ResetReadPointer();
@@ -99,51 +397,175 @@ bool RPC1::CallBlocking( OVR::String uniqueID, OVR::Net::BitStream* bitStream, P
 
 	SendParameters sp(pConnection, out.GetData(), out.GetNumberOfBytesUsed());
 
-    if (returnData)
+    // Register before sending, as the reply may arrive on the polling thread before Send() returns.
+    // Untagged calls are sent under the lock so that the send order matches pendingCalls.
+    int bytesSent;
+    if (call->Tagged)
     {
-        returnData->Reset();
+        {
+            Lock::Locker locker(&pendingCallsLock);
+            pendingCalls.PushBack(call);
+        }
+        bytesSent = pSession->Send(&sp);
+    }
+    else
+    {
+        Lock::Locker locker(&pendingCallsLock);
+        pendingCalls.PushBack(call);
+        bytesSent = pSession->Send(&sp);
     }
 
-    // Only one thread call at a time
-    Lock::Locker singleRPCLocker(&singleRPCLock);
-
-    // Note this does not prevent multiple calls at a time because .Wait will unlock it below.
-    // The purpose of this mutex is to synchronize the polling thread and this one, not prevent
-    // multiple threads from invoking RPC.
-    Mutex::Locker locker(&callBlockingMutex);
-
-    blockingReturnValue->Reset();
-    blockingOnThisConnection = pConnection;
-
-    int bytesSent = pSession->Send(&sp);
-    if (bytesSent == sp.Bytes)
+    if (bytesSent != sp.Bytes)
     {
-        while (blockingOnThisConnection == pConnection)
+        // The call may already have been failed by a disconnect in the meantime
+        Lock::Locker locker(&pendingCallsLock);
+        for (unsigned i = 0; i < pendingCalls.GetSize(); ++i)
         {
-            callBlockingWait.Wait(&callBlockingMutex);
+            if (pendingCalls[i] == call)
+            {
+                pendingCalls.RemoveAt(i);
+                break;
+            }
         }
+        return NULL;
     }
+
+	return call;
+}
+
+void RPC1::finishCall(RPCCall* call, OVR::Net::BitStream* returnData, RPCCall::CallState failedState)
+{
+	if (returnData)
+	{
+		call->Result.Write(returnData);
+		call->Result.ResetReadPointer();
+		call->State = RPCCall::State_Succeeded;
+	}
 	else
 	{
-		return false;
+		call->State = failedState;
 	}
 
-    if (returnData)
-    {
-        returnData->Write(blockingReturnValue);
-        returnData->ResetReadPointer();
-    }
+	if (call->Completion.IsValid())
+	{
+		call->Completion(call);
+	}
 
-	return true;
+	call->DoneEvent.SetEvent();
+}
+
+void RPC1::completeCall(Connection* conn, bool tagged, uint32_t requestID, OVR::Net::BitStream* returnData)
+{
+	Ptr<RPCCall> call;
+
+	{
+		Lock::Locker locker(&pendingCallsLock);
+
+		for (unsigned i = 0; i < pendingCalls.GetSize(); ++i)
+		{
+			RPCCall* pending = pendingCalls[i];
+
+			// Untagged replies answer the oldest untagged call on the connection
+			if (pending->pConnection == conn && pending->Tagged == tagged &&
+				(!tagged || pending->RequestID == requestID))
+			{
+				call = pending;
+				pendingCalls.RemoveAt(i);
+				break;
+			}
+		}
+	}
+
+	if (call)
+	{
+		// Replies without data say the function isn't registered
+		finishCall(call, returnData, RPCCall::State_NotRegistered);
+	}
+}
+
+void RPC1::invokeBlockingFunction(ReceivePayload *pPayload, OVR::Net::BitStream &bsIn, bool tagged, bool byID)
+{
+	uint32_t requestID = 0;
+	if (tagged)
+	{
+		bsIn.Read(requestID);
+	}
+
+	LocalEntry entry;
+	bool found;
+	if (byID)
+	{
+		uint16_t id = 0xFFFF;
+		bsIn.Read(id);
+		found = getLocalEntry(id, &entry);
+	}
+	else
+	{
+		OVR::String uniqueId;
+		bsIn.Read(uniqueId);
+		found = getLocalEntry(uniqueId, &entry);
+	}
+
+	if (!found || !entry.Function.IsValid())
+	{
+		OVR::Net::BitStream bsOut;
+		bsOut.Write((unsigned char) OVRID_RPC1);
+		if (tagged)
+		{
+			bsOut.Write((unsigned char) RPC_ERROR_TAGGED_FUNCTION_NOT_REGISTERED);
+			bsOut.Write(requestID);
+		}
+		else
+		{
+			bsOut.Write((unsigned char) RPC_ERROR_FUNCTION_NOT_REGISTERED);
+		}
+
+		SendParameters sp(pPayload->pConnection, bsOut.GetData(), bsOut.GetNumberOfBytesUsed());
+		pSession->Send(&sp);
+
+		return;
+	}
+
+	OVR::Net::BitStream returnData;
+	bsIn.AlignReadToByteBoundary();
+	entry.Function(&bsIn, &returnData, pPayload);
+
+	OVR::Net::BitStream out;
+	out.Write((MessageID) OVRID_RPC1);
+	if (tagged)
+	{
+		out.Write((MessageID) ID_RPC4_TAGGED_RETURN);
+		out.Write(requestID);
+	}
+	else
+	{
+		out.Write((MessageID) ID_RPC4_RETURN);
+	}
+	returnData.ResetReadPointer();
+	out.AlignWriteToByteBoundary();
+	out.Write(returnData);
+
+	SendParameters sp(pPayload->pConnection, out.GetData(), out.GetNumberOfBytesUsed());
+	pSession->Send(&sp);
 }
 
 bool RPC1::Signal(OVR::String sharedIdentifier, OVR::Net::BitStream* bitStream, Ptr<Connection> pConnection)
 {
 	OVR::Net::BitStream out;
 	out.Write((MessageID) OVRID_RPC1);
-	out.Write((MessageID) ID_RPC4_SIGNAL);
-	//out.Write(PluginId);
-	out.Write(sharedIdentifier);
+
+	uint16_t remoteID;
+	if (pConnection && getRemoteID(pConnection, sharedIdentifier, &remoteID))
+	{
+		out.Write((MessageID) ID_RPC4_SIGNAL_BY_ID);
+		out.Write(remoteID);
+	}
+	else
+	{
+		out.Write((MessageID) ID_RPC4_SIGNAL);
+		//out.Write(PluginId);
+		out.Write(sharedIdentifier);
+	}
 	if (bitStream)
 	{
 		bitStream->ResetReadPointer();
@@ -183,87 +605,117 @@ void RPC1::OnReceive(ReceivePayload *pPayload, ListenerReceiveResult *lrrOut)
 
         if (pPayload->pData[1] == RPC_ERROR_FUNCTION_NOT_REGISTERED)
         {
-            Mutex::Locker locker(&callBlockingMutex);
-
-            blockingReturnValue->Reset();
-            blockingOnThisConnection = 0;
-            callBlockingWait.NotifyAll();
+            // Completes the call, but without a result
+            completeCall(pPayload->pConnection, false, 0, NULL);
         }
         else if (pPayload->pData[1] == ID_RPC4_RETURN)
         {
-            Mutex::Locker locker(&callBlockingMutex);
-
-            blockingReturnValue->Reset();
-			blockingReturnValue->Write(bsIn);
-            blockingOnThisConnection = 0;
-            callBlockingWait.NotifyAll();
+            completeCall(pPayload->pConnection, false, 0, &bsIn);
 		}
+        else if (pPayload->pData[1] == RPC_ERROR_TAGGED_FUNCTION_NOT_REGISTERED)
+        {
+            uint32_t requestID = 0;
+            bsIn.Read(requestID);
+            completeCall(pPayload->pConnection, true, requestID, NULL);
+        }
+        else if (pPayload->pData[1] == ID_RPC4_TAGGED_RETURN)
+        {
+            uint32_t requestID = 0;
+            bsIn.Read(requestID);
+            bsIn.AlignReadToByteBoundary();
+            completeCall(pPayload->pConnection, true, requestID, &bsIn);
+        }
         else if (pPayload->pData[1] == CALL_BLOCKING)
         {
-			OVR::String uniqueId;
-			bsIn.Read(uniqueId);
-
-			RPCDelegate *bf = registeredBlockingFunctions.Get(uniqueId);
-			if (bf==0)
-			{
-				OVR::Net::BitStream bsOut;
-				bsOut.Write((unsigned char) OVRID_RPC1);
-				bsOut.Write((unsigned char) RPC_ERROR_FUNCTION_NOT_REGISTERED);
-
-				SendParameters sp(pPayload->pConnection, bsOut.GetData(), bsOut.GetNumberOfBytesUsed());
-				pSession->Send(&sp);
-
-				return;
-			}
-
-			OVR::Net::BitStream returnData;
-			bsIn.AlignReadToByteBoundary();
-			(*bf)(&bsIn, &returnData, pPayload);
-
-			OVR::Net::BitStream out;
-			out.Write((MessageID) OVRID_RPC1);
-			out.Write((MessageID) ID_RPC4_RETURN);
-			returnData.ResetReadPointer();
-			out.AlignWriteToByteBoundary();
-			out.Write(returnData);
-
-			SendParameters sp(pPayload->pConnection, out.GetData(), out.GetNumberOfBytesUsed());
-			pSession->Send(&sp);
+            invokeBlockingFunction(pPayload, bsIn, false, false);
 		}
-		else if (pPayload->pData[1]==ID_RPC4_SIGNAL)
+        else if (pPayload->pData[1] == CALL_TAGGED)
+        {
+            invokeBlockingFunction(pPayload, bsIn, true, false);
+        }
+        else if (pPayload->pData[1] == CALL_TAGGED_BY_ID)
+        {
+            invokeBlockingFunction(pPayload, bsIn, true, true);
+        }
+		else if (pPayload->pData[1]==ID_RPC4_SIGNAL || pPayload->pData[1]==ID_RPC4_SIGNAL_BY_ID)
 		{
-			OVR::String sharedIdentifier;
-			bsIn.Read(sharedIdentifier);
-
-			Observer<RPCSlot> *o = slotHash.GetSubject(sharedIdentifier);
+			LocalEntry entry;
+			bool found;
+			if (pPayload->pData[1]==ID_RPC4_SIGNAL_BY_ID)
+			{
+				uint16_t id = 0xFFFF;
+				bsIn.Read(id);
+				found = getLocalEntry(id, &entry);
+			}
+			else
+			{
+				OVR::String sharedIdentifier;
+				bsIn.Read(sharedIdentifier);
+				found = getLocalEntry(sharedIdentifier, &entry);
+			}
 
-			if (o)
+			if (found && entry.Slot)
 			{
 				bsIn.AlignReadToByteBoundary();
 
-				if (o)
-				{
-					OVR::Net::BitStream serializedParameters(bsIn.GetData() + bsIn.GetReadOffset()/8, bsIn.GetNumberOfUnreadBits()/8, false);
+				OVR::Net::BitStream serializedParameters(bsIn.GetData() + bsIn.GetReadOffset()/8, bsIn.GetNumberOfUnreadBits()/8, false);
 
-					o->Call(&serializedParameters, pPayload);
-				}
+				entry.Slot->Call(&serializedParameters, pPayload);
 			}
 		}
+		else if (pPayload->pData[1]==ID_RPC4_NAME_TABLE)
+		{
+			readNameTable(pPayload->pConnection, bsIn);
+		}
 	}
 }
 
 void RPC1::OnDisconnected(Connection* conn)
 {
-    if (blockingOnThisConnection == conn)
+    // Fail every call still waiting on this connection
+    Array< Ptr<RPCCall> > failed;
+    {
+        Lock::Locker locker(&pendingCallsLock);
+
+        for (unsigned i = 0; i < pendingCalls.GetSize();)
+        {
+            if (pendingCalls[i]->pConnection == conn)
+            {
+                failed.PushBack(pendingCalls[i]);
+                pendingCalls.RemoveAt(i);
+            }
+            else
+            {
+                ++i;
+            }
+        }
+    }
+
+    for (unsigned i = 0; i < failed.GetSize(); ++i)
+    {
+        finishCall(failed[i], NULL);
+    }
+
+    // Forget the IDs the peer gave us
+    Lock::Locker locker(&remoteIDsLock);
+    for (unsigned i = 0; i < remoteIDTables.GetSize(); ++i)
     {
-        blockingOnThisConnection = 0;
-        callBlockingWait.NotifyAll();
+        if (remoteIDTables[i]->pConnection == conn)
+        {
+            delete remoteIDTables[i];
+            remoteIDTables.RemoveAt(i);
+            break;
+        }
     }
 }
 
 void RPC1::OnConnected(Connection* conn)
 {
-    OVR_UNUSED(conn);
+    // The peer's hello or authorization told us its capabilities, so we know whether it understands IDs
+    if (SupportsNameIDs(conn))
+    {
+        sendNameTable(conn);
+    }
 }
 
 
@@ -35,6 +35,7 @@ limitations under the License.
 #include "../Kernel/OVR_Threads.h"
 #include "../Kernel/OVR_Delegates.h"
 #include "../Kernel//OVR_Observer.h"
+#include "../Kernel/OVR_Atomic.h"
 
 namespace OVR { namespace Net { namespace Plugins {
 
@@ -43,7 +44,55 @@ typedef Delegate3<void, BitStream*, BitStream*, ReceivePayload*> RPCDelegate;
 typedef Delegate2<void, BitStream*, ReceivePayload*> RPCSlot;
 // typedef void ( *Slot ) ( OVR::Net::BitStream *userData, OVR::Net::ReceivePayload *pPayload );
 
+class RPCCall;
+typedef Delegate1<void, RPCCall*> RPCCompletionDelegate;
+
+/// A call started with RPC1::CallAsync(). Completes when the remote system replies, the
+/// function turns out not to be registered remotely, or the connection is lost.
+class RPCCall : public RefCountBase<RPCCall>
+{
+	friend class RPC1;
+
+public:
+	enum CallState
+	{
+		State_Pending,
+		State_Succeeded,
+		State_Failed,
+		State_NotRegistered		// The remote system has no function by that name
+	};
+
+	RPCCall(const String& uniqueID, Connection* conn, RPCCompletionDelegate completion);
+
+	CallState		GetState() const     { return State; }
+	bool			IsDone() const       { return State != State_Pending; }
+	bool			Succeeded() const    { return State == State_Succeeded; }
+	const String&	GetUniqueID() const  { return UniqueID; }
+	uint32_t		GetRequestID() const { return RequestID; }
+
+	/// Waits for the call to complete. Returns false on timeout.
+	/// \note Must not be called from the Session::Poll() thread, which completes calls
+	bool Wait(unsigned delayMs = OVR_WAIT_INFINITE);
+
+	/// Data written by the remote function, with the read pointer reset. Only valid once the call succeeded.
+	BitStream* GetResult() { return &Result; }
+
+private:
+	String					UniqueID;
+	uint32_t				RequestID;
+	bool					Tagged;			// False for a peer that only answers calls in order
+	Ptr<Connection>			pConnection;
+	volatile CallState		State;
+	BitStream				Result;
+	RPCCompletionDelegate	Completion;
+	Event					DoneEvent;
+};
+
 /// NetworkPlugin that maps strings to function pointers. Can invoke the functions using blocking calls with return values, or signal/slots. Networked parameters serialized with BitStream
+///
+/// Each registered name is interned to a small integer ID, and on connect each side sends the other its table of IDs.
+/// Calls and signals to a peer that sent its table carry the ID instead of the name, and are dispatched by indexing a flat array.
+/// Names the peer hasn't announced, and peers without RPCCapability_NameIDs, still go by name.
 class RPC1 : public NetworkPlugin, public NewOverrideBase
 {
 public:
@@ -71,13 +120,26 @@ public:
 	/// \param[in] pConnection connection to send on
 	/// \param[out] returnData Written to by the function registered with RegisterBlockingFunction.
 	/// \return true if successfully called. False on disconnect, function not registered, or not connected to begin with
+	/// \note Implemented with CallAsync(), so concurrent calls from other threads are not serialized behind this one
 	bool CallBlocking( OVR::String uniqueID, OVR::Net::BitStream * bitStream, Ptr<Connection> pConnection, OVR::Net::BitStream *returnData = NULL );
 
+	/// Same as CallBlocking, but returns as soon as the call is sent.
+	/// Each call is tagged with a request ID, so any number of calls from any number of threads may be outstanding on a connection,
+	/// and replies may complete in any order.
+	/// \param[in] uniqueID Identifier originally passed to RegisterBlockingFunction() on the remote system(s)
+	/// \param[in] bitStream bitStream encoded data to send to the function callback
+	/// \param[in] pConnection connection to send on
+	/// \param[in] completion Optional. Invoked once the call completes, from the Session::Poll() thread, so it must not block on other calls
+	/// \return The outstanding call, or NULL if not connected or sending failed. In that case completion is not invoked
+	Ptr<RPCCall> CallAsync( OVR::String uniqueID, OVR::Net::BitStream * bitStream, Ptr<Connection> pConnection,
+							RPCCompletionDelegate completion = RPCCompletionDelegate() );
+
 	/// Calls zero or more functions identified by sharedIdentifier registered with RegisterSlot()
 	/// \param[in] sharedIdentifier parameter of the same name passed to RegisterSlot() on the remote system
 	/// \param[in] bitStream bitStream encoded data to send to the function callback
 	/// \param[in] pConnection connection to send on
 	bool Signal(OVR::String sharedIdentifier, OVR::Net::BitStream * bitStream, Ptr<Connection> pConnection);
+	/// Same as Signal, to all connections. Always sends the name, since IDs differ per connection
     void BroadcastSignal(OVR::String sharedIdentifier, OVR::Net::BitStream * bitStream);
 
 
@@ -87,16 +149,48 @@ protected:
     virtual void OnDisconnected(Connection* conn);
     virtual void OnConnected(Connection* conn);
 
-	Hash< String, RPCDelegate, String::HashFunctor > registeredBlockingFunctions;
-	ObserverHash< RPCSlot > slotHash;
+	// A name registered locally. Its ID is its index in localEntries
+	struct LocalEntry
+	{
+		String					Name;
+		RPCDelegate				Function;	// Invalid if no blocking function is registered
+		Ptr< Observer<RPCSlot> > Slot;		// NULL if no slot is registered
+	};
+
+	// IDs a peer assigned to its registered names
+	struct RemoteIDTable
+	{
+		Ptr<Connection>							 pConnection;
+		Hash< String, uint16_t, String::HashFunctor > IDs;
+	};
 
-    // Synchronization for RPC caller
-    Lock            singleRPCLock;
-    Mutex           callBlockingMutex;
-    WaitCondition   callBlockingWait;
+	ObserverHash< RPCSlot > slotHash;
 
-    Net::BitStream* blockingReturnValue;
-	Ptr<Connection> blockingOnThisConnection;
+	// Local name table. IDs are never reused, so a peer's copy of the table stays valid
+	Lock									registrationLock;
+	Array< LocalEntry >						localEntries;
+	Hash< String, uint16_t, String::HashFunctor > localIDs;
+
+	Lock									remoteIDsLock;
+	Array< RemoteIDTable* >					remoteIDTables;
+
+	uint16_t internName(const String& name, bool* isNew);
+	void announceName(uint16_t id);
+	bool getLocalEntry(uint16_t id, LocalEntry* entry);
+	bool getLocalEntry(const String& name, LocalEntry* entry);
+	bool getRemoteID(Connection* conn, const String& name, uint16_t* id);
+	void writeNameTable(OVR::Net::BitStream &out, unsigned firstID, unsigned endID);
+	void sendNameTable(Connection* conn);
+	void readNameTable(Connection* conn, OVR::Net::BitStream &bsIn);
+
+	void invokeBlockingFunction(ReceivePayload *pPayload, OVR::Net::BitStream &bsIn, bool tagged, bool byID);
+	void completeCall(Connection* conn, bool tagged, uint32_t requestID, OVR::Net::BitStream *returnData);
+	void finishCall(RPCCall* call, OVR::Net::BitStream *returnData, RPCCall::CallState failedState = RPCCall::State_Failed);
+
+	// Calls awaiting a reply, in the order they were sent
+	Lock					pendingCallsLock;
+	Array< Ptr<RPCCall> >	pendingCalls;
+	AtomicInt<uint32_t>		nextRequestID;
 };
 
 
@@ -45,6 +45,7 @@ void RPC_C2S_Hello::Generate(Net::BitStream* bs)
     hello.MajorVersion = RPCVersion_Major;
     hello.MinorVersion = RPCVersion_Minor;
     hello.PatchVersion = RPCVersion_Patch;
+    hello.Capabilities = RPCCapabilities_Supported;
     hello.Serialize(bs);
 }
 
@@ -69,6 +70,7 @@ void RPC_S2C_Authorization::Generate(Net::BitStream* bs, String errorString)
     auth.MajorVersion = RPCVersion_Major;
     auth.MinorVersion = RPCVersion_Minor;
     auth.PatchVersion = RPCVersion_Patch;
+    auth.Capabilities = RPCCapabilities_Supported;
     auth.Serialize(bs);
 }
 
@@ -107,6 +109,11 @@ void Session::Shutdown()
             ptcp->pSocket->Close();
         }
     }
+
+#ifdef OVR_OS_LINUX
+    // Closing a socket doesn't interrupt epoll, so wake the pollers to notice
+    Reactor.Wake();
+#endif
 }
 
 SessionResult Session::Listen(ListenerDescription* pListenerDescription)
@@ -123,6 +130,10 @@ SessionResult Session::Listen(ListenerDescription* pListenerDescription)
 
 		Lock::Locker locker(&SocketListenersLock);
         SocketListeners.PushBack(tcpSocket);
+
+#ifdef OVR_OS_LINUX
+        Reactor.Add(tcpSocket);
+#endif
 	}
     else if (pListenerDescription->Transport == TransportType_Loopback)
 	{
@@ -175,6 +186,10 @@ SessionResult Session::Connect(ConnectParameters *cp)
 
             AllConnections.PushBack(c);
 
+#ifdef OVR_OS_LINUX
+            Reactor.Add(c->pSocket);
+#endif
+
         }
 
         if (cp2->Blocking)
@@ -338,9 +353,19 @@ void Session::Broadcast(BroadcastParameters *payload)
         }    
     }
 }
-// DO NOT CALL Poll() FROM MULTIPLE THREADS due to allBlockingTcpSockets being a member
+// DO NOT CALL Poll() FROM MULTIPLE THREADS due to allBlockingTcpSockets being a member,
+// except when the reactor is in use
 void Session::Poll(bool listeners)
 {
+#ifdef OVR_OS_LINUX
+    // Sockets are already registered, so there is nothing to gather
+    if (Reactor.IsValid())
+    {
+        Reactor.Poll(this, listeners);
+        return;
+    }
+#endif
+
     allBlockingTcpSockets.Clear();
 
 	if (listeners)
@@ -551,6 +576,7 @@ void Session::TCP_OnRecv(Socket* pSocket, uint8_t* pData, int bytesRead)
                 conn->RemoteMajorVersion = auth.MajorVersion;
                 conn->RemoteMinorVersion = auth.MinorVersion;
                 conn->RemotePatchVersion = auth.PatchVersion;
+                conn->RemoteCapabilities = auth.Capabilities & RPCCapabilities_Supported;
 
                 // Mark as connected
                 conn->SetState(State_Connected);
@@ -590,6 +616,7 @@ void Session::TCP_OnRecv(Socket* pSocket, uint8_t* pData, int bytesRead)
                 conn->RemoteMajorVersion = hello.MajorVersion;
                 conn->RemoteMinorVersion = hello.MinorVersion;
                 conn->RemotePatchVersion = hello.PatchVersion;
+                conn->RemoteCapabilities = hello.Capabilities & RPCCapabilities_Supported;
 
                 // Send auth response
                 BitStream bsOut;
@@ -618,6 +645,10 @@ void Session::TCP_OnRecv(Socket* pSocket, uint8_t* pData, int bytesRead)
 
 void Session::TCP_OnClosed(TCPSocket* s)
 {
+#ifdef OVR_OS_LINUX
+    Reactor.Remove(s);
+#endif
+
 	Lock::Locker locker(&ConnectionsLock);
 
     // If found in the full connection list,
@@ -683,6 +714,10 @@ void Session::TCP_OnAccept(TCPSocket* pListener, SockAddr* pSockAddr, SocketHand
             AllConnections.PushBack(c);
         }
 
+#ifdef OVR_OS_LINUX
+        Reactor.Add(newSocket);
+#endif
+
         // Server does not send the first packet.  It waits for the client to send its version
 	}
 }
@@ -47,11 +47,23 @@ class Session;
 // 1.0.0 - [SDK 0.4.0] Initial version (July 21, 2014)
 // 1.1.0 - Add Get/SetDriverMode_1, HMDCountUpdate_1
 //         Version mismatch results (July 28, 2014)
+// 1.2.1 - Hello and authorization end with a mask of RPCCapabilities (October 17, 2014)
 //-----------------------------------------------------------------------------
 
 static const uint16_t RPCVersion_Major = 1; // MAJOR version when you make incompatible API changes,
 static const uint16_t RPCVersion_Minor = 2; // MINOR version when you add functionality in a backwards-compatible manner, and
-static const uint16_t RPCVersion_Patch = 0; // PATCH version when you make backwards-compatible bug fixes.
+static const uint16_t RPCVersion_Patch = 1; // PATCH version when you make backwards-compatible bug fixes.
+
+// Optional protocol features. Each side sends the mask it supports after its version
+// number, and a feature is used on a connection only if both sides have it. Peers from
+// before 1.2.1 do not send a mask and ignore ours, so they read as having none.
+enum RPCCapabilities
+{
+    RPCCapability_TaggedCalls = 0x01, // RPC1 calls carry request IDs and may be pipelined
+    RPCCapability_NameIDs     = 0x02, // RPC1 names interned to integer IDs, exchanged on connect
+};
+
+static const uint32_t RPCCapabilities_Supported = RPCCapability_TaggedCalls | RPCCapability_NameIDs;
 
 // Client starts communication by sending its version number.
 struct RPC_C2S_Hello
@@ -59,7 +71,8 @@ struct RPC_C2S_Hello
     RPC_C2S_Hello() :
         MajorVersion(0),
         MinorVersion(0),
-        PatchVersion(0)
+        PatchVersion(0),
+        Capabilities(0)
     {
     }
 
@@ -67,6 +80,7 @@ struct RPC_C2S_Hello
 
     // Client version info
     uint16_t MajorVersion, MinorVersion, PatchVersion;
+    uint32_t Capabilities;
 
     void Serialize(Net::BitStream* bs)
     {
@@ -74,6 +88,7 @@ struct RPC_C2S_Hello
         bs->Write(MajorVersion);
         bs->Write(MinorVersion);
         bs->Write(PatchVersion);
+        bs->Write(Capabilities);
     }
 
     bool Deserialize(Net::BitStream* bs)
@@ -81,7 +96,16 @@ struct RPC_C2S_Hello
         bs->Read(HelloString);
         bs->Read(MajorVersion);
         bs->Read(MinorVersion);
-        return bs->Read(PatchVersion);
+        if (!bs->Read(PatchVersion))
+        {
+            return false;
+        }
+        // Optional, see RPCCapabilities
+        if (!bs->Read(Capabilities))
+        {
+            Capabilities = 0;
+        }
+        return true;
     }
 
     static void Generate(Net::BitStream* bs);
@@ -95,7 +119,8 @@ struct RPC_S2C_Authorization
     RPC_S2C_Authorization() :
         MajorVersion(0),
         MinorVersion(0),
-        PatchVersion(0)
+        PatchVersion(0),
+        Capabilities(0)
     {
     }
 
@@ -103,6 +128,7 @@ struct RPC_S2C_Authorization
 
     // Server version info
     uint16_t MajorVersion, MinorVersion, PatchVersion;
+    uint32_t Capabilities;
 
     void Serialize(Net::BitStream* bs)
     {
@@ -110,6 +136,7 @@ struct RPC_S2C_Authorization
         bs->Write(MajorVersion);
         bs->Write(MinorVersion);
         bs->Write(PatchVersion);
+        bs->Write(Capabilities);
     }
 
     bool Deserialize(Net::BitStream* bs)
@@ -117,7 +144,16 @@ struct RPC_S2C_Authorization
         bs->Read(AuthString);
         bs->Read(MajorVersion);
         bs->Read(MinorVersion);
-        return bs->Read(PatchVersion);
+        if (!bs->Read(PatchVersion))
+        {
+            return false;
+        }
+        // Optional, see RPCCapabilities
+        if (!bs->Read(Capabilities))
+        {
+            Capabilities = 0;
+        }
+        return true;
     }
 
     static void Generate(Net::BitStream* bs, String errorString = "");
@@ -166,7 +202,8 @@ public:
         State(State_Zombie),
         RemoteMajorVersion(0),
         RemoteMinorVersion(0),
-        RemotePatchVersion(0)
+        RemotePatchVersion(0),
+        RemoteCapabilities(0)
     {
     }
 	virtual ~Connection() // Allow delete from base
@@ -183,6 +220,8 @@ public:
     int              RemoteMajorVersion;
     int              RemoteMinorVersion;
     int              RemotePatchVersion;
+    // RPCCapabilities bits both sides support
+    uint32_t         RemoteCapabilities;
 };
 
 
@@ -304,7 +343,8 @@ public:
 struct ReceivePayload
 {
 	Connection* pConnection; // Source connection
-	uint8_t*    pData;       // Pointer to data received
+	uint8_t*    pData;       // Pointer to data received; points into the socket's receive buffer and
+	                         // is only valid until the listener returns, so copy anything kept
 	int         Bytes;       // Number of bytes of data received
 };
 
@@ -463,7 +503,10 @@ public:
 	virtual SessionResult Connect(ConnectParameters* cp);
 	virtual int           Send(SendParameters* payload);
     virtual void          Broadcast(BroadcastParameters* payload);
-    // DO NOT CALL Poll() FROM MULTIPLE THREADS due to allBlockingTcpSockets being a member
+    // DO NOT CALL Poll() FROM MULTIPLE THREADS due to allBlockingTcpSockets being a member,
+    // except on Linux, where sockets are polled with a TCPSocketReactor. There several threads
+    // may poll at once, each socket is serviced by one of them at a time, and session listeners
+    // must then handle events for different connections concurrently.
     virtual void          Poll(bool listeners = true);
 	virtual void          AddSessionListener(SessionListener* se);
 	virtual void          RemoveSessionListener(SessionListener* se);
@@ -493,6 +536,9 @@ protected:
     Array< Ptr<Connection> >  FullConnections;     // List of active connections past the versioning handshake
     Array< SessionListener* > SessionListeners;    // List of session listeners
     Array< Ptr< Net::TCPSocket >, ArrayNoShrinkPolicy > allBlockingTcpSockets; // Preallocated blocking sockets array
+#ifdef OVR_OS_LINUX
+    TCPSocketReactor          Reactor;             // Sockets are registered here as they are added, if epoll is available
+#endif
 
     // Tools
     Ptr<PacketizedTCPConnection> findConnectionBySocket(Array< Ptr<Connection> >& connectionArray, Socket* s, int *connectionIndex = NULL); // Call with ConnectionsLock held
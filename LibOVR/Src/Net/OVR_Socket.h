@@ -232,6 +232,15 @@ protected:
                                 uint8_t* pData,
                                 int bytesRead) = 0;
 
+	// Buffer that the next receive should be written into, so the socket can parse it in
+	// place; OnRecv is then called with a pointer to the start of it. Returns NULL to have
+	// the poller receive into a buffer of its own.
+	virtual uint8_t*     GetRecvBuffer(int* pCapacity)
+	{
+		OVR_UNUSED(pCapacity);
+		return NULL;
+	}
+
 protected:
 	bool IsListenSocket; // Is the socket listening (acting as a server)?
 };
@@ -0,0 +1,1060 @@
+/************************************************************************************
+
+Filename    :   OVR_Unix_Socket.cpp
+Content     :   Berkeley sockets networking implementation for Unix platforms
+Created     :   October 17, 2014
+
+Copyright   :   Copyright 2014 Oculus VR, LLC All Rights reserved.
+
+Licensed under the Oculus VR Rift SDK License Version 3.2 (the "License");
+you may not use the Oculus VR Rift SDK except in compliance with the License,
+which is provided at the time of installation or download, or which
+otherwise accompanies this software in either electronic or hard copy form.
+
+You may obtain a copy of the License at
+
+http://www.oculusvr.com/licenses/LICENSE-3.2
+
+Unless required by applicable law or agreed to in writing, the Oculus VR SDK
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+************************************************************************************/
+
+#include "OVR_Unix_Socket.h"
+#include "../Kernel/OVR_Std.h"
+#include "../Kernel/OVR_Allocator.h"
+#include "../Kernel/OVR_Threads.h" // Thread::MSleep
+#include "../Kernel/OVR_Log.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <arpa/inet.h>
+#include <netinet/tcp.h>
+
+#ifdef OVR_OS_LINUX
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#endif
+
+// Don't raise SIGPIPE when sending to a peer that has gone away
+#ifdef MSG_NOSIGNAL
+#define OVR_SEND_FLAGS MSG_NOSIGNAL
+#else
+#define OVR_SEND_FLAGS 0
+#endif
+
+namespace OVR { namespace Net {
+
+
+//-----------------------------------------------------------------------------
+// BerkleySocket
+
+void BerkleySocket::Close()
+{
+	if (TheSocket != INVALID_SOCKET)
+	{
+		close(TheSocket);
+		TheSocket = INVALID_SOCKET;
+	}
+}
+
+int32_t BerkleySocket::GetSockname(SockAddr *pSockAddrOut)
+{
+	struct sockaddr_in6 sa;
+	memset(&sa,0,sizeof(sa));
+	socklen_t size = sizeof(sa);
+	int32_t i = getsockname(TheSocket, (sockaddr*) &sa, &size);
+	if (i>=0)
+	{
+		pSockAddrOut->Set(&sa);
+	}
+	return i;
+}
+
+
+//-----------------------------------------------------------------------------
+// BitStream overloads for SockAddr
+
+BitStream& operator<<(BitStream& out, SockAddr& in)
+{
+	out.WriteBits((const unsigned char*) &in.Addr6, sizeof(in.Addr6)*8, true);
+	return out;
+}
+
+BitStream& operator>>(BitStream& in, SockAddr& out)
+{
+	bool success = in.ReadBits((unsigned char*) &out.Addr6, sizeof(out.Addr6)*8, true);
+	OVR_ASSERT(success);
+	OVR_UNUSED(success);
+	return in;
+}
+
+
+//-----------------------------------------------------------------------------
+// SockAddr
+
+SockAddr::SockAddr()
+{
+    // Zero out the address to squelch static analysis tools
+    memset(&Addr6, 0, sizeof(Addr6));
+}
+
+SockAddr::SockAddr(SockAddr* address)
+{
+	Set(&address->Addr6);
+}
+
+SockAddr::SockAddr(sockaddr_storage* storage)
+{
+	Set(storage);
+}
+
+SockAddr::SockAddr(sockaddr_in6* address)
+{
+	Set(address);
+}
+
+SockAddr::SockAddr(const char* hostAddress, uint16_t port, int sockType)
+{
+	Set(hostAddress, port, sockType);
+}
+
+void SockAddr::Set(const sockaddr_storage* storage)
+{
+	memcpy(&Addr6, storage, sizeof(Addr6));
+}
+
+void SockAddr::Set(const sockaddr_in6* address)
+{
+	memcpy(&Addr6, address, sizeof(Addr6));
+}
+
+void SockAddr::Set(const char* hostAddress, uint16_t port, int sockType)
+{
+	memset(&Addr6, 0, sizeof(Addr6));
+
+	struct addrinfo hints;
+
+	// make sure the struct is empty
+	memset(&hints, 0, sizeof (addrinfo));
+
+	hints.ai_socktype = sockType; // SOCK_DGRAM or SOCK_STREAM
+	hints.ai_flags = AI_PASSIVE;     // fill in my IP for me
+	hints.ai_family = AF_INET6;      // Addr6 only has room for IPv6 addresses
+	hints.ai_protocol = (sockType == SOCK_DGRAM) ? IPPROTO_UDP : IPPROTO_TCP;
+
+    struct addrinfo* servinfo = NULL;  // will point to the results
+
+	char portStr[32];
+	OVR_itoa(port, portStr, sizeof(portStr), 10);
+	int errcode = getaddrinfo(hostAddress, portStr, &hints, &servinfo);
+
+    if (0 != errcode)
+    {
+        OVR::LogError("{ERR-008u} getaddrinfo error: %s", gai_strerror(errcode));
+    }
+
+    OVR_ASSERT(servinfo);
+
+    if (servinfo)
+    {
+        memcpy(&Addr6, servinfo->ai_addr, sizeof(Addr6));
+
+        freeaddrinfo(servinfo);
+    }
+}
+
+uint16_t SockAddr::GetPort()
+{
+	return htons(Addr6.sin6_port);
+}
+
+String SockAddr::ToString(bool writePort, char portDelineator) const
+{
+    char dest[INET6_ADDRSTRLEN + 1];
+
+	int ret = getnameinfo((struct sockaddr*)&Addr6,
+						  sizeof(struct sockaddr_in6),
+						  dest,
+						  INET6_ADDRSTRLEN,
+						  NULL,
+						  0,
+						  NI_NUMERICHOST);
+	if (ret != 0)
+	{
+		dest[0] = '\0';
+	}
+
+	if (writePort)
+	{
+		unsigned char ch[2];
+		ch[0]=portDelineator;
+		ch[1]=0;
+		OVR_strcat(dest, 16, (const char*) ch);
+		OVR_itoa(ntohs(Addr6.sin6_port), dest+strlen(dest), 16, 10);
+	}
+
+    return String(dest);
+}
+bool SockAddr::IsLocalhost() const
+{
+    static const unsigned char localhost_bytes[] =
+    { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1 };
+
+    return memcmp(Addr6.sin6_addr.s6_addr, localhost_bytes, 16) == 0;
+}
+bool SockAddr::operator==( const SockAddr& right ) const
+{
+	return memcmp(&Addr6, &right.Addr6, sizeof(Addr6)) == 0;
+}
+
+bool SockAddr::operator!=( const SockAddr& right ) const
+{
+	return !(*this == right);
+}
+
+bool SockAddr::operator>( const SockAddr& right ) const
+{
+	return memcmp(&Addr6, &right.Addr6, sizeof(Addr6)) > 0;
+}
+
+bool SockAddr::operator<( const SockAddr& right ) const
+{
+	return memcmp(&Addr6, &right.Addr6, sizeof(Addr6)) < 0;
+}
+
+static bool SetSocketOptions(SocketHandle sock)
+{
+    int result = 0;
+	int sock_opt;
+
+	// This doubles the max throughput rate
+    sock_opt = 1024 * 256;
+    result |= setsockopt(sock, SOL_SOCKET, SO_RCVBUF, (char *)& sock_opt, sizeof (sock_opt));
+
+	// Immediate hard close. Don't linger the socket.
+    struct linger linger_opt;
+    linger_opt.l_onoff = 0;
+    linger_opt.l_linger = 0;
+    result |= setsockopt(sock, SOL_SOCKET, SO_LINGER, (char *)& linger_opt, sizeof (linger_opt));
+
+	// This doesn't make much difference: 10% maybe
+    sock_opt = 1024 * 16;
+    result |= setsockopt(sock, SOL_SOCKET, SO_SNDBUF, (char *)& sock_opt, sizeof (sock_opt));
+
+#ifdef SO_NOSIGPIPE
+    // Platforms without MSG_NOSIGNAL
+    sock_opt = 1;
+    result |= setsockopt(sock, SOL_SOCKET, SO_NOSIGPIPE, (char *)& sock_opt, sizeof (sock_opt));
+#endif
+
+    // If all the setsockopt() returned 0 there were no failures, so return true for success, else false
+    return result == 0;
+}
+
+// The packetized socket writes the length prefix and the payload separately, so without
+// this each small message waits on a delayed ack from the other side
+static void SetNoDelay(SocketHandle sock)
+{
+    int sock_opt = 1;
+    setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, (char *)& sock_opt, sizeof (sock_opt));
+}
+
+static void SetNonBlocking(SocketHandle sock, bool nonblocking)
+{
+    int flags = fcntl(sock, F_GETFL, 0);
+    if (flags >= 0)
+    {
+        flags = nonblocking ? (flags | O_NONBLOCK) : (flags & ~O_NONBLOCK);
+        fcntl(sock, F_SETFL, flags);
+    }
+}
+
+static SocketHandle BindShared(int ai_family, int ai_socktype, BerkleyBindParameters* pBindParameters)
+{
+	SocketHandle sock;
+
+	struct addrinfo hints;
+	memset(&hints, 0, sizeof (addrinfo)); // make sure the struct is empty
+	hints.ai_family = ai_family;
+	hints.ai_socktype = ai_socktype;
+	hints.ai_flags = AI_PASSIVE;     // fill in my IP for me
+	struct addrinfo *servinfo=0, *aip;  // will point to the results
+	char portStr[32];
+	OVR_itoa(pBindParameters->Port, portStr, sizeof(portStr), 10);
+
+    int errcode = 0;
+	if (!pBindParameters->Address.IsEmpty())
+		errcode = getaddrinfo(pBindParameters->Address.ToCStr(), portStr, &hints, &servinfo);
+	else
+		errcode = getaddrinfo(0, portStr, &hints, &servinfo);
+
+    if (0 != errcode)
+    {
+        OVR::LogError("{ERR-020u} getaddrinfo error: %s", gai_strerror(errcode));
+    }
+
+	for (aip = servinfo; aip != NULL; aip = aip->ai_next)
+	{
+		// Open socket. The address type depends on what
+		// getaddrinfo() gave us.
+		sock = socket(aip->ai_family, aip->ai_socktype, aip->ai_protocol);
+        if (sock != INVALID_SOCKET)
+		{
+            // Allow restarting a server right away while old connections are in TIME_WAIT
+            if (pBindParameters->Port != 0)
+            {
+                int reuse = 1;
+                setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, (char *)& reuse, sizeof (reuse));
+            }
+
+            if (bind(sock, aip->ai_addr, (socklen_t)aip->ai_addrlen) != SOCKET_ERROR)
+			{
+				// The actual socket is always non-blocking
+				SetNonBlocking(sock, true);
+                freeaddrinfo(servinfo);
+				return sock;
+			}
+
+            close(sock);
+        }
+	}
+
+    if (servinfo) { freeaddrinfo(servinfo); }
+	return INVALID_SOCKET;
+}
+
+
+//-----------------------------------------------------------------------------
+// UDPSocket
+
+UDPSocket::UDPSocket()
+{
+	RecvBuf = new uint8_t[RecvBufSize];
+}
+
+UDPSocket::~UDPSocket()
+{
+	delete[] RecvBuf;
+}
+
+SocketHandle UDPSocket::Bind(BerkleyBindParameters *pBindParameters)
+{
+	SocketHandle s = BindShared(AF_INET6, SOCK_DGRAM, pBindParameters);
+	if (s == INVALID_SOCKET)
+		return s;
+
+	Close();
+	TheSocket = s;
+	SetSocketOptions(TheSocket);
+
+	return TheSocket;
+}
+
+void UDPSocket::OnRecv(SocketEvent_UDP* eventHandler, uint8_t* pData, int bytesRead, SockAddr* address)
+{
+	eventHandler->UDP_OnRecv(this, pData, bytesRead, address);
+}
+
+int UDPSocket::Send(const void* pData, int bytes, SockAddr* address)
+{
+	return (int)sendto(TheSocket, (const char*)pData, bytes, OVR_SEND_FLAGS, (const sockaddr*)&address->Addr6, sizeof(address->Addr6));
+}
+
+void UDPSocket::Poll(SocketEvent_UDP *eventHandler)
+{
+	struct sockaddr_storage addr;
+	socklen_t fromlen;
+	int bytesRead;
+
+    // FIXME: Implement blocking poll wait for UDP
+
+	// While some bytes are read,
+	while (fromlen = sizeof(addr), // Must set fromlen each time
+		   bytesRead = (int)recvfrom(TheSocket, (char*)RecvBuf, RecvBufSize, 0, (sockaddr*)&addr, &fromlen),
+		   bytesRead > 0)
+	{
+		SockAddr address(&addr); // Wrap address
+
+		OnRecv(eventHandler, RecvBuf, bytesRead, &address);
+	}
+}
+
+
+//-----------------------------------------------------------------------------
+// TCPSocket
+
+TCPSocket::TCPSocket()
+{
+	IsConnecting = false;
+	IsListenSocket = false;
+}
+TCPSocket::TCPSocket(SocketHandle boundHandle, bool isListenSocket)
+{
+	TheSocket = boundHandle;
+	IsListenSocket = isListenSocket;
+	IsConnecting = false;
+	SetSocketOptions(TheSocket);
+	SetNoDelay(TheSocket);
+
+	// The actual socket is always non-blocking
+	SetNonBlocking(TheSocket, true);
+}
+
+TCPSocket::~TCPSocket()
+{
+}
+
+void TCPSocket::OnRecv(SocketEvent_TCP* eventHandler, uint8_t* pData, int bytesRead)
+{
+	eventHandler->TCP_OnRecv(this, pData, bytesRead);
+}
+
+SocketHandle TCPSocket::Bind(BerkleyBindParameters* pBindParameters)
+{
+	SocketHandle s = BindShared(AF_INET6, SOCK_STREAM, pBindParameters);
+	if (s == INVALID_SOCKET)
+		return s;
+
+	Close();
+
+    SetBlockingTimeout(pBindParameters->blockingTimeout);
+    TheSocket = s;
+
+    SetSocketOptions(TheSocket);
+    SetNoDelay(TheSocket);
+
+	return TheSocket;
+}
+
+int TCPSocket::Listen()
+{
+    if (IsListenSocket)
+    {
+        return 0;
+    }
+
+	int i = listen(TheSocket, SOMAXCONN);
+	if (i >= 0)
+	{
+		IsListenSocket = true;
+	}
+
+	return i;
+}
+
+int TCPSocket::Connect(SockAddr* address)
+{
+	int retval;
+
+	retval = connect(TheSocket, (struct sockaddr *) &address->Addr6, sizeof(address->Addr6));
+	if (retval < 0)
+	{
+		int err = errno;
+		if (err == EINPROGRESS || err == EWOULDBLOCK)
+		{
+            IsConnecting = true;
+            return 0;
+		}
+
+		printf( "TCPSocket::Connect failed:Error code - %d\n", err );
+	}
+
+	return retval;
+}
+
+int TCPSocket::Send(const void* pData, int bytes)
+{
+	if (bytes <= 0)
+	{
+		return 0;
+	}
+	else
+	{
+		return (int)send(TheSocket, (const char*)pData, bytes, OVR_SEND_FLAGS);
+	}
+}
+
+
+//// TCPSocketPollState
+
+TCPSocketPollState::TCPSocketPollState()
+{
+    FD_ZERO(&readFD);
+    FD_ZERO(&exceptionFD);
+    FD_ZERO(&writeFD);
+    largestDescriptor = INVALID_SOCKET;
+}
+
+bool TCPSocketPollState::IsValid() const
+{
+    return largestDescriptor != INVALID_SOCKET;
+}
+
+void TCPSocketPollState::Add(TCPSocket* tcpSocket)
+{
+    if (!tcpSocket)
+    {
+        return;
+    }
+
+    SocketHandle handle = tcpSocket->GetSocketHandle();
+
+    // select() can't watch descriptors past FD_SETSIZE
+    if (handle >= FD_SETSIZE)
+    {
+        OVR_ASSERT(false);
+        return;
+    }
+
+    if (largestDescriptor == INVALID_SOCKET ||
+        largestDescriptor < handle)
+    {
+        largestDescriptor = handle;
+    }
+
+    FD_SET(handle, &readFD);
+    FD_SET(handle, &exceptionFD);
+
+    if (tcpSocket->IsConnecting)
+    {
+        FD_SET(handle, &writeFD);
+    }
+}
+
+bool TCPSocketPollState::Poll(long usec, long seconds)
+{
+    timeval tv;
+    tv.tv_sec = seconds;
+    tv.tv_usec = usec;
+
+    return (int)select((int)largestDescriptor + 1, &readFD, &writeFD, &exceptionFD, &tv) > 0;
+}
+
+void TCPSocketPollState::HandleEvent(TCPSocket* tcpSocket, SocketEvent_TCP* eventHandler)
+{
+    if (!tcpSocket || !eventHandler)
+    {
+        return;
+    }
+
+    SocketHandle handle = tcpSocket->GetSocketHandle();
+
+    if (handle == INVALID_SOCKET || handle >= FD_SETSIZE)
+    {
+        return;
+    }
+
+    if (tcpSocket->IsConnecting && FD_ISSET(handle, &writeFD))
+    {
+        tcpSocket->IsConnecting = false;
+        eventHandler->TCP_OnConnected(tcpSocket);
+    }
+
+    if (FD_ISSET(handle, &readFD))
+    {
+        if (!tcpSocket->IsListenSocket)
+        {
+            static const int BUFF_SIZE = 8096;
+            char data[BUFF_SIZE];
+
+            // Receive straight into the socket's own buffer if it has one
+            int      capacity = 0;
+            uint8_t* pBuffer  = tcpSocket->GetRecvBuffer(&capacity);
+            if (!pBuffer || capacity <= 0)
+            {
+                pBuffer  = (uint8_t*)data;
+                capacity = BUFF_SIZE;
+            }
+
+            int bytesRead = (int)recv(handle, (char*)pBuffer, capacity, 0);
+            if (bytesRead > 0)
+            {
+                tcpSocket->OnRecv(eventHandler, pBuffer, bytesRead);
+            }
+            else if (bytesRead < 0 && (errno == EWOULDBLOCK || errno == EAGAIN || errno == EINTR))
+            {
+                // Spurious wakeup
+            }
+            else // Disconnection event:
+            {
+                tcpSocket->IsConnecting = false;
+                eventHandler->TCP_OnClosed(tcpSocket);
+            }
+        }
+        else
+        {
+            struct sockaddr_storage sockAddr;
+            socklen_t sockAddrSize = sizeof(sockAddr);
+
+            SocketHandle newSock = accept(handle, (sockaddr*)&sockAddr, (socklen_t*)&sockAddrSize);
+            if (newSock != INVALID_SOCKET)
+            {
+                SockAddr sa(&sockAddr);
+                eventHandler->TCP_OnAccept(tcpSocket, &sa, newSock);
+            }
+        }
+    }
+
+    if (FD_ISSET(handle, &exceptionFD))
+    {
+        tcpSocket->IsConnecting = false;
+        eventHandler->TCP_OnClosed(tcpSocket);
+    }
+}
+
+
+#ifdef OVR_OS_LINUX
+
+//// TCPSocketReactor
+
+// Reads and accepts handled per event before the socket goes back in line behind the others
+static const int ReactorMaxOpsPerEvent = 16;
+static const int ReactorMaxEvents      = 64;
+
+static uint64_t ReactorEventData(SocketHandle handle, uint32_t generation)
+{
+    return ((uint64_t)generation << 32) | (uint32_t)handle;
+}
+
+static uint32_t ReactorEventMask(const TCPSocket* tcpSocket)
+{
+    uint32_t mask = EPOLLIN | EPOLLRDHUP | EPOLLET | EPOLLONESHOT;
+    if (tcpSocket->IsConnecting)
+    {
+        mask |= EPOLLOUT;
+    }
+    return mask;
+}
+
+TCPSocketReactor::TCPSocketReactor() :
+    EpollHandle(-1),
+    WakeHandle(-1),
+    SocketCount(0),
+    NextGeneration(0),
+    TimeoutMs(0)
+{
+    EpollHandle = epoll_create1(EPOLL_CLOEXEC);
+    if (EpollHandle < 0)
+    {
+        OVR::LogError("{ERR-021u} [Socket] epoll_create1 failed: %d", errno);
+        return;
+    }
+
+    // Level-triggered, so every poller wakes up until one of them reads it
+    WakeHandle = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (WakeHandle >= 0)
+    {
+        epoll_event ev;
+        memset(&ev, 0, sizeof(ev));
+        ev.events = EPOLLIN;
+        ev.data.u64 = ~(uint64_t)0;
+        epoll_ctl(EpollHandle, EPOLL_CTL_ADD, WakeHandle, &ev);
+    }
+}
+
+TCPSocketReactor::~TCPSocketReactor()
+{
+    if (WakeHandle >= 0)
+    {
+        close(WakeHandle);
+    }
+    if (EpollHandle >= 0)
+    {
+        close(EpollHandle);
+    }
+}
+
+bool TCPSocketReactor::IsValid() const
+{
+    return EpollHandle >= 0;
+}
+
+bool TCPSocketReactor::Add(TCPSocket* tcpSocket)
+{
+    if (!tcpSocket || !IsValid())
+    {
+        return false;
+    }
+
+    SocketHandle handle = tcpSocket->GetSocketHandle();
+    if (handle == INVALID_SOCKET)
+    {
+        return false;
+    }
+
+    Lock::Locker locker(&RegistrationLock);
+
+    if (Registrations.GetSizeI() <= handle)
+    {
+        Registrations.Resize(handle + 1);
+    }
+
+    Registration& reg = Registrations[handle];
+    if (reg.pSocket == tcpSocket)
+    {
+        // Already added
+        return true;
+    }
+    OVR_ASSERT(!reg.pSocket);
+
+    if (SocketCount == 0)
+    {
+        TimeoutMs = tcpSocket->GetBlockingTimeoutSec() * 1000 + tcpSocket->GetBlockingTimeoutUsec() / 1000;
+    }
+
+    reg.pSocket    = tcpSocket;
+    reg.Generation = ++NextGeneration;
+    reg.Armed      = true;
+
+    epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events   = ReactorEventMask(tcpSocket);
+    ev.data.u64 = ReactorEventData(handle, reg.Generation);
+
+    if (epoll_ctl(EpollHandle, EPOLL_CTL_ADD, handle, &ev) != 0)
+    {
+        reg.pSocket.Clear();
+        return false;
+    }
+
+    ++SocketCount;
+    return true;
+}
+
+void TCPSocketReactor::Remove(TCPSocket* tcpSocket)
+{
+    if (!tcpSocket)
+    {
+        return;
+    }
+
+    // Released outside the lock
+    Ptr<TCPSocket> removed;
+
+    Lock::Locker locker(&RegistrationLock);
+
+    SocketHandle handle = tcpSocket->GetSocketHandle();
+    if (handle == INVALID_SOCKET || handle >= Registrations.GetSizeI() ||
+        Registrations[handle].pSocket != tcpSocket)
+    {
+        // The socket was closed, so its descriptor is unknown
+        handle = INVALID_SOCKET;
+        for (int i = 0; i < Registrations.GetSizeI(); ++i)
+        {
+            if (Registrations[i].pSocket == tcpSocket)
+            {
+                handle = i;
+                break;
+            }
+        }
+
+        if (handle == INVALID_SOCKET)
+        {
+            return;
+        }
+    }
+    else
+    {
+        // Closing the descriptor would remove it too, but the socket may still be open
+        epoll_ctl(EpollHandle, EPOLL_CTL_DEL, handle, NULL);
+    }
+
+    Registration& reg = Registrations[handle];
+    removed = reg.pSocket;
+    reg.pSocket.Clear();
+    reg.Armed = true;
+    --SocketCount;
+
+    for (int i = 0; i < ParkedListeners.GetSizeI(); ++i)
+    {
+        if (ParkedListeners[i] == handle)
+        {
+            ParkedListeners.RemoveAtUnordered(i);
+            break;
+        }
+    }
+}
+
+void TCPSocketReactor::Wake()
+{
+    if (WakeHandle >= 0)
+    {
+        uint64_t one = 1;
+        ssize_t written = write(WakeHandle, &one, sizeof(one));
+        OVR_UNUSED(written);
+    }
+}
+
+void TCPSocketReactor::rearm(SocketHandle handle, uint32_t generation)
+{
+    bool closed = false;
+
+    {
+        Lock::Locker locker(&RegistrationLock);
+
+        if (handle >= Registrations.GetSizeI())
+        {
+            return;
+        }
+
+        // Skip sockets removed while the event was handled
+        Registration& reg = Registrations[handle];
+        if (!reg.pSocket || reg.Generation != generation)
+        {
+            return;
+        }
+
+        reg.Armed = true;
+
+        // Closed by another thread while the event was handled
+        if (reg.pSocket->GetSocketHandle() != handle)
+        {
+            closed = true;
+        }
+        else
+        {
+            epoll_event ev;
+            memset(&ev, 0, sizeof(ev));
+            ev.events   = ReactorEventMask(reg.pSocket);
+            ev.data.u64 = ReactorEventData(handle, generation);
+
+            // Rearming reports the socket again if it is still readable, so a socket that
+            // had more data than one event handles isn't left waiting for new data
+            epoll_ctl(EpollHandle, EPOLL_CTL_MOD, handle, &ev);
+        }
+    }
+
+    if (closed)
+    {
+        Wake();
+    }
+}
+
+void TCPSocketReactor::closeInvalidSockets(SocketEvent_TCP* eventHandler)
+{
+    Array< Ptr<TCPSocket> > closed;
+
+    {
+        Lock::Locker locker(&RegistrationLock);
+
+        for (int i = 0; i < Registrations.GetSizeI(); ++i)
+        {
+            Registration& reg = Registrations[i];
+
+            // Sockets still being handled by another poller are left to it
+            if (reg.pSocket && reg.Armed && reg.pSocket->GetSocketHandle() == INVALID_SOCKET)
+            {
+                closed.PushBack(reg.pSocket);
+            }
+        }
+    }
+
+    for (int i = 0; i < closed.GetSizeI(); ++i)
+    {
+        TCPSocket* tcpSocket = closed[i];
+
+        OVR_DEBUG_LOG(("[Session] Detected an invalid socket handle - Treating it as a disconnection."));
+        Remove(tcpSocket);
+
+        if (!tcpSocket->IsListenSocket)
+        {
+            tcpSocket->IsConnecting = false;
+            eventHandler->TCP_OnClosed(tcpSocket);
+        }
+    }
+}
+
+bool TCPSocketReactor::Poll(SocketEvent_TCP* eventHandler, bool handleListeners)
+{
+    if (!IsValid() || !eventHandler)
+    {
+        return false;
+    }
+
+    {
+        Lock::Locker locker(&RegistrationLock);
+
+        // Nothing to wait for, as with an empty TCPSocketPollState
+        if (SocketCount == 0)
+        {
+            return false;
+        }
+
+        // Listeners that had an event during a poll that didn't handle them
+        if (handleListeners)
+        {
+            for (int i = 0; i < ParkedListeners.GetSizeI(); ++i)
+            {
+                SocketHandle handle = ParkedListeners[i];
+                Registration& reg = Registrations[handle];
+
+                epoll_event ev;
+                memset(&ev, 0, sizeof(ev));
+                ev.events   = ReactorEventMask(reg.pSocket);
+                ev.data.u64 = ReactorEventData(handle, reg.Generation);
+                epoll_ctl(EpollHandle, EPOLL_CTL_MOD, handle, &ev);
+                reg.Armed = true;
+            }
+            ParkedListeners.Clear();
+        }
+    }
+
+    epoll_event events[ReactorMaxEvents];
+    int count = epoll_wait(EpollHandle, events, ReactorMaxEvents, TimeoutMs);
+    if (count <= 0)
+    {
+        return false;
+    }
+
+    for (int i = 0; i < count; ++i)
+    {
+        if (events[i].data.u64 == ~(uint64_t)0)
+        {
+            uint64_t value;
+            if (read(WakeHandle, &value, sizeof(value)) > 0)
+            {
+                closeInvalidSockets(eventHandler);
+            }
+            continue;
+        }
+
+        SocketHandle   handle     = (SocketHandle)(uint32_t)events[i].data.u64;
+        uint32_t       generation = (uint32_t)(events[i].data.u64 >> 32);
+        Ptr<TCPSocket> tcpSocket;
+
+        {
+            Lock::Locker locker(&RegistrationLock);
+
+            if (handle >= Registrations.GetSizeI())
+            {
+                continue;
+            }
+
+            // Ignore events for a socket that was removed, or whose descriptor was reused
+            Registration& reg = Registrations[handle];
+            if (!reg.pSocket || reg.Generation != generation)
+            {
+                continue;
+            }
+
+            reg.Armed = false;
+
+            if (reg.pSocket->IsListenSocket && !handleListeners)
+            {
+                ParkedListeners.PushBack(handle);
+                continue;
+            }
+
+            tcpSocket = reg.pSocket;
+        }
+
+        handleEvent(tcpSocket, events[i].events, eventHandler);
+        rearm(handle, generation);
+    }
+
+    return true;
+}
+
+void TCPSocketReactor::handleEvent(TCPSocket* tcpSocket, uint32_t events, SocketEvent_TCP* eventHandler)
+{
+    SocketHandle handle = tcpSocket->GetSocketHandle();
+    if (handle == INVALID_SOCKET)
+    {
+        return;
+    }
+
+    if (tcpSocket->IsConnecting && (events & (EPOLLOUT | EPOLLERR | EPOLLHUP)))
+    {
+        int       error = 0;
+        socklen_t errorSize = sizeof(error);
+        if (getsockopt(handle, SOL_SOCKET, SO_ERROR, &error, &errorSize) != 0)
+        {
+            error = errno;
+        }
+
+        tcpSocket->IsConnecting = false;
+
+        if (error != 0)
+        {
+            eventHandler->TCP_OnClosed(tcpSocket);
+            return;
+        }
+
+        eventHandler->TCP_OnConnected(tcpSocket);
+    }
+
+    if (!(events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR)))
+    {
+        return;
+    }
+
+    if (tcpSocket->IsListenSocket)
+    {
+        for (int op = 0; op < ReactorMaxOpsPerEvent; ++op)
+        {
+            struct sockaddr_storage sockAddr;
+            socklen_t sockAddrSize = sizeof(sockAddr);
+
+            SocketHandle newSock = accept(handle, (sockaddr*)&sockAddr, &sockAddrSize);
+            if (newSock == INVALID_SOCKET)
+            {
+                // EAGAIN once the backlog is empty
+                break;
+            }
+
+            SockAddr sa(&sockAddr);
+            eventHandler->TCP_OnAccept(tcpSocket, &sa, newSock);
+        }
+        return;
+    }
+
+    static const int BUFF_SIZE = 8096;
+    char data[BUFF_SIZE];
+
+    for (int op = 0; op < ReactorMaxOpsPerEvent; ++op)
+    {
+        // Receive straight into the socket's own buffer if it has one
+        int      capacity = 0;
+        uint8_t* pBuffer  = tcpSocket->GetRecvBuffer(&capacity);
+        if (!pBuffer || capacity <= 0)
+        {
+            pBuffer  = (uint8_t*)data;
+            capacity = BUFF_SIZE;
+        }
+
+        int bytesRead = (int)recv(handle, (char*)pBuffer, capacity, 0);
+        if (bytesRead > 0)
+        {
+            tcpSocket->OnRecv(eventHandler, pBuffer, bytesRead);
+
+            // A short read means the socket has been drained
+            if (bytesRead < capacity)
+            {
+                break;
+            }
+        }
+        else if (bytesRead < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        else if (bytesRead < 0 && (errno == EWOULDBLOCK || errno == EAGAIN))
+        {
+            break;
+        }
+        else // Disconnection event:
+        {
+            tcpSocket->IsConnecting = false;
+            eventHandler->TCP_OnClosed(tcpSocket);
+            break;
+        }
+    }
+}
+
+#endif // OVR_OS_LINUX
+
+
+}} // namespace OVR::Net
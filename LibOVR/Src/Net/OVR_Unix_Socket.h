@@ -0,0 +1,213 @@
+/************************************************************************************
+
+PublicHeader:   n/a
+Filename    :   OVR_Unix_Socket.h
+Content     :   Berkeley sockets networking implementation for Unix platforms
+Created     :   October 17, 2014
+
+Copyright   :   Copyright 2014 Oculus VR, LLC All Rights reserved.
+
+Licensed under the Oculus VR Rift SDK License Version 3.2 (the "License");
+you may not use the Oculus VR Rift SDK except in compliance with the License,
+which is provided at the time of installation or download, or which
+otherwise accompanies this software in either electronic or hard copy form.
+
+You may obtain a copy of the License at
+
+http://www.oculusvr.com/licenses/LICENSE-3.2
+
+Unless required by applicable law or agreed to in writing, the Oculus VR SDK
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+************************************************************************************/
+
+#ifndef OVR_Unix_Socket_h
+#define OVR_Unix_Socket_h
+
+#include "OVR_Socket.h"
+#include "OVR_BitStream.h"
+#include "../Kernel/OVR_Array.h"
+#include "../Kernel/OVR_Threads.h"
+
+#include <sys/socket.h>
+#include <sys/select.h>
+#include <netinet/in.h>
+#include <netdb.h>
+
+namespace OVR { namespace Net {
+
+
+//-----------------------------------------------------------------------------
+// SockAddr
+
+// Abstraction for IPV6 socket address, with various convenience functions
+class SockAddr
+{
+public:
+	SockAddr();
+	SockAddr(SockAddr* sa);
+	SockAddr(sockaddr_storage* sa);
+	SockAddr(sockaddr_in6* sa);
+	SockAddr(const char* hostAddress, uint16_t port, int sockType);
+
+public:
+	void   Set(const sockaddr_storage* sa);
+	void   Set(const sockaddr_in6* sa);
+	void   Set(const char* hostAddress, uint16_t port, int sockType); // SOCK_DGRAM or SOCK_STREAM
+
+	uint16_t GetPort();
+
+	String ToString(bool writePort, char portDelineator) const;
+    bool IsLocalhost() const;
+
+	void   Serialize(BitStream* bs);
+	bool   Deserialize(BitStream);
+
+	bool   operator==( const SockAddr& right ) const;
+	bool   operator!=( const SockAddr& right ) const;
+	bool   operator >( const SockAddr& right ) const;
+	bool   operator <( const SockAddr& right ) const;
+
+public:
+	sockaddr_in6 Addr6;
+};
+
+
+//-----------------------------------------------------------------------------
+// UDP Socket
+
+// Unix version of UDP socket
+class UDPSocket : public UDPSocketBase
+{
+public:
+	UDPSocket();
+	virtual ~UDPSocket();
+
+public:
+	virtual SocketHandle Bind(BerkleyBindParameters* pBindParameters);
+	virtual int          Send(const void* pData, int bytes, SockAddr* address);
+	virtual void         Poll(SocketEvent_UDP* eventHandler);
+
+protected:
+	static const int RecvBufSize = 1048576;
+	uint8_t* RecvBuf;
+
+	virtual void         OnRecv(SocketEvent_UDP* eventHandler, uint8_t* pData,
+								int bytesRead, SockAddr* address);
+};
+
+
+//-----------------------------------------------------------------------------
+// TCP Socket
+
+// Unix version of TCP socket
+class TCPSocket : public TCPSocketBase
+{
+    friend class TCPSocketPollState;
+    friend class TCPSocketReactor;
+
+public:
+	TCPSocket();
+	TCPSocket(SocketHandle boundHandle, bool isListenSocket);
+	virtual ~TCPSocket();
+
+public:
+	virtual SocketHandle Bind(BerkleyBindParameters* pBindParameters);
+	virtual int          Listen();
+	virtual int          Connect(SockAddr* address);
+	virtual int          Send(const void* pData, int bytes);
+
+protected:
+	virtual void         OnRecv(SocketEvent_TCP* eventHandler, uint8_t* pData,
+								int bytesRead);
+
+public:
+	bool IsConnecting; // Is in the process of connecting?
+};
+
+
+//-----------------------------------------------------------------------------
+// TCPSocketPollState
+
+// Polls multiple blocking TCP sockets at once
+class TCPSocketPollState
+{
+    fd_set readFD, exceptionFD, writeFD;
+    SocketHandle largestDescriptor;
+
+public:
+    TCPSocketPollState();
+    bool IsValid() const;
+    void Add(TCPSocket* tcpSocket);
+    bool Poll(long usec = 30000, long seconds = 0);
+    void HandleEvent(TCPSocket* tcpSocket, SocketEvent_TCP* eventHandler);
+};
+
+
+#ifdef OVR_OS_LINUX
+
+//-----------------------------------------------------------------------------
+// TCPSocketReactor
+
+// Edge-triggered epoll alternative to TCPSocketPollState. Sockets are registered once
+// rather than gathered into a descriptor set on every poll, so the cost of a poll depends
+// on the number of sockets with events rather than the number of sockets.
+//
+// Events are one-shot: each event is handed to a single polling thread, and the socket is
+// rearmed once that thread is done with it. So Poll() may be called from several threads
+// at once, and no socket is ever serviced by two of them at the same time.
+class TCPSocketReactor
+{
+public:
+    TCPSocketReactor();
+    ~TCPSocketReactor();
+
+    // False if epoll is unavailable, in which case TCPSocketPollState should be used
+    bool IsValid() const;
+
+    // The reactor holds a reference to the socket until it is removed.
+    // The first socket added sets the poll timeout, mirroring TCPSocketPollState.
+    bool Add(TCPSocket* tcpSocket);
+    void Remove(TCPSocket* tcpSocket);
+
+    // Waits for events and dispatches them to eventHandler.
+    // If handleListeners is false, listen sockets are left unarmed until a poll that handles them.
+    // Returns false if nothing happened before the timeout.
+    bool Poll(SocketEvent_TCP* eventHandler, bool handleListeners = true);
+
+    // Wakes up pollers, which then report any socket closed by another thread as disconnected.
+    void Wake();
+
+protected:
+    struct Registration
+    {
+        Registration() : Generation(0), Armed(true) {}
+
+        Ptr<TCPSocket> pSocket;
+        uint32_t       Generation;  // Distinguishes reuses of the same descriptor
+        bool           Armed;       // False while an event is being handled or a listener is parked
+    };
+
+    void handleEvent(TCPSocket* tcpSocket, uint32_t events, SocketEvent_TCP* eventHandler);
+    void rearm(SocketHandle handle, uint32_t generation);
+    void closeInvalidSockets(SocketEvent_TCP* eventHandler);
+
+    int                   EpollHandle;
+    int                   WakeHandle;       // eventfd used by Wake()
+    Lock                  RegistrationLock;
+    Array< Registration > Registrations;    // Indexed by socket descriptor
+    Array< SocketHandle > ParkedListeners;  // Listeners with an event waiting for a listener poll
+    int                   SocketCount;
+    uint32_t              NextGeneration;
+    int                   TimeoutMs;
+};
+
+#endif // OVR_OS_LINUX
+
+
+}} // OVR::Net
+
+#endif
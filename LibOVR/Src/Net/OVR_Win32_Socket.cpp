@@ -572,10 +572,19 @@ void TCPSocketPollState::HandleEvent(TCPSocket* tcpSocket, SocketEvent_TCP* even
             static const int BUFF_SIZE = 8096;
             char data[BUFF_SIZE];
 
-            int bytesRead = recv(handle, data, BUFF_SIZE, 0);
+            // Receive straight into the socket's own buffer if it has one
+            int      capacity = 0;
+            uint8_t* pBuffer  = tcpSocket->GetRecvBuffer(&capacity);
+            if (!pBuffer || capacity <= 0)
+            {
+                pBuffer  = (uint8_t*)data;
+                capacity = BUFF_SIZE;
+            }
+
+            int bytesRead = recv(handle, (char*)pBuffer, capacity, 0);
             if (bytesRead > 0)
             {
-                tcpSocket->OnRecv(eventHandler, (uint8_t*)data, bytesRead);
+                tcpSocket->OnRecv(eventHandler, pBuffer, bytesRead);
             }
             else // Disconnection event:
             {
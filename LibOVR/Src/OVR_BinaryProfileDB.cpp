@@ -0,0 +1,756 @@
+/************************************************************************************
+
+PublicHeader:   None
+Filename    :   OVR_BinaryProfileDB.cpp
+Content     :   Memory-mapped binary form of the profile database
+Created     :   October 17, 2014
+
+Copyright   :   Copyright 2014 Oculus VR, LLC All Rights reserved.
+
+Licensed under the Oculus VR Rift SDK License Version 3.2 (the "License");
+you may not use the Oculus VR Rift SDK except in compliance with the License,
+which is provided at the time of installation or download, or which
+otherwise accompanies this software in either electronic or hard copy form.
+
+You may obtain a copy of the License at
+
+http://www.oculusvr.com/licenses/LICENSE-3.2
+
+Unless required by applicable law or agreed to in writing, the Oculus VR SDK
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+************************************************************************************/
+
+#include "OVR_BinaryProfileDB.h"
+#include "OVR_JSON.h"
+#include "Kernel/OVR_CRC32.h"
+#include "Kernel/OVR_StringHash.h"
+#include "Kernel/OVR_SysFile.h"
+#include "Kernel/OVR_MappedFile.h"
+
+namespace OVR {
+
+
+//-----------------------------------------------------------------------------
+// File format
+
+static const uint32_t BinaryProfileMagic        = 0x5056524F;  // "OVRP"
+static const uint32_t BinaryProfileUpdateMagic  = 0x5556524F;  // "OVRU"
+static const uint16_t BinaryProfileMajorVersion = 2;
+static const uint16_t BinaryProfileMinorVersion = 0;
+
+struct BinaryProfileHeader
+{
+    uint32_t    Magic;
+    uint16_t    MajorVersion;
+    uint16_t    MinorVersion;
+    uint32_t    HeaderSize;
+    uint32_t    ImageSize;          // Header, nodes, tag sets and strings
+    uint32_t    UpdatesSize;        // Update records following the image
+    uint32_t    NodeCount;
+    uint32_t    TagSetCount;
+    uint32_t    StringsSize;
+    int64_t     SourceSize;         // JSON file that the database matches
+    int64_t     SourceModifyTime;
+    uint32_t    SourceCRC;
+    uint32_t    Reserved;
+    uint32_t    ImageCRC;           // Of the image following the header
+    uint32_t    HeaderCRC;          // Of the header up to here
+};
+
+// An update record is followed by its nodes and strings, padded to 8 bytes
+struct BinaryProfileUpdateHeader
+{
+    uint32_t    Magic;
+    uint32_t    Size;               // Of the nodes and strings with padding
+    uint32_t    CRC;                // Of the rest of the header and the data
+    uint32_t    NodeCount;
+    uint32_t    StringsSize;
+    uint32_t    Reserved;
+};
+
+// Updates beyond this share of the image are compacted by writing the file again
+static const uint32_t BinaryProfileMaxUpdateRatio = 2;
+
+static inline uint32_t AlignSize(uint32_t size)
+{
+    return (size + 7) & ~7u;
+}
+
+static uint32_t GetHeaderCRC(const BinaryProfileHeader& header)
+{
+    return CRC32_Calculate(&header, (int)OVR_OFFSETOF(BinaryProfileHeader, HeaderCRC));
+}
+
+static uint32_t GetUpdateCRC(const BinaryProfileUpdateHeader& header, const uint8_t* data)
+{
+    const int fields = (int)(sizeof(header) - OVR_OFFSETOF(BinaryProfileUpdateHeader, NodeCount));
+    uint32_t crc = CRC32_Calculate(&header.NodeCount, fields);
+    return CRC32_Calculate(data, (int)header.Size, ~crc);
+}
+
+static bool SourceMatches(const BinaryProfileHeader& header, const BinaryProfileSource& source)
+{
+    return header.SourceSize == source.FileSize && header.SourceModifyTime == source.ModifyTime &&
+           header.SourceCRC == source.CRC;
+}
+
+static void SetSource(BinaryProfileHeader& header, const BinaryProfileSource& source)
+{
+    header.SourceSize       = source.FileSize;
+    header.SourceModifyTime = source.ModifyTime;
+    header.SourceCRC        = source.CRC;
+}
+
+
+//-----------------------------------------------------------------------------
+// ***** BinaryProfileSource
+
+bool BinaryProfileSource::Read(const String& path)
+{
+    FileStat   stat;
+    MappedFile file;
+    if (!SysFile::GetFileStat(&stat, path) || !file.Open(path))
+        return false;
+
+    FileSize   = stat.FileSize;
+    ModifyTime = stat.ModifyTime;
+    CRC        = CRC32_Calculate(file.GetData(), (int)file.GetSize());
+    return true;
+}
+
+
+//-----------------------------------------------------------------------------
+// Tag matching
+
+// The hash of a set of tags doesn't depend on their order
+static uint32_t HashTag(const char* tag_name, const char* tag)
+{
+    uint32_t crc = CRC32_Calculate(tag_name, (int)OVR_strlen(tag_name) + 1);
+    return CRC32_Calculate(tag, (int)OVR_strlen(tag), ~crc);
+}
+
+static bool HasDistinctNames(const char** tag_names, int num_tags)
+{
+    for (int i = 1; i < num_tags; i++)
+    {
+        for (int j = 0; j < i; j++)
+        {
+            if (OVR_strcmp(tag_names[i], tag_names[j]) == 0)
+                return false;
+        }
+    }
+    return true;
+}
+
+static uint32_t HashTagSet(const char** tag_names, const char** tags, int num_tags)
+{
+    uint32_t hash = (uint32_t)num_tags;
+    for (int i = 0; i < num_tags; i++)
+        hash += HashTag(tag_names[i], tags[i]);
+    return hash;
+}
+
+// Gathers the tags of a TaggedData entry.  Returns false if the entry has no tag array,
+// or has an empty tag or a repeated tag name; such entries never match distinct tags.
+static bool GetEntryTags(const BinaryProfileDB::NodeTable& table, const BinaryProfileDB::Node* entry,
+                         Array<const char*>& tag_names, Array<const char*>& tags)
+{
+    const BinaryProfileDB::Node* tag_array = table.GetItemByName(entry, "tags");
+    if (tag_array == NULL || tag_array->Type != JSON_Array)
+        return false;
+
+    tag_names.Clear();
+    tags.Clear();
+    for (uint32_t i = 0; i < tag_array->ChildCount; i++)
+    {
+        const BinaryProfileDB::Node* tag = table.Nodes + tag_array->FirstChild + i;
+        if (tag->ChildCount == 0)
+            return false;
+
+        const BinaryProfileDB::Node* tagval = table.Nodes + tag->FirstChild;
+        tag_names.PushBack(table.GetString(tagval->Name));
+        tags.PushBack(table.GetString(tagval->Value));
+    }
+
+    return HasDistinctNames(tag_names.GetDataPtr(), (int)tag_names.GetSize());
+}
+
+// Matches the tags of an entry in the same way as the JSON profile database
+static bool EntryMatches(const BinaryProfileDB::NodeTable& table, const BinaryProfileDB::Node* entry,
+                         const char** tag_names, const char** tags, int num_tags)
+{
+    const BinaryProfileDB::Node* tag_array = table.GetItemByName(entry, "tags");
+    if (tag_array == NULL || tag_array->Type != JSON_Array || tag_array->ChildCount != (uint32_t)num_tags)
+        return false;
+
+    for (int k = 0; k < num_tags; k++)
+    {
+        bool matched = false;
+        for (uint32_t i = 0; i < tag_array->ChildCount; i++)
+        {
+            const BinaryProfileDB::Node* tag = table.Nodes + tag_array->FirstChild + i;
+            if (tag->ChildCount == 0)
+                continue;
+
+            const BinaryProfileDB::Node* tagval = table.Nodes + tag->FirstChild;
+            if (OVR_strcmp(table.GetString(tagval->Name), tag_names[k]) == 0)
+            {
+                matched = (OVR_strcmp(table.GetString(tagval->Value), tags[k]) == 0);
+                break;
+            }
+        }
+
+        if (!matched)
+            return false;
+    }
+    return true;
+}
+
+
+//-----------------------------------------------------------------------------
+// Encoding
+
+// Builds the node table of a tree.  The nodes are laid out breadth first, so that
+// the children of each node are consecutive.
+class BinaryProfileEncoder
+{
+public:
+    BinaryProfileEncoder()
+    {
+        Strings.PushBack(0);   // Offset 0 is the empty string
+    }
+
+    void Encode(JSON* root)
+    {
+        Array<JSON*> items;
+        items.PushBack(root);
+        Nodes.PushBack(makeNode(root));
+
+        // The index of an item in items is its node index
+        for (size_t i = 0; i < items.GetSize(); i++)
+        {
+            JSON*    item  = items[i];
+            uint32_t first = (uint32_t)Nodes.GetSize();
+            uint32_t count = 0;
+
+            for (JSON* child = item->GetFirstItem(); child; child = item->GetNextItem(child))
+            {
+                items.PushBack(child);
+                Nodes.PushBack(makeNode(child));
+                count++;
+            }
+
+            Nodes[i].FirstChild = count ? first : 0;
+            Nodes[i].ChildCount = count;
+        }
+    }
+
+    // Pads the strings to 8 bytes
+    uint32_t GetStringsSize() const { return (uint32_t)Strings.GetSize(); }
+    void     PadStrings()           { while (Strings.GetSize() & 7) Strings.PushBack(0); }
+
+    BinaryProfileDB::NodeTable GetTable() const
+    {
+        BinaryProfileDB::NodeTable table;
+        table.Nodes       = Nodes.GetDataPtr();
+        table.NodeCount   = (uint32_t)Nodes.GetSize();
+        table.Strings     = Strings.GetDataPtr();
+        table.StringsSize = (uint32_t)Strings.GetSize();
+        return table;
+    }
+
+    ArrayPOD<BinaryProfileDB::Node> Nodes;
+    ArrayPOD<char>                  Strings;
+
+protected:
+    BinaryProfileDB::Node makeNode(JSON* item)
+    {
+        BinaryProfileDB::Node node;
+        node.Type       = (uint32_t)item->Type;
+        node.Name       = addString(item->Name);
+        node.Value      = addString(item->Value);
+        node.FirstChild = 0;
+        node.ChildCount = 0;
+        node.Reserved   = 0;
+        node.dValue     = item->dValue;
+        return node;
+    }
+
+    uint32_t addString(const String& s)
+    {
+        if (s.IsEmpty())
+            return 0;
+
+        uint32_t* poffset = Offsets.Get(s);
+        if (poffset)
+            return *poffset;
+
+        uint32_t offset = (uint32_t)Strings.GetSize();
+        Strings.Append(s.ToCStr(), s.GetSize() + 1);
+        Offsets.Set(s, offset);
+        return offset;
+    }
+
+    StringHash<uint32_t>            Offsets;
+};
+
+static bool WriteBytes(File* file, const void* data, size_t size)
+{
+    return file->Write((const uint8_t*)data, (int)size) == (int)size;
+}
+
+static bool TagSetLess(const BinaryProfileDB::TagSet& a, const BinaryProfileDB::TagSet& b)
+{
+    return (a.Hash != b.Hash) ? (a.Hash < b.Hash) : (a.Item < b.Item);
+}
+
+
+//-----------------------------------------------------------------------------
+// ***** BinaryProfileDB
+
+bool BinaryProfileDB::NodeTable::IsValid() const
+{
+    if (StringsSize == 0 || Strings[0] != 0 || Strings[StringsSize - 1] != 0 || NodeCount == 0)
+        return false;
+
+    for (uint32_t i = 0; i < NodeCount; i++)
+    {
+        const Node& node = Nodes[i];
+        if (node.Type > JSON_Object || node.Name >= StringsSize || node.Value >= StringsSize)
+            return false;
+
+        // Children follow their parent, which rules out cycles
+        if (node.ChildCount && (node.FirstChild <= i || node.FirstChild > NodeCount ||
+                                node.ChildCount > NodeCount - node.FirstChild))
+            return false;
+    }
+    return true;
+}
+
+const BinaryProfileDB::Node* BinaryProfileDB::NodeTable::GetItemByName(const Node* node, const char* name) const
+{
+    for (uint32_t i = 0; i < node->ChildCount; i++)
+    {
+        const Node* child = Nodes + node->FirstChild + i;
+        if (OVR_strcmp(GetString(child->Name), name) == 0)
+            return child;
+    }
+    return NULL;
+}
+
+// Decodes a node and its children
+static JSON* DecodeNode(const BinaryProfileDB::NodeTable& table, const BinaryProfileDB::Node* node)
+{
+    JSON* item = JSON::CreateNull();
+    item->Type   = (JSONItemType)node->Type;
+    item->Value  = table.GetString(node->Value);
+    item->dValue = node->dValue;
+
+    for (uint32_t i = 0; i < node->ChildCount; i++)
+    {
+        const BinaryProfileDB::Node* child = table.Nodes + node->FirstChild + i;
+        item->AddItem(table.GetString(child->Name), DecodeNode(table, child));
+    }
+    return item;
+}
+
+BinaryProfileDB::BinaryProfileDB(MappedFile* mapping) :
+    pMapping(mapping),
+    TagSets(NULL),
+    TagSetCount(0)
+{
+}
+
+BinaryProfileDB::~BinaryProfileDB()
+{
+    Decoded.Clear();
+    delete pMapping;
+}
+
+BinaryProfileDB* BinaryProfileDB::Open(const String& path, const BinaryProfileSource& source)
+{
+    MappedFile* mapping = new MappedFile;
+    if (!mapping->Open(path) || mapping->GetSize() < sizeof(BinaryProfileHeader))
+    {
+        delete mapping;
+        return NULL;
+    }
+
+    const uint8_t*             data   = mapping->GetData();
+    const BinaryProfileHeader& header = *(const BinaryProfileHeader*)data;
+
+    // Check the header before trusting any of its sizes
+    uint64_t nodesOffset   = AlignSize(header.HeaderSize);
+    uint64_t tagSetsOffset = nodesOffset + (uint64_t)header.NodeCount * sizeof(Node);
+    uint64_t stringsOffset = tagSetsOffset + (uint64_t)header.TagSetCount * sizeof(TagSet);
+
+    if (header.Magic != BinaryProfileMagic ||
+        header.MajorVersion != BinaryProfileMajorVersion ||
+        header.HeaderSize < sizeof(BinaryProfileHeader) ||
+        header.HeaderCRC != GetHeaderCRC(header) ||
+        !SourceMatches(header, source) ||
+        stringsOffset + header.StringsSize > header.ImageSize ||
+        (uint64_t)header.ImageSize + header.UpdatesSize != mapping->GetSize() ||
+        header.ImageCRC != CRC32_Calculate(data + header.HeaderSize, (int)(header.ImageSize - header.HeaderSize)))
+    {
+        delete mapping;
+        return NULL;
+    }
+
+    Ptr<BinaryProfileDB> db = *new BinaryProfileDB(mapping);
+
+    db->Image.Nodes       = (const Node*)(data + nodesOffset);
+    db->Image.NodeCount   = header.NodeCount;
+    db->Image.Strings     = (const char*)(data + stringsOffset);
+    db->Image.StringsSize = header.StringsSize;
+    db->TagSets           = (const TagSet*)(data + tagSetsOffset);
+    db->TagSetCount       = header.TagSetCount;
+
+    if (!db->Image.IsValid())
+        return NULL;
+
+    for (uint32_t i = 0; i < db->TagSetCount; i++)
+    {
+        if (db->TagSets[i].Item >= db->Image.NodeCount)
+            return NULL;
+    }
+
+    // Gather the update records
+    Array<const char*> tag_names, tags;
+    size_t offset = header.ImageSize;
+    while (offset < mapping->GetSize())
+    {
+        if (mapping->GetSize() - offset < sizeof(BinaryProfileUpdateHeader))
+            return NULL;
+
+        const BinaryProfileUpdateHeader& record = *(const BinaryProfileUpdateHeader*)(data + offset);
+        const uint8_t* recordData = data + offset + sizeof(BinaryProfileUpdateHeader);
+        offset += sizeof(BinaryProfileUpdateHeader);
+
+        if (record.Magic != BinaryProfileUpdateMagic ||
+            record.Size > mapping->GetSize() - offset || (record.Size & 7) != 0 ||
+            (uint64_t)record.NodeCount * sizeof(Node) + record.StringsSize > record.Size ||
+            record.CRC != GetUpdateCRC(record, recordData))
+            return NULL;
+
+        Update update;
+        update.Table.Nodes       = (const Node*)recordData;
+        update.Table.NodeCount   = record.NodeCount;
+        update.Table.Strings     = (const char*)(recordData + record.NodeCount * sizeof(Node));
+        update.Table.StringsSize = record.StringsSize;
+
+        if (!update.Table.IsValid() ||
+            !GetEntryTags(update.Table, update.Table.Nodes, tag_names, tags))
+            return NULL;
+
+        update.Hash = HashTagSet(tag_names.GetDataPtr(), tags.GetDataPtr(), (int)tag_names.GetSize());
+        db->Updates.PushBack(update);
+
+        offset += record.Size;
+    }
+
+    db->AddRef();
+    return db;
+}
+
+bool BinaryProfileDB::Write(const String& path, JSON* root, const BinaryProfileSource& source)
+{
+    BinaryProfileEncoder encoder;
+    encoder.Encode(root);
+
+    BinaryProfileDB::NodeTable table = encoder.GetTable();
+
+    // Index the TaggedData entries.  Entries without distinct tags are left out, since
+    // only queries with distinct tags are answered here.  Entries without values
+    // aren't supported.
+    Array<TagSet>      tagSets;
+    Array<const char*> tag_names, tags;
+
+    const Node* tagged_data = table.GetItemByName(table.Nodes, "TaggedData");
+    if (tagged_data && tagged_data->Type == JSON_Array)
+    {
+        for (uint32_t i = 0; i < tagged_data->ChildCount; i++)
+        {
+            const Node* entry = table.Nodes + tagged_data->FirstChild + i;
+            const Node* vals  = table.GetItemByName(entry, "vals");
+            if (vals == NULL || vals->Type != JSON_Object)
+                return false;
+
+            if (GetEntryTags(table, entry, tag_names, tags))
+            {
+                TagSet tagSet;
+                tagSet.Hash = HashTagSet(tag_names.GetDataPtr(), tags.GetDataPtr(), (int)tag_names.GetSize());
+                tagSet.Item = tagged_data->FirstChild + i;
+                tagSets.PushBack(tagSet);
+            }
+        }
+    }
+
+    Alg::QuickSort(tagSets, TagSetLess);
+
+    uint32_t stringsSize = encoder.GetStringsSize();
+    encoder.PadStrings();
+
+    BinaryProfileHeader header;
+    memset(&header, 0, sizeof(header));
+    header.Magic            = BinaryProfileMagic;
+    header.MajorVersion     = BinaryProfileMajorVersion;
+    header.MinorVersion     = BinaryProfileMinorVersion;
+    header.HeaderSize       = sizeof(BinaryProfileHeader);
+    header.NodeCount        = (uint32_t)encoder.Nodes.GetSize();
+    header.TagSetCount      = (uint32_t)tagSets.GetSize();
+    header.StringsSize      = stringsSize;
+    header.ImageSize        = (uint32_t)(sizeof(header) + encoder.Nodes.GetSize() * sizeof(Node) +
+                                         tagSets.GetSize() * sizeof(TagSet) + encoder.Strings.GetSize());
+    header.UpdatesSize      = 0;
+    SetSource(header, source);
+
+    // CRC32_Calculate returns the complement of its accumulator, so ~crc continues it
+    // and ImageCRC is the checksum of the whole image as Open computes it
+    uint32_t crc = CRC32_Calculate(encoder.Nodes.GetDataPtr(), (int)(encoder.Nodes.GetSize() * sizeof(Node)));
+    crc = CRC32_Calculate(tagSets.GetDataPtr(), (int)(tagSets.GetSize() * sizeof(TagSet)), ~crc);
+    header.ImageCRC  = CRC32_Calculate(encoder.Strings.GetDataPtr(), (int)encoder.Strings.GetSize(), ~crc);
+    header.HeaderCRC = GetHeaderCRC(header);
+
+    // Write a new file and move it into place
+    String tempPath = path + ".tmp";
+    SysFile file;
+    if (!file.Open(tempPath, File::Open_Write | File::Open_Create | File::Open_Truncate, File::Mode_ReadWrite))
+        return false;
+
+    bool result = WriteBytes(&file, &header, sizeof(header)) &&
+                  WriteBytes(&file, encoder.Nodes.GetDataPtr(), encoder.Nodes.GetSize() * sizeof(Node)) &&
+                  WriteBytes(&file, tagSets.GetDataPtr(), tagSets.GetSize() * sizeof(TagSet)) &&
+                  WriteBytes(&file, encoder.Strings.GetDataPtr(), encoder.Strings.GetSize());
+    result = file.Close() && result;
+
+    if (!result)
+    {
+        RemoveFile(tempPath);
+        return false;
+    }
+
+    return ReplaceFileWith(path, tempPath);
+}
+
+bool BinaryProfileDB::Append(const String& path, const Array<JSON*>& taggedItems,
+                             const BinaryProfileSource& prevSource, const BinaryProfileSource& source)
+{
+    SysFile file;
+    if (!file.Open(path, File::Open_ReadWrite, File::Mode_ReadWrite))
+        return false;
+
+    BinaryProfileHeader header;
+    if (file.Read((uint8_t*)&header, sizeof(header)) != sizeof(header) ||
+        header.Magic != BinaryProfileMagic ||
+        header.MajorVersion != BinaryProfileMajorVersion ||
+        header.HeaderSize < sizeof(BinaryProfileHeader) ||
+        header.HeaderCRC != GetHeaderCRC(header) ||
+        !SourceMatches(header, prevSource) ||
+        (int64_t)header.ImageSize + header.UpdatesSize != file.GetLength())
+    {
+        return false;
+    }
+
+    // Encode the records
+    ArrayPOD<uint8_t>  records;
+    Array<const char*> tag_names, tags;
+    for (size_t i = 0; i < taggedItems.GetSize(); i++)
+    {
+        BinaryProfileEncoder encoder;
+        encoder.Encode(taggedItems[i]);
+
+        BinaryProfileDB::NodeTable table = encoder.GetTable();
+        const Node* vals = table.GetItemByName(table.Nodes, "vals");
+        if (vals == NULL || vals->Type != JSON_Object || !GetEntryTags(table, table.Nodes, tag_names, tags))
+            return false;
+
+        uint32_t stringsSize = encoder.GetStringsSize();
+        encoder.PadStrings();
+
+        ArrayPOD<uint8_t> data;
+        data.Append((const uint8_t*)encoder.Nodes.GetDataPtr(), encoder.Nodes.GetSize() * sizeof(Node));
+        data.Append((const uint8_t*)encoder.Strings.GetDataPtr(), encoder.Strings.GetSize());
+
+        BinaryProfileUpdateHeader record;
+        record.Magic       = BinaryProfileUpdateMagic;
+        record.Size        = (uint32_t)data.GetSize();
+        record.NodeCount   = (uint32_t)encoder.Nodes.GetSize();
+        record.StringsSize = stringsSize;
+        record.Reserved    = 0;
+        record.CRC         = GetUpdateCRC(record, data.GetDataPtr());
+
+        records.Append((const uint8_t*)&record, sizeof(record));
+        records.Append(data.GetDataPtr(), data.GetSize());
+    }
+
+    if ((uint64_t)header.UpdatesSize + records.GetSize() > (uint64_t)header.ImageSize * BinaryProfileMaxUpdateRatio)
+        return false;
+
+    // Write the records, then the header that covers them
+    if (file.Seek((int)(header.ImageSize + header.UpdatesSize)) < 0 ||
+        !WriteBytes(&file, records.GetDataPtr(), records.GetSize()))
+    {
+        return false;
+    }
+
+    header.UpdatesSize += (uint32_t)records.GetSize();
+    SetSource(header, source);
+    header.HeaderCRC    = GetHeaderCRC(header);
+
+    bool result = file.Seek(0) == 0 && WriteBytes(&file, &header, sizeof(header));
+    return file.Close() && result;
+}
+
+const BinaryProfileDB::Node* BinaryProfileDB::findImageEntry(const char** tag_names, const char** tags,
+                                                             int num_tags, uint32_t hash) const
+{
+    // Find the first tag set with the hash; equal hashes are sorted by entry
+    uint32_t lower = 0, upper = TagSetCount;
+    while (lower < upper)
+    {
+        uint32_t middle = (lower + upper) / 2;
+        if (TagSets[middle].Hash < hash)
+            lower = middle + 1;
+        else
+            upper = middle;
+    }
+
+    for (uint32_t i = lower; i < TagSetCount && TagSets[i].Hash == hash; i++)
+    {
+        const Node* entry = Image.Nodes + TagSets[i].Item;
+        if (EntryMatches(Image, entry, tag_names, tags, num_tags))
+            return entry;
+    }
+    return NULL;
+}
+
+int BinaryProfileDB::findUpdate(const char** tag_names, const char** tags, int num_tags,
+                                uint32_t hash, int before) const
+{
+    for (int i = before - 1; i >= 0; i--)
+    {
+        if (Updates[i].Hash == hash &&
+            EntryMatches(Updates[i].Table, Updates[i].Table.Nodes, tag_names, tags, num_tags))
+            return i;
+    }
+    return -1;
+}
+
+JSON* BinaryProfileDB::getDecoded(const NodeTable& table, const Node* node)
+{
+    Ptr<JSON>* pitem = Decoded.Get(node);
+    if (pitem)
+        return *pitem;
+
+    Ptr<JSON> item = *DecodeNode(table, node);
+    Decoded.Set(node, item);
+    return item;
+}
+
+JSON* BinaryProfileDB::FindTaggedData(const char** tag_names, const char** tags, int num_tags)
+{
+    if (num_tags < 0 || !HasDistinctNames(tag_names, num_tags))
+        return NULL;
+
+    uint32_t hash = HashTagSet(tag_names, tags, num_tags);
+
+    // The latest update of an entry replaces it
+    const NodeTable* table = NULL;
+    const Node*      entry = NULL;
+
+    int update = findUpdate(tag_names, tags, num_tags, hash, (int)Updates.GetSize());
+    if (update >= 0)
+    {
+        table = &Updates[update].Table;
+        entry = table->Nodes;
+    }
+    else
+    {
+        table = &Image;
+        entry = findImageEntry(tag_names, tags, num_tags, hash);
+    }
+
+    if (entry == NULL)
+        return NULL;
+
+    const Node* vals = table->GetItemByName(entry, "vals");
+    return vals ? getDecoded(*table, vals) : NULL;
+}
+
+JSON* BinaryProfileDB::GetItemByName(const char* name)
+{
+    const Node* item = Image.GetItemByName(Image.Nodes, name);
+    return item ? getDecoded(Image, item) : NULL;
+}
+
+JSON* BinaryProfileDB::CreateJSON() const
+{
+    JSON* root = DecodeNode(Image, Image.Nodes);
+    if (Updates.GetSize() == 0)
+        return root;
+
+    JSON* tagged_data = root->GetItemByName("TaggedData");
+    if (tagged_data == NULL)
+    {
+        tagged_data = JSON::CreateArray();
+        root->AddItem("TaggedData", tagged_data);
+    }
+
+    // Decoded TaggedData entries, by node and by update record
+    Array<JSON*> entries;
+    for (JSON* entry = tagged_data->GetFirstItem(); entry; entry = tagged_data->GetNextItem(entry))
+        entries.PushBack(entry);
+
+    const Node* first_entry = NULL;
+    const Node* image_tagged_data = Image.GetItemByName(Image.Nodes, "TaggedData");
+    if (image_tagged_data && image_tagged_data->ChildCount)
+        first_entry = Image.Nodes + image_tagged_data->FirstChild;
+
+    Array<JSON*>       updated(Updates.GetSize());
+    Array<const char*> tag_names, tags;
+    for (size_t i = 0; i < Updates.GetSize(); i++)
+    {
+        const Update& update = Updates[i];
+        GetEntryTags(update.Table, update.Table.Nodes, tag_names, tags);
+
+        const char** names = tag_names.GetDataPtr();
+        const char** vals  = tags.GetDataPtr();
+        int          count = (int)tag_names.GetSize();
+
+        // Replace the entry written last with these tags, or else add this one
+        JSON* target = NULL;
+        int previous = findUpdate(names, vals, count, update.Hash, (int)i);
+        if (previous >= 0)
+        {
+            target = updated[previous];
+        }
+        else
+        {
+            const Node* entry = findImageEntry(names, vals, count, update.Hash);
+            if (entry)
+                target = entries[entry - first_entry];
+        }
+
+        JSON* item = DecodeNode(update.Table, update.Table.Nodes);
+        if (target)
+        {
+            target->ReplaceNodeWith(item);
+            target->Release();
+        }
+        else
+        {
+            tagged_data->AddArrayElement(item);
+        }
+        updated[i] = item;
+    }
+
+    return root;
+}
+
+
+} // namespace OVR
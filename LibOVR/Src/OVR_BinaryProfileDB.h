@@ -0,0 +1,182 @@
+/************************************************************************************
+
+PublicHeader:   None
+Filename    :   OVR_BinaryProfileDB.h
+Content     :   Memory-mapped binary form of the profile database
+Created     :   October 17, 2014
+Notes       :
+
+   ProfileDB.bin holds the same tree as ProfileDB.json in a form that can be
+   queried in place, so that loading a profile at startup doesn't parse the
+   JSON file.  The JSON file stays the master copy; the binary database is
+   only used while it matches it.  ProfileManager only writes it once it has
+   been enabled with SetBinaryCacheEnabled, and from then on the file's
+   presence keeps it enabled.
+
+Copyright   :   Copyright 2014 Oculus VR, LLC All Rights reserved.
+
+Licensed under the Oculus VR Rift SDK License Version 3.2 (the "License");
+you may not use the Oculus VR Rift SDK except in compliance with the License,
+which is provided at the time of installation or download, or which
+otherwise accompanies this software in either electronic or hard copy form.
+
+You may obtain a copy of the License at
+
+http://www.oculusvr.com/licenses/LICENSE-3.2
+
+Unless required by applicable law or agreed to in writing, the Oculus VR SDK
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+************************************************************************************/
+
+#ifndef OVR_BinaryProfileDB_h
+#define OVR_BinaryProfileDB_h
+
+#include "Kernel/OVR_RefCount.h"
+#include "Kernel/OVR_Array.h"
+#include "Kernel/OVR_Hash.h"
+#include "Kernel/OVR_String.h"
+
+namespace OVR {
+
+class JSON;
+class MappedFile;
+
+
+//-----------------------------------------------------------------------------
+// ***** BinaryProfileSource
+
+// Identifies the contents of the JSON file a binary database was written from.  Size
+// and modification time alone miss a rewrite of the same size within the resolution
+// of the file times, so the file's checksum is compared as well.
+struct BinaryProfileSource
+{
+    BinaryProfileSource() : FileSize(0), ModifyTime(0), CRC(0) { }
+
+    int64_t             FileSize;
+    int64_t             ModifyTime;
+    uint32_t            CRC;            // CRC32_Calculate of the whole file
+
+    // Reads the file's stats and checksums it.  Returns false if it can't be read.
+    bool                Read(const String& path);
+
+    bool operator==(const BinaryProfileSource& other) const
+    {
+        return FileSize == other.FileSize && ModifyTime == other.ModifyTime && CRC == other.CRC;
+    }
+};
+
+
+//-----------------------------------------------------------------------------
+// ***** BinaryProfileDB
+
+// Read-only view of a mapped binary profile database.  The file holds, in native
+// (little-endian) byte order:
+//
+//   Header
+//   Node[NodeCount]        - The JSON tree; node 0 is the root and the children of
+//                            a node are consecutive
+//   TagSet[TagSetCount]    - The TaggedData entries, sorted by the hash of their tags
+//   Strings                - Null-terminated names and values; offset 0 is ""
+//   Update records         - TaggedData entries saved since the file was written,
+//                            each one replacing the entry with the same tags
+//
+// The image and each update record are checksummed with CRC32_Calculate.  The header
+// also records the BinaryProfileSource of the JSON file the database matches, so a
+// database left behind by another writer of the JSON file is ignored.
+//
+// Items returned by the database are decoded on first use and stay valid for its
+// lifetime.  The object isn't thread-safe; ProfileManager serializes access to it.
+
+class BinaryProfileDB : public RefCountBase<BinaryProfileDB>
+{
+public:
+    ~BinaryProfileDB();
+
+    // Maps the database at path if it is intact and matches the given JSON file.
+    // Returns NULL otherwise.
+    static BinaryProfileDB* Open(const String& path, const BinaryProfileSource& source);
+
+    // Replaces the database at path with the tree of a profile database.
+    static bool         Write(const String& path, JSON* root, const BinaryProfileSource& source);
+
+    // Appends update records for TaggedData entries to the database at path, which
+    // must match prevSource; it then matches source.  Returns false if the database
+    // has to be written again instead.
+    static bool         Append(const String& path, const Array<JSON*>& taggedItems,
+                               const BinaryProfileSource& prevSource, const BinaryProfileSource& source);
+
+    // Returns the "vals" object of the TaggedData entry with exactly the given tags,
+    // in any order, or NULL.  Tag names must be distinct.
+    JSON*               FindTaggedData(const char** tag_names, const char** tags, int num_tags);
+
+    // Returns a top-level item such as "Users".  Update records aren't applied,
+    // so this isn't used for "TaggedData".
+    JSON*               GetItemByName(const char* name);
+
+    // Decodes the whole database with its updates applied.
+    JSON*               CreateJSON() const;
+
+public:
+    struct Node
+    {
+        uint32_t        Type;           // JSONItemType
+        uint32_t        Name;           // String offsets
+        uint32_t        Value;
+        uint32_t        FirstChild;
+        uint32_t        ChildCount;
+        uint32_t        Reserved;
+        double          dValue;
+    };
+
+    struct TagSet
+    {
+        uint32_t        Hash;
+        uint32_t        Item;           // TaggedData entry node
+    };
+
+    // Nodes and strings of the image or of an update record
+    struct NodeTable
+    {
+        NodeTable() : Nodes(NULL), NodeCount(0), Strings(NULL), StringsSize(0) { }
+
+        const Node*     Nodes;
+        uint32_t        NodeCount;
+        const char*     Strings;
+        uint32_t        StringsSize;
+
+        bool            IsValid() const;
+        const char*     GetString(uint32_t offset) const { return Strings + offset; }
+        const Node*     GetItemByName(const Node* node, const char* name) const;
+    };
+
+protected:
+    struct Update
+    {
+        uint32_t        Hash;           // Of the tags of the entry, which is node 0
+        NodeTable       Table;
+    };
+
+    BinaryProfileDB(MappedFile* mapping);
+
+    const Node*         findImageEntry(const char** tag_names, const char** tags, int num_tags,
+                                       uint32_t hash) const;
+    int                 findUpdate(const char** tag_names, const char** tags, int num_tags,
+                                   uint32_t hash, int before) const;
+    JSON*               getDecoded(const NodeTable& table, const Node* node);
+
+    MappedFile*             pMapping;
+    NodeTable               Image;
+    const TagSet*           TagSets;
+    uint32_t                TagSetCount;
+    Array<Update>           Updates;
+    Hash<const Node*, Ptr<JSON> > Decoded;
+};
+
+
+} // namespace OVR
+
+#endif // OVR_BinaryProfileDB_h
@@ -1283,6 +1283,32 @@ OVR_EXPORT ovrBool ovrHmd_StopPerfLog(ovrHmd hmd)
     return false;
 }
 
+OVR_EXPORT ovrBool ovrHmd_StartFrameTimeTrace(ovrHmd hmd, const char* fileName)
+{
+    OVR_ASSERT(fileName && fileName[0]);
+
+    OVR::CAPI::HMDState* pHMDState = (OVR::CAPI::HMDState*)hmd->Handle;
+
+    if (pHMDState)
+    {
+        ovrBool started = pHMDState->TimeTrace.Start(fileName) ? 1 : 0;
+        if (started)
+            pHMDState->TimeManager.SetTraceRecorder(&pHMDState->TimeTrace);
+        return started;
+    }
+    return 0;
+}
+OVR_EXPORT ovrBool ovrHmd_StopFrameTimeTrace(ovrHmd hmd)
+{
+    OVR::CAPI::HMDState* pHMDState = (OVR::CAPI::HMDState*)hmd->Handle;
+
+    if (pHMDState)
+    {
+        return pHMDState->TimeTrace.Stop() ? 1 : 0;
+    }
+    return false;
+}
+
 
 #ifdef __cplusplus 
 } // extern "C"
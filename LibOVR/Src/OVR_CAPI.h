@@ -936,6 +936,15 @@ OVR_EXPORT ovrBool ovrHmd_StartPerfLog(ovrHmd hmd, const char* fileName, const c
 /// Stop performance logging.
 OVR_EXPORT ovrBool ovrHmd_StopPerfLog(ovrHmd hmd);
 
+/// Start recording a binary trace of frame timing events (BeginFrame/EndFrame, predicted scanout
+/// times, timewarp waits and latency tester matches) to fileName in the Oculus data directory.
+/// Recording is cheap enough to leave on; a background thread writes the trace.
+/// The trace can be converted for chrome://tracing with Tools/FrameTimeTrace.
+/// If called while tracing is already active, the current trace is stopped first.
+OVR_EXPORT ovrBool ovrHmd_StartFrameTimeTrace(ovrHmd hmd, const char* fileName);
+/// Stop recording the frame timing trace, writing out all pending events.
+OVR_EXPORT ovrBool ovrHmd_StopFrameTimeTrace(ovrHmd hmd);
+
 
 #ifdef __cplusplus
 } // extern "C"
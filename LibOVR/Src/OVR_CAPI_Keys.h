@@ -39,6 +39,9 @@ limitations under the License.
 #define OVR_KEY_EYE_CUP                     "EyeCup"            // char[16]
 #define OVR_KEY_CUSTOM_EYE_RENDER           "CustomEyeRender"   // bool
 #define OVR_KEY_CAMERA_POSITION				"CenteredFromWorld" // double[7]
+#define OVR_KEY_TIMEWARP_MISS_PROBABILITY   "TimewarpMissProbability" // float
+#define OVR_KEY_DISTORTION_MESH_CACHE       "DistortionMeshCache" // bool
+#define OVR_KEY_PROFILE_BINARY_CACHE        "ProfileBinaryCache" // bool
 
 // Default measurements empirically determined at Oculus to make us happy
 // The neck model numbers were derived as an average of the male and female averages from ANSUR-88
@@ -53,4 +56,5 @@ limitations under the License.
 #define OVR_DEFAULT_NECK_TO_EYE_VERTICAL    0.075f
 #define OVR_DEFAULT_EYE_RELIEF_DIAL         3
 #define OVR_DEFAULT_CAMERA_POSITION			{0,0,0,1,0,0,0}
+#define OVR_DEFAULT_TIMEWARP_MISS_PROBABILITY 0.01f
 
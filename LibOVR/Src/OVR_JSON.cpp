@@ -67,60 +67,6 @@ limitations under the License.
 namespace OVR {
 
 
-//-----------------------------------------------------------------------------
-// Create a new copy of a string
-static char* JSON_strdup(const char* str)
-{
-    size_t len  = OVR_strlen(str) + 1;
-    char* copy = (char*)OVR_ALLOC(len);
-    if (!copy)
-        return 0;
-    memcpy(copy, str, len);
-    return copy;
-}
-
-
-//-----------------------------------------------------------------------------
-// Render the number from the given item into a string.
-static char* PrintInt(int valueint)
-{
-    char *str;
-    str = (char*)OVR_ALLOC(21);	// 2^64+1 can be represented in 21 chars.
-    if (str)
-    {
-        OVR_sprintf(str, 21, "%d", valueint);
-    }
-    return str;
-}
-
-
-//-----------------------------------------------------------------------------
-// Render the number from the given item into a string.
-static char* PrintNumber(double d)
-{
-    char *str;
-    int valueint = (int)d;
-	if (fabs(((double)valueint)-d)<=DBL_EPSILON && d<=INT_MAX && d>=INT_MIN)
-	{
-        return PrintInt(valueint);
-	}
-	else
-	{
-		str=(char*)OVR_ALLOC(64);	// This is a nice tradeoff.
-		if (str)
-		{
-			if (fabs(floor(d)-d)<=DBL_EPSILON && fabs(d)<1.0e60)
-                OVR_sprintf(str, 64, "%.0f", d);
-			else if (fabs(d)<1.0e-6 || fabs(d)>1.0e9)
-                OVR_sprintf(str, 64, "%e", d);
-			else
-                OVR_sprintf(str, 64, "%f", d);
-		}
-	}
-	return str;
-}
-
-
 // Parse the input text into an un-escaped cstring, and populate item.
 static const unsigned char firstByteMark[7] = { 0x00, 0x00, 0xC0, 0xE0, 0xF0, 0xF8, 0xFC };
 
@@ -152,15 +98,9 @@ JSON::~JSON()
 }
 
 //-----------------------------------------------------------------------------
-// Parse the input text to generate a number, and populate the result into item
-// Returns the text position after the parsed number
-const char* JSON::parseNumber(const char *num)
+// Returns the decimal separator accepted in numbers besides '.'
+static char GetLocaleSeparator()
 {
-    const char* num_start = num;
-    double      n=0, scale=0;
-    int         subscale     = 0,
-                signsubscale = 1;
-    bool positiveSign = true;
     char localeSeparator = '.';
 
 #ifdef OVR_OS_LINUX
@@ -171,6 +111,19 @@ const char* JSON::parseNumber(const char *num)
     localeSeparator = localeConv->decimal_point[0];
 #endif
 
+    return localeSeparator;
+}
+
+//-----------------------------------------------------------------------------
+// Parse the input text to generate a number, shared by JSON and JSONDocument.
+// Returns the text position after the parsed number
+static const char* ScanNumber(const char *num, char localeSeparator, double* pvalue)
+{
+    double      n=0, scale=0;
+    int         subscale     = 0,
+                signsubscale = 1;
+    bool positiveSign = true;
+
     // Could use sscanf for this?
     if (*num == '-')
     {
@@ -229,12 +182,22 @@ const char* JSON::parseNumber(const char *num)
         n = -n;
     }
 
+    *pvalue = n;
+	return num;
+}
+
+//-----------------------------------------------------------------------------
+// Parse the input text to generate a number, and populate the result into item
+// Returns the text position after the parsed number
+const char* JSON::parseNumber(const char *num)
+{
+    const char* end = ScanNumber(num, GetLocaleSeparator(), &dValue);
+
     // Assign parsed value.
     Type = JSON_Number;
-    dValue = n;
-    Value.AssignString(num_start, num - num_start);
+    Value.AssignString(num, end - num);
 
-	return num;
+	return end;
 }
 
 // Parses a hex string up to the specified number of digits.
@@ -263,32 +226,30 @@ const char* ParseHex(unsigned* val, unsigned digits, const char* str)
 }
 
 //-----------------------------------------------------------------------------
-// Parses the input text into a string item and returns the text position after
-// the parsed string
-const char* JSON::parseString(const char* str, const char** perror)
+// Returns enough space for the unescaped text of the quoted string at str
+static int MeasureString(const char* str)
 {
 	const char* ptr = str+1;
-    const char* p;
-    char*       ptr2;
-    char*       out;
-    int         len=0;
-    unsigned    uc, uc2;
-	
-    if (*str!='\"')
-    {
-        return AssignError(perror, "Syntax Error: Missing quote");
-    }
-	
+    int         len = 0;
+
 	while (*ptr!='\"' && *ptr && ++len)
     {   
-        if (*ptr++ == '\\') ptr++;	// Skip escaped quotes.
+        if (*ptr++ == '\\' && *ptr) ptr++;	// Skip escaped quotes.
     }
-	
-    // This is how long we need for the string, roughly.
-	out=(char*)OVR_ALLOC(len+1);
-	if (!out)
-        return 0;
-	
+	return len;
+}
+
+//-----------------------------------------------------------------------------
+// Writes the unescaped text of the quoted string at str to out, which must hold
+// MeasureString(str)+1 bytes.  Returns the text position after the string.
+static const char* UnescapeString(const char* str, char* out)
+{
+	const char* ptr;
+    const char* p;
+    char*       ptr2;
+    int         len;
+    unsigned    uc, uc2;
+
 	ptr = str+1;
     ptr2= out;
 
@@ -301,6 +262,8 @@ const char* JSON::parseString(const char* str, const char** perror)
 		else
 		{
 			ptr++;
+            if (!*ptr)
+                break;
 			switch (*ptr)
 			{
 				case 'b': *ptr2++ = '\b';	break;
@@ -372,74 +335,32 @@ const char* JSON::parseString(const char* str, const char** perror)
 	*ptr2 = 0;
 	if (*ptr=='\"')
         ptr++;
-	
-    // Make a copy of the string 
-    Value=out;
-    OVR_FREE(out);
-	Type=JSON_String;
-
 	return ptr;
 }
 
 //-----------------------------------------------------------------------------
-// Render the string provided to an escaped version that can be printed.
-char* PrintString(const char* str)
+// Parses the input text into a string item and returns the text position after
+// the parsed string
+const char* JSON::parseString(const char* str, const char** perror)
 {
-	const char *ptr;
-    char *ptr2,*out;
-    int len=0;
-    unsigned char token;
-	
-	if (!str)
-        return JSON_strdup("");
-	ptr=str;
-    
-    token=*ptr;
-    while (token && ++len)\
+    if (*str!='\"')
     {
-        if (strchr("\"\\\b\f\n\r\t",token))
-            len++;
-        else if (token<32) 
-            len+=5;
-        ptr++;
-        token=*ptr;
+        return AssignError(perror, "Syntax Error: Missing quote");
     }
 	
-	int buff_size = len+3;
-    out=(char*)OVR_ALLOC(buff_size);
+    // This is how long we need for the string, roughly.
+	char* out=(char*)OVR_ALLOC(MeasureString(str)+1);
 	if (!out)
         return 0;
+	
+	const char* ptr = UnescapeString(str, out);
+	
+    // Make a copy of the string 
+    Value=out;
+    OVR_FREE(out);
+	Type=JSON_String;
 
-	ptr2 = out;
-    ptr  = str;
-	*ptr2++ = '\"';
-
-	while (*ptr)
-	{
-		if ((unsigned char)*ptr>31 && *ptr!='\"' && *ptr!='\\') 
-            *ptr2++=*ptr++;
-		else
-		{
-			*ptr2++='\\';
-			switch (token=*ptr++)
-			{
-				case '\\':	*ptr2++='\\';	break;
-				case '\"':	*ptr2++='\"';	break;
-				case '\b':	*ptr2++='b';	break;
-				case '\f':	*ptr2++='f';	break;
-				case '\n':	*ptr2++='n';	break;
-				case '\r':	*ptr2++='r';	break;
-				case '\t':	*ptr2++='t';	break;
-				default: 
-                    OVR_sprintf(ptr2, buff_size - (ptr2-out), "u%04x",token);
-                    ptr2+=5;
-                    break;	// Escape and print.
-			}
-		}
-	}
-	*ptr2++='\"';
-    *ptr2++=0;
-	return out;
+	return ptr;
 }
 
 //-----------------------------------------------------------------------------
@@ -542,30 +463,6 @@ const char* JSON::parseValue(const char* buff, const char** perror)
 }
 
 
-//-----------------------------------------------------------------------------
-// Render a value to text. 
-char* JSON::PrintValue(int depth, bool fmt)
-{
-	char *out=0;
-
-    switch (Type)
-	{
-        case JSON_Null:	    out = JSON_strdup("null");	break;
-        case JSON_Bool:
-            if ((int)dValue == 0)
-                out = JSON_strdup("false");
-            else
-                out = JSON_strdup("true");
-            break;
-        case JSON_Number:	out = PrintNumber(dValue); break;
-        case JSON_String:	out = PrintString(Value); break;
-        case JSON_Array:	out = PrintArray(depth, fmt); break;
-        case JSON_Object:	out = PrintObject(depth, fmt); break;
-        case JSON_None: OVR_ASSERT_LOG(false, ("Bad JSON type.")); break;
-	}
-	return out;
-}
-
 //-----------------------------------------------------------------------------
 // Build an array object from input text and returns the text position after
 // the parsed array
@@ -611,90 +508,6 @@ const char* JSON::parseArray(const char* buff, const char** perror)
     return AssignError(perror, "Syntax Error: Missing ending bracket");
 }
 
-//-----------------------------------------------------------------------------
-// Render an array to text.  The returned text must be freed
-char* JSON::PrintArray(int depth, bool fmt)
-{
-	char **  entries;
-	char *   out = 0, *ptr,*ret;
-    intptr_t len = 5;
-	
-    bool fail = false;
-	
-	// How many entries in the array? 
-    int numentries = GetItemCount();
-	if (!numentries)
-	{
-		out=(char*)OVR_ALLOC(3);
-		if (out)
-            OVR_strcpy(out, 3, "[]");
-		return out;
-	}
-	// Allocate an array to hold the values for each
-	entries=(char**)OVR_ALLOC(numentries*sizeof(char*));
-	if (!entries)
-        return 0;
-	memset(entries,0,numentries*sizeof(char*));
-
-	//// Retrieve all the results:
-    JSON* child = Children.GetFirst();
-    for (int i=0; i<numentries; i++)
-	{
-		//JSON* child = Children[i];
-        ret=child->PrintValue(depth+1, fmt);
-		entries[i]=ret;
-		if (ret)
-            len+=OVR_strlen(ret)+2+(fmt?1:0);
-        else
-        {
-            fail = true;
-            break;
-        }
-        child = Children.GetNext(child);
-	}
-	
-	// If we didn't fail, try to malloc the output string 
-	if (!fail)
-        out=(char*)OVR_ALLOC(len);
-	// If that fails, we fail. 
-	if (!out)
-        fail = true;
-
-	// Handle failure.
-	if (fail)
-	{
-		for (int i=0; i<numentries; i++) 
-        {
-            if (entries[i])
-                OVR_FREE(entries[i]);
-        }
-		OVR_FREE(entries);
-		return 0;
-	}
-	
-	// Compose the output array.
-	*out='[';
-	ptr=out+1;
-    *ptr=0;
-	for (int i=0; i<numentries; i++)
-	{
-		OVR_strcpy(ptr, len - (ptr-out), entries[i]);
-        ptr+=OVR_strlen(entries[i]);
-		if (i!=numentries-1)
-        {
-            *ptr++=',';
-            if (fmt)
-                *ptr++=' ';
-            *ptr=0;
-        }
-		OVR_FREE(entries[i]);
-	}
-	OVR_FREE(entries);
-	*ptr++=']';
-    *ptr++=0;
-	return out;	
-}
-
 //-----------------------------------------------------------------------------
 // Build an object from the supplied text and returns the text position after
 // the parsed object
@@ -760,166 +573,6 @@ const char* JSON::parseObject(const char* buff, const char** perror)
     return AssignError(perror, "Syntax Error: Missing closing brace");
 }
 
-//-----------------------------------------------------------------------------
-// Render an object to text.  The returned string must be freed
-char* JSON::PrintObject(int depth, bool fmt)
-{
-	char**   entries = 0, **names = 0;
-	char*    out = 0;
-    char*    ptr, *ret, *str;
-    intptr_t len = 7, i = 0, j;
-    bool     fail = false;
-	
-    // Count the number of entries.
-    int numentries = GetItemCount();
-    
-	// Explicitly handle empty object case
-	if (numentries == 0)
-	{
-		out=(char*)OVR_ALLOC(fmt?depth+4:4);
-		if (!out)
-            return 0;
-		ptr=out;
-        *ptr++='{';
-		
-        if (fmt)
-        {
-            *ptr++='\n';
-            for (i=0;i<depth-1;i++)
-                *ptr++='\t';
-        }
-		*ptr++='}';
-        *ptr++=0;
-		return out;
-	}
-	// Allocate space for the names and the objects
-	entries=(char**)OVR_ALLOC(numentries*sizeof(char*));
-	if (!entries)
-        return 0;
-	names=(char**)OVR_ALLOC(numentries*sizeof(char*));
-	
-    if (!names)
-    {
-        OVR_FREE(entries);
-        return 0;
-    }
-	memset(entries,0,sizeof(char*)*numentries);
-	memset(names,0,sizeof(char*)*numentries);
-
-	// Collect all the results into our arrays:
-    depth++;
-    if (fmt)
-        len+=depth;
-
-    JSON* child = Children.GetFirst();
-    while (!Children.IsNull(child))
-	{
-		names[i]     = str = PrintString(child->Name);
-		entries[i++] = ret = child->PrintValue(depth, fmt);
-
-		if (str && ret)
-        {
-            len += OVR_strlen(ret)+OVR_strlen(str)+2+(fmt?3+depth:0);
-        }
-        else
-        {
-            fail = true;
-            break;
-        }
-		
-        child = Children.GetNext(child);
-	}
-	
-	// Try to allocate the output string
-	if (!fail)
-        out=(char*)OVR_ALLOC(len);
-	if (!out)
-        fail=true;
-
-	// Handle failure
-	if (fail)
-	{
-		for (i=0;i<numentries;i++)
-        {
-            if (names[i])
-                OVR_FREE(names[i]);
-            
-            if (entries[i])
-                OVR_FREE(entries[i]);}
-		
-        OVR_FREE(names);
-        OVR_FREE(entries);
-		return 0;
-	}
-	
-	// Compose the output:
-	*out = '{';
-    ptr  = out+1;
-    if (fmt)
-    {
-#ifdef OVR_OS_WIN32
-        *ptr++ = '\r';
-#endif
-        *ptr++ = '\n';
-    }
-    *ptr = 0;
-	
-    for (i=0; i<numentries; i++)
-	{
-		if (fmt)
-        {
-            for (j = 0; j < depth; j++)
-            {
-                *ptr++ = '\t';
-            }
-        }
-		OVR_strcpy(ptr, len - (ptr-out), names[i]);
-        ptr   += OVR_strlen(names[i]);
-		*ptr++ =':';
-        
-        if (fmt)
-        {
-            *ptr++ = '\t';
-        }
-		
-        OVR_strcpy(ptr, len - (ptr-out), entries[i]);
-        ptr+=OVR_strlen(entries[i]);
-		
-        if (i != numentries - 1)
-        {
-            *ptr++ = ',';
-        }
-		
-        if (fmt)
-        {
-#ifdef OVR_OS_WIN32
-            *ptr++ = '\r';
-#endif
-            *ptr++ = '\n';
-        }
-        *ptr = 0;
-		
-        OVR_FREE(names[i]);
-        OVR_FREE(entries[i]);
-	}
-	
-	OVR_FREE(names);
-    OVR_FREE(entries);
-	
-    if (fmt)
-    {
-        for (i = 0; i < depth - 1; i++)
-        {
-            *ptr++ = '\t';
-        }
-    }
-	*ptr++='}';
-    *ptr++=0;
-	
-    return out;	
-}
-
-
 
 // Returns the number of child items in the object
 // Counts the number of items in the object.
@@ -1266,21 +919,1300 @@ bool JSON::Save(const char* path)
     if (!f.Open(path, File::Open_Write | File::Open_Create | File::Open_Truncate, File::Mode_Write))
         return false;
 
-    char* text = PrintValue(0, true);
-    if (text)
-    {
-        intptr_t len   = OVR_strlen(text);
-        OVR_ASSERT(len <= (intptr_t)(int)len);
+    JSONWriter writer(&f);
+    writer.WriteValue(0, this);
+    bool written = writer.Flush();
+    f.Close();
+    return written;
+}
 
-        int   bytes = f.Write((uint8_t*)text, (int)len);
-        f.Close();
-        OVR_FREE(text);
-        return (bytes == len);
+
+//-----------------------------------------------------------------------------
+// ***** JSONArena
+
+static const size_t JSONArenaAlignment    = 8;
+static const size_t JSONArenaFirstBlock   = 4096;
+static const size_t JSONArenaMaxBlock     = 256 * 1024;
+
+static inline size_t JSONArenaAlign(size_t size)
+{
+    return (size + JSONArenaAlignment - 1) & ~(JSONArenaAlignment - 1);
+}
+
+JSONArena::JSONArena() :
+    pBlocks(0),
+    NextBlockSize(JSONArenaFirstBlock),
+    BytesReserved(0)
+{
+}
+
+JSONArena::~JSONArena()
+{
+    Clear();
+}
+
+JSONArena::Block* JSONArena::allocBlock(size_t size)
+{
+    Block* block = (Block*)OVR_ALLOC(JSONArenaAlign(sizeof(Block)) + size);
+    if (block)
+    {
+        block->pNext   = 0;
+        block->Size    = size;
+        block->Used    = 0;
+        BytesReserved += size;
     }
-    else
+    return block;
+}
+
+void* JSONArena::Alloc(size_t size)
+{
+    size = JSONArenaAlign(size);
+
+    Block* block = pBlocks;
+    if (!block || block->Size - block->Used < size)
     {
-        return false;
+        if (size > NextBlockSize / 4)
+        {   // Large allocations get a block of their own behind the current one,
+            // so that the free space left in the current block is not wasted.
+            block = allocBlock(size);
+            if (!block)
+                return 0;
+
+            if (pBlocks)
+            {
+                block->pNext   = pBlocks->pNext;
+                pBlocks->pNext = block;
+            }
+            else
+            {
+                pBlocks = block;
+            }
+        }
+        else
+        {
+            block = allocBlock(NextBlockSize);
+            if (!block)
+                return 0;
+
+            block->pNext = pBlocks;
+            pBlocks      = block;
+
+            if (NextBlockSize < JSONArenaMaxBlock)
+                NextBlockSize *= 2;
+        }
     }
+
+    void* p = (uint8_t*)block + JSONArenaAlign(sizeof(Block)) + block->Used;
+    block->Used += size;
+    return p;
+}
+
+char* JSONArena::CopyString(const char* str, size_t len)
+{
+    char* copy = (char*)Alloc(len + 1);
+    if (copy)
+    {
+        memcpy(copy, str, len);
+        copy[len] = 0;
+    }
+    return copy;
+}
+
+void JSONArena::Clear()
+{
+    while (pBlocks)
+    {
+        Block* next = pBlocks->pNext;
+        OVR_FREE(pBlocks);
+        pBlocks = next;
+    }
+
+    NextBlockSize = JSONArenaFirstBlock;
+    BytesReserved = 0;
+}
+
+
+//-----------------------------------------------------------------------------
+// ***** JSONNode
+
+// Lookup table for the children of a large object or array.
+struct JSONNodeIndex
+{
+    JSONNode**  Items;      // Children in order
+    unsigned*   Buckets;    // Open addressed by name hash, holding item index + 1; null for arrays
+    unsigned    BucketMask;
+};
+
+// Objects and arrays carry their child list after the common node fields.
+struct JSONContainerNode : public JSONNode
+{
+    JSONNode*       pFirstChild;
+    JSONNode*       pLastChild;
+    unsigned        ChildCount;
+    JSONNodeIndex*  pIndex;     // Built by the first lookup once ChildCount > IndexThreshold
+    JSONArena*      pArena;     // Arena of the owning document, for the index
+};
+
+static inline const JSONContainerNode* GetContainer(const JSONNode* node)
+{
+    return node->IsContainer() ? static_cast<const JSONContainerNode*>(node) : 0;
+}
+
+static inline unsigned HashName(const char* name)
+{
+    unsigned hash = 5381;
+    while (*name)
+        hash = (hash * 33) ^ (unsigned char)*name++;
+    return hash;
+}
+
+// Returns the index of a container, building it first if the container is large enough
+// to need one.  Returns null for small containers, which are searched directly.
+static JSONNodeIndex* GetIndex(const JSONContainerNode* container)
+{
+    if (container->pIndex || container->ChildCount <= JSONDocument::IndexThreshold)
+        return container->pIndex;
+
+    JSONArena*     arena = container->pArena;
+    JSONNodeIndex* index = (JSONNodeIndex*)arena->Alloc(sizeof(JSONNodeIndex));
+    if (!index)
+        return 0;
+
+    index->Items      = (JSONNode**)arena->Alloc(container->ChildCount * sizeof(JSONNode*));
+    index->Buckets    = 0;
+    index->BucketMask = 0;
+    if (!index->Items)
+        return 0;
+
+    unsigned i = 0;
+    for (JSONNode* child = container->pFirstChild; child; child = container->GetNextItem(child))
+        index->Items[i++] = child;
+
+    if (container->Type == JSON_Object)
+    {   // Keep the table at most half full
+        unsigned bucketCount = 16;
+        while (bucketCount < container->ChildCount * 2)
+            bucketCount *= 2;
+
+        index->Buckets = (unsigned*)arena->Alloc(bucketCount * sizeof(unsigned));
+        if (!index->Buckets)
+            return 0;
+        memset(index->Buckets, 0, bucketCount * sizeof(unsigned));
+        index->BucketMask = bucketCount - 1;
+
+        for (i = 0; i < container->ChildCount; i++)
+        {
+            const char* name   = index->Items[i]->Name;
+            unsigned    bucket = HashName(name) & index->BucketMask;
+
+            // The first of several items with the same name is the one found, as in JSON.
+            while (index->Buckets[bucket] && OVR_strcmp(index->Items[index->Buckets[bucket] - 1]->Name, name) != 0)
+                bucket = (bucket + 1) & index->BucketMask;
+
+            if (!index->Buckets[bucket])
+                index->Buckets[bucket] = i + 1;
+        }
+    }
+
+    const_cast<JSONContainerNode*>(container)->pIndex = index;
+    return index;
+}
+
+JSONNode* JSONNode::GetFirstItem() const
+{
+    const JSONContainerNode* container = GetContainer(this);
+    return container ? container->pFirstChild : 0;
+}
+
+JSONNode* JSONNode::GetLastItem() const
+{
+    const JSONContainerNode* container = GetContainer(this);
+    return container ? container->pLastChild : 0;
+}
+
+unsigned JSONNode::GetItemCount() const
+{
+    const JSONContainerNode* container = GetContainer(this);
+    return container ? container->ChildCount : 0;
+}
+
+JSONNode* JSONNode::GetItemByIndex(unsigned index) const
+{
+    const JSONContainerNode* container = GetContainer(this);
+    if (!container || index >= container->ChildCount)
+        return 0;
+
+    JSONNodeIndex* lookup = GetIndex(container);
+    if (lookup)
+        return lookup->Items[index];
+
+    JSONNode* child = container->pFirstChild;
+    while (index--)
+        child = child->pNext;
+    return child;
+}
+
+// Returns the child item with the given name or NULL if not found
+JSONNode* JSONNode::GetItemByName(const char* name) const
+{
+    const JSONContainerNode* container = GetContainer(this);
+    if (!container)
+        return 0;
+
+    JSONNodeIndex* lookup = GetIndex(container);
+    if (lookup && lookup->Buckets)
+    {
+        unsigned bucket = HashName(name) & lookup->BucketMask;
+        while (lookup->Buckets[bucket])
+        {
+            JSONNode* child = lookup->Items[lookup->Buckets[bucket] - 1];
+            if (OVR_strcmp(child->Name, name) == 0)
+                return child;
+            bucket = (bucket + 1) & lookup->BucketMask;
+        }
+        return 0;
+    }
+
+    for (JSONNode* child = container->pFirstChild; child; child = child->pNext)
+    {
+        if (OVR_strcmp(child->Name, name) == 0)
+            return child;
+    }
+    return 0;
+}
+
+double JSONNode::GetNumberByName(const char *name, double defValue) const
+{
+	JSONNode* item = GetItemByName(name);
+	return (item && item->Type == JSON_Number) ? item->dValue : defValue;
+}
+
+int JSONNode::GetIntByName(const char *name, int defValue) const
+{
+	JSONNode* item = GetItemByName(name);
+	return (item && item->Type == JSON_Number) ? (int)item->dValue : defValue;
+}
+
+bool JSONNode::GetBoolByName(const char *name, bool defValue) const
+{
+	JSONNode* item = GetItemByName(name);
+	return (item && item->Type == JSON_Bool) ? (int)item->dValue != 0 : defValue;
+}
+
+const char* JSONNode::GetStringByName(const char *name, const char* defValue) const
+{
+	JSONNode* item = GetItemByName(name);
+	return (item && item->Type == JSON_String) ? item->Value : defValue;
+}
+
+int JSONNode::GetArraySize() const
+{
+    return (Type == JSON_Array) ? (int)GetItemCount() : 0;
+}
+
+double JSONNode::GetArrayNumber(int index) const
+{
+    if (Type == JSON_Array && index >= 0)
+    {
+        JSONNode* number = GetItemByIndex(index);
+        return number ? number->dValue : 0.0;
+    }
+    return 0;
+}
+
+const char* JSONNode::GetArrayString(int index) const
+{
+    if (Type == JSON_Array && index >= 0)
+    {
+        JSONNode* string = GetItemByIndex(index);
+        return string ? string->Value : 0;
+    }
+    return 0;
+}
+
+JSON* JSONNode::CopyToJSON() const
+{
+    JSON* copy = (Type == JSON_Object) ? JSON::CreateObject() :
+                 (Type == JSON_Array)  ? JSON::CreateArray()  : JSON::CreateNull();
+    copy->Type   = Type;
+    copy->Value  = Value;
+    copy->dValue = dValue;
+
+    for (JSONNode* child = GetFirstItem(); child; child = child->pNext)
+    {
+        copy->AddItem(child->Name, child->CopyToJSON());
+    }
+    return copy;
+}
+
+
+//-----------------------------------------------------------------------------
+// ***** JSONDocument
+
+JSONDocument::JSONDocument() :
+    pRoot(0),
+    LocaleSeparator('.')
+{
+}
+
+JSONDocument::~JSONDocument()
+{
+}
+
+void JSONDocument::Clear()
+{
+    pRoot = 0;
+    Arena.Clear();
+}
+
+JSONNode* JSONDocument::createNode(JSONItemType type)
+{
+    bool      container = (type == JSON_Array || type == JSON_Object);
+    JSONNode* node      = (JSONNode*)Arena.Alloc(container ? sizeof(JSONContainerNode) : sizeof(JSONNode));
+    if (!node)
+        return 0;
+
+    node->Type   = type;
+    node->Name   = "";
+    node->Value  = "";
+    node->dValue = 0.;
+    node->pNext  = 0;
+
+    if (container)
+    {
+        JSONContainerNode* c = static_cast<JSONContainerNode*>(node);
+        c->pFirstChild = 0;
+        c->pLastChild  = 0;
+        c->ChildCount  = 0;
+        c->pIndex      = 0;
+        c->pArena      = &Arena;
+    }
+    return node;
+}
+
+void JSONDocument::appendChild(JSONNode* parent, JSONNode* child)
+{
+    JSONContainerNode* container = static_cast<JSONContainerNode*>(parent);
+
+    if (container->pLastChild)
+        container->pLastChild->pNext = child;
+    else
+        container->pFirstChild = child;
+    container->pLastChild = child;
+    container->ChildCount++;
+
+    // Dropped rather than updated; it is rebuilt by the next lookup.
+    container->pIndex = 0;
+}
+
+JSONNode* JSONDocument::CreateBool(bool b)
+{
+    JSONNode* item = createNode(JSON_Bool);
+    if (item)
+    {
+        item->dValue = b ? 1. : 0.;
+        item->Value  = b ? "true" : "false";
+    }
+    return item;
+}
+
+JSONNode* JSONDocument::CreateNumber(double num)
+{
+    JSONNode* item = createNode(JSON_Number);
+    if (item)
+    {
+        item->dValue = num;
+    }
+    return item;
+}
+
+JSONNode* JSONDocument::CreateString(const char* s)
+{
+    JSONNode* item = createNode(JSON_String);
+    if (item && s)
+    {
+        item->Value = Arena.CopyString(s, OVR_strlen(s));
+        if (!item->Value)
+            return 0;
+    }
+    return item;
+}
+
+void JSONDocument::AddItem(JSONNode* object, const char* name, JSONNode* item)
+{
+    OVR_ASSERT(object && object->IsContainer());
+    if (item && object && object->IsContainer())
+    {
+        const char* copy = name ? Arena.CopyString(name, OVR_strlen(name)) : "";
+        if (copy)
+        {
+            item->Name = copy;
+            appendChild(object, item);
+        }
+    }
+}
+
+void JSONDocument::AddArrayElement(JSONNode* array, JSONNode* item)
+{
+    OVR_ASSERT(array && array->IsContainer());
+    if (item && array && array->IsContainer())
+    {
+        appendChild(array, item);
+    }
+}
+
+JSONNode* JSONDocument::copyJSON(JSON* json)
+{
+    JSONNode* node = createNode(json->Type);
+    if (!node)
+        return 0;
+
+    node->dValue = json->dValue;
+    if (!json->Value.IsEmpty())
+    {
+        node->Value = Arena.CopyString(json->Value.ToCStr(), json->Value.GetSize());
+        if (!node->Value)
+            return 0;
+    }
+
+    if (node->IsContainer())
+    {
+        for (JSON* child = json->GetFirstItem(); child; child = json->GetNextItem(child))
+        {
+            JSONNode* childNode = copyJSON(child);
+            if (!childNode)
+                return 0;
+
+            if (!child->Name.IsEmpty())
+            {
+                childNode->Name = Arena.CopyString(child->Name.ToCStr(), child->Name.GetSize());
+                if (!childNode->Name)
+                    return 0;
+            }
+            appendChild(node, childNode);
+        }
+    }
+    return node;
+}
+
+JSONDocument* JSONDocument::CreateFromJSON(JSON* json)
+{
+    JSONDocument* doc = new JSONDocument;
+    if (json)
+    {
+        doc->pRoot = doc->copyJSON(json);
+        if (!doc->pRoot)
+        {
+            doc->Release();
+            return 0;
+        }
+    }
+    return doc;
+}
+
+//-----------------------------------------------------------------------------
+// Parses the supplied buffer of JSON text and returns a document
+// The returned document must be Released after use
+JSONDocument* JSONDocument::Parse(const char* buff, const char** perror)
+{
+    JSONDocument* doc = new JSONDocument;
+    if (!doc)
+    {
+        AssignError(perror, "Error: Failed to allocate memory");
+        return 0;
+    }
+
+    // Looked up once rather than for every number.
+    doc->LocaleSeparator = GetLocaleSeparator();
+
+    if (!doc->parseValue(&doc->pRoot, skip(buff), perror))
+    {   // parse failure. perror is set.
+        doc->Release();
+        return 0;
+    }
+
+    return doc;
+}
+
+//-----------------------------------------------------------------------------
+// This version works for buffers that are not null terminated strings.
+JSONDocument* JSONDocument::ParseBuffer(const char *buff, int len, const char** perror)
+{
+	char *termStr = new char[len + 1];
+	memcpy(termStr, buff, len);
+	termStr[len] = '\0';
+
+	JSONDocument* doc = Parse(termStr, perror);
+
+	delete[] termStr;
+
+	return doc;
+}
+
+//-----------------------------------------------------------------------------
+// Loads and parses the given JSON file pathname and returns a document.
+// The returned document must be Released after use.
+JSONDocument* JSONDocument::Load(const char* path, const char** perror)
+{
+    SysFile f;
+    if (!f.Open(path, File::Open_Read, File::Mode_Read))
+    {
+        AssignError(perror, "Failed to open file");
+        return NULL;
+    }
+
+    int    len   = f.GetLength();
+    uint8_t* buff  = (uint8_t*)OVR_ALLOC(len + 1);
+    int    bytes = f.Read(buff, len);
+    f.Close();
+
+    if (bytes == 0 || bytes != len)
+    {
+        OVR_FREE(buff);
+        return NULL;
+    }
+
+	// Ensure the result is null-terminated since Parse() expects null-terminated input.
+	buff[len] = '\0';
+
+    JSONDocument* doc = Parse((char*)buff, perror);
+    OVR_FREE(buff);
+    return doc;
+}
+
+//-----------------------------------------------------------------------------
+// Parser core - creates the node for the value at buff.  The text is handled the
+// same way as by JSON::parseValue.
+const char* JSONDocument::parseValue(JSONNode** pnode, const char* buff, const char** perror)
+{
+    if (perror)
+        *perror = 0;
+
+	if (!buff)
+        return NULL;	// Fail on null.
+
+    JSONNode* node = 0;
+
+	if (!strncmp(buff,"null",4))
+    {
+        node = createNode(JSON_Null);
+        buff += 4;
+    }
+	else if (!strncmp(buff,"false",5))
+    { 
+        node = CreateBool(false);
+        buff += 5;
+    }
+	else if (!strncmp(buff,"true",4))
+    {
+        node = CreateBool(true);
+        buff += 4;
+    }
+	else if (*buff=='\"')
+    {
+        const char* str = 0;
+        buff = parseString(&str, buff, perror);
+        if (!buff)
+            return 0;
+        node = createNode(JSON_String);
+        if (node)
+            node->Value = str;
+    }
+	else if (*buff=='-' || (*buff>='0' && *buff<='9'))
+    { 
+        double      value;
+        const char* end = ScanNumber(buff, LocaleSeparator, &value);
+        node = createNode(JSON_Number);
+        if (node)
+        {
+            node->dValue = value;
+            node->Value  = Arena.CopyString(buff, end - buff);
+            if (!node->Value)
+                node = 0;
+        }
+        buff = end;
+    }
+	else if (*buff=='[')
+    { 
+        node = createNode(JSON_Array);
+        if (node)
+            buff = parseArray(node, buff, perror);
+    }
+	else if (*buff=='{')
+    {
+        node = createNode(JSON_Object);
+        if (node)
+            buff = parseObject(node, buff, perror);
+    }
+    else
+    {
+        return AssignError(perror, "Syntax Error: Invalid syntax");
+    }
+
+    if (!node)
+        return AssignError(perror, "Error: Failed to allocate memory");
+
+    *pnode = node;
+    return buff;
+}
+
+//-----------------------------------------------------------------------------
+// Unescapes the string at buff into the arena and returns the text position after it
+const char* JSONDocument::parseString(const char** pstr, const char* buff, const char** perror)
+{
+    if (*buff!='\"')
+    {
+        return AssignError(perror, "Syntax Error: Missing quote");
+    }
+
+    char* out = (char*)Arena.Alloc(MeasureString(buff) + 1);
+    if (!out)
+        return AssignError(perror, "Error: Failed to allocate memory");
+
+    *pstr = out;
+    return UnescapeString(buff, out);
+}
+
+//-----------------------------------------------------------------------------
+// Fills an array node from the supplied text and returns the text position after
+// the parsed array
+const char* JSONDocument::parseArray(JSONNode* node, const char* buff, const char** perror)
+{
+	buff=skip(buff+1);
+    if (*buff==']')
+        return buff+1;	// empty array.
+
+    for (;;)
+    {
+        JSONNode* child = 0;
+        buff=skip(parseValue(&child, skip(buff), perror));	// skip any spacing, get the buff. 
+        if (!buff)
+            return 0;
+        appendChild(node, child);
+
+        if (*buff!=',')
+            break;
+        buff++;
+    }
+
+	if (*buff==']')
+        return buff+1;	// end of array
+
+    return AssignError(perror, "Syntax Error: Missing ending bracket");
+}
+
+//-----------------------------------------------------------------------------
+// Fills an object node from the supplied text and returns the text position after
+// the parsed object
+const char* JSONDocument::parseObject(JSONNode* node, const char* buff, const char** perror)
+{
+	buff=skip(buff+1);
+	if (*buff=='}')
+        return buff+1;	// empty object.
+
+    for (;;)
+    {
+        const char* name = 0;
+        buff=skip(parseString(&name, skip(buff), perror));
+        if (!buff)
+            return 0;
+
+        if (*buff!=':')
+        {
+            return AssignError(perror, "Syntax Error: Missing colon");
+        }
+
+        // Skip any spacing, get the value.
+        JSONNode* child = 0;
+        buff=skip(parseValue(&child, skip(buff+1), perror));
+        if (!buff)
+            return 0;
+        child->Name = name;
+        appendChild(node, child);
+
+        if (*buff!=',')
+            break;
+        buff++;
+    }
+
+	if (*buff=='}')
+        return buff+1;	// end of object
+
+    return AssignError(perror, "Syntax Error: Missing closing brace");
+}
+
+
+//-----------------------------------------------------------------------------
+// ***** JSONReader
+
+JSONReader::JSONReader(JSONHandler* handler) :
+    pHandler(handler),
+    pFile(0),
+    pCur(0),
+    pEnd(0),
+    pError(0),
+    Depth(0),
+    LocaleSeparator('.'),
+    RawLength(0)
+{
+}
+
+bool JSONReader::Parse(const char* text, const char** perror)
+{
+    pFile = 0;
+    pCur  = text ? text : "";
+    pEnd  = pCur + OVR_strlen(pCur);
+    return parse(perror);
+}
+
+bool JSONReader::Parse(File* file, const char** perror)
+{
+    pFile = file;
+    pCur  = ReadBuffer;
+    pEnd  = ReadBuffer;
+    return parse(perror);
+}
+
+bool JSONReader::parse(const char** perror)
+{
+    pError          = 0;
+    Depth           = 0;
+    LocaleSeparator = GetLocaleSeparator();
+
+    bool parsed = parseValue(0);
+    if (perror)
+        *perror = pError;
+    return parsed;
+}
+
+// Reads the next chunk of the file; false at the end of the text.
+bool JSONReader::fill()
+{
+    if (!pFile)
+        return false;
+
+    int bytes = pFile->Read((uint8_t*)ReadBuffer, ReadBufferSize);
+    if (bytes <= 0)
+        return false;
+
+    pCur = ReadBuffer;
+    pEnd = ReadBuffer + bytes;
+    return true;
+}
+
+// Returns the next character without consuming it, or 0 at the end of the text.
+inline int JSONReader::peek()
+{
+    if (pCur == pEnd && !fill())
+        return 0;
+    return (unsigned char)*pCur;
+}
+
+int JSONReader::skipSpace()
+{
+    for (;;)
+    {
+        while (pCur < pEnd && *pCur && (unsigned char)*pCur <= ' ')
+            pCur++;
+
+        if (pCur < pEnd)
+            return (unsigned char)*pCur;
+        if (!fill())
+            return 0;
+    }
+}
+
+static inline bool IsNumberChar(char c, char localeSeparator)
+{
+    return (c >= '0' && c <= '9') || c == '-' || c == '+' || c == '.' ||
+           c == 'e' || c == 'E' || c == localeSeparator;
+}
+
+bool JSONReader::fail(const char* error)
+{
+    if (!pError)
+        pError = error;
+    return false;
+}
+
+bool JSONReader::handled(bool result)
+{
+    return result || fail("Error: Parse stopped by handler");
+}
+
+void JSONReader::appendRaw(const char* text, size_t length)
+{
+    if (RawLength + length + 1 > Raw.GetSize())
+        Raw.Resize(Alg::Max(RawLength + length + 1, Raw.GetSize() * 2));
+
+    memcpy(&Raw[0] + RawLength, text, length);
+    RawLength += length;
+    Raw[RawLength] = 0;
+}
+
+bool JSONReader::parseValue(const char* name)
+{
+    int c = skipSpace();
+
+    switch (c)
+    {
+    case 'n':
+        return parseLiteral("null") && handled(pHandler->OnNull(name));
+    case 'f':
+        return parseLiteral("false") && handled(pHandler->OnBool(name, false));
+    case 't':
+        return parseLiteral("true") && handled(pHandler->OnBool(name, true));
+    case '\"':
+        return parseString(Value) && handled(pHandler->OnString(name, &Value[0], OVR_strlen(&Value[0])));
+    case '[':
+        return parseArray(name);
+    case '{':
+        return parseObject(name);
+    default:
+        if (c == '-' || (c >= '0' && c <= '9'))
+            return parseNumber(name);
+    }
+
+    return fail("Syntax Error: Invalid syntax");
+}
+
+bool JSONReader::parseLiteral(const char* literal)
+{
+    for (; *literal; literal++, pCur++)
+    {
+        if (peek() != *literal)
+            return fail("Syntax Error: Invalid syntax");
+    }
+    return true;
+}
+
+// Gathers the characters that can make up a number and converts them the same way
+// as JSON::parseNumber.
+bool JSONReader::parseNumber(const char* name)
+{
+    RawLength = 0;
+
+    while (peek())
+    {
+        const char* start = pCur;
+        while (pCur < pEnd && IsNumberChar(*pCur, LocaleSeparator))
+            pCur++;
+        appendRaw(start, pCur - start);
+
+        if (pCur < pEnd)
+            break;      // Otherwise the number may continue in the next chunk
+    }
+
+    double      value;
+    const char* end = ScanNumber(&Raw[0], LocaleSeparator, &value);
+    if (end != &Raw[0] + RawLength)
+        return fail("Syntax Error: Invalid number");
+
+    return handled(pHandler->OnNumber(name, value, &Raw[0]));
+}
+
+// Gathers a quoted string as written, then unescapes it into out.
+bool JSONReader::parseString(ArrayPOD<char>& out)
+{
+    if (peek() != '\"')
+        return fail("Syntax Error: Missing quote");
+
+    RawLength = 0;
+    appendRaw("\"", 1);
+    pCur++;
+
+    for (;;)
+    {
+        const char* start = pCur;
+        while (pCur < pEnd && *pCur != '\"' && *pCur != '\\')
+            pCur++;
+        appendRaw(start, pCur - start);
+
+        int c = peek();
+        if (c == 0)
+            break;      // Unterminated at the end of the text, which JSON::Parse accepts too.
+        if (c != '\"' && c != '\\')
+            continue;   // The run reached the end of a chunk
+
+        char ch = (char)c;
+        appendRaw(&ch, 1);
+        pCur++;
+
+        if (c == '\"')
+            break;
+
+        // Escaped character.
+        c = peek();
+        if (c == 0)
+            break;
+        ch = (char)c;
+        appendRaw(&ch, 1);
+        pCur++;
+    }
+
+    size_t size = MeasureString(&Raw[0]) + 1;
+    if (out.GetSize() < size)
+        out.Resize(size);
+
+    UnescapeString(&Raw[0], &out[0]);
+    return true;
+}
+
+bool JSONReader::parseArray(const char* name)
+{
+    pCur++;
+
+    if (++Depth > MaxDepth)
+        return fail("Syntax Error: Nesting too deep");
+    if (!handled(pHandler->OnBeginArray(name)))
+        return false;
+
+    int c = skipSpace();
+    if (c != ']')
+    {
+        for (;;)
+        {
+            if (!parseValue(0))
+                return false;
+
+            c = skipSpace();
+            if (c != ',')
+                break;
+            pCur++;
+        }
+
+        if (c != ']')
+            return fail("Syntax Error: Missing ending bracket");
+    }
+
+    pCur++;
+    Depth--;
+    return handled(pHandler->OnEndArray());
+}
+
+bool JSONReader::parseObject(const char* name)
+{
+    pCur++;
+
+    if (++Depth > MaxDepth)
+        return fail("Syntax Error: Nesting too deep");
+    if (!handled(pHandler->OnBeginObject(name)))
+        return false;
+
+    int c = skipSpace();
+    if (c != '}')
+    {
+        for (;;)
+        {
+            if (!parseString(Name))
+                return false;
+
+            if (skipSpace() != ':')
+                return fail("Syntax Error: Missing colon");
+            pCur++;
+
+            // Name is reused by members of nested objects, but only after the
+            // handler has been given this one.
+            if (!parseValue(&Name[0]))
+                return false;
+
+            c = skipSpace();
+            if (c != ',')
+                break;
+            pCur++;
+            skipSpace();
+        }
+
+        if (c != '}')
+            return fail("Syntax Error: Missing closing brace");
+    }
+
+    pCur++;
+    Depth--;
+    return handled(pHandler->OnEndObject());
+}
+
+
+//-----------------------------------------------------------------------------
+// ***** JSONWriter
+
+JSONWriter::JSONWriter(StringBuffer* buffer, bool formatted) :
+    pBuffer(buffer),
+    pFile(0),
+    Formatted(formatted),
+    Failed(false),
+    Used(0)
+{
+}
+
+JSONWriter::JSONWriter(File* file, bool formatted) :
+    pBuffer(0),
+    pFile(file),
+    Formatted(formatted),
+    Failed(false),
+    Used(0)
+{
+}
+
+JSONWriter::~JSONWriter()
+{
+    Flush();
+}
+
+bool JSONWriter::Flush()
+{
+    if (Used)
+    {
+        if (pBuffer)
+        {
+            pBuffer->AppendString(WriteBuffer, Used);
+        }
+        else if (pFile)
+        {
+            if (pFile->Write((const uint8_t*)WriteBuffer, (int)Used) != (int)Used)
+                Failed = true;
+        }
+        Used = 0;
+    }
+    return !Failed;
+}
+
+void JSONWriter::write(const char* text, size_t length)
+{
+    while (length)
+    {
+        if (Used == WriteBufferSize)
+            Flush();
+
+        size_t count = Alg::Min(length, (size_t)WriteBufferSize - Used);
+        memcpy(WriteBuffer + Used, text, count);
+        Used   += count;
+        text   += count;
+        length -= count;
+    }
+}
+
+inline void JSONWriter::writeChar(char c)
+{
+    if (Used == WriteBufferSize)
+        Flush();
+    WriteBuffer[Used++] = c;
+}
+
+void JSONWriter::writeNewline()
+{
+#ifdef OVR_OS_WIN32
+    writeChar('\r');
+#endif
+    writeChar('\n');
+}
+
+void JSONWriter::writeTabs(size_t count)
+{
+    while (count--)
+        writeChar('\t');
+}
+
+// Writes str quoted, with the escapes used by JSON since the original cJSON code.
+void JSONWriter::writeQuoted(const char* str)
+{
+    writeChar('\"');
+
+    for (const char* ptr = str ? str : ""; *ptr; )
+    {
+        const char* start = ptr;
+        while ((unsigned char)*ptr > 31 && *ptr != '\"' && *ptr != '\\')
+            ptr++;
+        write(start, ptr - start);
+
+        if (!*ptr)
+            break;
+
+        unsigned char token = (unsigned char)*ptr++;
+        writeChar('\\');
+        switch (token)
+        {
+            case '\\':  writeChar('\\');   break;
+            case '\"':  writeChar('\"');   break;
+            case '\b':  writeChar('b');    break;
+            case '\f':  writeChar('f');    break;
+            case '\n':  writeChar('n');    break;
+            case '\r':  writeChar('r');    break;
+            case '\t':  writeChar('t');    break;
+            default:
+            {
+                char escape[8];
+                OVR_sprintf(escape, sizeof(escape), "u%04x", token);
+                write(escape, 5);
+                break;
+            }
+        }
+    }
+
+    writeChar('\"');
+}
+
+// Writes the separator, indentation and name that go before a value.
+void JSONWriter::beginValue(const char* name)
+{
+    if (Levels.IsEmpty())
+        return;
+
+    Level& level = Levels.Back();
+    if (level.IsObject)
+    {
+        if (level.ItemCount)
+            writeChar(',');
+        if (Formatted)
+        {
+            writeNewline();
+            writeTabs(Levels.GetSize());
+        }
+        writeQuoted(name);
+        writeChar(':');
+        if (Formatted)
+            writeChar('\t');
+    }
+    else if (level.ItemCount)
+    {
+        writeChar(',');
+        if (Formatted)
+            writeChar(' ');
+    }
+
+    level.ItemCount++;
+}
+
+void JSONWriter::BeginObject(const char* name)
+{
+    beginValue(name);
+    writeChar('{');
+
+    Level level = { true, 0 };
+    Levels.PushBack(level);
+}
+
+void JSONWriter::EndObject()
+{
+    OVR_ASSERT(!Levels.IsEmpty() && Levels.Back().IsObject);
+    if (Levels.IsEmpty())
+        return;
+
+    if (Formatted)
+    {
+        if (Levels.Back().ItemCount)
+        {
+            writeNewline();
+            writeTabs(Levels.GetSize() - 1);
+        }
+        else
+        {   // Empty objects have always been written this way.
+            writeChar('\n');
+            if (Levels.GetSize() > 2)
+                writeTabs(Levels.GetSize() - 2);
+        }
+    }
+    writeChar('}');
+    Levels.PopBack();
+}
+
+void JSONWriter::BeginArray(const char* name)
+{
+    beginValue(name);
+    writeChar('[');
+
+    Level level = { false, 0 };
+    Levels.PushBack(level);
+}
+
+void JSONWriter::EndArray()
+{
+    OVR_ASSERT(!Levels.IsEmpty() && !Levels.Back().IsObject);
+    if (Levels.IsEmpty())
+        return;
+
+    writeChar(']');
+    Levels.PopBack();
+}
+
+void JSONWriter::WriteNull(const char* name)
+{
+    beginValue(name);
+    write("null", 4);
+}
+
+void JSONWriter::WriteBool(const char* name, bool value)
+{
+    beginValue(name);
+    if (value)
+        write("true", 4);
+    else
+        write("false", 5);
+}
+
+void JSONWriter::WriteNumber(const char* name, double d)
+{
+    beginValue(name);
+
+    char text[64];
+    int  valueint = (int)d;
+	if (fabs(((double)valueint)-d)<=DBL_EPSILON && d<=INT_MAX && d>=INT_MIN)
+        OVR_sprintf(text, sizeof(text), "%d", valueint);
+    else if (fabs(floor(d)-d)<=DBL_EPSILON && fabs(d)<1.0e60)
+        OVR_sprintf(text, sizeof(text), "%.0f", d);
+    else if (fabs(d)<1.0e-6 || fabs(d)>1.0e9)
+        OVR_sprintf(text, sizeof(text), "%e", d);
+    else
+        OVR_sprintf(text, sizeof(text), "%f", d);
+
+    write(text, OVR_strlen(text));
+}
+
+void JSONWriter::WriteString(const char* name, const char* value)
+{
+    beginValue(name);
+    writeQuoted(value);
+}
+
+// Shared by the JSON and JSONNode versions of WriteValue.
+template<class Node>
+static void WriteTree(JSONWriter& writer, const char* name, Node* node)
+{
+    switch (node->Type)
+    {
+    case JSON_Null:     writer.WriteNull(name); break;
+    case JSON_Bool:     writer.WriteBool(name, (int)node->dValue != 0); break;
+    case JSON_Number:   writer.WriteNumber(name, node->dValue); break;
+    case JSON_String:   writer.WriteString(name, node->Value); break;
+
+    case JSON_Array:
+        writer.BeginArray(name);
+        for (Node* child = node->GetFirstItem(); child; child = node->GetNextItem(child))
+            WriteTree(writer, 0, child);
+        writer.EndArray();
+        break;
+
+    case JSON_Object:
+        writer.BeginObject(name);
+        for (Node* child = node->GetFirstItem(); child; child = node->GetNextItem(child))
+            WriteTree(writer, child->Name, child);
+        writer.EndObject();
+        break;
+
+    case JSON_None: OVR_ASSERT_LOG(false, ("Bad JSON type.")); break;
+    }
+}
+
+void JSONWriter::WriteValue(const char* name, JSON* json)
+{
+    if (json)
+        WriteTree(*this, name, json);
+}
+
+void JSONWriter::WriteValue(const char* name, const JSONNode* node)
+{
+    if (node)
+        WriteTree(*this, name, node);
 }
 
 
@@ -32,9 +32,12 @@ limitations under the License.
 #include "Kernel/OVR_RefCount.h"
 #include "Kernel/OVR_String.h"
 #include "Kernel/OVR_List.h"
+#include "Kernel/OVR_Array.h"
 
 namespace OVR {  
 
+class File;
+
 // JSONItemType describes the type of JSON item, specifying the type of
 // data that can be obtained from it.
 enum JSONItemType
@@ -153,10 +156,319 @@ protected:
     const char*     parseArray(const char* value, const char** perror);
     const char*     parseObject(const char* value, const char** perror);
     const char*     parseString(const char* str, const char** perror);
+};
+
+
+//-----------------------------------------------------------------------------
+// ***** JSONArena
+
+// Bump allocator holding all of the memory of a JSONDocument.  Allocations are
+// never freed individually; Clear releases every block at once.
+
+class JSONArena
+{
+public:
+    JSONArena();
+    ~JSONArena();
+
+    // Returns 8 byte aligned memory that lives until Clear.
+    void*           Alloc(size_t size);
+    // Copies len characters of str and null-terminates the copy.
+    char*           CopyString(const char* str, size_t len);
+
+    void            Clear();
+
+    // Bytes in all blocks, including unused space at the end of each.
+    size_t          GetBytesReserved() const { return BytesReserved; }
+
+private:
+    struct Block
+    {
+        Block*      pNext;
+        size_t      Size;
+        size_t      Used;
+    };
+
+    Block*          allocBlock(size_t size);
+
+    Block*          pBlocks;        // Blocks in use, current one first
+    size_t          NextBlockSize;
+    size_t          BytesReserved;
+
+    // Not copyable.
+    JSONArena(const JSONArena&);
+    void operator=(const JSONArena&);
+};
+
+
+//-----------------------------------------------------------------------------
+// ***** JSONNode
+
+// Node of a JSONDocument.  Nodes are created and owned by their document and stay
+// valid until it is destroyed or cleared; they are not reference counted.
+// The accessors mirror those of JSON, except that items of large objects and
+// arrays are found through an index rather than by walking the children.
+
+class JSONNode
+{
+public:
+    JSONItemType    Type;       // Type of this JSON node.
+    const char*     Name;       // Name part of the {Name, Value} pair in a parent object; "" otherwise.
+    const char*     Value;      // Text of strings, numbers and bools; "" otherwise.
+    double          dValue;
+
+public:
+    bool            IsContainer() const { return Type == JSON_Array || Type == JSON_Object; }
+
+    // *** Object Member Access
+
+    bool            HasItems() const         { return GetItemCount() != 0; }
+    // Returns first/last child item, or null if child list is empty
+    JSONNode*       GetFirstItem() const;
+    JSONNode*       GetLastItem() const;
+    // Returns next item in a list of children; 0 if no more items exist.
+    JSONNode*       GetNextItem(const JSONNode* item) const { return item->pNext; }
+
+    unsigned        GetItemCount() const;
+    JSONNode*       GetItemByIndex(unsigned i) const;
+    JSONNode*       GetItemByName(const char* name) const;
+
+	// Accessors by name
+	double			GetNumberByName(const char *name, double defValue = 0.0) const;
+	int				GetIntByName(const char *name, int defValue = 0) const;
+	bool			GetBoolByName(const char *name, bool defValue = false) const;
+	const char*		GetStringByName(const char *name, const char* defValue = "") const;
+
+    // *** Array Element Access
+
+    int             GetArraySize() const;
+    double          GetArrayNumber(int index) const;
+    const char*     GetArrayString(int index) const;
+
+    // Creates a reference counted JSON copy of this node and its children.
+    JSON*           CopyToJSON() const;
+
+protected:
+    friend class JSONDocument;
+
+    JSONNode*       pNext;      // Next sibling in the parent
+};
+
+
+//-----------------------------------------------------------------------------
+// ***** JSONDocument
+
+// Alternative to a tree of JSON objects for large documents that are loaded once
+// and then searched, such as the profile database.  Every node, name and string of
+// the document lives in one JSONArena, so loading does no per-node allocation and
+// the whole tree is freed at once.  The first lookup by name or index in an object
+// or array with more than IndexThreshold items builds a hash index for it, so later
+// lookups don't walk the children.
+//
+// Lookups may build an index, so a document should not be searched by several
+// threads at once without a lock.
+
+class JSONDocument : public RefCountBase<JSONDocument>
+{
+public:
+    enum { IndexThreshold = 8 };
+
+    JSONDocument();
+    ~JSONDocument();
 
-    char*           PrintValue(int depth, bool fmt);
-    char*           PrintObject(int depth, bool fmt);
-    char*           PrintArray(int depth, bool fmt);
+    // Creates a new document from parsing string.
+    // Returns null pointer and fills in *perror in case of parse error.
+    static JSONDocument* Parse(const char* buff, const char** perror = 0);
+
+	// This version works for buffers that are not null terminated strings.
+	static JSONDocument* ParseBuffer(const char *buff, int len, const char** perror = 0);
+
+    // Loads and parses a document from a file.
+    // Returns 0 and assigns perror with error message on fail.
+    static JSONDocument* Load(const char* path, const char** perror = 0);
+
+    // Creates a document holding a copy of a JSON tree.
+    static JSONDocument* CreateFromJSON(JSON* json);
+
+    // Root value of the document, or null if it is empty.
+    JSONNode*       GetRoot() const          { return pRoot; }
+    void            SetRoot(JSONNode* root)  { pRoot = root; }
+
+    // Frees every node of the document.
+    void            Clear();
+
+    // *** Creation of new nodes, owned by this document
+
+    JSONNode*       CreateObject()           { return createNode(JSON_Object); }
+    JSONNode*       CreateArray()            { return createNode(JSON_Array); }
+    JSONNode*       CreateNull()             { return createNode(JSON_Null); }
+    JSONNode*       CreateBool(bool b);
+    JSONNode*       CreateNumber(double num);
+    JSONNode*       CreateString(const char* s);
+
+    // Adds a new item to the end of an object or array of this document.
+    void            AddItem(JSONNode* object, const char* name, JSONNode* item);
+    void            AddArrayElement(JSONNode* array, JSONNode* item);
+
+    size_t          GetBytesReserved() const { return Arena.GetBytesReserved(); }
+
+protected:
+    JSONNode*       createNode(JSONItemType type);
+    JSONNode*       copyJSON(JSON* json);
+    void            appendChild(JSONNode* parent, JSONNode* child);
+
+    // JSON Parsing helper functions.
+    const char*     parseValue(JSONNode** pnode, const char* buff, const char** perror);
+    const char*     parseString(const char** pstr, const char* buff, const char** perror);
+    const char*     parseArray(JSONNode* node, const char* buff, const char** perror);
+    const char*     parseObject(JSONNode* node, const char* buff, const char** perror);
+
+    JSONArena       Arena;
+    JSONNode*       pRoot;
+    char            LocaleSeparator;    // Decimal separator accepted while parsing
+};
+
+
+//-----------------------------------------------------------------------------
+// ***** JSONHandler
+
+// Receives the values found by a JSONReader in document order.  name is the member
+// name for values inside an object, and null for array elements and the root value.
+// Strings passed to a callback are only valid during the call.  Returning false
+// from a callback stops the parse, which then fails.
+
+class JSONHandler
+{
+public:
+    virtual ~JSONHandler() { }
+
+    virtual bool    OnNull(const char* /*name*/)                                        { return true; }
+    virtual bool    OnBool(const char* /*name*/, bool /*value*/)                        { return true; }
+    // text is the number as written in the document.
+    virtual bool    OnNumber(const char* /*name*/, double /*value*/, const char* /*text*/) { return true; }
+    virtual bool    OnString(const char* /*name*/, const char* /*value*/, size_t /*length*/) { return true; }
+    virtual bool    OnBeginObject(const char* /*name*/)                                 { return true; }
+    virtual bool    OnEndObject()                                                       { return true; }
+    virtual bool    OnBeginArray(const char* /*name*/)                                  { return true; }
+    virtual bool    OnEndArray()                                                        { return true; }
+};
+
+
+//-----------------------------------------------------------------------------
+// ***** JSONReader
+
+// Streaming parser that reports values to a JSONHandler instead of building a tree.
+// Text is read from a file ReadBufferSize bytes at a time, so memory use depends on
+// the longest string and the nesting depth rather than on the size of the document.
+// The syntax accepted is the same as for JSON::Parse.
+
+class JSONReader
+{
+public:
+    enum
+    {
+        ReadBufferSize = 4096,
+        MaxDepth       = 512    // Deeper nesting fails rather than risk the stack
+    };
+
+    JSONReader(JSONHandler* handler);
+
+    // Parses one value from null-terminated text, or from the current position of a file.
+    // Returns false and fills in *perror on a syntax error or when the handler stops.
+    bool            Parse(const char* text, const char** perror = 0);
+    bool            Parse(File* file, const char** perror = 0);
+
+protected:
+    bool            parse(const char** perror);
+    bool            fill();
+    int             peek();
+    int             skipSpace();
+    bool            fail(const char* error);
+    bool            handled(bool result);
+
+    bool            parseValue(const char* name);
+    bool            parseLiteral(const char* literal);
+    bool            parseNumber(const char* name);
+    bool            parseString(ArrayPOD<char>& out);
+    bool            parseArray(const char* name);
+    bool            parseObject(const char* name);
+
+    void            appendRaw(const char* text, size_t length);
+
+    JSONHandler*    pHandler;
+    File*           pFile;
+    const char*     pCur;
+    const char*     pEnd;
+    const char*     pError;
+    int             Depth;
+    char            LocaleSeparator;
+
+    // Grown as needed and reused for every value.
+    ArrayPOD<char>  Raw;            // Text of the current string or number as written
+    size_t          RawLength;
+    ArrayPOD<char>  Name;           // Unescaped name of the current object member
+    ArrayPOD<char>  Value;          // Unescaped current string value
+
+    char            ReadBuffer[ReadBufferSize];
+};
+
+
+//-----------------------------------------------------------------------------
+// ***** JSONWriter
+
+// Writes JSON text to a StringBuffer or a File through a fixed buffer, without
+// allocating for each value.  name is the member name for values written inside an
+// object, and is ignored elsewhere.  Formatted output matches what JSON::Save has
+// always written: one object member per line, indented with tabs.
+
+class JSONWriter
+{
+public:
+    enum { WriteBufferSize = 4096 };
+
+    JSONWriter(StringBuffer* buffer, bool formatted = true);
+    JSONWriter(File* file, bool formatted = true);
+    ~JSONWriter();
+
+    void            BeginObject(const char* name = 0);
+    void            EndObject();
+    void            BeginArray(const char* name = 0);
+    void            EndArray();
+
+    void            WriteNull(const char* name);
+    void            WriteBool(const char* name, bool value);
+    void            WriteNumber(const char* name, double value);
+    void            WriteString(const char* name, const char* value);
+
+    // Writes a node and all of its children.
+    void            WriteValue(const char* name, JSON* json);
+    void            WriteValue(const char* name, const JSONNode* node);
+
+    // Passes buffered text on to the buffer or file.  Returns false if any
+    // write to the file has failed.
+    bool            Flush();
+
+protected:
+    struct Level
+    {
+        bool        IsObject;
+        unsigned    ItemCount;
+    };
+
+    void            beginValue(const char* name);
+    void            write(const char* text, size_t length);
+    void            writeChar(char c);
+    void            writeNewline();
+    void            writeTabs(size_t count);
+    void            writeQuoted(const char* str);
+
+    StringBuffer*   pBuffer;
+    File*           pFile;
+    bool            Formatted;
+    bool            Failed;
+    ArrayPOD<Level> Levels;         // Open objects and arrays, innermost last
+    size_t          Used;
+    char            WriteBuffer[WriteBufferSize];
 };
 
 
@@ -33,7 +33,9 @@ limitations under the License.
 
 #include "OVR_Profile.h"
 #include "OVR_JSON.h"
+#include "OVR_BinaryProfileDB.h"
 #include "Kernel/OVR_SysFile.h"
+#include "Kernel/OVR_MappedFile.h"
 #include "Kernel/OVR_Allocator.h"
 #include "OVR_Stereo.h"
 
@@ -198,7 +200,12 @@ String ProfileManager::GetProfilePath()
     return BasePath + "/ProfileDB.json";
 }
 
-static JSON* FindTaggedData(JSON* data, const char** tag_names, const char** qtags, int num_qtags)
+String ProfileManager::GetBinaryProfilePath()
+{
+    return BasePath + "/ProfileDB.bin";
+}
+
+static JSON* FindTaggedItem(JSON* data, const char** tag_names, const char** qtags, int num_qtags)
 {
     if (data == NULL || !(data->Name == "TaggedData") || data->Type != JSON_Array)
         return NULL;
@@ -227,12 +234,9 @@ static JSON* FindTaggedData(JSON* data, const char** tag_names, const char** qta
                 }
             }
 
-            // if all tags were matched then copy the values into this Profile
+            // if all tags were matched then this item holds the values
             if (num_matches == num_qtags)
-            {
-                JSON* vals = tagged_item->GetItemByName("vals");
-                return vals;
-            }
+                return tagged_item;
         }
 
         tagged_item = data->GetNextItem(tagged_item);
@@ -241,36 +245,252 @@ static JSON* FindTaggedData(JSON* data, const char** tag_names, const char** qta
     return NULL;
 }
 
-static void FilterTaggedData(JSON* data, const char* tag_name, const char* qtag, Array<JSON*>& items)
+//-----------------------------------------------------------------------------
+// ***** ProfileTagIndex
+
+struct ProfileTag
+{
+    const char* Name;
+    const char* Value;
+};
+
+// Tag names and values are joined with the ASCII unit and record separators,
+// which don't occur in profile tags
+static void AppendTagKey(String& key, const char* tag_name, const char* tag)
+{
+    key += tag_name;
+    key += "\x1f";
+    key += tag;
+    key += "\x1e";
+}
+
+// Builds the key of a set of tags, sorting them by name.  Returns false if
+// a tag name occurs twice.
+static bool MakeTagSetKey(Array<ProfileTag>& tags, String& key)
 {
-    if (data == NULL || !(data->Name == "TaggedData") || data->Type != JSON_Array)
+    // Tag sets only hold a handful of tags
+    for (size_t i = 1; i < tags.GetSize(); i++)
+    {
+        for (size_t j = i; j > 0 && OVR_strcmp(tags[j - 1].Name, tags[j].Name) > 0; j--)
+            Alg::Swap(tags[j - 1], tags[j]);
+    }
+
+    key.Clear();
+    for (size_t i = 0; i < tags.GetSize(); i++)
+    {
+        if (i > 0 && OVR_strcmp(tags[i - 1].Name, tags[i].Name) == 0)
+            return false;
+        AppendTagKey(key, tags[i].Name, tags[i].Value);
+    }
+    return true;
+}
+
+// Gathers the first member of each tag of a TaggedData entry, which is what
+// FindTaggedItem compares.  complete is false if a tag is empty, in which case the
+// entry never matches a tag set.  Returns false if the entry has no tag array.
+static bool GetEntryTags(JSON* tagged_item, Array<ProfileTag>& tags, bool& complete)
+{
+    JSON* tag_array = tagged_item->GetItemByName("tags");
+    if (tag_array == NULL || tag_array->Type != JSON_Array)
+        return false;
+
+    complete = true;
+    JSON* tag = tag_array->GetFirstItem();
+    while (tag)
+    {
+        JSON* tagval = tag->GetFirstItem();
+        if (tagval)
+        {
+            ProfileTag t = { tagval->Name.ToCStr(), tagval->Value.ToCStr() };
+            tags.PushBack(t);
+        }
+        else
+        {
+            complete = false;
+        }
+        tag = tag_array->GetNextItem(tag);
+    }
+    return true;
+}
+
+static bool HasRepeatedTagName(const char** tag_names, int num_tags)
+{
+    for (int i = 1; i < num_tags; i++)
+    {
+        for (int j = 0; j < i; j++)
+        {
+            if (OVR_strcmp(tag_names[i], tag_names[j]) == 0)
+                return true;
+        }
+    }
+    return false;
+}
+
+// Only the first tag of a given name is matched by a tag filter
+static bool IsFirstTagName(const Array<ProfileTag>& tags, size_t index)
+{
+    for (size_t i = 0; i < index; i++)
+    {
+        if (OVR_strcmp(tags[i].Name, tags[index].Name) == 0)
+            return false;
+    }
+    return true;
+}
+
+ProfileTagIndex::ProfileTagIndex() :
+    pTaggedData(NULL),
+    pBinaryDB(NULL)
+{
+}
+
+void ProfileTagIndex::Clear()
+{
+    pTaggedData = NULL;
+    pBinaryDB = NULL;
+    ByTagSet.Clear();
+    ByTag.Clear();
+}
+
+void ProfileTagIndex::Build(JSON* taggedData)
+{
+    Clear();
+
+    if (taggedData == NULL || taggedData->Type != JSON_Array)
         return;
 
-    JSON* tagged_item = data->GetFirstItem();
+    pTaggedData = taggedData;
+
+    JSON* tagged_item = taggedData->GetFirstItem();
     while (tagged_item)
     {
-        JSON* tags = tagged_item->GetItemByName("tags");
-        if (tags->Type == JSON_Array)
-        {   // Check for a tag match on the requested tag
-            
-            JSON* tag = tags->GetFirstItem();
-            while (tag)
-            {
-                JSON* tagval = tag->GetFirstItem();
-                if (tagval && tagval->Name == tag_name)
-                {
-                    if (tagval->Value == qtag)
-                    {   // Add this item to the output list
-                        items.PushBack(tagged_item);
-                    }
-                    break;
-                }
-                tag = tags->GetNextItem(tag);
-            }
+        Add(tagged_item);
+        tagged_item = taggedData->GetNextItem(tagged_item);
+    }
+}
+
+void ProfileTagIndex::Build(BinaryProfileDB* binaryDB)
+{
+    Clear();
+    pBinaryDB = binaryDB;
+}
+
+void ProfileTagIndex::Add(JSON* taggedItem)
+{
+    Array<ProfileTag> tags;
+    bool complete;
+    if (!GetEntryTags(taggedItem, tags, complete))
+        return;
+
+    String key;
+    for (size_t i = 0; i < tags.GetSize(); i++)
+    {
+        if (IsFirstTagName(tags, i))
+        {
+            key.Clear();
+            AppendTagKey(key, tags[i].Name, tags[i].Value);
+            addEntry(ByTag, key, taggedItem);
         }
+    }
 
-        tagged_item = data->GetNextItem(tagged_item);
+    // An entry with a repeated or empty tag can't match a query with distinct tag names,
+    // and queries that repeat a name are answered by FindTaggedItem
+    if (complete && MakeTagSetKey(tags, key))
+        addEntry(ByTagSet, key, taggedItem);
+}
+
+void ProfileTagIndex::Remove(JSON* taggedItem)
+{
+    Array<ProfileTag> tags;
+    bool complete;
+    if (!GetEntryTags(taggedItem, tags, complete))
+        return;
+
+    String key;
+    for (size_t i = 0; i < tags.GetSize(); i++)
+    {
+        if (IsFirstTagName(tags, i))
+        {
+            key.Clear();
+            AppendTagKey(key, tags[i].Name, tags[i].Value);
+            removeEntry(ByTag, key, taggedItem);
+        }
+    }
+
+    if (complete && MakeTagSetKey(tags, key))
+        removeEntry(ByTagSet, key, taggedItem);
+}
+
+JSON* ProfileTagIndex::Find(const char** tag_names, const char** tags, int num_tags) const
+{
+    if (pBinaryDB)
+        return pBinaryDB->FindTaggedData(tag_names, tags, num_tags);
+
+    JSON* item = FindItem(tag_names, tags, num_tags);
+    return item ? item->GetItemByName("vals") : NULL;
+}
+
+JSON* ProfileTagIndex::FindItem(const char** tag_names, const char** tags, int num_tags) const
+{
+    if (pTaggedData == NULL)
+        return NULL;
+
+    Array<ProfileTag> query;
+    query.Resize(num_tags);
+    for (int i = 0; i < num_tags; i++)
+    {
+        query[i].Name  = tag_names[i];
+        query[i].Value = tags[i];
     }
+
+    String key;
+    if (MakeTagSetKey(query, key))
+    {
+        const Array<JSON*>* items = ByTagSet.Get(key);
+        return items ? (*items)[0] : NULL;
+    }
+
+    // Repeated tag names don't have a single key, so fall back to comparing every entry
+    return FindTaggedItem(pTaggedData, tag_names, tags, num_tags);
+}
+
+void ProfileTagIndex::Filter(const char* tag_name, const char* tag, Array<JSON*>& items) const
+{
+    String key;
+    AppendTagKey(key, tag_name, tag);
+
+    const Array<JSON*>* found = ByTag.Get(key);
+    if (found)
+        items.Append(found->GetDataPtr(), found->GetSize());
+}
+
+void ProfileTagIndex::addEntry(EntryHash& hash, const String& key, JSON* taggedItem)
+{
+    Array<JSON*>* items = hash.Get(key);
+    if (items == NULL)
+    {
+        hash.Set(key, Array<JSON*>());
+        items = hash.Get(key);
+    }
+    items->PushBack(taggedItem);
+}
+
+void ProfileTagIndex::removeEntry(EntryHash& hash, const String& key, JSON* taggedItem)
+{
+    Array<JSON*>* items = hash.Get(key);
+    if (items == NULL)
+        return;
+
+    for (size_t i = 0; i < items->GetSize(); i++)
+    {
+        if ((*items)[i] == taggedItem)
+        {
+            items->RemoveAt(i);
+            break;
+        }
+    }
+
+    if (items->GetSize() == 0)
+        hash.Remove(key);
 }
 
 
@@ -286,6 +506,8 @@ template<> ProfileManager* OVR::SystemSingletonBase<ProfileManager>::SlowGetInst
 }
 
 ProfileManager::ProfileManager(bool sys_register) :
+    BinaryCurrent(false),
+    BinaryEnabled(false),
     Changed(false)
 {
     // Attempt to get the base path automatically, but this may fail
@@ -315,12 +537,45 @@ void ProfileManager::SetBasePath(String basePath)
     }
 }
 
+void ProfileManager::SetBinaryCacheEnabled(bool enabled)
+{
+    Lock::Locker lockScope(&ProfileLock);
+
+    if (enabled == BinaryEnabled)
+        return;
+
+    BinaryEnabled = enabled;
+    if (enabled)
+    {
+        // Write ProfileDB.bin now, so that the next process finds it before it loads anything
+        BinaryProfileSource source;
+        if (ProfileCache && !Changed && source.Read(GetProfilePath()))
+        {
+            BinaryCurrent = BinaryProfileDB::Write(GetBinaryProfilePath(), ProfileCache, source);
+            BinaryStamp = source;
+            ChangedItems.Clear();
+        }
+    }
+    else
+    {
+        // ProfileDB.bin isn't kept up to date from here on, and later processes don't use it.
+        // A database this process has mapped stays readable.
+        BinaryCurrent = false;
+        ChangedItems.Clear();
+        RemoveFile(GetBinaryProfilePath());
+    }
+}
+
 // Clear the local profile cache
 void ProfileManager::ClearProfileData()
 {
     Lock::Locker lockScope(&ProfileLock);
 
     ProfileCache.Clear();
+    TagIndex.Clear();
+    BinaryCache.Clear();
+    ChangedItems.Clear();
+    BinaryCurrent = false;
     Changed = false;
 }
 
@@ -337,6 +592,21 @@ void ProfileManager::Save()
     String path = GetProfilePath();
     ProfileCache->Save(path);
     Changed = false;
+
+    // Bring ProfileDB.bin up to date, appending the changed entries if it was current
+    BinaryProfileSource source;
+    if (BinaryEnabled && source.Read(path))
+    {
+        String binary_path = GetBinaryProfilePath();
+        BinaryCurrent = (BinaryCurrent && BinaryProfileDB::Append(binary_path, ChangedItems, BinaryStamp, source)) ||
+                        BinaryProfileDB::Write(binary_path, ProfileCache, source);
+        BinaryStamp = source;
+    }
+    else
+    {
+        BinaryCurrent = false;
+    }
+    ChangedItems.Clear();
 }
 
 // Returns a profile with all system default values
@@ -405,6 +675,27 @@ void ProfileManager::LoadCache(bool create)
 
     String path = GetProfilePath();
 
+    // ProfileDB.bin only exists while the binary cache is enabled, so it carries the
+    // setting over to processes that load the profiles before they could enable it
+    FileStat binary_stat;
+    if (SysFile::GetFileStat(&binary_stat, GetBinaryProfilePath()))
+        BinaryEnabled = true;
+
+    // Use ProfileDB.bin if it still matches the JSON file, which then isn't parsed
+    BinaryProfileSource source;
+    bool have_source = BinaryEnabled && source.Read(path);
+    if (have_source)
+    {
+        BinaryCache = *BinaryProfileDB::Open(GetBinaryProfilePath(), source);
+        if (BinaryCache)
+        {
+            TagIndex.Build(BinaryCache);
+            BinaryStamp = source;
+            BinaryCurrent = true;
+            return;
+        }
+    }
+
     Ptr<JSON> root = *JSON::Load(path);
     if (root == NULL)
     {   
@@ -420,6 +711,7 @@ void ProfileManager::LoadCache(bool create)
                 root->AddItem("Users", JSON::CreateArray());
                 root->AddItem("TaggedData", JSON::CreateArray());
                 ProfileCache = root;
+                TagIndex.Build(ProfileCache->GetItemByName("TaggedData"));
             }
             
             return;
@@ -457,7 +749,40 @@ void ProfileManager::LoadCache(bool create)
         }
 
         ProfileCache = root;   // store the database contents for traversal
+        TagIndex.Build(ProfileCache->GetItemByName("TaggedData"));
+
+        // Write ProfileDB.bin for the next time the cache is loaded
+        if (have_source)
+        {
+            BinaryCurrent = BinaryProfileDB::Write(GetBinaryProfilePath(), ProfileCache, source);
+            BinaryStamp = source;
+        }
+    }
+}
+
+// Makes sure that ProfileCache holds the database so it can be changed, decoding
+// the binary database if that is what was loaded.
+bool ProfileManager::LoadEditableCache(bool create)
+{
+    if (!HasCache())
+        LoadCache(create);
+
+    if (ProfileCache == NULL && BinaryCache)
+    {
+        ProfileCache = *BinaryCache->CreateJSON();
+        TagIndex.Build(ProfileCache->GetItemByName("TaggedData"));
+        BinaryCache.Clear();
     }
+
+    return ProfileCache != NULL;
+}
+
+// Returns a top-level item of whichever cache is loaded
+JSON* ProfileManager::GetCacheItem(const char* name)
+{
+    if (ProfileCache)
+        return ProfileCache->GetItemByName(name);
+    return BinaryCache ? BinaryCache->GetItemByName(name) : NULL;
 }
 
 void ProfileManager::LoadV1Profiles(JSON* v1)
@@ -476,6 +801,7 @@ void ProfileManager::LoadV1Profiles(JSON* v1)
     root->AddItem("Users", JSON::CreateArray());
     root->AddItem("TaggedData", JSON::CreateArray());
     ProfileCache = root;
+    TagIndex.Build(ProfileCache->GetItemByName("TaggedData"));
 
     const char* default_dk1_user = item1->Value;
     
@@ -600,14 +926,14 @@ int ProfileManager::GetUserCount()
 {
     Lock::Locker lockScope(&ProfileLock);
 
-    if (ProfileCache == NULL)
+    if (!HasCache())
     {   // Load the cache
         LoadCache(false);
-        if (ProfileCache == NULL)
+        if (!HasCache())
             return 0;
     }
 
-    JSON* users = ProfileCache->GetItemByName("Users");
+    JSON* users = GetCacheItem("Users");
     if (users == NULL)
         return 0;
 
@@ -618,12 +944,8 @@ bool ProfileManager::CreateUser(const char* user, const char* name)
 {
     Lock::Locker lockScope(&ProfileLock);
 
-    if (ProfileCache == NULL)
-    {   // Load the cache
-        LoadCache(true);
-        if (ProfileCache == NULL)
-            return false;
-    }
+    if (!LoadEditableCache(true))
+        return false;
 
     JSON* users = ProfileCache->GetItemByName("Users");
     if (users == NULL)
@@ -647,6 +969,7 @@ bool ProfileManager::CreateUser(const char* user, const char* name)
             {
                 name_item->Value = name;
                 Changed = true;
+                BinaryCurrent = false;
             }
             return true;
         }
@@ -671,6 +994,7 @@ bool ProfileManager::CreateUser(const char* user, const char* name)
         users->InsertArrayElement(index, new_user);
 
     Changed = true;
+    BinaryCurrent = false;
     return true;
 }
 
@@ -678,14 +1002,14 @@ bool ProfileManager::HasUser(const char* user)
 {
 	Lock::Locker lockScope(&ProfileLock);
 
-	if (ProfileCache == NULL)
+	if (!HasCache())
 	{   // Load the cache
 		LoadCache(false);
-		if (ProfileCache == NULL)
+		if (!HasCache())
 			return false;
 	}
 
-	JSON* users = ProfileCache->GetItemByName("Users");
+	JSON* users = GetCacheItem("Users");
 	if (users == NULL)
 		return false;
 
@@ -712,14 +1036,14 @@ const char* ProfileManager::GetUser(unsigned int index)
 {
     Lock::Locker lockScope(&ProfileLock);
 
-    if (ProfileCache == NULL)
+    if (!HasCache())
     {   // Load the cache
         LoadCache(false);
-        if (ProfileCache == NULL)
+        if (!HasCache())
             return NULL;
     }
 
-    JSON* users = ProfileCache->GetItemByName("Users");
+    JSON* users = GetCacheItem("Users");
     
     if (users && index < users->GetItemCount())
     {
@@ -744,12 +1068,8 @@ bool ProfileManager::RemoveUser(const char* user)
 {
     Lock::Locker lockScope(&ProfileLock);
 
-    if (ProfileCache == NULL)
-    {   // Load the cache
-        LoadCache(false);
-        if (ProfileCache == NULL)
-            return true;
-    }
+    if (!LoadEditableCache(false))
+        return true;
 
     JSON* users = ProfileCache->GetItemByName("Users");
     if (users == NULL)
@@ -765,6 +1085,7 @@ bool ProfileManager::RemoveUser(const char* user)
             user_item->RemoveNode();
             user_item->Release();
             Changed = true;
+            BinaryCurrent = false;
             break;
         }
         
@@ -772,14 +1093,16 @@ bool ProfileManager::RemoveUser(const char* user)
     }
 
     // Now remove all data entries with this user tag
-    JSON* tagged_data = ProfileCache->GetItemByName("TaggedData");
     Array<JSON*> user_items;
-    FilterTaggedData(tagged_data, "User", user, user_items);
+    TagIndex.Filter("User", user, user_items);
     for (unsigned int i=0; i<user_items.GetSize(); i++)
     {
+        TagIndex.Remove(user_items[i]);
         user_items[i]->RemoveNode();
         user_items[i]->Release();
         Changed = true;
+        BinaryCurrent = false;
+        ChangedItems.Clear();
     }
  
     return Changed;
@@ -857,21 +1180,20 @@ Profile* ProfileManager::GetTaggedProfile(const char** tag_names, const char** t
 {
     Lock::Locker lockScope(&ProfileLock);
 
-    if (ProfileCache == NULL)
+    if (!HasCache())
     {   // Load the cache
         LoadCache(false);
-        if (ProfileCache == NULL)
+        if (!HasCache())
             return NULL;
     }
 
-    JSON* tagged_data = ProfileCache->GetItemByName("TaggedData");
-    OVR_ASSERT(tagged_data);
-    if (tagged_data == NULL)
-        return NULL;
-    
+    // The binary database only looks up distinct tag names
+    if (BinaryCache && HasRepeatedTagName(tag_names, num_tags))
+        LoadEditableCache(false);
+
     Profile* profile = new Profile(BasePath);
     
-    JSON* vals = FindTaggedData(tagged_data, tag_names, tags, num_tags);
+    JSON* vals = TagIndex.Find(tag_names, tags, num_tags);
     if (vals)
     {   
         JSON* item = vals->GetFirstItem();
@@ -897,12 +1219,8 @@ bool ProfileManager::SetTaggedProfile(const char** tag_names, const char** tags,
 {
     Lock::Locker lockScope(&ProfileLock);
 
-    if (ProfileCache == NULL)
-    {   // Load the cache
-        LoadCache(true);
-        if (ProfileCache == NULL)
-            return false;  // TODO: Generate a new profile DB
-    }
+    if (!LoadEditableCache(true))
+        return false;  // TODO: Generate a new profile DB
 
     JSON* tagged_data = ProfileCache->GetItemByName("TaggedData");
     OVR_ASSERT(tagged_data);
@@ -910,10 +1228,11 @@ bool ProfileManager::SetTaggedProfile(const char** tag_names, const char** tags,
         return false;
 
     // Get the cached tagged data section
-    JSON* vals = FindTaggedData(tagged_data, tag_names, tags, num_tags);
+    JSON* tagged_item = TagIndex.FindItem(tag_names, tags, num_tags);
+    JSON* vals = tagged_item ? tagged_item->GetItemByName("vals") : NULL;
     if (vals == NULL)
     {  
-        JSON* tagged_item = JSON::CreateObject();
+        tagged_item = JSON::CreateObject();
         JSON* taglist = JSON::CreateArray();
         for (int i=0; i<num_tags; i++)
         {
@@ -927,6 +1246,17 @@ bool ProfileManager::SetTaggedProfile(const char** tag_names, const char** tags,
         tagged_item->AddItem("tags", taglist);
         tagged_item->AddItem("vals", vals);
         tagged_data->AddArrayElement(tagged_item);
+        TagIndex.Add(tagged_item);
+    }
+
+    // The entry is appended to ProfileDB.bin on save
+    if (BinaryCurrent)
+    {
+        size_t i = 0;
+        while (i < ChangedItems.GetSize() && ChangedItems[i] != tagged_item)
+            i++;
+        if (i == ChangedItems.GetSize())
+            ChangedItems.PushBack(tagged_item);
     }
 
     // Now add or update each profile setting in cache
@@ -1049,10 +1379,10 @@ Profile* ProfileManager::GetProfile(const ProfileDeviceKey& deviceKey, const cha
 {
     Lock::Locker lockScope(&ProfileLock);
 
-    if (ProfileCache == NULL)
+    if (!HasCache())
     {   // Load the cache
         LoadCache(false);
-        if (ProfileCache == NULL)
+        if (!HasCache())
             return NULL;
     }
     
@@ -1072,7 +1402,7 @@ Profile* ProfileManager::GetProfile(const ProfileDeviceKey& deviceKey, const cha
         const char* product_str = deviceKey.ProductName.IsEmpty() ? NULL : deviceKey.ProductName.ToCStr();
         const char* serial_str = deviceKey.PrintedSerial.IsEmpty() ? NULL : deviceKey.PrintedSerial.ToCStr();
 
-        if (!profile->LoadProfile(ProfileCache.GetPtr(), user, product_str, serial_str))
+        if (!profile->LoadProfile(TagIndex, user, product_str, serial_str))
         {
             profile->Release();
             return NULL;
@@ -1216,10 +1546,10 @@ bool Profile::LoadDeviceProfile(const ProfileDeviceKey& deviceKey)
 }
 
 //-----------------------------------------------------------------------------
-bool Profile::LoadUser(JSON* root, 
-                         const char* user,
-                          const char* model_name,
-                          const char* device_serial)
+bool Profile::LoadUser(const ProfileTagIndex& tagIndex,
+                       const char* user,
+                       const char* model_name,
+                       const char* device_serial)
 {
     if (user == NULL)
         return false;
@@ -1229,51 +1559,48 @@ bool Profile::LoadUser(JSON* root,
     //    model_name = "RiftDK1";
     
     bool user_found = false;
-    JSON* data = root->GetItemByName("TaggedData");
-    if (data)
-    {   
-        const char* tag_names[3];
-        const char* tags[3];
-        tag_names[0] = "User";
-        tags[0] = user;
-        int num_tags = 1;
 
-        if (model_name)
-        {
-            tag_names[num_tags] = "Product";
-            tags[num_tags] = model_name;
-            num_tags++;
-        }
+    const char* tag_names[3];
+    const char* tags[3];
+    tag_names[0] = "User";
+    tags[0] = user;
+    int num_tags = 1;
 
-        if (device_serial)
-        {
-            tag_names[num_tags] = "Serial";
-            tags[num_tags] = device_serial;
-            num_tags++;
-        }
+    if (model_name)
+    {
+        tag_names[num_tags] = "Product";
+        tags[num_tags] = model_name;
+        num_tags++;
+    }
 
-        // Retrieve all tag permutations
-        for (int combos=1; combos<=num_tags; combos++)
+    if (device_serial)
+    {
+        tag_names[num_tags] = "Serial";
+        tags[num_tags] = device_serial;
+        num_tags++;
+    }
+
+    // Retrieve all tag permutations
+    for (int combos=1; combos<=num_tags; combos++)
+    {
+        for (int i=0; i<(num_tags - combos + 1); i++)
         {
-            for (int i=0; i<(num_tags - combos + 1); i++)
-            {
-                JSON* vals = FindTaggedData(data, tag_names+i, tags+i, combos);
-                if (vals)
-                {   
-                    if (i==0)   // This tag-combination contains a user match
-                        user_found = true;
-
-                    // Add the values to the Profile.  More specialized multi-tag values
-                    // will take precedence over and overwrite generalized ones 
-                    // For example: ("Me","RiftDK1").IPD would overwrite ("Me").IPD
-                    JSON* item = vals->GetFirstItem();
-                    while (item)
-                    {
-                        //printf("Add %s, %s\n", item->Name.ToCStr(), item->Value.ToCStr());
-                        //Settings.Set(item->Name, item->Value);
-                        SetValue(item);
-                        item = vals->GetNextItem(item);
-                    }
+            JSON* vals = tagIndex.Find(tag_names+i, tags+i, combos);
+            if (vals)
+            {   
+                if (i==0)   // This tag-combination contains a user match
+                    user_found = true;
+
+                // Add the values to the Profile.  More specialized multi-tag values
+                // will take precedence over and overwrite generalized ones 
+                // For example: ("Me","RiftDK1").IPD would overwrite ("Me").IPD
+                JSON* item = vals->GetFirstItem();
+                while (item)
+                {
+                    //printf("Add %s, %s\n", item->Name.ToCStr(), item->Value.ToCStr());
+                    //Settings.Set(item->Name, item->Value);
+                    SetValue(item);
+                    item = vals->GetNextItem(item);
                 }
             }
         }
@@ -1287,12 +1614,12 @@ bool Profile::LoadUser(JSON* root,
 
 
 //-----------------------------------------------------------------------------
-bool Profile::LoadProfile(JSON* root,
+bool Profile::LoadProfile(const ProfileTagIndex& tagIndex,
                           const char* user,
                           const char* device_model,
                           const char* device_serial)
 {
-    if (!LoadUser(root, user, device_model, device_serial))
+    if (!LoadUser(tagIndex, user, device_model, device_serial))
         return false;
 
     return true;
@@ -40,6 +40,7 @@ limitations under the License.
 #include "Kernel/OVR_Array.h"
 #include "Kernel/OVR_StringHash.h"
 #include "Kernel/OVR_System.h"
+#include "OVR_BinaryProfileDB.h"
 
 namespace OVR {
 
@@ -73,6 +74,49 @@ struct ProfileDeviceKey
 };
 
 
+// -----------------------------------------------------------------------------
+// ***** ProfileTagIndex
+
+// Hash index over the TaggedData section of the profile database, so that finding
+// the values for a set of tags doesn't compare the tags of every entry.  Each entry
+// is indexed by its complete set of tags, for exact matches, and by each of its tags
+// on its own, for finding all the entries of a user.  The index refers to the entries
+// in the database and must be told about every entry added or removed.
+//
+// Built over a mapped binary database instead, the index forwards Find to it, and
+// the rest isn't used.
+class ProfileTagIndex
+{
+public:
+    ProfileTagIndex();
+
+    void                Clear();
+    void                Build(JSON* taggedData);
+    void                Build(BinaryProfileDB* binaryDB);
+    void                Add(JSON* taggedItem);
+    void                Remove(JSON* taggedItem);
+
+    // Returns the "vals" object of the first entry whose tags are exactly the given
+    // ones, in any order, or NULL.  A binary database needs distinct tag names.
+    JSON*               Find(const char** tag_names, const char** tags, int num_tags) const;
+    // Returns the entry that Find takes the values from.
+    JSON*               FindItem(const char** tag_names, const char** tags, int num_tags) const;
+    // Appends every entry that has the given tag.
+    void                Filter(const char* tag_name, const char* tag, Array<JSON*>& items) const;
+
+protected:
+    typedef Hash<String, Array<JSON*>, String::HashFunctor> EntryHash;
+
+    static void         addEntry(EntryHash& hash, const String& key, JSON* taggedItem);
+    static void         removeEntry(EntryHash& hash, const String& key, JSON* taggedItem);
+
+    JSON*               pTaggedData;
+    BinaryProfileDB*    pBinaryDB;
+    EntryHash           ByTagSet;    // Key of all tags of an entry, sorted by name
+    EntryHash           ByTag;       // Key of a single tag
+};
+
+
 // -----------------------------------------------------------------------------
 // ***** ProfileManager
 
@@ -106,6 +150,12 @@ protected:
     // as it's shared through DeviceManager.
     Lock                ProfileLock;
     Ptr<JSON>           ProfileCache;
+    Ptr<BinaryProfileDB> BinaryCache;   // Mapped ProfileDB.bin, used until ProfileCache is needed
+    ProfileTagIndex     TagIndex;       // Index of ProfileCache TaggedData, or of BinaryCache
+    Array<JSON*>        ChangedItems;   // TaggedData entries set since ProfileDB.bin was written
+    BinaryProfileSource BinaryStamp;    // The ProfileDB.json that ProfileDB.bin matches
+    bool                BinaryCurrent;  // ProfileDB.bin matches ProfileCache apart from ChangedItems
+    bool                BinaryEnabled;
     bool                Changed;
     String              TempBuff;
     String              BasePath;
@@ -114,6 +164,15 @@ public:
     // In the service process it is important to set the base path because this cannot be detected automatically
     void                SetBasePath(String basePath);
 
+    // ProfileDB.bin, a binary copy of ProfileDB.json that is read in place instead of
+    // parsing the JSON, is only read and written once enabled, e.g. through the
+    // OVR_KEY_PROFILE_BINARY_CACHE HMD property.  Off by default.  Enabling it writes
+    // ProfileDB.bin right away, and its presence enables the cache for every later
+    // process, which then loads the profiles without parsing the JSON.  Disabling it
+    // deletes ProfileDB.bin.
+    void                SetBinaryCacheEnabled(bool enabled);
+    bool                IsBinaryCacheEnabled() const { return BinaryEnabled; }
+
     int                 GetUserCount();
     const char*         GetUser(unsigned int index);
     bool                CreateUser(const char* user, const char* name);
@@ -138,7 +197,11 @@ protected:
     void                Save();
 
     String              GetProfilePath();
+    String              GetBinaryProfilePath();
     void                LoadCache(bool create);
+    bool                LoadEditableCache(bool create);
+    bool                HasCache() const { return ProfileCache || BinaryCache; }
+    JSON*               GetCacheItem(const char* name);
     void                LoadV1Profiles(JSON* v1);
     const char*         GetDefaultUser(const char* product, const char* serial);
 };
@@ -199,12 +262,12 @@ protected:
     bool                LoadDeviceFile(unsigned int device_id, const char* serial);
 	bool                LoadDeviceProfile(const ProfileDeviceKey& deviceKey);
 
-    bool                LoadProfile(JSON* root,
+    bool                LoadProfile(const ProfileTagIndex& tagIndex,
                                     const char* user,
                                     const char* device_model,
                                     const char* device_serial);
 
-    bool                LoadUser(JSON* root,
+    bool                LoadUser(const ProfileTagIndex& tagIndex,
                                  const char* user,
                                  const char* device_name,
                                  const char* device_serial);
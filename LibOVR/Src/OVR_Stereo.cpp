@@ -28,6 +28,26 @@ limitations under the License.
 #include "OVR_Profile.h"
 #include "Kernel/OVR_Log.h"
 #include "Kernel/OVR_Alg.h"
+#include "Kernel/OVR_Timer.h"
+
+// SSE2/AVX2 kernels for the batched distortion functions, selected at runtime.
+#if defined(OVR_CPU_X86) || defined(OVR_CPU_X86_64)
+    #define OVR_STEREO_BATCH_SSE2
+    #include <emmintrin.h>
+    #if !defined(OVR_CC_MSVC) || (OVR_CC_MSVC >= 1700) // AVX2 intrinsics need VS2012+
+        #define OVR_STEREO_BATCH_AVX2
+        #include <immintrin.h>
+    #endif
+    #if defined(OVR_CC_MSVC)
+        #include <intrin.h>
+    #endif
+#endif
+
+#if defined(OVR_STEREO_BATCH_AVX2) && !defined(OVR_CC_MSVC)
+    #define OVR_STEREO_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+    #define OVR_STEREO_TARGET_AVX2
+#endif
 
 //To allow custom distortion to be introduced to CatMulSpline.
 float (*CustomDistortion)(float) = NULL;
@@ -81,6 +101,85 @@ bool FitCubicPolynomial ( float *pResult, const float *pFitX, const float *pFitY
     return true;
 }
 
+// Hermite segment coefficients of the spline through K[].  EvalCatmullRom10Spline
+// derives the one segment it needs on every call; the batched paths derive all of
+// them once per batch.
+struct CatmullRom10Segments
+{
+    enum { NumSegments = LensConfig::NumCoefficients };
+
+    float P0[NumSegments];
+    float M0[NumSegments];
+    float P1[NumSegments];
+    float M1[NumSegments];
+
+    explicit CatmullRom10Segments ( float const *K )
+    {
+        for ( int k = 0; k < NumSegments; k++ )
+        {
+            GetSegment ( K, k, P0[k], M0[k], P1[k], M1[k] );
+        }
+    }
+
+    static void GetSegment ( float const *K, int k, float &p0, float &m0, float &p1, float &m1 )
+    {
+        switch ( k )
+        {
+        case 0:
+            // Curve starts at 1.0 with gradient K[1]-K[0]
+            p0 = 1.0f;
+            m0 =        ( K[1] - K[0] );    // general case would have been (K[1]-K[-1])/2
+            p1 = K[1];
+            m1 = 0.5f * ( K[2] - K[0] );
+            break;
+        default:
+            // General case
+            p0 = K[k  ];
+            m0 = 0.5f * ( K[k+1] - K[k-1] );
+            p1 = K[k+1];
+            m1 = 0.5f * ( K[k+2] - K[k  ] );
+            break;
+        case NumSegments-2:
+            // Last tangent is just the slope of the last two points.
+            p0 = K[NumSegments-2];
+            m0 = 0.5f * ( K[NumSegments-1] - K[NumSegments-2] );
+            p1 = K[NumSegments-1];
+            m1 = K[NumSegments-1] - K[NumSegments-2];
+            break;
+        case NumSegments-1:
+            // Beyond the last segment it's just a straight line
+            p0 = K[NumSegments-1];
+            m0 = K[NumSegments-1] - K[NumSegments-2];
+            p1 = p0 + m0;
+            m1 = m0;
+            break;
+        }
+    }
+
+    // Splits scaledVal into a clamped segment index and the position t within it.
+    static int GetSegmentIndex ( float scaledVal, float &t )
+    {
+        float scaledValFloor = floorf ( scaledVal );
+        scaledValFloor = Alg::Max ( 0.0f, Alg::Min ( (float)(NumSegments-1), scaledValFloor ) );
+        t = scaledVal - scaledValFloor;
+        return (int)scaledValFloor;
+    }
+
+    static float Hermite ( float p0, float m0, float p1, float m1, float t )
+    {
+        float omt = 1.0f - t;
+        return ( p0 * ( 1.0f + 2.0f *   t ) + m0 *   t ) * omt * omt
+             + ( p1 * ( 1.0f + 2.0f * omt ) - m1 * omt ) *   t *   t;
+    }
+
+    float Eval ( float scaledVal ) const
+    {
+        float t;
+        int   k = GetSegmentIndex ( scaledVal, t );
+        return Hermite ( P0[k], M0[k], P1[k], M1[k], t );
+    }
+};
+
 #define TPH_SPLINE_STATISTICS 0
 #if TPH_SPLINE_STATISTICS
 static float max_scaledVal = 0;
@@ -96,9 +195,9 @@ static float percent_out_of_range;
 
 float EvalCatmullRom10Spline ( float const *K, float scaledVal )
 {
-    int const NumSegments = LensConfig::NumCoefficients;
-
 	#if TPH_SPLINE_STATISTICS
+    int const NumSegments = CatmullRom10Segments::NumSegments;
+
 	//Value should be in range of 0 to (NumSegments-1) (typically 10) if spline is valid. Right?
 	if (scaledVal > (NumSegments-1))
 	{
@@ -118,50 +217,186 @@ float EvalCatmullRom10Spline ( float const *K, float scaledVal )
 	}
 	#endif
 
-    float scaledValFloor = floorf ( scaledVal );
-    scaledValFloor = Alg::Max ( 0.0f, Alg::Min ( (float)(NumSegments-1), scaledValFloor ) );
-    float t = scaledVal - scaledValFloor;
-    int k = (int)scaledValFloor;
+    float t;
+    int   k = CatmullRom10Segments::GetSegmentIndex ( scaledVal, t );
 
     float p0, p1;
     float m0, m1;
-    switch ( k )
-    {
-    case 0:
-        // Curve starts at 1.0 with gradient K[1]-K[0]
-        p0 = 1.0f;
-        m0 =        ( K[1] - K[0] );    // general case would have been (K[1]-K[-1])/2
-        p1 = K[1];
-        m1 = 0.5f * ( K[2] - K[0] );
-        break;
-    default:
-        // General case
-        p0 = K[k  ];
-        m0 = 0.5f * ( K[k+1] - K[k-1] );
-        p1 = K[k+1];
-        m1 = 0.5f * ( K[k+2] - K[k  ] );
-        break;
-    case NumSegments-2:
-        // Last tangent is just the slope of the last two points.
-        p0 = K[NumSegments-2];
-        m0 = 0.5f * ( K[NumSegments-1] - K[NumSegments-2] );
-        p1 = K[NumSegments-1];
-        m1 = K[NumSegments-1] - K[NumSegments-2];
-        break;
-    case NumSegments-1:
-        // Beyond the last segment it's just a straight line
-        p0 = K[NumSegments-1];
-        m0 = K[NumSegments-1] - K[NumSegments-2];
-        p1 = p0 + m0;
-        m1 = m0;
-        break;
+    CatmullRom10Segments::GetSegment ( K, k, p0, m0, p1, m1 );
+
+    return CatmullRom10Segments::Hermite ( p0, m0, p1, m1, t );
+}
+
+
+
+//-----------------------------------------------------------------------------------
+// ***** Batched spline evaluation
+
+// The batched paths evaluate exactly the expression in CatmullRom10Segments::Hermite,
+// in the same operation order and without fused multiply-add, so wherever scalar float
+// math is done in SSE registers (all x64 builds) the results are bit-identical to the
+// scalar functions.  Builds whose scalar path uses x87 or contracts to FMA may differ
+// by up to 2 ULP.
+
+// Each kernel computes result[i] = spline ( ( numer * value[i] ) / denom ), matching
+// the "(NumSegments-1) * rsq / ( MaxR * MaxR )" scaling done by the callers.
+typedef void (*CatmullRom10BatchKernel) ( CatmullRom10Segments const &seg, float numer, float denom,
+                                           float const *value, float *result, int count );
+
+static void evalCatmullRom10BatchScalar ( CatmullRom10Segments const &seg, float numer, float denom,
+                                          float const *value, float *result, int count )
+{
+    for ( int i = 0; i < count; i++ )
+    {
+        result[i] = seg.Eval ( numer * value[i] / denom );
     }
+}
+
+#ifdef OVR_STEREO_BATCH_SSE2
+
+static void evalCatmullRom10BatchSSE2 ( CatmullRom10Segments const &seg, float numer, float denom,
+                                        float const *value, float *result, int count )
+{
+    const __m128 vNumer = _mm_set1_ps ( numer );
+    const __m128 vDenom = _mm_set1_ps ( denom );
+    const __m128 vZero  = _mm_setzero_ps();
+    const __m128 vLast  = _mm_set1_ps ( (float)(CatmullRom10Segments::NumSegments-1) );
+    const __m128 vOne   = _mm_set1_ps ( 1.0f );
+    const __m128 vTwo   = _mm_set1_ps ( 2.0f );
+
+    int i = 0;
+    for ( ; i + 4 <= count; i += 4 )
+    {
+        __m128 x = _mm_div_ps ( _mm_mul_ps ( vNumer, _mm_loadu_ps ( value + i ) ), vDenom );
+
+        // The clamp bounds are integers, so floor(clamp(x)) == clamp(floor(x)). Clamping
+        // first keeps the conversion in range, and truncation is floor for x >= 0.
+        __m128i k = _mm_cvttps_epi32 ( _mm_min_ps ( _mm_max_ps ( x, vZero ), vLast ) );
+        __m128  t = _mm_sub_ps ( x, _mm_cvtepi32_ps ( k ) );
+
+        OVR_ALIGNAS(16) int32_t idx[4];
+        _mm_store_si128 ( (__m128i*)idx, k );
 
-    float omt = 1.0f - t;
-    float res  = ( p0 * ( 1.0f + 2.0f *   t ) + m0 *   t ) * omt * omt
-               + ( p1 * ( 1.0f + 2.0f * omt ) - m1 * omt ) *   t *   t;
+        __m128 p0 = _mm_setr_ps ( seg.P0[idx[0]], seg.P0[idx[1]], seg.P0[idx[2]], seg.P0[idx[3]] );
+        __m128 m0 = _mm_setr_ps ( seg.M0[idx[0]], seg.M0[idx[1]], seg.M0[idx[2]], seg.M0[idx[3]] );
+        __m128 p1 = _mm_setr_ps ( seg.P1[idx[0]], seg.P1[idx[1]], seg.P1[idx[2]], seg.P1[idx[3]] );
+        __m128 m1 = _mm_setr_ps ( seg.M1[idx[0]], seg.M1[idx[1]], seg.M1[idx[2]], seg.M1[idx[3]] );
+
+        __m128 omt = _mm_sub_ps ( vOne, t );
+        __m128 a   = _mm_add_ps ( _mm_mul_ps ( p0, _mm_add_ps ( vOne, _mm_mul_ps ( vTwo, t ) ) ), _mm_mul_ps ( m0, t ) );
+        __m128 b   = _mm_sub_ps ( _mm_mul_ps ( p1, _mm_add_ps ( vOne, _mm_mul_ps ( vTwo, omt ) ) ), _mm_mul_ps ( m1, omt ) );
+        a = _mm_mul_ps ( _mm_mul_ps ( a, omt ), omt );
+        b = _mm_mul_ps ( _mm_mul_ps ( b, t ), t );
+
+        _mm_storeu_ps ( result + i, _mm_add_ps ( a, b ) );
+    }
 
-    return res;
+    evalCatmullRom10BatchScalar ( seg, numer, denom, value + i, result + i, count - i );
+}
+
+#endif // OVR_STEREO_BATCH_SSE2
+
+#ifdef OVR_STEREO_BATCH_AVX2
+
+OVR_STEREO_TARGET_AVX2
+static void evalCatmullRom10BatchAVX2 ( CatmullRom10Segments const &seg, float numer, float denom,
+                                        float const *value, float *result, int count )
+{
+    const __m256 vNumer = _mm256_set1_ps ( numer );
+    const __m256 vDenom = _mm256_set1_ps ( denom );
+    const __m256 vZero  = _mm256_setzero_ps();
+    const __m256 vLast  = _mm256_set1_ps ( (float)(CatmullRom10Segments::NumSegments-1) );
+    const __m256 vOne   = _mm256_set1_ps ( 1.0f );
+    const __m256 vTwo   = _mm256_set1_ps ( 2.0f );
+
+    int i = 0;
+    for ( ; i + 8 <= count; i += 8 )
+    {
+        __m256 x = _mm256_div_ps ( _mm256_mul_ps ( vNumer, _mm256_loadu_ps ( value + i ) ), vDenom );
+
+        // See the SSE2 kernel for why clamping before truncation matches floorf.
+        __m256i k = _mm256_cvttps_epi32 ( _mm256_min_ps ( _mm256_max_ps ( x, vZero ), vLast ) );
+        __m256  t = _mm256_sub_ps ( x, _mm256_cvtepi32_ps ( k ) );
+
+        __m256 p0 = _mm256_i32gather_ps ( seg.P0, k, 4 );
+        __m256 m0 = _mm256_i32gather_ps ( seg.M0, k, 4 );
+        __m256 p1 = _mm256_i32gather_ps ( seg.P1, k, 4 );
+        __m256 m1 = _mm256_i32gather_ps ( seg.M1, k, 4 );
+
+        __m256 omt = _mm256_sub_ps ( vOne, t );
+        __m256 a   = _mm256_add_ps ( _mm256_mul_ps ( p0, _mm256_add_ps ( vOne, _mm256_mul_ps ( vTwo, t ) ) ), _mm256_mul_ps ( m0, t ) );
+        __m256 b   = _mm256_sub_ps ( _mm256_mul_ps ( p1, _mm256_add_ps ( vOne, _mm256_mul_ps ( vTwo, omt ) ) ), _mm256_mul_ps ( m1, omt ) );
+        a = _mm256_mul_ps ( _mm256_mul_ps ( a, omt ), omt );
+        b = _mm256_mul_ps ( _mm256_mul_ps ( b, t ), t );
+
+        _mm256_storeu_ps ( result + i, _mm256_add_ps ( a, b ) );
+    }
+
+    evalCatmullRom10BatchScalar ( seg, numer, denom, value + i, result + i, count - i );
+}
+
+#endif // OVR_STEREO_BATCH_AVX2
+
+static CatmullRom10BatchKernel detectCatmullRom10BatchKernel()
+{
+#if defined(OVR_STEREO_BATCH_SSE2) && defined(OVR_CC_MSVC)
+    int info[4];
+    __cpuid ( info, 0 );
+    const int maxLeaf = info[0];
+    __cpuid ( info, 1 );
+    const bool sse2 = ( info[3] & (1 << 26) ) != 0;
+
+    #ifdef OVR_STEREO_BATCH_AVX2
+    // AVX state must also be enabled by the OS (OSXSAVE + XCR0 YMM bits).
+    const bool osAvx = ( info[2] & (1 << 27) ) && ( info[2] & (1 << 28) ) &&
+                       ( ( _xgetbv ( 0 ) & 6 ) == 6 );
+    if ( osAvx && maxLeaf >= 7 )
+    {
+        __cpuidex ( info, 7, 0 );
+        if ( info[1] & (1 << 5) )
+        {
+            return evalCatmullRom10BatchAVX2;
+        }
+    }
+    #else
+    OVR_UNUSED ( maxLeaf );
+    #endif
+
+    if ( sse2 )
+    {
+        return evalCatmullRom10BatchSSE2;
+    }
+#elif defined(OVR_STEREO_BATCH_SSE2)
+    __builtin_cpu_init();
+    #ifdef OVR_STEREO_BATCH_AVX2
+    if ( __builtin_cpu_supports ( "avx2" ) )
+    {
+        return evalCatmullRom10BatchAVX2;
+    }
+    #endif
+    if ( __builtin_cpu_supports ( "sse2" ) )
+    {
+        return evalCatmullRom10BatchSSE2;
+    }
+#endif
+    return evalCatmullRom10BatchScalar;
+}
+
+static CatmullRom10BatchKernel getCatmullRom10BatchKernel()
+{
+    // Detection is idempotent, so racing first calls are harmless.
+    static CatmullRom10BatchKernel kernel = NULL;
+    if ( !kernel )
+    {
+        kernel = detectCatmullRom10BatchKernel();
+    }
+    return kernel;
+}
+
+void EvalCatmullRom10SplineBatch ( float const *K, float const *scaledVal, float *result, int count )
+{
+    CatmullRom10Segments seg ( K );
+    getCatmullRom10BatchKernel() ( seg, 1.0f, 1.0f, scaledVal, result, count );
 }
 
 
@@ -241,6 +476,61 @@ Vector3f LensConfig::DistortionFnScaleRadiusSquaredChroma (float rsq) const
     return scaleRGB;
 }
 
+void LensConfig::DistortionFnScaleRadiusSquaredBatch (float const *rsq, float *scale, int count) const
+{
+    switch ( Eqn )
+    {
+    case Distortion_Poly4:
+        for ( int i = 0; i < count; i++ )
+        {
+            scale[i] = ( K[0] + rsq[i] * ( K[1] + rsq[i] * ( K[2] + rsq[i] * K[3] ) ) );
+        }
+        break;
+    case Distortion_RecipPoly4:
+        for ( int i = 0; i < count; i++ )
+        {
+            scale[i] = 1.0f / ( K[0] + rsq[i] * ( K[1] + rsq[i] * ( K[2] + rsq[i] * K[3] ) ) );
+        }
+        break;
+    case Distortion_CatmullRom10:
+        if ( !CustomDistortion )
+        {
+            CatmullRom10Segments seg ( K );
+            getCatmullRom10BatchKernel() ( seg, (float)(NumCoefficients-1), MaxR * MaxR, rsq, scale, count );
+            break;
+        }
+        // Fall through to the scalar path, which applies the CustomDistortion override.
+    default:
+        for ( int i = 0; i < count; i++ )
+        {
+            scale[i] = DistortionFnScaleRadiusSquared ( rsq[i] );
+        }
+        break;
+    }
+}
+
+void LensConfig::DistortionFnScaleRadiusSquaredChromaBatch (float const *rsq, Vector3f *scaleRGB, int count) const
+{
+    // Work through a fixed stack buffer to avoid allocating for large batches.
+    const int ChunkSize = 256;
+    float     scale[ChunkSize];
+
+    for ( int start = 0; start < count; start += ChunkSize )
+    {
+        const int chunk = Alg::Min ( ChunkSize, count - start );
+        DistortionFnScaleRadiusSquaredBatch ( rsq + start, scale, chunk );
+
+        for ( int i = 0; i < chunk; i++ )
+        {
+            const float r2 = rsq[start + i];
+            Vector3f&   out = scaleRGB[start + i];
+            out.x = scale[i] * ( 1.0f + ChromaticAberration[0] + r2 * ChromaticAberration[1] );  // Red
+            out.y = scale[i];                                                                     // Green
+            out.z = scale[i] * ( 1.0f + ChromaticAberration[2] + r2 * ChromaticAberration[3] );  // Blue
+        }
+    }
+}
+
 // DistortionFnInverse computes the inverse of the distortion function on an argument.
 float LensConfig::DistortionFnInverse(float r) const
 {    
@@ -399,8 +689,145 @@ void LensConfig::SetUpInverseApprox()
     default:
         break;
     }
+
+    SetUpInverseTable();
 }
 
+void LensConfig::SetUpInverseTable()
+{
+    InvTableScale = 0.0f;
+    if ( ( MaxInvR <= 0.0f ) || ( MaxR <= 0.0f ) )
+    {
+        return;
+    }
+
+    // Bisect the forward function for each sample. Samples are increasing, so each
+    // search can start from the previous result.
+    InvTable[0] = 0.0f;
+    for ( int i = 1; i <= NumInvTableSegments; i++ )
+    {
+        float r  = MaxInvR * (float)i / (float)NumInvTableSegments;
+        float lo = InvTable[i-1];
+        float hi = Alg::Max ( lo, MaxR );
+        while ( ( DistortionFn ( hi ) < r ) && ( hi < 20.0f ) )
+        {
+            hi *= 2.0f;
+        }
+
+        for ( int iter = 0; iter < 32; iter++ )
+        {
+            float mid = 0.5f * ( lo + hi );
+            if ( DistortionFn ( mid ) < r )
+            {
+                lo = mid;
+            }
+            else
+            {
+                hi = mid;
+            }
+        }
+        InvTable[i] = 0.5f * ( lo + hi );
+    }
+
+    InvTableScale = (float)NumInvTableSegments / MaxInvR;
+
+    // Worst case for the interpolated seed is midway between samples. Lens configs come
+    // from profile data, so a steep or non-monotonic curve falls back to the exact inverse.
+    for ( int i = 0; i < NumInvTableSegments; i++ )
+    {
+        float r     = MaxInvR * ( (float)i + 0.5f ) / (float)NumInvTableSegments;
+        float error = fabsf ( DistortionFn ( DistortionFnInverseFast ( r ) ) - r );
+        if ( !( error < 0.0001f * MaxR ) )
+        {
+            LogText ( "LensConfig: inverse table error %g at r = %g, using the exact inverse\n", error, r );
+            InvTableScale = 0.0f;
+            return;
+        }
+    }
+}
+
+float LensConfig::DistortionFnInverseFast(float r) const
+{
+    if ( ( InvTableScale <= 0.0f ) || !( r >= 0.0f ) || ( r > MaxInvR ) )
+    {
+        return DistortionFnInverse ( r );
+    }
+
+    float pos = r * InvTableScale;
+    int   i   = Alg::Min ( (int)pos, (int)NumInvTableSegments - 1 );
+    float t   = pos - (float)i;
+
+    // Linear seed from the table, one Newton step using the table's slope as the
+    // derivative of the inverse, then secant steps through the latest two evaluations.
+    // The spline's slope is discontinuous at its knots, so a single secant step that
+    // straddles one is not enough.
+    float delta = InvTable[i+1] - InvTable[i];
+    float slope = delta * InvTableScale;
+    float s0    = InvTable[i] + t * delta;
+    float e0    = DistortionFn ( s0 ) - r;
+    float s1    = s0 - e0 * slope;
+
+    for ( int iter = 0; iter < 2; iter++ )
+    {
+        float e1 = DistortionFn ( s1 ) - r;
+        if ( e1 == e0 )
+        {
+            break;
+        }
+        float s2 = s1 - e1 * ( s1 - s0 ) / ( e1 - e0 );
+        s0 = s1;
+        e0 = e1;
+        s1 = s2;
+    }
+
+    return s1;
+}
+
+#ifdef OVR_STEREO_BENCHMARK
+void BenchmarkDistortionFnInverse ( LensConfig const &config )
+{
+    const int NumSamples = 100000;
+    const float maxR = config.MaxInvR;
+
+    struct InverseFn
+    {
+        const char* Name;
+        float (LensConfig::*Fn)(float) const;
+    };
+    const InverseFn fns[] =
+    {
+        { "DistortionFnInverse",       &LensConfig::DistortionFnInverse },
+        { "DistortionFnInverseApprox", &LensConfig::DistortionFnInverseApprox },
+        { "DistortionFnInverseFast",   &LensConfig::DistortionFnInverseFast }
+    };
+
+    for ( int f = 0; f < (int)(sizeof(fns) / sizeof(fns[0])); f++ )
+    {
+        float  maxError = 0.0f;
+        float  checksum = 0.0f;
+        double start    = Timer::GetSeconds();
+
+        for ( int i = 0; i < NumSamples; i++ )
+        {
+            checksum += (config.*fns[f].Fn) ( maxR * (float)i / (float)NumSamples );
+        }
+
+        double elapsed = Timer::GetSeconds() - start;
+
+        // Error is measured in the forward direction, relative to MaxR.
+        for ( int i = 0; i < NumSamples; i += 97 )
+        {
+            float r   = maxR * (float)i / (float)NumSamples;
+            float err = fabsf ( config.DistortionFn ( (config.*fns[f].Fn) ( r ) ) - r ) / config.MaxR;
+            maxError  = Alg::Max ( maxError, err );
+        }
+
+        LogText ( "BenchmarkDistortionFnInverse: %-26s %8.1f ns/call, max error %g (checksum %f)\n",
+                  fns[f].Name, elapsed * 1e9 / NumSamples, maxError, checksum );
+    }
+}
+#endif
+
 
 void LensConfig::SetToIdentity()
 {
@@ -419,6 +846,8 @@ void LensConfig::SetToIdentity()
     ChromaticAberration[2] = 0.0f;
     ChromaticAberration[3] = 0.0f;
     MetersPerTanAngleAtCenter = 0.05f;
+    // Callers usually overwrite K[] next, so leave the table for SetUpInverseApprox().
+    InvTableScale = 0.0f;
 }
 
 
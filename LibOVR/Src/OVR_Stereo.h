@@ -31,10 +31,18 @@ limitations under the License.
 #include "Displays/OVR_Display.h"
 #include "OVR_Profile.h"
 
+// Define this to compile-in distortion benchmark logic
+//#define OVR_STEREO_BENCHMARK
+
 // CAPI Forward declaration.
 typedef struct ovrFovPort_ ovrFovPort;
 typedef struct ovrRecti_ ovrRecti;
 
+// Optional replacements for the lens distortion scale and its inverse, as a function of
+// the squared radius. Meshes generated while either is set aren't standard ones.
+extern float (*CustomDistortion)(float);
+extern float (*CustomDistortionInv)(float);
+
 namespace OVR {
 
 class SensorDevice; // Opaque forward declaration
@@ -162,6 +170,15 @@ struct ScaleAndOffset2D
 // have the same pFitX value).
 bool FitCubicPolynomial ( float *pResult, const float *pFitX, const float *pFitY );
 
+// Evaluates the Catmull-Rom spline used by Distortion_CatmullRom10 (see LensConfig)
+// at a point already scaled into segment units [0, NumCoefficients-1].
+float EvalCatmullRom10Spline ( float const *K, float scaledVal );
+
+// Evaluates the spline at count points, using SSE2 or AVX2 when the CPU supports them.
+// Results are bit-identical to EvalCatmullRom10Spline wherever scalar float math is done
+// in SSE registers (all x64 builds), and within 2 ULP otherwise.
+void EvalCatmullRom10SplineBatch ( float const *K, float const *scaledVal, float *result, int count );
+
 //-----------------------------------------------------------------------------------
 // ***** LensConfig
 
@@ -183,10 +200,13 @@ struct LensConfig
       //ChromaticAberration()
       //InvK()
       , MaxInvR(0.0f)
+      //InvTable()
+      , InvTableScale(0.0f)
     {
         memset(&K, 0, sizeof(K));
         memset(&ChromaticAberration, 0, sizeof(ChromaticAberration));
         memset(&InvK, 0, sizeof(InvK));
+        memset(&InvTable, 0, sizeof(InvTable));
     }
     
     // The result is a scaling applied to the distance from the center of the lens.
@@ -194,6 +214,11 @@ struct LensConfig
     // x,y,z components map to r,g,b scales.
     Vector3f DistortionFnScaleRadiusSquaredChroma (float rsq) const;
 
+    // Batched versions of the above for building tables and validating profiles;
+    // same accuracy guarantee as EvalCatmullRom10SplineBatch.
+    void     DistortionFnScaleRadiusSquaredBatch (float const *rsq, float *scale, int count) const;
+    void     DistortionFnScaleRadiusSquaredChromaBatch (float const *rsq, Vector3f *scaleRGB, int count) const;
+
     // DistortionFn applies distortion to the argument.
     // Input: the distance in TanAngle/NIC space from the optical center to the input pixel.
     // Output: the resulting distance after distortion.
@@ -207,9 +232,19 @@ struct LensConfig
 
     // Also computes the inverse, but using a polynomial approximation. Warning - it's just an approximation!
     float DistortionFnInverseApprox(float r) const;
-    // Sets up InvK[].
+    // Sets up InvK[], and InvTable[] via SetUpInverseTable().
     void SetUpInverseApprox();
 
+    // Computes the inverse from InvTable[] plus a Newton step and two secant steps.  Over
+    // [0, MaxInvR], DistortionFn() of the result is within 1e-4 * MaxR of r (typically 1e-5,
+    // tighter than DistortionFnInverse itself) at about a seventh of the cost.  Outside that
+    // range, or if the table has not been set up, it falls back to DistortionFnInverse.
+    // The table is not rebuilt when K[] changes; call SetUpInverseApprox() again after that.
+    float DistortionFnInverseFast(float r) const;
+    // Sets up InvTable[]; requires K[], Eqn, MaxR and MaxInvR.  The distortion function
+    // must be monotonic over [0, MaxR].
+    void SetUpInverseTable();
+
     // Sets a bunch of sensible defaults.
     void SetToIdentity();
 
@@ -232,6 +267,11 @@ struct LensConfig
 
     float               InvK[NumCoefficients];
     float               MaxInvR;
+
+    // DistortionFnInverse sampled at NumInvTableSegments+1 evenly spaced points over [0, MaxInvR].
+    enum { NumInvTableSegments = 64 };
+    float               InvTable[NumInvTableSegments + 1];
+    float               InvTableScale;  // NumInvTableSegments / MaxInvR, or 0 if InvTable is not set up.
 };
 
 
@@ -245,6 +285,12 @@ int SaveLensConfigSizeInBytes ( LensConfig const &config );
 // Returns true on success.
 bool SaveLensConfig ( uint8_t *pbuffer, int bufferSizeInBytes, LensConfig const &config );
 
+#ifdef OVR_STEREO_BENCHMARK
+// Logs the cost and worst-case error of DistortionFnInverse, DistortionFnInverseApprox
+// and DistortionFnInverseFast over [0, MaxInvR].
+void BenchmarkDistortionFnInverse ( LensConfig const &config );
+#endif
+
 
 //-----------------------------------------------------------------------------------
 // ***** DistortionRenderDesc
@@ -42,7 +42,9 @@ using namespace OVR::Net;
 NetClient::NetClient() :
     LatencyTesterAvailable(false),
     HMDCount(0),
-    EdgeTriggeredHMDCount(false)
+    EdgeTriggeredHMDCount(false),
+    ValueCacheGeneration(0),
+    ValueBatchSupport(ValueBatches_Unknown)
 {
     GetSession()->AddSessionListener(this);
 
@@ -101,6 +103,9 @@ void NetClient::OnDisconnected(Connection* conn)
     OVR_DEBUG_LOG(("[NetClient] Disconnected"));
 
     EdgeTriggeredHMDCount = false;
+
+    // Changes made while disconnected won't be reported
+    invalidateAllValues();
 }
 
 void NetClient::OnConnected(Connection* conn)
@@ -112,6 +117,8 @@ void NetClient::OnConnected(Connection* conn)
         RPCVersion_Major, RPCVersion_Minor, RPCVersion_Patch));
 
     EdgeTriggeredHMDCount = false;
+
+    invalidateAllValues();
 }
 
 bool NetClient::Connect(bool blocking)
@@ -200,6 +207,16 @@ const char* NetClient::GetStringValue(VirtualHmdId hmd, const char* key, const c
 
     ProfileGetValue1_Str = default_val;
 
+    if (serverSupportsValueBatches())
+    {
+        ValueRequest request(EGetStringValue, hmd, key);
+        request.StringValue = default_val;
+        getValuesBatched(&request, 1);
+
+        ProfileGetValue1_Str = request.StringValue;
+        return ProfileGetValue1_Str.ToCStr();
+    }
+
     OVR::Net::BitStream bsOut, returnData;
     bsOut.Write(hmd);
     bsOut.Write(key);
@@ -221,6 +238,14 @@ bool NetClient::GetBoolValue(VirtualHmdId hmd, const char* key, bool default_val
         return default_val;
     }
 
+    if (serverSupportsValueBatches())
+    {
+        ValueRequest request(EGetBoolValue, hmd, key);
+        request.NumberValue = default_val ? 1. : 0.;
+        getValuesBatched(&request, 1);
+        return request.NumberValue != 0.;
+    }
+
     OVR::Net::BitStream bsOut, returnData;
     bsOut.Write(hmd);
     bsOut.Write(key);
@@ -243,6 +268,14 @@ int NetClient::GetIntValue(VirtualHmdId hmd, const char* key, int default_val)
         return default_val;
     }
 
+    if (serverSupportsValueBatches())
+    {
+        ValueRequest request(EGetIntValue, hmd, key);
+        request.NumberValue = default_val;
+        getValuesBatched(&request, 1);
+        return (int)request.NumberValue;
+    }
+
     OVR::Net::BitStream bsOut, returnData;
     bsOut.Write(hmd);
     bsOut.Write(key);
@@ -265,6 +298,14 @@ double NetClient::GetNumberValue(VirtualHmdId hmd, const char* key, double defau
         return default_val;
     }
 
+    if (serverSupportsValueBatches())
+    {
+        ValueRequest request(EGetNumberValue, hmd, key);
+        request.NumberValue = default_val;
+        getValuesBatched(&request, 1);
+        return request.NumberValue;
+    }
+
     OVR::Net::BitStream bsOut, returnData;
     bsOut.Write(hmd);
     bsOut.Write(key);
@@ -284,6 +325,23 @@ int NetClient::GetNumberValues(VirtualHmdId hmd, const char* key, double* values
         return 0;
     }
 
+    if (serverSupportsValueBatches())
+    {
+        ValueRequest request(EGetNumberValues, hmd, key);
+        request.NumberValues.Resize(num_vals > 0 ? num_vals : 0);
+        if (!getValuesBatched(&request, 1))
+        {
+            return 0;
+        }
+
+        const int count = request.NumberValues.GetSizeI();
+        for (int i = 0; i < count; i++)
+        {
+            values[i] = request.NumberValues[i];
+        }
+        return count;
+    }
+
     OVR::Net::BitStream bsOut, returnData;
     bsOut.Write(hmd);
     bsOut.Write(key);
@@ -329,6 +387,9 @@ bool NetClient::SetStringValue(VirtualHmdId hmd, const char* key, const char* va
         return false;
     }
 
+    // Our own gets see the new value before the server reports the change
+    invalidateValue(hmd, key);
+
     OVR::Net::BitStream bsOut;
     bsOut.Write(hmd);
     bsOut.Write(key);
@@ -350,6 +411,9 @@ bool NetClient::SetBoolValue(VirtualHmdId hmd, const char* key, bool val)
         return false;
     }
 
+    // Our own gets see the new value before the server reports the change
+    invalidateValue(hmd, key);
+
     OVR::Net::BitStream bsOut;
     bsOut.Write(hmd);
     bsOut.Write(key);
@@ -372,6 +436,9 @@ bool NetClient::SetIntValue(VirtualHmdId hmd, const char* key, int val)
         return false;
     }
 
+    // Our own gets see the new value before the server reports the change
+    invalidateValue(hmd, key);
+
     OVR::Net::BitStream bsOut;
     bsOut.Write(hmd);
     bsOut.Write(key);
@@ -394,6 +461,9 @@ bool NetClient::SetNumberValue(VirtualHmdId hmd, const char* key, double val)
         return false;
     }
 
+    // Our own gets see the new value before the server reports the change
+    invalidateValue(hmd, key);
+
     OVR::Net::BitStream bsOut;
     bsOut.Write(hmd);
     bsOut.Write(key);
@@ -415,6 +485,9 @@ bool NetClient::SetNumberValues(VirtualHmdId hmd, const char* key, const double*
         return false;
     }
 
+    // Our own gets see the new value before the server reports the change
+    invalidateValue(hmd, key);
+
     OVR::Net::BitStream bsOut;
     bsOut.Write(hmd);
     bsOut.Write(key);
@@ -435,6 +508,351 @@ bool NetClient::SetNumberValues(VirtualHmdId hmd, const char* key, const double*
     return true;
 }
 
+bool NetClient::GetValues(Array<ValueRequest>& requests)
+{
+    if (!IsConnected(true, true))
+    {
+        return false;
+    }
+
+    if (requests.IsEmpty())
+    {
+        return true;
+    }
+
+    if (serverSupportsValueBatches())
+    {
+        return getValuesBatched(&requests[0], requests.GetSizeI());
+    }
+
+    // Older servers: one call per value
+    for (int i = 0; i < requests.GetSizeI(); ++i)
+    {
+        ValueRequest& request = requests[i];
+        const char* key = request.Key.ToCStr();
+
+        switch (request.Type)
+        {
+        case EGetStringValue:
+            request.StringValue = GetStringValue(request.Hmd, key, request.StringValue.ToCStr());
+            break;
+        case EGetBoolValue:
+            request.NumberValue = GetBoolValue(request.Hmd, key, request.NumberValue != 0.) ? 1. : 0.;
+            break;
+        case EGetIntValue:
+            request.NumberValue = GetIntValue(request.Hmd, key, (int)request.NumberValue);
+            break;
+        case EGetNumberValue:
+            request.NumberValue = GetNumberValue(request.Hmd, key, request.NumberValue);
+            break;
+        case EGetNumberValues:
+            if (!request.NumberValues.IsEmpty())
+            {
+                int count = GetNumberValues(request.Hmd, key, &request.NumberValues[0], request.NumberValues.GetSizeI());
+                request.NumberValues.Resize(count);
+            }
+            break;
+        default:
+            OVR_ASSERT(false); // Setter in a get
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool NetClient::SetValues(const Array<ValueRequest>& requests)
+{
+    if (!IsConnected(true, true))
+    {
+        return false;
+    }
+
+    if (requests.IsEmpty())
+    {
+        return true;
+    }
+
+    if (!serverSupportsValueBatches())
+    {
+        // Older servers: one call per value
+        bool result = true;
+
+        for (int i = 0; i < requests.GetSizeI(); ++i)
+        {
+            const ValueRequest& request = requests[i];
+            const char* key = request.Key.ToCStr();
+
+            switch (request.Type)
+            {
+            case ESetStringValue:
+                result &= SetStringValue(request.Hmd, key, request.StringValue.ToCStr());
+                break;
+            case ESetBoolValue:
+                result &= SetBoolValue(request.Hmd, key, request.NumberValue != 0.);
+                break;
+            case ESetIntValue:
+                result &= SetIntValue(request.Hmd, key, (int)request.NumberValue);
+                break;
+            case ESetNumberValue:
+                result &= SetNumberValue(request.Hmd, key, request.NumberValue);
+                break;
+            case ESetNumberValues:
+                result &= SetNumberValues(request.Hmd, key, request.NumberValues.GetDataPtr(), request.NumberValues.GetSizeI());
+                break;
+            default:
+                OVR_ASSERT(false); // Getter in a set
+                return false;
+            }
+        }
+
+        return result;
+    }
+
+    OVR::Net::BitStream bsOut;
+
+    int32_t w_count = (int32_t)requests.GetSizeI();
+    bsOut.Write(w_count);
+
+    for (int i = 0; i < w_count; ++i)
+    {
+        const ValueRequest& request = requests[i];
+        OVR_ASSERT(!request.IsGetter());
+
+        request.SerializeKey(&bsOut);
+        request.SerializeValue(&bsOut);
+
+        invalidateValue(request.Hmd, request.Key.ToCStr());
+    }
+
+    if (!GetRPC1()->Signal("SetValues_1", &bsOut, GetSession()->GetConnectionAtIndex(0)))
+    {
+        return false;
+    }
+
+    return true;
+}
+
+// Key of a getter's cached value. The key is filtered as it is by the server, which
+// reports changes by the filtered key.
+static String GetValueCacheKey(NetSessionCommon::EGetterSetters type, VirtualHmdId hmd, const char* key)
+{
+    char prefix[32];
+    OVR_sprintf(prefix, sizeof(prefix), "%d:%d:", (int)type, (int)hmd);
+
+    String cacheKey(prefix);
+    cacheKey += NetSessionCommon::FilterKeyPrefix(key);
+    return cacheKey;
+}
+
+bool NetClient::CachedValue::Apply(ValueRequest& request) const
+{
+    if (!Found)
+    {
+        // The default stays, and arrays return no values
+        if (request.Type == EGetNumberValues)
+        {
+            request.NumberValues.Clear();
+        }
+        return true;
+    }
+
+    switch (request.Type)
+    {
+    case EGetStringValue:
+        request.StringValue = Value.StringValue;
+        break;
+
+    case EGetNumberValues:
+        {
+            const int wanted = request.NumberValues.GetSizeI();
+            const int have   = Value.NumberValues.GetSizeI();
+
+            // Fewer were asked for when it was fetched, and all of those were returned
+            if (wanted > Capacity && have >= Capacity)
+            {
+                return false;
+            }
+
+            const int count = Alg::Min(wanted, have);
+            request.NumberValues.Resize(count);
+            for (int i = 0; i < count; ++i)
+            {
+                request.NumberValues[i] = Value.NumberValues[i];
+            }
+        }
+        break;
+
+    default:
+        request.NumberValue = Value.NumberValue;
+        break;
+    }
+
+    return true;
+}
+
+bool NetClient::serverSupportsValueBatches()
+{
+    Ptr<Connection> conn = GetSession()->GetConnectionAtIndex(0);
+    if (!conn)
+    {
+        return false;
+    }
+
+    {
+        Lock::Locker locker(&ValueCacheLock);
+
+        if (ValueBatchSupport != ValueBatches_Unknown)
+        {
+            return ValueBatchSupport == ValueBatches_Supported;
+        }
+    }
+
+    // Ask for no values; servers without GetValues_1 say it isn't registered. GetValues_1,
+    // SetValues_1 and ProfileValuesChanged_1 were added together, so this covers all three,
+    // and values may only be cached because the server reports their changes.
+    OVR::Net::BitStream bsOut;
+    int32_t w_count = 0;
+    bsOut.Write(w_count);
+
+    Ptr<Net::Plugins::RPCCall> call = GetRPC1()->CallAsync("GetValues_1", &bsOut, conn);
+    if (!call)
+    {
+        return false;
+    }
+    call->Wait();
+
+    ValueBatchSupportType support;
+    if (call->Succeeded())
+    {
+        support = ValueBatches_Supported;
+    }
+    else if (call->GetState() == Net::Plugins::RPCCall::State_NotRegistered)
+    {
+        support = ValueBatches_Unsupported;
+    }
+    else
+    {
+        // Disconnected, so there is nothing to remember
+        return false;
+    }
+
+    // Don't apply the answer to a server reconnected to in the meantime
+    if (GetSession()->GetConnectionAtIndex(0) == conn)
+    {
+        Lock::Locker locker(&ValueCacheLock);
+        ValueBatchSupport = support;
+    }
+    return support == ValueBatches_Supported;
+}
+
+bool NetClient::getValuesBatched(ValueRequest* requests, int count)
+{
+    Array<int> misses;
+    uint32_t   generation = 0;
+
+    {
+        Lock::Locker locker(&ValueCacheLock);
+
+        generation = ValueCacheGeneration;
+
+        for (int i = 0; i < count; ++i)
+        {
+            ValueRequest& request = requests[i];
+            OVR_ASSERT(request.IsGetter());
+
+            const CachedValue* cached = ValueCache.Get(GetValueCacheKey(request.Type, request.Hmd, request.Key.ToCStr()));
+            if (!cached || !cached->Apply(request))
+            {
+                misses.PushBack(i);
+            }
+        }
+    }
+
+    if (misses.IsEmpty())
+    {
+        return true;
+    }
+
+    OVR::Net::BitStream bsOut, returnData;
+
+    int32_t w_count = (int32_t)misses.GetSizeI();
+    bsOut.Write(w_count);
+
+    for (int i = 0; i < w_count; ++i)
+    {
+        requests[misses[i]].SerializeKey(&bsOut);
+    }
+
+    if (!GetRPC1()->CallBlocking("GetValues_1", &bsOut, GetSession()->GetConnectionAtIndex(0), &returnData))
+    {
+        return false;
+    }
+
+    int32_t out = 0;
+    if (!returnData.Read(out) || out != w_count)
+    {
+        OVR_ASSERT(false);
+        return false;
+    }
+
+    Lock::Locker locker(&ValueCacheLock);
+
+    // Values that changed while the call was in flight may be stale, so they are
+    // returned but not cached
+    const bool cacheable = (generation == ValueCacheGeneration);
+
+    for (int i = 0; i < w_count; ++i)
+    {
+        ValueRequest& request = requests[misses[i]];
+
+        CachedValue cached;
+        cached.Capacity = request.NumberValues.GetSizeI();
+        cached.Value    = request;
+
+        uint8_t found = 0;
+        if (!returnData.Read(found) ||
+            (found != 0 && !cached.Value.DeserializeValue(&returnData)))
+        {
+            OVR_ASSERT(false);
+            return false;
+        }
+        cached.Found = (found != 0);
+
+        cached.Apply(request);
+
+        if (cacheable)
+        {
+            ValueCache.Set(GetValueCacheKey(request.Type, request.Hmd, request.Key.ToCStr()), cached);
+        }
+    }
+
+    return true;
+}
+
+void NetClient::invalidateValue(VirtualHmdId hmd, const char* key)
+{
+    Lock::Locker locker(&ValueCacheLock);
+
+    ++ValueCacheGeneration;
+
+    for (int type = EGetStringValue; type <= EGetNumberValues; ++type)
+    {
+        ValueCache.Remove(GetValueCacheKey((EGetterSetters)type, hmd, key));
+    }
+}
+
+void NetClient::invalidateAllValues()
+{
+    Lock::Locker locker(&ValueCacheLock);
+
+    ++ValueCacheGeneration;
+    ValueCache.Clear();
+
+    // Called on connect and disconnect, and the next server may be a different version
+    ValueBatchSupport = ValueBatches_Unknown;
+}
+
 int NetClient::Hmd_Detect()
 {
     if (!IsConnected(true, false))
@@ -824,6 +1242,7 @@ void NetClient::registerRPC()
     RPC_REGISTER_SLOT(LatencyTesterAvailableScope, LatencyTesterAvailable_1);
     RPC_REGISTER_SLOT(DefaultLogOutputScope, DefaultLogOutput_1);
     RPC_REGISTER_SLOT(HMDCountUpdateScope, HMDCountUpdate_1);
+    RPC_REGISTER_SLOT(ProfileValuesChangedScope, ProfileValuesChanged_1);
 }
 
 void NetClient::InitialServerState_1(BitStream* userData, ReceivePayload* pPayload)
@@ -878,5 +1297,33 @@ void NetClient::HMDCountUpdate_1(BitStream* userData, ReceivePayload* pPayload)
     EdgeTriggeredHMDCount = true;
 }
 
+void NetClient::ProfileValuesChanged_1(BitStream* userData, ReceivePayload* pPayload)
+{
+    OVR_UNUSED(pPayload);
+
+    // A negative count means everything may have changed, e.g. on a profile switch
+    int32_t count = 0;
+    if (!userData->Read(count) || count < 0)
+    {
+        invalidateAllValues();
+        return;
+    }
+
+    for (int32_t i = 0; i < count; ++i)
+    {
+        VirtualHmdId hmd = InvalidVirtualHmdId;
+        String       key;
+        userData->Read(hmd);
+        if (!userData->Read(key))
+        {
+            OVR_ASSERT(false);
+            invalidateAllValues();
+            return;
+        }
+
+        invalidateValue(hmd, key.ToCStr());
+    }
+}
+
 
 }} // namespace OVR::Service
@@ -32,6 +32,7 @@ limitations under the License.
 #include "../Kernel/OVR_System.h"
 #include "../OVR_CAPI.h"
 #include "../Util/Util_Render_Stereo.h"
+#include "../Kernel/OVR_Hash.h"
 
 namespace OVR { namespace Service {
 
@@ -84,6 +85,13 @@ public:
     bool         SetNumberValue(VirtualHmdId hmd, const char* key, double val);
     bool         SetNumberValues(VirtualHmdId hmd, const char* key, const double* vals, int num_vals);
 
+    // Batched versions of the above: each request is handled as by the call for its Type,
+    // but the batch is sent in one message. Values fetched from servers that push changes
+    // are cached, so repeated gets don't go to the server at all.
+    // GetValues returns false if the values couldn't be fetched, leaving the defaults.
+    bool         GetValues(Array<ValueRequest>& requests);
+    bool         SetValues(const Array<ValueRequest>& requests);
+
     bool         GetDriverMode(bool& driverInstalled, bool& compatMode, bool& hideDK1Mode);
     bool         SetDriverMode(bool compatMode, bool hideDK1Mode);
 
@@ -125,6 +133,38 @@ protected:
     String       LatencyUtil_GetResultsString_Str;
     String       ProfileGetValue1_Str, ProfileGetValue3_Str;
 
+protected:
+    // Values fetched with GetValues_1, keyed by getter type, HMD and key. Only used with
+    // servers that send ProfileValuesChanged_1, since nothing else invalidates it.
+    struct CachedValue
+    {
+        bool         Found;     // Else the requester's default is returned
+        int          Capacity;  // Most values asked for, for EGetNumberValues
+        ValueRequest Value;
+
+        // Copies the cached result into request, or returns false if it can't answer it
+        bool Apply(ValueRequest& request) const;
+    };
+
+    Lock         ValueCacheLock;
+    Hash<String, CachedValue, String::HashFunctor> ValueCache;
+    uint32_t     ValueCacheGeneration; // Incremented by each invalidation
+
+    // Whether the server has GetValues_1, found out on first use after each connect
+    enum ValueBatchSupportType
+    {
+        ValueBatches_Unknown,
+        ValueBatches_Supported,
+        ValueBatches_Unsupported
+    };
+    ValueBatchSupportType ValueBatchSupport; // Guarded by ValueCacheLock
+
+    bool         serverSupportsValueBatches();
+    // Answers requests from the cache, fetching the rest with one GetValues_1 call
+    bool         getValuesBatched(ValueRequest* requests, int count);
+    void         invalidateValue(VirtualHmdId hmd, const char* key);
+    void         invalidateAllValues();
+
 protected:
     //// Push Notifications:
 
@@ -141,6 +181,9 @@ protected:
 
     ObserverScope<Net::Plugins::RPCSlot> HMDCountUpdateScope;
     void HMDCountUpdate_1(BitStream* userData, ReceivePayload* pPayload);
+
+    ObserverScope<Net::Plugins::RPCSlot> ProfileValuesChangedScope;
+    void ProfileValuesChanged_1(BitStream* userData, ReceivePayload* pPayload);
 };
 
 
@@ -340,4 +340,161 @@ bool NetSessionCommon::IsServiceProperty(EGetterSetters e, const char* key)
 }
 
 
+//// ValueRequest
+
+void ValueRequest::SerializeKey(Net::BitStream* bs) const
+{
+    uint8_t t = (uint8_t)Type;
+    bs->Write(t);
+    bs->Write(Hmd);
+    bs->Write(Key);
+
+    if (Type == NetSessionCommon::EGetNumberValues)
+    {
+        int32_t w = (int32_t)NumberValues.GetSizeI();
+        bs->Write(w);
+    }
+}
+
+bool ValueRequest::DeserializeKey(Net::BitStream* bs)
+{
+    uint8_t t = 0;
+    bs->Read(t);
+    bs->Read(Hmd);
+    if (!bs->Read(Key) || t >= NetSessionCommon::ENumTypes)
+    {
+        return false;
+    }
+    Type = (NetSessionCommon::EGetterSetters)t;
+
+    if (Type == NetSessionCommon::EGetNumberValues)
+    {
+        int32_t w = 0;
+        if (!bs->Read(w) || w < 0)
+        {
+            return false;
+        }
+        NumberValues.Resize(w);
+    }
+
+    return true;
+}
+
+void ValueRequest::SerializeValue(Net::BitStream* bs) const
+{
+    switch (Type)
+    {
+    case NetSessionCommon::EGetStringValue:
+    case NetSessionCommon::ESetStringValue:
+        bs->Write(StringValue);
+        break;
+
+    case NetSessionCommon::EGetBoolValue:
+    case NetSessionCommon::ESetBoolValue:
+        {
+            uint8_t b = NumberValue != 0. ? 1 : 0;
+            bs->Write(b);
+        }
+        break;
+
+    case NetSessionCommon::EGetIntValue:
+    case NetSessionCommon::ESetIntValue:
+        {
+            int32_t w = (int32_t)NumberValue;
+            bs->Write(w);
+        }
+        break;
+
+    case NetSessionCommon::EGetNumberValue:
+    case NetSessionCommon::ESetNumberValue:
+        bs->Write(NumberValue);
+        break;
+
+    case NetSessionCommon::EGetNumberValues:
+    case NetSessionCommon::ESetNumberValues:
+        {
+            int32_t w_count = (int32_t)NumberValues.GetSizeI();
+            bs->Write(w_count);
+
+            for (int i = 0; i < w_count; ++i)
+            {
+                bs->Write(NumberValues[i]);
+            }
+        }
+        break;
+
+    default:
+        OVR_ASSERT(false);
+        break;
+    }
+}
+
+bool ValueRequest::DeserializeValue(Net::BitStream* bs)
+{
+    switch (Type)
+    {
+    case NetSessionCommon::EGetStringValue:
+    case NetSessionCommon::ESetStringValue:
+        return bs->Read(StringValue);
+
+    case NetSessionCommon::EGetBoolValue:
+    case NetSessionCommon::ESetBoolValue:
+        {
+            uint8_t b = 0;
+            if (!bs->Read(b))
+            {
+                return false;
+            }
+            NumberValue = b != 0 ? 1. : 0.;
+        }
+        return true;
+
+    case NetSessionCommon::EGetIntValue:
+    case NetSessionCommon::ESetIntValue:
+        {
+            int32_t w = 0;
+            if (!bs->Read(w))
+            {
+                return false;
+            }
+            NumberValue = w;
+        }
+        return true;
+
+    case NetSessionCommon::EGetNumberValue:
+    case NetSessionCommon::ESetNumberValue:
+        return bs->Read(NumberValue);
+
+    case NetSessionCommon::EGetNumberValues:
+    case NetSessionCommon::ESetNumberValues:
+        {
+            int32_t w_count = 0;
+            if (!bs->Read(w_count) || w_count < 0)
+            {
+                return false;
+            }
+
+            // A get never returns more values than were asked for
+            if (Type == NetSessionCommon::EGetNumberValues && w_count > NumberValues.GetSizeI())
+            {
+                return false;
+            }
+
+            NumberValues.Resize(w_count);
+            for (int i = 0; i < w_count; ++i)
+            {
+                if (!bs->Read(NumberValues[i]))
+                {
+                    return false;
+                }
+            }
+        }
+        return true;
+
+    default:
+        return false;
+    }
+}
+
+
 }} // namespace OVR::Service
@@ -137,6 +137,54 @@ protected:
 };
 
 
+//-------------------------------------------------------------------------------------
+// ***** ValueRequest
+
+// One key of a batched get or set (GetValues_1, SetValues_1). Type is one of the
+// getter or setter types above and picks the value field used, the same as calling the
+// single value function of that type.  For a get the value fields hold the default and
+// receive the result; for EGetNumberValues the size of NumberValues is the most values
+// to return, and the array is resized to the number returned (none if the key isn't set).
+
+struct ValueRequest
+{
+    ValueRequest() :
+        Type(NetSessionCommon::EGetNumberValue),
+        Hmd(InvalidVirtualHmdId),
+        NumberValue(0.)
+    {
+    }
+    ValueRequest(NetSessionCommon::EGetterSetters type, VirtualHmdId hmd, const char* key) :
+        Type(type),
+        Hmd(hmd),
+        Key(key),
+        NumberValue(0.)
+    {
+    }
+
+    NetSessionCommon::EGetterSetters Type;
+    VirtualHmdId   Hmd;
+    String         Key;
+
+    String         StringValue;  // String values
+    double         NumberValue;  // Bool, int and number values
+    Array<double>  NumberValues; // Number arrays
+
+    bool IsGetter() const
+    {
+        return Type >= NetSessionCommon::EGetStringValue && Type <= NetSessionCommon::EGetNumberValues;
+    }
+
+    // Type, HMD and key; for EGetNumberValues also the most values to return
+    void SerializeKey(Net::BitStream* bs) const;
+    bool DeserializeKey(Net::BitStream* bs);
+
+    // The value, written the same way as in the single value calls
+    void SerializeValue(Net::BitStream* bs) const;
+    bool DeserializeValue(Net::BitStream* bs);
+};
+
+
 }} // namespace OVR::Service
 
 #endif // OVR_Service_NetSessionCommon_h
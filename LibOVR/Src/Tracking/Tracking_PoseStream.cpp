@@ -0,0 +1,309 @@
+/************************************************************************************
+
+Filename    :   Tracking_PoseStream.cpp
+Content     :   Recording and replay of the shared sensor state stream
+Created     :   October 17, 2014
+
+Copyright   :   Copyright 2014 Oculus VR, LLC All Rights reserved.
+
+Licensed under the Oculus VR Rift SDK License Version 3.2 (the "License");
+you may not use the Oculus VR Rift SDK except in compliance with the License,
+which is provided at the time of installation or download, or which
+otherwise accompanies this software in either electronic or hard copy form.
+
+You may obtain a copy of the License at
+
+http://www.oculusvr.com/licenses/LICENSE-3.2
+
+Unless required by applicable law or agreed to in writing, the Oculus VR SDK
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*************************************************************************************/
+
+#include "Tracking_PoseStream.h"
+
+#include "../Kernel/OVR_Alg.h"
+#include "../Kernel/OVR_Log.h"
+
+namespace OVR { namespace Tracking {
+
+
+//-------------------------------------------------------------------------------------
+// ***** PoseStreamRecorder
+
+PoseStreamRecorder::PoseStreamRecorder() :
+    Active(false),
+    WriteFailed(false),
+    RecordCount(0),
+    LostCount(0),
+    Polled(false),
+    NextHistoryIndex(0)
+{
+}
+
+PoseStreamRecorder::~PoseStreamRecorder()
+{
+    Stop();
+}
+
+bool PoseStreamRecorder::Start(const char* path)
+{
+    Stop();
+
+    if (!File.Open(path, File::Open_Write | File::Open_Create | File::Open_Truncate | File::Open_Buffered,
+                   File::Mode_Write))
+    {
+        LogError("{ERR-111} [PoseStream] Unable to create %s", path);
+        return false;
+    }
+
+    PoseStreamFileHeader header;
+    header.Magic      = PoseStreamMagic;
+    header.Version    = PoseStreamVersion;
+    header.RecordSize = sizeof(PoseStreamRecord);
+    header.Reserved   = 0;
+
+    WriteFailed = (File.Write((const uint8_t*)&header, sizeof(header)) != (int)sizeof(header));
+    Active      = true;
+    RecordCount = 0;
+    LostCount   = 0;
+    Polled      = false;
+    return true;
+}
+
+bool PoseStreamRecorder::Stop()
+{
+    if (!Active)
+        return false;
+
+    Active = false;
+    bool closed = File.Close();
+    return closed && !WriteFailed;
+}
+
+void PoseStreamRecorder::Record(const LocklessSensorState& state, double timeInSeconds, uint32_t lost)
+{
+    if (!Active)
+        return;
+
+    PoseStreamRecord record;
+    record.Time  = timeInSeconds;
+    record.Lost  = lost;
+    record.State = state;
+
+    if (File.Write((const uint8_t*)&record, sizeof(record)) != (int)sizeof(record))
+        WriteFailed = true;
+
+    RecordCount++;
+    LostCount += lost;
+}
+
+int PoseStreamRecorder::Poll(const CombinedSharedStateUpdater* updater, const SensorStateHistoryUpdater* history)
+{
+    if (!Active)
+        return 0;
+
+    int recorded = 0;
+
+    if (history)
+    {
+        const uint32_t count = history->GetUpdateCount();
+        if (!Polled)
+        {
+            if (count == 0)
+                return 0;
+            NextHistoryIndex = count - 1;
+            Polled           = true;
+        }
+
+        // The oldest slot may be overwritten at any time, so only Capacity - 1 are kept
+        const uint32_t retained = SensorStateHistorySize - 1;
+        uint32_t       lost     = 0;
+        if (count - NextHistoryIndex > retained)
+        {
+            lost             = count - retained - NextHistoryIndex;
+            NextHistoryIndex = count - retained;
+        }
+
+        for (; NextHistoryIndex != count; NextHistoryIndex++)
+        {
+            LocklessSensorState state;
+            double              time;
+            if (!history->GetState(NextHistoryIndex, state, &time))
+            {
+                // Overwritten while we were catching up
+                lost++;
+                continue;
+            }
+
+            Record(state, time, lost);
+            lost = 0;
+            recorded++;
+        }
+
+        LostCount += lost;
+    }
+    else if (updater)
+    {
+        const LocklessSensorState state = updater->SharedSensorState.GetState();
+        if (!Polled || memcmp(&state, &LastState, sizeof(state)) != 0)
+        {
+            Record(state, state.WorldFromImu.TimeInSeconds);
+            LastState = state;
+            Polled    = true;
+            recorded++;
+        }
+    }
+
+    return recorded;
+}
+
+
+//-------------------------------------------------------------------------------------
+// ***** PoseStreamPublisher
+
+bool PoseStreamPublisher::Open(const char* sharedMemoryName)
+{
+    if (!StateWriter.Open(sharedMemoryName))
+        return false;
+    pState = StateWriter.Get();
+
+    String historyName = String(sharedMemoryName) + SensorStateHistoryNameSuffix;
+    pHistory = HistoryWriter.Open(historyName.ToCStr()) ? HistoryWriter.Get() : NULL;
+    return pState != NULL;
+}
+
+void PoseStreamPublisher::Publish(const LocklessSensorState& state, double timeInSeconds)
+{
+    OVR_ASSERT(pState);
+
+    // The history first, so a reader that sees the new latest state can also find it there
+    if (pHistory)
+        pHistory->Push(state, timeInSeconds);
+    pState->SharedSensorState.SetState(state);
+}
+
+
+//-------------------------------------------------------------------------------------
+// ***** PoseStreamPlayer
+
+PoseStreamPlayer::PoseStreamPlayer() :
+    StartTime(0.0),
+    Speed(1.0),
+    Period(0.0),
+    Loop(false),
+    NextRecord(0),
+    Pass(0)
+{
+}
+
+bool PoseStreamPlayer::Load(const char* path)
+{
+    Records.Clear();
+
+    SysFile file;
+    if (!file.Open(path, File::Open_Read, File::Mode_Read))
+        return false;
+
+    PoseStreamFileHeader header;
+    if (file.Read((uint8_t*)&header, sizeof(header)) != (int)sizeof(header) ||
+        header.Magic != PoseStreamMagic ||
+        header.Version != PoseStreamVersion ||
+        header.RecordSize != sizeof(PoseStreamRecord))
+    {
+        return false;
+    }
+
+    // A stream cut short by a crash may end in a partial record; it is ignored.
+    int length = file.GetLength() - (int)sizeof(header);
+    int count  = Alg::Max(length, 0) / (int)sizeof(PoseStreamRecord);
+
+    Records.Resize(count);
+    if (count > 0)
+    {
+        int bytes = count * (int)sizeof(PoseStreamRecord);
+        if (file.Read((uint8_t*)&Records[0], bytes) != bytes)
+        {
+            Records.Clear();
+            return false;
+        }
+    }
+
+    NextRecord = Records.GetSize();
+    return true;
+}
+
+void PoseStreamPlayer::Start(double now, double speed, bool loop)
+{
+    StartTime  = now;
+    Speed      = speed;
+    NextRecord = 0;
+    Pass       = 0;
+    Period     = 0.0;
+
+    // One pass lasts the recording plus its average interval
+    size_t count = Records.GetSize();
+    if (count >= 2)
+    {
+        double span = Records[count - 1].Time - Records[0].Time;
+        Period = span + span / (double)(count - 1);
+    }
+
+    // A pass must take some time, or a looped stream would never let Update return
+    Loop = loop && (Period > 0.0 || speed <= 0.0);
+}
+
+double PoseStreamPlayer::GetNextTime() const
+{
+    if (IsFinished() || Speed <= 0.0)
+        return StartTime;
+
+    double recorded = Records[NextRecord].Time - Records[0].Time + Pass * Period;
+    return StartTime + recorded / Speed;
+}
+
+int PoseStreamPlayer::Update(PoseStreamPublisher& publisher, double now)
+{
+    int published = 0;
+
+    while (!IsFinished())
+    {
+        double replayTime = GetNextTime();
+        if (Speed <= 0.0)
+        {
+            if (published > 0)
+                break;
+            replayTime = now;
+        }
+        else if (replayTime > now)
+        {
+            break;
+        }
+
+        // Move the timestamps onto the replay clock
+        const PoseStreamRecord& record = Records[NextRecord];
+        const double            offset = replayTime - record.Time;
+
+        LocklessSensorState state = record.State;
+        state.WorldFromImu.TimeInSeconds += offset;
+        if (state.RawSensorData.AbsoluteTimeSeconds != 0.0)
+            state.RawSensorData.AbsoluteTimeSeconds += offset;
+
+        publisher.Publish(state, replayTime);
+        published++;
+
+        if (++NextRecord == Records.GetSize() && Loop)
+        {
+            NextRecord = 0;
+            Pass++;
+        }
+    }
+
+    return published;
+}
+
+
+}} // namespace OVR::Tracking
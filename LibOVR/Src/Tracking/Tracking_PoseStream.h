@@ -0,0 +1,180 @@
+/************************************************************************************
+
+Filename    :   Tracking_PoseStream.h
+Content     :   Recording and replay of the shared sensor state stream
+Created     :   October 17, 2014
+
+Copyright   :   Copyright 2014 Oculus VR, LLC All Rights reserved.
+
+Licensed under the Oculus VR Rift SDK License Version 3.2 (the "License");
+you may not use the Oculus VR Rift SDK except in compliance with the License,
+which is provided at the time of installation or download, or which
+otherwise accompanies this software in either electronic or hard copy form.
+
+You may obtain a copy of the License at
+
+http://www.oculusvr.com/licenses/LICENSE-3.2
+
+Unless required by applicable law or agreed to in writing, the Oculus VR SDK
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*************************************************************************************/
+
+#ifndef Tracking_PoseStream_h
+#define Tracking_PoseStream_h
+
+#include "Tracking_SensorState.h"
+#include "../Kernel/OVR_SysFile.h"
+#include "../Kernel/OVR_Array.h"
+
+namespace OVR { namespace Tracking {
+
+
+//-------------------------------------------------------------------------------------
+// ***** Pose stream file format
+//
+// A pose stream is a PoseStreamFileHeader followed by PoseStreamRecords until the end of
+// the file, in the native (little-endian) byte order. Records hold the LocklessSensorState
+// data without the padding of the shared memory slots.
+
+struct PoseStreamRecord
+{
+    double              Time;       // Timestamp the state was published with
+    uint32_t            Lost;       // States published before this one that weren't recorded
+    uint32_t            _PAD_0_;
+    LocklessSensorState State;
+
+    PoseStreamRecord() : Time(0.0), Lost(0), _PAD_0_(0) { }
+};
+
+static const uint32_t PoseStreamMagic   = 0x5350564F; // "OVPS"
+static const uint32_t PoseStreamVersion = 1;
+
+struct PoseStreamFileHeader
+{
+    uint32_t    Magic;              // PoseStreamMagic
+    uint32_t    Version;            // PoseStreamVersion
+    uint32_t    RecordSize;         // sizeof(PoseStreamRecord)
+    uint32_t    Reserved;
+};
+
+
+//-------------------------------------------------------------------------------------
+// ***** PoseStreamRecorder
+
+// Writes the sensor states a tracking service publishes to a pose stream file.
+// A publisher can call Record for each state it publishes; a separate process calls Poll
+// with the shared regions it has opened for reading. The recorder isn't thread-safe.
+
+class PoseStreamRecorder
+{
+public:
+    PoseStreamRecorder();
+    ~PoseStreamRecorder();
+
+    // Starts a new pose stream file at path; a stream being recorded is stopped first.
+    bool        Start(const char* path);
+    // Finishes the file. Returns false if not recording or if a write failed.
+    bool        Stop();
+
+    bool        IsActive() const        { return Active; }
+    uint32_t    GetRecordCount() const  { return RecordCount; }
+    uint32_t    GetLostCount() const    { return LostCount; }
+
+    // Appends a state published at timeInSeconds, after lost states that weren't seen.
+    void        Record(const LocklessSensorState& state, double timeInSeconds, uint32_t lost = 0);
+
+    // Records the states published since the last call. With a history every update that
+    // is still in the ring is recorded, and updates it no longer holds are counted as lost;
+    // history can be NULL, in which case the latest state is recorded if it changed.
+    // Recording starts with the latest state. Returns the number of states recorded.
+    int         Poll(const CombinedSharedStateUpdater* updater, const SensorStateHistoryUpdater* history);
+
+private:
+    SysFile             File;
+    bool                Active;
+    bool                WriteFailed;
+    uint32_t            RecordCount;
+    uint32_t            LostCount;
+
+    // Poll state
+    bool                Polled;
+    uint32_t            NextHistoryIndex;
+    LocklessSensorState LastState;
+};
+
+
+//-------------------------------------------------------------------------------------
+// ***** PoseStreamPublisher
+
+// Publishes states through the shared regions a tracking service creates, so that
+// readers such as SensorStateReader can run against a recorded stream.
+
+class PoseStreamPublisher
+{
+public:
+    PoseStreamPublisher() : pState(NULL), pHistory(NULL) { }
+
+    // Creates or opens the combined state region called sharedMemoryName and its history
+    // region. Returns false if the combined region can't be opened; the history is optional.
+    bool        Open(const char* sharedMemoryName);
+
+    bool        HasHistory() const { return pHistory != NULL; }
+
+    void        Publish(const LocklessSensorState& state, double timeInSeconds);
+
+private:
+    CombinedSharedStateWriter   StateWriter;
+    SensorStateHistoryWriter    HistoryWriter;
+    CombinedSharedStateUpdater* pState;
+    SensorStateHistoryUpdater*  pHistory;
+};
+
+
+//-------------------------------------------------------------------------------------
+// ***** PoseStreamPlayer
+
+// Replays a pose stream against a clock such as ovr_GetTimeInSeconds(). The states are
+// published in recorded order with their timestamps moved onto the replay clock, so the
+// readers see a stream that is happening now; everything else is published as recorded.
+// At speeds other than 1 only the timestamps are scaled, not the velocities.
+
+class PoseStreamPlayer
+{
+public:
+    PoseStreamPlayer();
+
+    // Reads all records of a pose stream. Returns false if the file isn't a pose stream.
+    bool        Load(const char* path);
+
+    const Array<PoseStreamRecord>& GetRecords() const { return Records; }
+
+    // Starts replay at time now. A speed of 2 replays twice as fast; a speed of 0 publishes
+    // one record per Update as fast as it is called. A looped stream repeats forever, one
+    // recorded interval after its last record.
+    void        Start(double now, double speed = 1.0, bool loop = false);
+
+    // Publishes the records that are due at time now and returns how many were published.
+    int         Update(PoseStreamPublisher& publisher, double now);
+
+    bool        IsFinished() const { return NextRecord >= Records.GetSize(); }
+    // Replay time of the next record, for waiting until it is due.
+    double      GetNextTime() const;
+
+private:
+    Array<PoseStreamRecord> Records;
+    double                  StartTime;
+    double                  Speed;
+    double                  Period;         // Recorded length of one pass, for looping
+    bool                    Loop;
+    size_t                  NextRecord;
+    uint32_t                Pass;
+};
+
+
+}} // namespace OVR::Tracking
+
+#endif // Tracking_PoseStream_h
@@ -0,0 +1,283 @@
+/************************************************************************************
+
+Filename    :   Tracking_PredictionFilter.cpp
+Content     :   Pose prediction filters used by SensorStateReader
+Created     :   October 17, 2014
+
+Copyright   :   Copyright 2014 Oculus VR, LLC All Rights reserved.
+
+Licensed under the Oculus VR Rift SDK License Version 3.2 (the "License");
+you may not use the Oculus VR Rift SDK except in compliance with the License,
+which is provided at the time of installation or download, or which
+otherwise accompanies this software in either electronic or hard copy form.
+
+You may obtain a copy of the License at
+
+http://www.oculusvr.com/licenses/LICENSE-3.2
+
+Unless required by applicable law or agreed to in writing, the Oculus VR SDK
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*************************************************************************************/
+
+#include "Tracking_PredictionFilter.h"
+
+namespace OVR { namespace Tracking {
+
+
+// The prediction interval the filters use, shortened at low speeds to reduce jitter.
+// This could be tuned so that linear and angular are combined with different coefficients.
+static double dynamicPredictionDt(double slope, const Vector3d& angularVelocity, const Vector3d& linearVelocity,
+                                  double predictionDt)
+{
+    const double linearCoef  = 1.0;
+    const double speed       = angularVelocity.Length() + linearCoef * linearVelocity.Length();
+    const double candidateDt = slope * speed; // TODO: Replace with smoothstep function
+
+    // Choose the candidate if it is shorter, to improve stability
+    return (candidateDt < predictionDt) ? candidateDt : predictionDt;
+}
+
+// Integrates constant angular and linear accelerations over dt.
+static Posed extrapolatePose(const Posed& pose, const Vector3d& angularVelocity, const Vector3d& angularAcceleration,
+                             const Vector3d& linearVelocity, const Vector3d& linearAcceleration, double dt)
+{
+    const double halfDtSq = 0.5 * dt * dt;
+    Posed        result   = pose;
+
+    const Vector3d rotation = angularVelocity * dt + angularAcceleration * halfDtSq;
+    const double   angle    = rotation.Length();
+    if (angle > 0.)
+    {
+        result.Rotation = result.Rotation * Quatd(rotation, angle);
+    }
+
+    result.Translation += linearVelocity * dt + linearAcceleration * halfDtSq;
+    return result;
+}
+
+
+//-------------------------------------------------------------------------------------
+// ***** PredictionFilter
+
+void PredictionFilter::PredictPoses(const PoseState<double>& sample, const Posed& centeredFromWorld,
+                                    const Posed& imuFromCpf, const double* predictionDts,
+                                    Posef* poses, int count) const
+{
+    for (int i = 0; i < count; ++i)
+    {
+        poses[i] = Posef(centeredFromWorld * Predict(sample, predictionDts[i]) * imuFromCpf);
+    }
+}
+
+
+//-------------------------------------------------------------------------------------
+// ***** ConstantVelocityFilter
+
+Posed ConstantVelocityFilter::Predict(const PoseState<double>& sample, double predictionDt) const
+{
+    Posed          pose            = sample.ThePose;
+    const Vector3d angularVelocity = sample.AngularVelocity;
+    const double   angularSpeed    = angularVelocity.Length();
+    const double   dynamicDt       = dynamicPredictionDt(Slope, angularVelocity, sample.LinearVelocity, predictionDt);
+
+    if (angularSpeed > 0.001)
+    {
+        pose.Rotation = pose.Rotation * Quatd(angularVelocity, angularSpeed * dynamicDt);
+    }
+
+    pose.Translation += sample.LinearVelocity * dynamicDt;
+
+    return pose;
+}
+
+// Intervals predicted together by PredictPoses; bounds its stack arrays.
+static const int PredictionBatchSize = 16;
+
+// Predict for a batch of intervals, followed by the transform to centeredFromWorld * pose *
+// imuFromCpf.  The rotation added by the prediction is always about the same axis n, by an
+// angle a that depends on the interval, so with c = cos(a/2), s = sin(a/2) and P = R * (n, 0):
+//
+//   R * Quat(n, a)          = c * R + s * P
+//   Quat(n, a).Rotate(v)    = v_par + cos(a) * v_perp + sin(a) * (n x v)
+//
+// Both are linear in a few sines and cosines, and so is everything after them, leaving
+// loops over the intervals that the compiler can vectorize.
+void ConstantVelocityFilter::PredictPoses(const PoseState<double>& sample, const Posed& centeredFromWorld,
+                                          const Posed& imuFromCpf, const double* predictionDts,
+                                          Posef* poses, int count) const
+{
+    const Vector3d angularVelocity = sample.AngularVelocity;
+    double         angularSpeed    = angularVelocity.Length();
+
+    // Same dynamic interval as Predict, for an interval longer than any the speed allows
+    const double candidateDt = dynamicPredictionDt(Slope, angularVelocity, sample.LinearVelocity, 1e30);
+
+    // Below the threshold Predict doesn't rotate, which is a zero angle here
+    Vector3d axis;
+    if (angularSpeed > 0.001)
+    {
+        axis = angularVelocity / angularSpeed;
+    }
+    else
+    {
+        angularSpeed = 0.;
+    }
+
+    // Terms that don't depend on the interval
+    const Quatd&    worldFromImu = sample.ThePose.Rotation;
+    const Quatd     rotationC    = centeredFromWorld.Rotation * worldFromImu * imuFromCpf.Rotation;
+    const Quatd     rotationS    = centeredFromWorld.Rotation * (worldFromImu * Quatd(axis.x, axis.y, axis.z, 0.)) *
+                                   imuFromCpf.Rotation;
+
+    const Vector3d& cpfOffset    = imuFromCpf.Translation;
+    const Vector3d  offsetPar    = axis * axis.Dot(cpfOffset);
+    const Vector3d  translation0 = centeredFromWorld.Apply(sample.ThePose.Translation + worldFromImu.Rotate(offsetPar));
+    const Vector3d  translationC = centeredFromWorld.Rotation.Rotate(worldFromImu.Rotate(cpfOffset - offsetPar));
+    const Vector3d  translationS = centeredFromWorld.Rotation.Rotate(worldFromImu.Rotate(axis.Cross(cpfOffset)));
+    const Vector3d  translationV = centeredFromWorld.Rotation.Rotate(sample.LinearVelocity);
+
+    double dynamicDt[PredictionBatchSize], c[PredictionBatchSize], s[PredictionBatchSize];
+
+    for (int start = 0; start < count; start += PredictionBatchSize)
+    {
+        const int n = (count - start < PredictionBatchSize) ? count - start : PredictionBatchSize;
+
+        for (int i = 0; i < n; ++i)
+        {
+            const double dt = predictionDts[start + i];
+            dynamicDt[i] = (candidateDt < dt) ? candidateDt : dt;
+        }
+
+        for (int i = 0; i < n; ++i)
+        {
+            const double halfAngle = 0.5 * angularSpeed * dynamicDt[i];
+            c[i] = cos(halfAngle);
+            s[i] = sin(halfAngle);
+        }
+
+        for (int i = 0; i < n; ++i)
+        {
+            const double cosAngle = c[i] * c[i] - s[i] * s[i];
+            const double sinAngle = 2. * s[i] * c[i];
+
+            Posef& pose = poses[start + i];
+            pose.Rotation = Quatf(rotationC * c[i] + rotationS * s[i]);
+            pose.Translation = Vector3f(translation0 + translationC * cosAngle + translationS * sinAngle +
+                                        translationV * dynamicDt[i]);
+        }
+    }
+}
+
+
+//-------------------------------------------------------------------------------------
+// ***** ConstantAccelerationFilter
+
+Posed ConstantAccelerationFilter::Predict(const PoseState<double>& sample, double predictionDt) const
+{
+    const double dynamicDt = dynamicPredictionDt(Slope, sample.AngularVelocity, sample.LinearVelocity, predictionDt);
+
+    return extrapolatePose(sample.ThePose, sample.AngularVelocity, sample.AngularAcceleration,
+                           sample.LinearVelocity, sample.LinearAcceleration, dynamicDt);
+}
+
+
+//-------------------------------------------------------------------------------------
+// ***** AlphaBetaFilter
+
+AlphaBetaFilter::AlphaBetaFilter(double alpha, double beta, double slope) :
+    Alpha(alpha),
+    Beta(beta),
+    Slope(slope),
+    Tracking(false),
+    LastTime(0.)
+{
+}
+
+void AlphaBetaFilter::SetGains(double alpha, double beta)
+{
+    Lock::Locker lockScope(&EstimateLock);
+    Alpha = alpha;
+    Beta  = beta;
+}
+
+void AlphaBetaFilter::SetSlope(double slope)
+{
+    Lock::Locker lockScope(&EstimateLock);
+    Slope = slope;
+}
+
+void AlphaBetaFilter::Reset()
+{
+    Lock::Locker lockScope(&EstimateLock);
+    Tracking = false;
+}
+
+void AlphaBetaFilter::Observe(const PoseState<double>& sample)
+{
+    Lock::Locker lockScope(&EstimateLock);
+
+    // A slightly older sample was read by another thread before the latest one was
+    // observed; it has nothing to add.
+    const double dt = sample.TimeInSeconds - LastTime;
+    if (Tracking && dt <= 0. && dt >= -0.1)
+    {
+        return;
+    }
+
+    // Restart after a gap, since the rate estimates no longer describe the motion
+    if (!Tracking || dt <= 0. || dt > 0.1)
+    {
+        AngularVelocity     = sample.AngularVelocity;
+        LinearVelocity      = sample.LinearVelocity;
+        AngularAcceleration = Vector3d();
+        LinearAcceleration  = Vector3d();
+        LastTime            = sample.TimeInSeconds;
+        Tracking            = true;
+        return;
+    }
+
+    const Vector3d angularPredicted = AngularVelocity + AngularAcceleration * dt;
+    const Vector3d angularResidual  = sample.AngularVelocity - angularPredicted;
+    AngularVelocity      = angularPredicted + angularResidual * Alpha;
+    AngularAcceleration += angularResidual * (Beta / dt);
+
+    const Vector3d linearPredicted = LinearVelocity + LinearAcceleration * dt;
+    const Vector3d linearResidual  = sample.LinearVelocity - linearPredicted;
+    LinearVelocity      = linearPredicted + linearResidual * Alpha;
+    LinearAcceleration += linearResidual * (Beta / dt);
+
+    LastTime = sample.TimeInSeconds;
+}
+
+Posed AlphaBetaFilter::Predict(const PoseState<double>& sample, double predictionDt) const
+{
+    // Without estimates for this sample, fall back to its own velocities
+    double   slope;
+    Vector3d angularVelocity     = sample.AngularVelocity;
+    Vector3d angularAcceleration;
+    Vector3d linearVelocity      = sample.LinearVelocity;
+    Vector3d linearAcceleration;
+    {
+        Lock::Locker lockScope(&EstimateLock);
+
+        slope = Slope;
+        if (Tracking && sample.TimeInSeconds == LastTime)
+        {
+            angularVelocity     = AngularVelocity;
+            angularAcceleration = AngularAcceleration;
+            linearVelocity      = LinearVelocity;
+            linearAcceleration  = LinearAcceleration;
+        }
+    }
+
+    const double dynamicDt = dynamicPredictionDt(slope, angularVelocity, linearVelocity, predictionDt);
+    return extrapolatePose(sample.ThePose, angularVelocity, angularAcceleration,
+                           linearVelocity, linearAcceleration, dynamicDt);
+}
+
+
+}} // namespace OVR::Tracking
@@ -0,0 +1,165 @@
+/************************************************************************************
+
+Filename    :   Tracking_PredictionFilter.h
+Content     :   Pose prediction filters used by SensorStateReader
+Created     :   October 17, 2014
+
+Copyright   :   Copyright 2014 Oculus VR, LLC All Rights reserved.
+
+Licensed under the Oculus VR Rift SDK License Version 3.2 (the "License");
+you may not use the Oculus VR Rift SDK except in compliance with the License,
+which is provided at the time of installation or download, or which
+otherwise accompanies this software in either electronic or hard copy form.
+
+You may obtain a copy of the License at
+
+http://www.oculusvr.com/licenses/LICENSE-3.2
+
+Unless required by applicable law or agreed to in writing, the Oculus VR SDK
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*************************************************************************************/
+
+#ifndef Tracking_PredictionFilter_h
+#define Tracking_PredictionFilter_h
+
+#include "Tracking_PoseState.h"
+#include "../Kernel/OVR_Allocator.h"
+#include "../Kernel/OVR_Atomic.h"
+
+namespace OVR { namespace Tracking {
+
+
+//-------------------------------------------------------------------------------------
+// ***** PredictionFilter
+
+// Extrapolates the pose of the latest sensor sample to a short interval after it.
+// SensorStateReader passes each sample it predicts from to Observe before calling Predict
+// or PredictPoses with it; filters that keep estimates across samples update them there.
+// A filter belongs to one reader, whose const getters are called from both the application
+// and the render thread, so filters that keep estimates must synchronize them.
+
+class PredictionFilter : public NewOverrideBase
+{
+public:
+    virtual ~PredictionFilter() { }
+
+    virtual const char* GetName() const = 0;
+
+    // Called with the sample about to be predicted from, possibly more than once per sample.
+    virtual void        Observe(const PoseState<double>& sample) { OVR_UNUSED(sample); }
+    // Forgets what Observe has seen.
+    virtual void        Reset() { }
+
+    // The pose of the sample's frame predictionDt seconds after the sample.
+    virtual Posed       Predict(const PoseState<double>& sample, double predictionDt) const = 0;
+
+    // centeredFromWorld * Predict(sample, predictionDts[i]) * imuFromCpf for count intervals.
+    virtual void        PredictPoses(const PoseState<double>& sample, const Posed& centeredFromWorld,
+                                     const Posed& imuFromCpf, const double* predictionDts,
+                                     Posef* poses, int count) const;
+};
+
+
+//-------------------------------------------------------------------------------------
+// ***** ConstantVelocityFilter
+
+// This is a "perceptually tuned predictive filter", which means that it is optimized
+// for improvements in the VR experience, rather than pure error.  In particular,
+// jitter is more perceptible at lower speeds whereas latency is more perceptible
+// after a high-speed motion.  Therefore, the prediction interval is dynamically
+// adjusted based on speed.  Significant more research is needed to further improve
+// this family of filters.
+// This is the filter SensorStateReader uses by default.
+
+class ConstantVelocityFilter : public PredictionFilter
+{
+public:
+    ConstantVelocityFilter(double slope = 0.2) : Slope(slope) { }
+
+    virtual const char* GetName() const { return "ConstantVelocity"; }
+
+    virtual Posed       Predict(const PoseState<double>& sample, double predictionDt) const;
+    virtual void        PredictPoses(const PoseState<double>& sample, const Posed& centeredFromWorld,
+                                     const Posed& imuFromCpf, const double* predictionDts,
+                                     Posef* poses, int count) const;
+
+    // The prediction interval is limited to Slope seconds per unit of speed (rad/s + m/s).
+    double              GetSlope() const        { return Slope; }
+    void                SetSlope(double slope)  { Slope = slope; }
+
+private:
+    double              Slope;
+};
+
+
+//-------------------------------------------------------------------------------------
+// ***** ConstantAccelerationFilter
+
+// Extrapolates with the accelerations reported by sensor fusion as well as the velocities,
+// over the same speed-limited interval as ConstantVelocityFilter.
+
+class ConstantAccelerationFilter : public PredictionFilter
+{
+public:
+    ConstantAccelerationFilter(double slope = 0.2) : Slope(slope) { }
+
+    virtual const char* GetName() const { return "ConstantAcceleration"; }
+
+    virtual Posed       Predict(const PoseState<double>& sample, double predictionDt) const;
+
+    double              GetSlope() const        { return Slope; }
+    void                SetSlope(double slope)  { Slope = slope; }
+
+private:
+    double              Slope;
+};
+
+
+//-------------------------------------------------------------------------------------
+// ***** AlphaBetaFilter
+
+// Runs an alpha-beta tracker over the angular and linear velocities of the samples it
+// observes, and extrapolates with its smoothed velocities and their estimated rate of
+// change over the same speed-limited interval as ConstantVelocityFilter. Alpha is the
+// fraction of each velocity residual taken into the velocity, beta the fraction taken
+// into its rate; a stable tracker needs 0 < alpha < 1 and 0 < beta < 4 - 2 * alpha.
+// The estimates are guarded by a lock, which is held only to update or copy them.
+
+class AlphaBetaFilter : public PredictionFilter
+{
+public:
+    AlphaBetaFilter(double alpha = 0.5, double beta = 0.05, double slope = 0.2);
+
+    virtual const char* GetName() const { return "AlphaBeta"; }
+
+    virtual void        Observe(const PoseState<double>& sample);
+    virtual void        Reset();
+
+    virtual Posed       Predict(const PoseState<double>& sample, double predictionDt) const;
+
+    void                SetGains(double alpha, double beta);
+    void                SetSlope(double slope);
+
+private:
+    mutable Lock        EstimateLock;
+    double              Alpha;
+    double              Beta;
+    double              Slope;
+
+    // Estimates as of LastTime
+    bool                Tracking;
+    double              LastTime;
+    Vector3d            AngularVelocity;
+    Vector3d            AngularAcceleration;
+    Vector3d            LinearVelocity;
+    Vector3d            LinearAcceleration;
+};
+
+
+}} // namespace OVR::Tracking
+
+#endif // Tracking_PredictionFilter_h
@@ -194,6 +194,12 @@ inline LocklessSensorState& LocklessSensorState::operator = (const LocklessSenso
 // A lockless updater for sensor state
 typedef LocklessUpdater<LocklessSensorState, LocklessSensorStatePadding> SensorStateUpdater;
 
+// Number of past sensor states retained for interpolation (about 0.25 s at 1 kHz)
+static const int SensorStateHistorySize = 256;
+
+// A lockless ring of recent sensor states, keyed by WorldFromImu.TimeInSeconds
+typedef LocklessHistory<LocklessSensorState, LocklessSensorStatePadding, SensorStateHistorySize> SensorStateHistoryUpdater;
+
 
 //// Combined state
 
@@ -206,6 +212,15 @@ struct CombinedSharedStateUpdater
 typedef SharedObjectWriter< CombinedSharedStateUpdater > CombinedSharedStateWriter;
 typedef SharedObjectReader< CombinedSharedStateUpdater > CombinedSharedStateReader;
 
+// The history lives in its own region so that the combined region keeps the layout
+// older clients and services expect.  Its name is the combined region name with
+// SensorStateHistoryNameSuffix appended; services that do not publish it simply
+// leave readers extrapolating from the latest state.
+static const char SensorStateHistoryNameSuffix[] = ".History";
+
+typedef SharedObjectWriter< SensorStateHistoryUpdater > SensorStateHistoryWriter;
+typedef SharedObjectReader< SensorStateHistoryUpdater > SensorStateHistoryReader;
+
 
 }} // namespace OVR::Tracking
 
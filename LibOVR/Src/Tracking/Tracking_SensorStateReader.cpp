@@ -32,48 +32,57 @@ namespace OVR { namespace Tracking {
 
 //-------------------------------------------------------------------------------------
 
-// This is a "perceptually tuned predictive filter", which means that it is optimized
-// for improvements in the VR experience, rather than pure error.  In particular,
-// jitter is more perceptible at lower speeds whereas latency is more perceptible
-// after a high-speed motion.  Therefore, the prediction interval is dynamically
-// adjusted based on speed.  Significant more research is needed to further improve
-// this family of filters.
-static Pose<double> calcPredictedPose(const PoseState<double>& poseState, double predictionDt)
+// Blends two consecutive sensor states for a time that lies between them.
+// Pose and derivatives are interpolated; the remaining fields (status, raw sensor
+// data, vision timing) are taken from the newer state.
+static void interpolateSensorState(const LocklessSensorState& older, double olderTime,
+                                   const LocklessSensorState& newer, double newerTime,
+                                   double absoluteTime, LocklessSensorState& result)
 {
-	Pose<double> pose = poseState.ThePose;
-	const double linearCoef = 1.0;
-	Vector3d angularVelocity = poseState.AngularVelocity;
-	double angularSpeed = angularVelocity.Length();
-
-	// This could be tuned so that linear and angular are combined with different coefficients
-	double speed = angularSpeed + linearCoef * poseState.LinearVelocity.Length();
-
-	const double slope = 0.2; // The rate at which the dynamic prediction interval varies
-	double candidateDt = slope * speed; // TODO: Replace with smoothstep function
+    const double span = newerTime - olderTime;
+    const double f    = (span > 0.) ? (absoluteTime - olderTime) / span : 1.;
+
+    result = newer;
+
+    const PoseState<double>& from = older.WorldFromImu;
+    PoseState<double>&       to   = result.WorldFromImu;
+
+    // Nlerp weights 'this' by f and the argument by (1 - f)
+    to.ThePose.Rotation    = to.ThePose.Rotation.Nlerp(from.ThePose.Rotation, f);
+    to.ThePose.Translation = from.ThePose.Translation.Lerp(to.ThePose.Translation, f);
+    to.AngularVelocity     = from.AngularVelocity.Lerp(to.AngularVelocity, f);
+    to.LinearVelocity      = from.LinearVelocity.Lerp(to.LinearVelocity, f);
+    to.AngularAcceleration = from.AngularAcceleration.Lerp(to.AngularAcceleration, f);
+    to.LinearAcceleration  = from.LinearAcceleration.Lerp(to.LinearAcceleration, f);
+    to.TimeInSeconds       = absoluteTime;
+}
 
-	double dynamicDt = predictionDt;
 
-	// Choose the candidate if it is shorter, to improve stability
-	if (candidateDt < predictionDt)
+// Status flags as reported to the application: if no hardware is connected, the
+// tracking flags are overridden.
+static uint32_t getReportedStatusFlags(uint32_t statusFlags)
+{
+	if (0 == (statusFlags & Status_HMDConnected))
 	{
-		dynamicDt = candidateDt;
+		statusFlags &= ~Status_TrackingMask;
 	}
-
-	if (angularSpeed > 0.001)
+	if (0 == (statusFlags & Status_PositionConnected))
 	{
-		pose.Rotation = pose.Rotation * Quatd(angularVelocity, angularSpeed * dynamicDt);
+		statusFlags &= ~(Status_PositionTracked | Status_CameraPoseTracked);
 	}
-
-	pose.Translation += poseState.LinearVelocity * dynamicDt;
-
-	return pose;
+	return statusFlags;
 }
 
+// Times predicted together by GetPosesAtTimes; bounds its stack arrays.
+static const int PredictionBatchSize = 16;
+
 
 //// SensorStateReader
 
 SensorStateReader::SensorStateReader() :
 	Updater(NULL),
+    History(NULL),
+    Filter(NULL),
     LastLatWarnTime(0.)
 {
 }
@@ -83,6 +92,21 @@ void SensorStateReader::SetUpdater(const CombinedSharedStateUpdater* updater)
 	Updater = updater;
 }
 
+void SensorStateReader::SetHistory(const SensorStateHistoryUpdater* history)
+{
+    History = history;
+}
+
+void SensorStateReader::SetPredictionFilter(PredictionFilter* filter)
+{
+    Filter = filter;
+}
+
+PredictionFilter* SensorStateReader::getPredictionFilter() const
+{
+    return Filter ? Filter : &DefaultFilter;
+}
+
 void SensorStateReader::RecenterPose()
 {
 	if (!Updater)
@@ -114,22 +138,32 @@ bool SensorStateReader::GetSensorStateAtTime(double absoluteTime, TrackingState&
         return false;
 	}
 
-	const LocklessSensorState lstate = Updater->SharedSensorState.GetState();
+    LocklessSensorState lstate;
+    bool                interpolated = false;
+
+    // Past times within the retained history are interpolated rather than predicted
+    if (History)
+    {
+        LocklessSensorState older, newer;
+        double              olderTime, newerTime;
+
+        if (History->GetBracketingStates(absoluteTime, older, olderTime, newer, newerTime))
+        {
+            interpolateSensorState(older, olderTime, newer, newerTime, absoluteTime, lstate);
+            interpolated = true;
+        }
+    }
+
+    if (!interpolated)
+    {
+        lstate = Updater->SharedSensorState.GetState();
+    }
 
     // Update time
 	ss.HeadPose.TimeInSeconds = absoluteTime;
 
 	// Update the status flags
-	ss.StatusFlags = lstate.StatusFlags;
-	// If no hardware is connected, override the tracking flags
-	if (0 == (ss.StatusFlags & Status_HMDConnected))
-	{
-		ss.StatusFlags &= ~Status_TrackingMask;
-	}
-	if (0 == (ss.StatusFlags & Status_PositionConnected))
-	{
-		ss.StatusFlags &= ~(Status_PositionTracked | Status_CameraPoseTracked);
-	}
+	ss.StatusFlags = getReportedStatusFlags(lstate.StatusFlags);
 
 	// If tracking info is invalid,
     if (0 == (ss.StatusFlags & Status_TrackingMask))
@@ -137,28 +171,39 @@ bool SensorStateReader::GetSensorStateAtTime(double absoluteTime, TrackingState&
         return false;
 	}
     
-    // Delta time from the last available data
-	double pdt = absoluteTime - lstate.WorldFromImu.TimeInSeconds;
-	static const double maxPdt = 0.1;
+	ss.HeadPose = PoseStatef(lstate.WorldFromImu);
 
-	// If delta went negative due to synchronization problems between processes or just a lag spike,
-	if (pdt < 0.)
-	{
-		pdt = 0.;
-	}
-	else if (pdt > maxPdt)
-	{
-        if (LastLatWarnTime != lstate.WorldFromImu.TimeInSeconds)
+    if (interpolated)
+    {
+        // Interpolated state is already at the requested time
+        ss.HeadPose.ThePose = Posef(CenteredFromWorld * lstate.WorldFromImu.ThePose * lstate.ImuFromCpf);
+    }
+    else
+    {
+        // Delta time from the last available data
+        double pdt = absoluteTime - lstate.WorldFromImu.TimeInSeconds;
+        static const double maxPdt = 0.1;
+
+        // If delta went negative due to synchronization problems between processes or just a lag spike,
+        if (pdt < 0.)
         {
-            LastLatWarnTime = lstate.WorldFromImu.TimeInSeconds;
-            LogText("[SensorStateReader] Prediction interval too high: %f s, clamping at %f s\n", pdt, maxPdt);
+            pdt = 0.;
+        }
+        else if (pdt > maxPdt)
+        {
+            if (LastLatWarnTime != lstate.WorldFromImu.TimeInSeconds)
+            {
+                LastLatWarnTime = lstate.WorldFromImu.TimeInSeconds;
+                LogText("[SensorStateReader] Prediction interval too high: %f s, clamping at %f s\n", pdt, maxPdt);
+            }
+            pdt = maxPdt;
         }
-		pdt = maxPdt;
-	}
 
-	ss.HeadPose = PoseStatef(lstate.WorldFromImu);
-	// Do prediction logic and ImuFromCpf transformation
-	ss.HeadPose.ThePose = Posef(CenteredFromWorld * calcPredictedPose(lstate.WorldFromImu, pdt) * lstate.ImuFromCpf);
+        // Do prediction logic and ImuFromCpf transformation
+        PredictionFilter* filter = getPredictionFilter();
+        filter->Observe(lstate.WorldFromImu);
+        ss.HeadPose.ThePose = Posef(CenteredFromWorld * filter->Predict(lstate.WorldFromImu, pdt) * lstate.ImuFromCpf);
+    }
 
     ss.CameraPose = Posef(CenteredFromWorld * lstate.WorldFromCamera);
 
@@ -185,6 +230,78 @@ bool SensorStateReader::GetPoseAtTime(double absoluteTime, Posef& transform) con
 	return true;
 }
 
+bool SensorStateReader::GetPosesAtTimes(const double* absoluteTimes, Posef* transforms, int count) const
+{
+	LocklessSensorState lstate;
+	if (Updater)
+	{
+		lstate = Updater->SharedSensorState.GetState();
+	}
+
+	// If tracking info is invalid,
+	if (!Updater || 0 == (getReportedStatusFlags(lstate.StatusFlags) & Status_TrackingMask))
+	{
+		for (int i = 0; i < count; ++i)
+		{
+			transforms[i] = Posef();
+		}
+		return false;
+	}
+
+	PredictionFilter* filter = getPredictionFilter();
+	filter->Observe(lstate.WorldFromImu);
+
+	static const double maxPdt = 0.1;
+	const double sampleTime = lstate.WorldFromImu.TimeInSeconds;
+	double pdt[PredictionBatchSize];
+	double maxRequestedPdt = 0.;
+
+	for (int start = 0; start < count; start += PredictionBatchSize)
+	{
+		const int n = (count - start < PredictionBatchSize) ? count - start : PredictionBatchSize;
+
+		// Delta time from the last available data, clamped as in GetSensorStateAtTime
+		for (int i = 0; i < n; ++i)
+		{
+			double dt = absoluteTimes[start + i] - sampleTime;
+			maxRequestedPdt = (dt > maxRequestedPdt) ? dt : maxRequestedPdt;
+			pdt[i] = (dt < 0.) ? 0. : (dt > maxPdt) ? maxPdt : dt;
+		}
+
+		filter->PredictPoses(lstate.WorldFromImu, CenteredFromWorld, lstate.ImuFromCpf, pdt, transforms + start, n);
+	}
+
+	if (maxRequestedPdt > maxPdt && LastLatWarnTime != sampleTime)
+	{
+		LastLatWarnTime = sampleTime;
+		LogText("[SensorStateReader] Prediction interval too high: %f s, clamping at %f s\n", maxRequestedPdt, maxPdt);
+	}
+
+	// Past times within the retained history are interpolated rather than predicted.  Their
+	// samples are no newer than the snapshot, so they can't come from a later update.
+	if (History)
+	{
+		for (int i = 0; i < count; ++i)
+		{
+			if (absoluteTimes[i] >= sampleTime)
+			{
+				continue;
+			}
+
+			LocklessSensorState older, newer, interpolated;
+			double              olderTime, newerTime;
+
+			if (History->GetBracketingStates(absoluteTimes[i], older, olderTime, newer, newerTime))
+			{
+				interpolateSensorState(older, olderTime, newer, newerTime, absoluteTimes[i], interpolated);
+				transforms[i] = Posef(CenteredFromWorld * interpolated.WorldFromImu.ThePose * interpolated.ImuFromCpf);
+			}
+		}
+	}
+
+	return true;
+}
+
 uint32_t SensorStateReader::GetStatus() const
 {
 	if (!Updater)
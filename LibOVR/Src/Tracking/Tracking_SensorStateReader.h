@@ -29,6 +29,7 @@ limitations under the License.
 
 #include "../Kernel/OVR_Lockless.h"
 #include "Tracking_SensorState.h"
+#include "Tracking_PredictionFilter.h"
 
 #include "../OVR_Profile.h"
 
@@ -44,6 +45,12 @@ class SensorStateReader : public NewOverrideBase
 protected:
 	const CombinedSharedStateUpdater *Updater;
 
+    // Optional ring of recent states used to interpolate poses in the past
+    const SensorStateHistoryUpdater *History;
+
+    // Filter used to extrapolate the latest sample; NULL uses DefaultFilter
+    PredictionFilter *Filter;
+    mutable ConstantVelocityFilter DefaultFilter;
 
     // Last latency warning time
     mutable double LastLatWarnTime;
@@ -51,22 +58,39 @@ protected:
     // Transform from real-world coordinates to centered coordinates
     Posed CenteredFromWorld; 
 
+    PredictionFilter* getPredictionFilter() const;
+
 public:
 	SensorStateReader();
 
 	// Initialize the updater
     void         SetUpdater(const CombinedSharedStateUpdater *updater);
 
+    // Initialize the history ring; NULL disables interpolation of past poses
+    void         SetHistory(const SensorStateHistoryUpdater *history);
+
+    // Sets the filter used for prediction, which the caller keeps alive while it is set;
+    // NULL restores the default ConstantVelocityFilter.
+    void         SetPredictionFilter(PredictionFilter *filter);
+
 	// Re-centers on the current yaw (optionally pitch) and translation
 	void		 RecenterPose();
 
 	// Get the full dynamical system state of the CPF, which includes velocities and accelerations,
 	// predicted at a specified absolute point in time.
+	// Times covered by the history ring are interpolated between the two bracketing samples;
+	// later times are extrapolated from the latest sample.
 	bool		 GetSensorStateAtTime(double absoluteTime, Tracking::TrackingState& state) const;
 
 	// Get the predicted pose (orientation, position) of the center pupil frame (CPF) at a specific point in time.
 	bool		 GetPoseAtTime(double absoluteTime, Posef& transform) const;
 
+	// Get the predicted poses of the CPF at several points in time, all from one snapshot of the
+	// sensor state, for timewarp that needs a pose per scanline or tile. Gives the same poses as
+	// calling GetPoseAtTime for each time, with the prediction for all times computed together.
+	// Returns false, with identity poses, if tracking isn't available.
+	bool		 GetPosesAtTimes(const double* absoluteTimes, Posef* transforms, int count) const;
+
 	// Get the sensor status (same as GetSensorStateAtTime(...).Status)
 	uint32_t     GetStatus() const;
 
@@ -0,0 +1,444 @@
+/************************************************************************************
+
+Filename    :   Util_DistortionMeshCache.cpp
+Content     :   Persistent on-disk cache of generated distortion meshes
+Created     :   October 17, 2014
+
+Copyright   :   Copyright 2014 Oculus VR, LLC All Rights reserved.
+
+Licensed under the Oculus VR Rift SDK License Version 3.2 (the "License");
+you may not use the Oculus VR Rift SDK except in compliance with the License,
+which is provided at the time of installation or download, or which
+otherwise accompanies this software in either electronic or hard copy form.
+
+You may obtain a copy of the License at
+
+http://www.oculusvr.com/licenses/LICENSE-3.2
+
+Unless required by applicable law or agreed to in writing, the Oculus VR SDK
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*************************************************************************************/
+
+#include "Util_DistortionMeshCache.h"
+#include "../OVR_Profile.h"
+#include "../Kernel/OVR_CRC32.h"
+#include "../Kernel/OVR_SysFile.h"
+#include "../Kernel/OVR_Log.h"
+
+#if defined(OVR_OS_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#elif defined(OVR_OS_MS) // Other Microsoft OSs
+// Nothing, thanks.
+#else
+#include <dirent.h>
+#include <unistd.h>
+#endif
+
+OVR_DEFINE_SINGLETON(OVR::Util::Render::DistortionMeshCache);
+
+namespace OVR { namespace Util { namespace Render {
+
+
+static const uint32_t DistortionMeshCacheMagic      = 0x4D445644;   // "DVDM"
+static const char     DistortionMeshCacheFilePrefix[] = "DistortionMesh_";
+static const char     DistortionMeshCacheFileSuffix[] = ".bin";
+
+OVR_COMPILER_ASSERT ( ( sizeof(DistortionMeshCacheKey) % 4 ) == 0 );
+
+// Vertex data starts on a 16-byte boundary after the header.
+static int getVertexOffset()
+{
+    return ( (int)sizeof(DistortionMeshCacheFileHeader) + 15 ) & ~15;
+}
+
+static int getImageSize ( int numVertices, int numIndices )
+{
+    return getVertexOffset() + numVertices * (int)sizeof(DistortionMeshVertexData) +
+           numIndices * (int)sizeof(uint16_t);
+}
+
+static bool deleteCacheFile ( const String& path )
+{
+    return RemoveFile ( path );
+}
+
+
+//-----------------------------------------------------------------------------------
+// ***** DistortionMeshCacheKey
+
+DistortionMeshCacheKey::DistortionMeshCacheKey(int gridSizeLog2, bool rightEye, unsigned distortionCaps,
+                                               const HmdRenderInfo& hmdRenderInfo, const DistortionRenderDesc& distortion,
+                                               const FovPort& fov)
+{
+    memset(this, 0, sizeof(*this));
+
+    GridSizeLog2                    = (uint32_t)gridSizeLog2;
+    RightEye                        = rightEye ? 1 : 0;
+    DistortionCaps                  = distortionCaps;
+    HmdType                         = (uint32_t)hmdRenderInfo.HmdType;
+    ShutterType                     = (uint32_t)hmdRenderInfo.Shutter.Type;
+    Fov[0]                          = fov.UpTan;
+    Fov[1]                          = fov.DownTan;
+    Fov[2]                          = fov.LeftTan;
+    Fov[3]                          = fov.RightTan;
+
+    const LensConfig& lens = distortion.Lens;
+    LensEqn                         = (uint32_t)lens.Eqn;
+    memcpy(LensK, lens.K, sizeof(LensK));
+    LensMaxR                        = lens.MaxR;
+    LensMetersPerTanAngleAtCenter   = lens.MetersPerTanAngleAtCenter;
+    memcpy(LensChromaticAberration, lens.ChromaticAberration, sizeof(LensChromaticAberration));
+    memcpy(LensInvK, lens.InvK, sizeof(LensInvK));
+    LensMaxInvR                     = lens.MaxInvR;
+
+    LensCenter[0]                   = distortion.LensCenter.x;
+    LensCenter[1]                   = distortion.LensCenter.y;
+    TanEyeAngleScale[0]             = distortion.TanEyeAngleScale.x;
+    TanEyeAngleScale[1]             = distortion.TanEyeAngleScale.y;
+    PixelsPerTanAngleAtCenter[0]    = distortion.PixelsPerTanAngleAtCenter.x;
+    PixelsPerTanAngleAtCenter[1]    = distortion.PixelsPerTanAngleAtCenter.y;
+}
+
+uint32_t DistortionMeshCacheKey::GetHash() const
+{
+    return CRC32_Calculate(this, (int)sizeof(*this));
+}
+
+
+//-----------------------------------------------------------------------------------
+// ***** DistortionMeshCache::Entry
+
+DistortionMeshCache::Entry::Entry(uint8_t* image, int imageSize) :
+    pMapping(NULL),
+    LastUsed(0)
+{
+    setImage(image, imageSize);
+}
+
+DistortionMeshCache::Entry::Entry(MappedFile* mapping) :
+    pMapping(mapping),
+    LastUsed(0)
+{
+    setImage(mapping->GetData(), (int)mapping->GetSize());
+}
+
+DistortionMeshCache::Entry::~Entry()
+{
+    if (pMapping)
+    {
+        delete pMapping;
+    }
+    else
+    {
+        OVR_FREE((void*)pImage);
+    }
+}
+
+void DistortionMeshCache::Entry::setImage(const uint8_t* image, int imageSize)
+{
+    pImage    = image;
+    ImageSize = imageSize;
+    pHeader   = (const DistortionMeshCacheFileHeader*)pImage;
+    pVertices = (const DistortionMeshVertexData*)(pImage + getVertexOffset());
+    pIndices  = (const uint16_t*)(pVertices + pHeader->NumVertices);
+}
+
+
+//-----------------------------------------------------------------------------------
+// ***** DistortionMeshCache
+
+DistortionMeshCache::DistortionMeshCache() :
+    UseCounter(0),
+    MaxLoaded(DefaultMaxLoaded),
+    Enabled(true)
+{
+    PushDestroyCallbacks();
+}
+
+DistortionMeshCache::~DistortionMeshCache()
+{
+}
+
+void DistortionMeshCache::OnSystemDestroy()
+{
+    delete this;
+}
+
+void DistortionMeshCache::SetEnabled(bool enabled)
+{
+    Lock::Locker locker(&CacheLock);
+    Enabled = enabled;
+    if (!enabled)
+    {
+        Loaded.Clear();
+    }
+}
+
+void DistortionMeshCache::SetMaxLoaded(int maxLoaded)
+{
+    Lock::Locker locker(&CacheLock);
+    MaxLoaded = Alg::Max(maxLoaded, 0);
+    trimLoaded();
+}
+
+String DistortionMeshCache::getFilePath(const DistortionMeshCacheKey& key) const
+{
+    char name[64];
+    OVR_sprintf(name, sizeof(name), "/%s%08X%s",
+                DistortionMeshCacheFilePrefix, key.GetHash(), DistortionMeshCacheFileSuffix);
+    return BasePath + name;
+}
+
+DistortionMeshCache::Entry* DistortionMeshCache::findLoaded(const DistortionMeshCacheKey& key)
+{
+    Ptr<Entry>* entry = Loaded.Get(key.GetHash());
+    if (entry && ((*entry)->GetKey() == key))
+    {
+        (*entry)->LastUsed = ++UseCounter;
+        return *entry;
+    }
+    return NULL;
+}
+
+// Replaces any entry with the same key hash, then releases the least recently used
+// entries beyond MaxLoaded.
+void DistortionMeshCache::addLoaded(Entry* entry)
+{
+    entry->LastUsed = ++UseCounter;
+    Loaded.Set(entry->GetKey().GetHash(), entry);
+    trimLoaded();
+}
+
+void DistortionMeshCache::trimLoaded()
+{
+    while (Loaded.GetSizeI() > MaxLoaded)
+    {
+        // Only runs when a mesh is added, so a scan of the few loaded entries is fine.
+        EntryHash::Iterator oldest = Loaded.Begin();
+        for (EntryHash::Iterator it = Loaded.Begin(); it != Loaded.End(); ++it)
+        {
+            // Counter differences stay correct across wrap-around.
+            if ((int32_t)(it->Second->LastUsed - oldest->Second->LastUsed) < 0)
+            {
+                oldest = it;
+            }
+        }
+        Loaded.Remove(oldest->First);
+    }
+}
+
+Ptr<DistortionMeshCache::Entry> DistortionMeshCache::loadFile(const DistortionMeshCacheKey& key)
+{
+    // The entry uses the file in place; mapped pages are page aligned, so the
+    // vertex data stays 16-byte aligned.
+    String      path    = getFilePath(key);
+    MappedFile* mapping = new MappedFile;
+    if (!mapping->Open(path))
+    {
+        delete mapping;
+        return NULL;
+    }
+
+    const uint8_t* image     = mapping->GetData();
+    int            imageSize = (int)mapping->GetSize();
+    bool           valid     = false;
+
+    if (imageSize >= getVertexOffset())
+    {
+        const DistortionMeshCacheFileHeader* header = (const DistortionMeshCacheFileHeader*)image;
+
+        valid = (header->Magic == DistortionMeshCacheMagic) &&
+                (header->Version == DistortionMeshCacheVersion) &&
+                (header->VertexSize == sizeof(DistortionMeshVertexData)) &&
+                (header->Key == key) &&
+                (header->NumVertices <= 0x10000) &&
+                (header->NumIndices % 3 == 0) &&
+                (getImageSize((int)header->NumVertices, (int)header->NumIndices) == imageSize) &&
+                (CRC32_Calculate(image + getVertexOffset(), imageSize - getVertexOffset()) == header->DataCRC);
+    }
+
+    if (!valid)
+    {
+        // A key hash collision, a file from an older version or a damaged file.
+        // Either way it will be regenerated and rewritten by the caller.
+        LogText("DistortionMeshCache: discarding invalid cache file %s\n", path.ToCStr());
+        delete mapping;
+        deleteCacheFile(path);
+        return NULL;
+    }
+
+    return *new Entry(mapping);
+}
+
+Ptr<DistortionMeshCache::Entry> DistortionMeshCache::Find(const DistortionMeshCacheKey& key)
+{
+    Lock::Locker locker(&CacheLock);
+
+    if (!Enabled)
+    {
+        return NULL;
+    }
+
+    Entry* loaded = findLoaded(key);
+    if (loaded)
+    {
+        return loaded;
+    }
+
+    if (BasePath.IsEmpty())
+    {
+        BasePath = GetBaseOVRPath(true);
+    }
+
+    Ptr<Entry> entry = loadFile(key);
+    if (entry)
+    {
+        addLoaded(entry);
+    }
+    return entry;
+}
+
+Ptr<DistortionMeshCache::Entry> DistortionMeshCache::Store(const DistortionMeshCacheKey& key,
+                                                           const DistortionMeshVertexData* pVertices, int numVertices,
+                                                           const uint16_t* pIndices, int numIndices)
+{
+    OVR_ASSERT(pVertices && pIndices && (numVertices > 0) && (numIndices > 0));
+
+    Lock::Locker locker(&CacheLock);
+
+    if (!Enabled)
+    {
+        return NULL;
+    }
+
+    // Build the file image in memory; it doubles as the in-memory entry.
+    int      imageSize = getImageSize(numVertices, numIndices);
+    uint8_t* image     = (uint8_t*)OVR_ALLOC(imageSize);
+    if (!image)
+    {
+        return NULL;
+    }
+    memset(image, 0, getVertexOffset());
+
+    DistortionMeshCacheFileHeader* header = (DistortionMeshCacheFileHeader*)image;
+    header->Magic       = DistortionMeshCacheMagic;
+    header->Version     = DistortionMeshCacheVersion;
+    header->VertexSize  = sizeof(DistortionMeshVertexData);
+    header->NumVertices = (uint32_t)numVertices;
+    header->NumIndices  = (uint32_t)numIndices;
+    header->Key         = key;
+
+    memcpy(image + getVertexOffset(), pVertices, numVertices * sizeof(DistortionMeshVertexData));
+    memcpy(image + getVertexOffset() + numVertices * sizeof(DistortionMeshVertexData), pIndices,
+           numIndices * sizeof(uint16_t));
+    header->DataCRC = CRC32_Calculate(image + getVertexOffset(), imageSize - getVertexOffset());
+
+    Ptr<Entry> entry = *new Entry(image, imageSize);
+    addLoaded(entry);
+
+    if (BasePath.IsEmpty())
+    {
+        BasePath = GetBaseOVRPath(true);
+    }
+
+    // Write to a temporary file first so that other processes never see a partial file;
+    // they would reject it anyway, but would then delete it.
+    String path     = getFilePath(key);
+    String tempPath = path + ".tmp";
+    SysFile file;
+    if (file.Open(tempPath, File::Open_Write | File::Open_Create | File::Open_Truncate, File::Mode_ReadWrite))
+    {
+        bool written = (file.Write(image, imageSize) == imageSize);
+        file.Close();
+
+        // ReplaceFileWith removes the temporary file if it fails.
+        if (!written || !ReplaceFileWith(path, tempPath))
+        {
+            LogText("DistortionMeshCache: failed to write cache file %s\n", path.ToCStr());
+            if (!written)
+            {
+                deleteCacheFile(tempPath);
+            }
+        }
+    }
+
+    return entry;
+}
+
+void DistortionMeshCache::Invalidate(const DistortionMeshCacheKey& key)
+{
+    Lock::Locker locker(&CacheLock);
+
+    if (findLoaded(key))
+    {
+        Loaded.Remove(key.GetHash());
+    }
+
+    if (BasePath.IsEmpty())
+    {
+        BasePath = GetBaseOVRPath(false);
+    }
+    deleteCacheFile(getFilePath(key));
+}
+
+void DistortionMeshCache::InvalidateAll()
+{
+    Lock::Locker locker(&CacheLock);
+
+    Loaded.Clear();
+
+    if (BasePath.IsEmpty())
+    {
+        BasePath = GetBaseOVRPath(false);
+    }
+
+#if defined(OVR_OS_WIN32)
+    String pattern = BasePath + "/" + DistortionMeshCacheFilePrefix + "*" + DistortionMeshCacheFileSuffix;
+    wchar_t wpattern[MAX_PATH];
+    if (UTF8Util::GetLength(pattern.ToCStr()) >= MAX_PATH)
+    {
+        return;
+    }
+    UTF8Util::DecodeString(wpattern, pattern.ToCStr());
+
+    WIN32_FIND_DATAW findData;
+    HANDLE hFind = FindFirstFileW(wpattern, &findData);
+    if (hFind != INVALID_HANDLE_VALUE)
+    {
+        do
+        {
+            deleteCacheFile(BasePath + "/" + String(findData.cFileName));
+        } while (FindNextFileW(hFind, &findData));
+        FindClose(hFind);
+    }
+#elif defined(OVR_OS_MS)
+    // No file system access on these platforms.
+#else
+    DIR* dir = opendir(BasePath.ToCStr());
+    if (dir)
+    {
+        const size_t prefixLength = sizeof(DistortionMeshCacheFilePrefix) - 1;
+        const size_t suffixLength = sizeof(DistortionMeshCacheFileSuffix) - 1;
+
+        while (dirent* ent = readdir(dir))
+        {
+            size_t length = strlen(ent->d_name);
+            if ((length > prefixLength + suffixLength) &&
+                (strncmp(ent->d_name, DistortionMeshCacheFilePrefix, prefixLength) == 0) &&
+                (strcmp(ent->d_name + length - suffixLength, DistortionMeshCacheFileSuffix) == 0))
+            {
+                deleteCacheFile(BasePath + "/" + ent->d_name);
+            }
+        }
+        closedir(dir);
+    }
+#endif
+}
+
+
+}}} // namespace OVR::Util::Render
@@ -0,0 +1,188 @@
+/************************************************************************************
+
+Filename    :   Util_DistortionMeshCache.h
+Content     :   Persistent on-disk cache of generated distortion meshes
+Created     :   October 17, 2014
+
+Copyright   :   Copyright 2014 Oculus VR, LLC All Rights reserved.
+
+Licensed under the Oculus VR Rift SDK License Version 3.2 (the "License");
+you may not use the Oculus VR Rift SDK except in compliance with the License,
+which is provided at the time of installation or download, or which
+otherwise accompanies this software in either electronic or hard copy form.
+
+You may obtain a copy of the License at
+
+http://www.oculusvr.com/licenses/LICENSE-3.2
+
+Unless required by applicable law or agreed to in writing, the Oculus VR SDK
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*************************************************************************************/
+
+#ifndef OVR_Util_DistortionMeshCache_h
+#define OVR_Util_DistortionMeshCache_h
+
+#include "Util_Render_Stereo.h"
+#include "../Kernel/OVR_System.h"
+#include "../Kernel/OVR_String.h"
+#include "../Kernel/OVR_Hash.h"
+#include "../Kernel/OVR_MappedFile.h"
+
+namespace OVR { namespace Util { namespace Render {
+
+
+//-----------------------------------------------------------------------------------
+// ***** DistortionMeshCacheKey
+
+// Everything a distortion mesh depends on. Only 32-bit fields, so there is no padding and
+// keys can be hashed and compared as raw bytes. Of HmdRenderInfo, only the HMD type and
+// shutter type affect the mesh; the rest reaches it through the DistortionRenderDesc and FOV.
+struct DistortionMeshCacheKey
+{
+    uint32_t    GridSizeLog2;
+    uint32_t    RightEye;
+    uint32_t    DistortionCaps;
+    uint32_t    HmdType;
+    uint32_t    ShutterType;
+    float       Fov[4];                     // UpTan, DownTan, LeftTan, RightTan
+    uint32_t    LensEqn;
+    float       LensK[LensConfig::NumCoefficients];
+    float       LensMaxR;
+    float       LensMetersPerTanAngleAtCenter;
+    float       LensChromaticAberration[4];
+    float       LensInvK[LensConfig::NumCoefficients];
+    float       LensMaxInvR;
+    float       LensCenter[2];
+    float       TanEyeAngleScale[2];
+    float       PixelsPerTanAngleAtCenter[2];
+
+    DistortionMeshCacheKey() { memset(this, 0, sizeof(*this)); }
+
+    DistortionMeshCacheKey(int gridSizeLog2, bool rightEye, unsigned distortionCaps,
+                           const HmdRenderInfo& hmdRenderInfo, const DistortionRenderDesc& distortion,
+                           const FovPort& fov);
+
+    uint32_t GetHash() const;
+
+    bool operator==(const DistortionMeshCacheKey& other) const
+    {
+        return memcmp(this, &other, sizeof(*this)) == 0;
+    }
+};
+
+
+//-----------------------------------------------------------------------------------
+// ***** DistortionMeshCache
+
+// Bump this whenever mesh generation changes, so meshes cached by older code are ignored.
+static const uint32_t DistortionMeshCacheVersion = 1;
+
+// Each cached mesh is stored in its own file under GetBaseOVRPath(), named after the key hash:
+//
+//   DistortionMeshCacheFileHeader
+//   padding to a 16-byte boundary
+//   DistortionMeshVertexData[NumVertices]
+//   uint16_t[NumIndices]
+//
+// The file is the in-memory image of the mesh: it is read into a single block and served
+// in place, so a hit costs one read and a CRC check rather than a regeneration.
+struct DistortionMeshCacheFileHeader
+{
+    uint32_t                Magic;          // DistortionMeshCacheMagic
+    uint32_t                Version;        // DistortionMeshCacheVersion
+    uint32_t                VertexSize;     // sizeof(DistortionMeshVertexData)
+    uint32_t                NumVertices;
+    uint32_t                NumIndices;
+    uint32_t                DataCRC;        // CRC32 of the vertex and index data
+    DistortionMeshCacheKey  Key;            // Must match the requested key exactly
+};
+
+// Process-wide cache of distortion meshes, backed by files so that meshes survive
+// application restarts. All methods are thread-safe.
+class DistortionMeshCache : public NewOverrideBase, public SystemSingletonBase<DistortionMeshCache>
+{
+    OVR_DECLARE_SINGLETON(DistortionMeshCache);
+
+public:
+    // A cached mesh. The vertex and index data stay valid for as long as the entry is referenced,
+    // even if the cache is invalidated in the meantime.
+    class Entry : public RefCountBase<Entry>
+    {
+        friend class DistortionMeshCache;
+
+    public:
+        ~Entry();
+
+        const DistortionMeshCacheKey&   GetKey() const          { return pHeader->Key; }
+        const DistortionMeshVertexData* GetVertices() const     { return pVertices; }
+        const uint16_t*                 GetIndices() const      { return pIndices; }
+        int                             GetNumVertices() const  { return (int)pHeader->NumVertices; }
+        int                             GetNumIndices() const   { return (int)pHeader->NumIndices; }
+
+    private:
+        Entry(uint8_t* image, int imageSize);
+        Entry(MappedFile* mapping);
+
+        void                            setImage(const uint8_t* image, int imageSize);
+
+        MappedFile*                     pMapping;   // The file the image is mapped from, or NULL
+        const uint8_t*                  pImage;     // File image, OVR_ALLOC'd unless mapped
+        int                             ImageSize;
+        const DistortionMeshCacheFileHeader* pHeader;
+        const DistortionMeshVertexData* pVertices;
+        const uint16_t*                 pIndices;
+        uint32_t                        LastUsed;   // DistortionMeshCache::UseCounter at the last Find or Store
+    };
+
+    // Returns the mesh for key from memory or disk, or NULL on a miss. Files that fail
+    // validation are treated as misses and deleted.
+    Ptr<Entry>  Find(const DistortionMeshCacheKey& key);
+
+    // Adds a mesh to the cache and writes it to disk. Returns the new entry, or NULL if
+    // the cache is disabled. A failure to write the file only affects later processes.
+    Ptr<Entry>  Store(const DistortionMeshCacheKey& key,
+                      const DistortionMeshVertexData* pVertices, int numVertices,
+                      const uint16_t* pIndices, int numIndices);
+
+    // Removes a single mesh, in memory and on disk.
+    void        Invalidate(const DistortionMeshCacheKey& key);
+    // Removes all cached meshes, including files written by other processes.
+    void        InvalidateAll();
+
+    // The cache is enabled by default; applications can turn it off through the
+    // OVR_KEY_DISTORTION_MESH_CACHE HMD property. While disabled, Find and Store do nothing
+    // and the meshes held in memory are released.
+    void        SetEnabled(bool enabled);
+    bool        IsEnabled() const { return Enabled; }
+
+    // At most this many meshes are held in memory; beyond it the least recently used
+    // one is released. Files on disk are not affected.
+    enum { DefaultMaxLoaded = 16 };
+    void        SetMaxLoaded(int maxLoaded);
+    int         GetMaxLoaded() const { return MaxLoaded; }
+
+private:
+    typedef Hash<uint32_t, Ptr<Entry> > EntryHash;  // By DistortionMeshCacheKey::GetHash()
+
+    String      getFilePath(const DistortionMeshCacheKey& key) const;
+    Ptr<Entry>  loadFile(const DistortionMeshCacheKey& key);
+    Entry*      findLoaded(const DistortionMeshCacheKey& key);
+    void        addLoaded(Entry* entry);
+    void        trimLoaded();
+
+    Lock                CacheLock;
+    EntryHash           Loaded;
+    uint32_t            UseCounter;
+    int                 MaxLoaded;
+    String              BasePath;
+    volatile bool       Enabled;
+};
+
+
+}}} // namespace OVR::Util::Render
+
+#endif // OVR_Util_DistortionMeshCache_h
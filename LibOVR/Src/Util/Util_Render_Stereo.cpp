@@ -26,6 +26,8 @@ limitations under the License.
 
 #include "Util_Render_Stereo.h"
 
+OVR_DEFINE_SINGLETON(OVR::Util::Render::SharedDistortionMeshGenerator);
+
 namespace OVR { namespace Util { namespace Render {
 
 using namespace OVR::Tracking;
@@ -781,17 +783,6 @@ Matrix4f StereoConfig::GetProjectionWithZoom ( StereoEye eye, float fovZoom ) co
 // *****  Distortion Mesh Rendering
 
 
-// Pow2 for the Morton order to work!
-// 4 is too low - it is easy to see the "wobbles" in the HMD.
-// 5 is realllly close but you can see pixel differences with even/odd frame checking.
-// 6 is indistinguishable on a monitor on even/odd frames.
-static const int DMA_GridSizeLog2   = 6;
-static const int DMA_GridSize       = 1<<DMA_GridSizeLog2;
-static const int DMA_NumVertsPerEye = (DMA_GridSize+1)*(DMA_GridSize+1);
-static const int DMA_NumTrisPerEye  = (DMA_GridSize)*(DMA_GridSize)*2;
-
-
-
 DistortionMeshVertexData DistortionMeshMakeVertex ( Vector2f screenNDC,
                                                     bool rightEye,
                                                     const HmdRenderInfo &hmdRenderInfo,
@@ -885,6 +876,99 @@ DistortionMeshVertexData DistortionMeshMakeVertex ( Vector2f screenNDC,
 }
 
 
+// Builds row y of a (gridSize+1)x(gridSize+1) vertex grid.
+static void distortionMeshMakeRow ( DistortionMeshVertexData *pcurVert, int y, int gridSize,
+                                    bool rightEye,
+                                    const HmdRenderInfo &hmdRenderInfo,
+                                    const DistortionRenderDesc &distortion, const ScaleAndOffset2D &eyeToSourceNDC )
+{
+    for ( int x = 0; x <= gridSize; x++ )
+    {
+
+        Vector2f sourceCoordNDC;
+        // NDC texture coords [-1,+1]
+        sourceCoordNDC.x = 2.0f * ( (float)x / (float)gridSize ) - 1.0f;
+        sourceCoordNDC.y = 2.0f * ( (float)y / (float)gridSize ) - 1.0f;
+        Vector2f tanEyeAngle = TransformRendertargetNDCToTanFovSpace ( eyeToSourceNDC, sourceCoordNDC );
+
+        // Find a corresponding screen position.
+        // Note - this function does not have to be precise - we're just trying to match the mesh tessellation
+        // with the shape of the distortion to minimise the number of trianlges needed.
+        Vector2f screenNDC = TransformTanFovSpaceToScreenNDC ( distortion, tanEyeAngle, false );
+        // ...but don't let verts overlap to the other eye.
+        screenNDC.x = Alg::Max ( -1.0f, Alg::Min ( screenNDC.x, 1.0f ) );
+        screenNDC.y = Alg::Max ( -1.0f, Alg::Min ( screenNDC.y, 1.0f ) );
+
+        // From those screen positions, generate the vertex.
+        *pcurVert = DistortionMeshMakeVertex ( screenNDC, rightEye, hmdRenderInfo, distortion, eyeToSourceNDC );
+        pcurVert++;
+    }
+}
+
+// Builds the triangle list for a grid with (1<<gridSizeLog2) quads along each side.
+static void distortionMeshMakeIndices ( uint16_t *pcurIndex, int gridSizeLog2 )
+{
+    OVR_ASSERT ( gridSizeLog2 <= DistortionMeshMaxGridSizeLog2 );
+    int gridSize = 1 << gridSizeLog2;
+
+    for ( int triNum = 0; triNum < gridSize * gridSize; triNum++ )
+    {
+        // Use a Morton order to help locality of FB, texture and vertex cache.
+        // (0.325ms raster order -> 0.257ms Morton order)
+        // x comes from the even bits of triNum, y from the odd bits.
+        int x = 0;
+        int y = 0;
+        for ( int bit = 0; bit < gridSizeLog2; bit++ )
+        {
+            x |= ( ( triNum >> ( 2 * bit     ) ) & 1 ) << bit;
+            y |= ( ( triNum >> ( 2 * bit + 1 ) ) & 1 ) << bit;
+        }
+        int FirstVertex = x * (gridSize+1) + y;
+        // Another twist - we want the top-left and bottom-right quadrants to
+        // have the triangles split one way, the other two split the other.
+        // +---+---+---+---+
+        // |  /|  /|\  |\  |
+        // | / | / | \ | \ |
+        // |/  |/  |  \|  \|
+        // +---+---+---+---+
+        // |  /|  /|\  |\  |
+        // | / | / | \ | \ |
+        // |/  |/  |  \|  \|
+        // +---+---+---+---+
+        // |\  |\  |  /|  /|
+        // | \ | \ | / | / |
+        // |  \|  \|/  |/  |
+        // +---+---+---+---+
+        // |\  |\  |  /|  /|
+        // | \ | \ | / | / |
+        // |  \|  \|/  |/  |
+        // +---+---+---+---+
+        // This way triangle edges don't span long distances over the distortion function,
+        // so linear interpolation works better & we can use fewer tris.
+        if ( ( x < gridSize/2 ) != ( y < gridSize/2 ) )       // != is logical XOR
+        {
+            *pcurIndex++ = (uint16_t)FirstVertex;
+            *pcurIndex++ = (uint16_t)FirstVertex+1;
+            *pcurIndex++ = (uint16_t)FirstVertex+(gridSize+1)+1;
+
+            *pcurIndex++ = (uint16_t)FirstVertex+(gridSize+1)+1;
+            *pcurIndex++ = (uint16_t)FirstVertex+(gridSize+1);
+            *pcurIndex++ = (uint16_t)FirstVertex;
+        }
+        else
+        {
+            *pcurIndex++ = (uint16_t)FirstVertex;
+            *pcurIndex++ = (uint16_t)FirstVertex+1;
+            *pcurIndex++ = (uint16_t)FirstVertex+(gridSize+1);
+
+            *pcurIndex++ = (uint16_t)FirstVertex+1;
+            *pcurIndex++ = (uint16_t)FirstVertex+(gridSize+1)+1;
+            *pcurIndex++ = (uint16_t)FirstVertex+(gridSize+1);
+        }
+    }
+}
+
+
 void DistortionMeshDestroy ( DistortionMeshVertexData *pVertices, uint16_t *pTriangleMeshIndices )
 {
     OVR_FREE ( pVertices );
@@ -915,131 +999,252 @@ void DistortionMeshCreate( DistortionMeshVertexData **ppVertices, uint16_t **ppT
                            const HmdRenderInfo &hmdRenderInfo,
                            const DistortionRenderDesc &distortion, const ScaleAndOffset2D &eyeToSourceNDC )
 {
-    *pNumVertices  = DMA_NumVertsPerEye;
-    *pNumTriangles = DMA_NumTrisPerEye;
+    DistortionMeshCreate ( ppVertices, ppTriangleListIndices, pNumVertices, pNumTriangles,
+                           DistortionMeshDefaultGridSizeLog2, rightEye,
+                           hmdRenderInfo, distortion, eyeToSourceNDC );
+}
 
-    *ppVertices = (DistortionMeshVertexData*)
-                      OVR_ALLOC( sizeof(DistortionMeshVertexData) * (*pNumVertices) );
-    *ppTriangleListIndices  = (uint16_t*) OVR_ALLOC( sizeof(uint16_t) * (*pNumTriangles) * 3 );
+void DistortionMeshCreate( DistortionMeshVertexData **ppVertices, uint16_t **ppTriangleListIndices,
+                           int *pNumVertices, int *pNumTriangles,
+                           int gridSizeLog2, bool rightEye,
+                           const HmdRenderInfo &hmdRenderInfo,
+                           const DistortionRenderDesc &distortion, const ScaleAndOffset2D &eyeToSourceNDC )
+{
+    *ppVertices             = NULL;
+    *ppTriangleListIndices  = NULL;
+    *pNumVertices           = 0;
+    *pNumTriangles          = 0;
 
-    if (!*ppVertices || !*ppTriangleListIndices)
+    if ( ( gridSizeLog2 < 1 ) || ( gridSizeLog2 > DistortionMeshMaxGridSizeLog2 ) )
     {
-        if (*ppVertices)
-        {
-            OVR_FREE(*ppVertices);
-        }
-        if (*ppTriangleListIndices)
-        {
-            OVR_FREE(*ppTriangleListIndices);
-        }
-        *ppVertices             = NULL;
-        *ppTriangleListIndices  = NULL;
-        *pNumTriangles          = 0;
-        *pNumVertices           = 0;
+        OVR_ASSERT ( false );
         return;
     }
 
+    int numVertices  = DistortionMeshGetNumVertices ( gridSizeLog2 );
+    int numTriangles = DistortionMeshGetNumTriangles ( gridSizeLog2 );
 
+    DistortionMeshVertexData* pVertices = (DistortionMeshVertexData*)
+                      OVR_ALLOC( sizeof(DistortionMeshVertexData) * numVertices );
+    uint16_t*                 pIndices  = (uint16_t*) OVR_ALLOC( sizeof(uint16_t) * numTriangles * 3 );
 
-    // Populate vertex buffer info
+    if ( !pVertices || !pIndices ||
+         !SharedDistortionMeshGenerator::GetInstance()->Generate ( pVertices, numVertices,
+                                                                  pIndices, numTriangles * 3,
+                                                                  gridSizeLog2, rightEye,
+                                                                  hmdRenderInfo, distortion, eyeToSourceNDC ) )
+    {
+        DistortionMeshDestroy ( pVertices, pIndices );
+        return;
+    }
 
-    // First pass - build up raw vertex data.
-    DistortionMeshVertexData* pcurVert = *ppVertices;
+    *ppVertices             = pVertices;
+    *ppTriangleListIndices  = pIndices;
+    *pNumVertices           = numVertices;
+    *pNumTriangles          = numTriangles;
+}
+
+//-----------------------------------------------------------------------------------
+// *****  DistortionMeshGenerator
+
+#ifdef OVR_ENABLE_THREADS
+class DistortionMeshGenerator::Worker : public Thread
+{
+public:
+    Worker ( DistortionMeshGenerator *owner ) : pOwner(owner) { }
 
-    for ( int y = 0; y <= DMA_GridSize; y++ )
+    virtual int Run()
     {
-        for ( int x = 0; x <= DMA_GridSize; x++ )
-        {
+        SetThreadName ( "DistortionMeshGenerator" );
+        pOwner->workerLoop();
+        return 0;
+    }
 
-            Vector2f sourceCoordNDC;
-            // NDC texture coords [-1,+1]
-            sourceCoordNDC.x = 2.0f * ( (float)x / (float)DMA_GridSize ) - 1.0f;
-            sourceCoordNDC.y = 2.0f * ( (float)y / (float)DMA_GridSize ) - 1.0f;
-            Vector2f tanEyeAngle = TransformRendertargetNDCToTanFovSpace ( eyeToSourceNDC, sourceCoordNDC );
+private:
+    DistortionMeshGenerator *pOwner;
+};
+#endif
 
-            // Find a corresponding screen position.
-            // Note - this function does not have to be precise - we're just trying to match the mesh tessellation
-            // with the shape of the distortion to minimise the number of trianlges needed.
-            Vector2f screenNDC = TransformTanFovSpaceToScreenNDC ( distortion, tanEyeAngle, false );
-            // ...but don't let verts overlap to the other eye.
-            screenNDC.x = Alg::Max ( -1.0f, Alg::Min ( screenNDC.x, 1.0f ) );
-            screenNDC.y = Alg::Max ( -1.0f, Alg::Min ( screenNDC.y, 1.0f ) );
 
-            // From those screen positions, generate the vertex.
-            *pcurVert = DistortionMeshMakeVertex ( screenNDC, rightEye, hmdRenderInfo, distortion, eyeToSourceNDC );
-            pcurVert++;
+DistortionMeshGenerator::DistortionMeshGenerator ( int numWorkerThreads )
+  : NextRow(0)
+  , NumWorkers(0)
+#ifdef OVR_ENABLE_THREADS
+  , JobSerial(0)
+  , WorkersBusy(0)
+  , Quit(false)
+#endif
+{
+    memset ( &CurrentJob, 0, sizeof(CurrentJob) );
+
+#ifdef OVR_ENABLE_THREADS
+    if ( numWorkerThreads < 0 )
+    {
+        // The calling thread generates rows too.
+        numWorkerThreads = Alg::Max ( Thread::GetCPUCount() - 1, 0 );
+    }
+
+    for ( int i = 0; i < numWorkerThreads; i++ )
+    {
+        Ptr<Worker> worker = *new Worker ( this );
+        if ( !worker->Start() )
+        {
+            break;
         }
+        Workers.PushBack ( worker );
     }
+    NumWorkers = (int)Workers.GetSize();
+#else
+    OVR_UNUSED ( numWorkerThreads );
+#endif
+}
 
+DistortionMeshGenerator::~DistortionMeshGenerator()
+{
+#ifdef OVR_ENABLE_THREADS
+    {
+        Mutex::Locker lock ( &JobLock );
+        Quit = true;
+        JobStart.NotifyAll();
+    }
 
-    // Populate index buffer info
-    uint16_t *pcurIndex = *ppTriangleListIndices;
+    for ( size_t i = 0; i < Workers.GetSize(); i++ )
+    {
+        Workers[i]->Join();
+    }
+#endif
+}
 
-    for ( int triNum = 0; triNum < DMA_GridSize * DMA_GridSize; triNum++ )
+bool DistortionMeshGenerator::Generate ( DistortionMeshVertexData *pVertices, int vertexCapacity,
+                                         uint16_t *pTriangleListIndices, int indexCapacity,
+                                         int gridSizeLog2, bool rightEye,
+                                         const HmdRenderInfo &hmdRenderInfo,
+                                         const DistortionRenderDesc &distortion, const ScaleAndOffset2D &eyeToSourceNDC )
+{
+    if ( ( gridSizeLog2 < 1 ) || ( gridSizeLog2 > DistortionMeshMaxGridSizeLog2 ) ||
+         ( pVertices == NULL ) || ( vertexCapacity < DistortionMeshGetNumVertices ( gridSizeLog2 ) ) ||
+         ( pTriangleListIndices == NULL ) || ( indexCapacity < DistortionMeshGetNumTriangles ( gridSizeLog2 ) * 3 ) )
     {
-        // Use a Morton order to help locality of FB, texture and vertex cache.
-        // (0.325ms raster order -> 0.257ms Morton order)
-        OVR_ASSERT ( DMA_GridSize <= 256 );
-        int x = ( ( triNum & 0x0001 ) >> 0 ) |
-                ( ( triNum & 0x0004 ) >> 1 ) |
-                ( ( triNum & 0x0010 ) >> 2 ) |
-                ( ( triNum & 0x0040 ) >> 3 ) |
-                ( ( triNum & 0x0100 ) >> 4 ) |
-                ( ( triNum & 0x0400 ) >> 5 ) |
-                ( ( triNum & 0x1000 ) >> 6 ) |
-                ( ( triNum & 0x4000 ) >> 7 );
-        int y = ( ( triNum & 0x0002 ) >> 1 ) |
-                ( ( triNum & 0x0008 ) >> 2 ) |
-                ( ( triNum & 0x0020 ) >> 3 ) |
-                ( ( triNum & 0x0080 ) >> 4 ) |
-                ( ( triNum & 0x0200 ) >> 5 ) |
-                ( ( triNum & 0x0800 ) >> 6 ) |
-                ( ( triNum & 0x2000 ) >> 7 ) |
-                ( ( triNum & 0x8000 ) >> 8 );
-        int FirstVertex = x * (DMA_GridSize+1) + y;
-        // Another twist - we want the top-left and bottom-right quadrants to
-        // have the triangles split one way, the other two split the other.
-        // +---+---+---+---+
-        // |  /|  /|\  |\  |
-        // | / | / | \ | \ |
-        // |/  |/  |  \|  \|
-        // +---+---+---+---+
-        // |  /|  /|\  |\  |
-        // | / | / | \ | \ |
-        // |/  |/  |  \|  \|
-        // +---+---+---+---+
-        // |\  |\  |  /|  /|
-        // | \ | \ | / | / |
-        // |  \|  \|/  |/  |
-        // +---+---+---+---+
-        // |\  |\  |  /|  /|
-        // | \ | \ | / | / |
-        // |  \|  \|/  |/  |
-        // +---+---+---+---+
-        // This way triangle edges don't span long distances over the distortion function,
-        // so linear interpolation works better & we can use fewer tris.
-        if ( ( x < DMA_GridSize/2 ) != ( y < DMA_GridSize/2 ) )       // != is logical XOR
+        return false;
+    }
+
+    CurrentJob.pVertices       = pVertices;
+    CurrentJob.GridSize        = 1 << gridSizeLog2;
+    CurrentJob.RightEye        = rightEye;
+    CurrentJob.pHmdRenderInfo  = &hmdRenderInfo;
+    CurrentJob.pDistortion     = &distortion;
+    CurrentJob.pEyeToSourceNDC = &eyeToSourceNDC;
+    NextRow.Store_Release ( 0 );
+
+#ifdef OVR_ENABLE_THREADS
+    if ( NumWorkers > 0 )
+    {
+        // Taking the lock publishes CurrentJob to the workers.
+        Mutex::Locker lock ( &JobLock );
+        WorkersBusy = NumWorkers;
+        JobSerial++;
+        JobStart.NotifyAll();
+    }
+#endif
+
+    // The indices depend only on the grid size, so build them while the workers
+    // make a start on the vertices, then join in.
+    distortionMeshMakeIndices ( pTriangleListIndices, gridSizeLog2 );
+    processRows();
+
+#ifdef OVR_ENABLE_THREADS
+    if ( NumWorkers > 0 )
+    {
+        Mutex::Locker lock ( &JobLock );
+        while ( WorkersBusy > 0 )
         {
-            *pcurIndex++ = (uint16_t)FirstVertex;
-            *pcurIndex++ = (uint16_t)FirstVertex+1;
-            *pcurIndex++ = (uint16_t)FirstVertex+(DMA_GridSize+1)+1;
+            JobDone.Wait ( &JobLock );
+        }
+    }
+#endif
 
-            *pcurIndex++ = (uint16_t)FirstVertex+(DMA_GridSize+1)+1;
-            *pcurIndex++ = (uint16_t)FirstVertex+(DMA_GridSize+1);
-            *pcurIndex++ = (uint16_t)FirstVertex;
+    return true;
+}
+
+void DistortionMeshGenerator::processRows()
+{
+    const Job &job = CurrentJob;
+
+    for ( ;; )
+    {
+        int y = NextRow.ExchangeAdd_Sync ( 1 );
+        if ( y > job.GridSize )
+        {
+            break;
         }
-        else
+
+        distortionMeshMakeRow ( job.pVertices + y * ( job.GridSize + 1 ), y, job.GridSize,
+                                job.RightEye, *job.pHmdRenderInfo, *job.pDistortion, *job.pEyeToSourceNDC );
+    }
+}
+
+#ifdef OVR_ENABLE_THREADS
+void DistortionMeshGenerator::workerLoop()
+{
+    int lastJobSerial = 0;
+
+    for ( ;; )
+    {
         {
-            *pcurIndex++ = (uint16_t)FirstVertex;
-            *pcurIndex++ = (uint16_t)FirstVertex+1;
-            *pcurIndex++ = (uint16_t)FirstVertex+(DMA_GridSize+1);
+            Mutex::Locker lock ( &JobLock );
+            while ( ( JobSerial == lastJobSerial ) && !Quit )
+            {
+                JobStart.Wait ( &JobLock );
+            }
+            if ( Quit )
+            {
+                return;
+            }
+            lastJobSerial = JobSerial;
+        }
 
-            *pcurIndex++ = (uint16_t)FirstVertex+1;
-            *pcurIndex++ = (uint16_t)FirstVertex+(DMA_GridSize+1)+1;
-            *pcurIndex++ = (uint16_t)FirstVertex+(DMA_GridSize+1);
+        processRows();
+
+        {
+            Mutex::Locker lock ( &JobLock );
+            if ( --WorkersBusy == 0 )
+            {
+                JobDone.NotifyAll();
+            }
         }
     }
 }
+#endif
+
+
+//-----------------------------------------------------------------------------------
+// *****  SharedDistortionMeshGenerator
+
+SharedDistortionMeshGenerator::SharedDistortionMeshGenerator()
+{
+    PushDestroyCallbacks();
+}
+
+SharedDistortionMeshGenerator::~SharedDistortionMeshGenerator()
+{
+}
+
+void SharedDistortionMeshGenerator::OnSystemDestroy()
+{
+    delete this;
+}
+
+bool SharedDistortionMeshGenerator::Generate ( DistortionMeshVertexData *pVertices, int vertexCapacity,
+                                               uint16_t *pTriangleListIndices, int indexCapacity,
+                                               int gridSizeLog2, bool rightEye,
+                                               const HmdRenderInfo &hmdRenderInfo,
+                                               const DistortionRenderDesc &distortion, const ScaleAndOffset2D &eyeToSourceNDC )
+{
+    Lock::Locker locker ( &GenerateLock );
+    return Generator.Generate ( pVertices, vertexCapacity, pTriangleListIndices, indexCapacity,
+                                gridSizeLog2, rightEye, hmdRenderInfo, distortion, eyeToSourceNDC );
+}
+
 
 //-----------------------------------------------------------------------------------
 // *****  Heightmap Mesh Rendering
@@ -1345,23 +1550,153 @@ Matrix4f TimewarpComputePoseDeltaPosition ( Matrix4f const &renderedViewFromWorl
     return matRenderXform.Inverted();
 }
 
+//-----------------------------------------------------------------------------------
+// ***** TimewarpWaitScheduler
+
+TimewarpWaitScheduler::TimewarpWaitScheduler()
+  : Count(0),
+    Oldest(0),
+    TargetMissProbability(0.01f),
+    SafetyMargin(0.0f)
+{
+    memset ( Samples, 0, sizeof(Samples) );
+    memset ( Sorted, 0, sizeof(Sorted) );
+}
+
+void TimewarpWaitScheduler::Reset()
+{
+    Count = 0;
+    Oldest = 0;
+}
+
+void TimewarpWaitScheduler::SetTargetMissProbability ( float probability )
+{
+    TargetMissProbability = Alg::Clamp ( probability, 0.0f, 0.5f );
+}
+
+void TimewarpWaitScheduler::AddMeasurement ( float distortionTimeSeconds )
+{
+    if ( !( distortionTimeSeconds >= 0.0f ) )
+    {
+        // Negative or NaN - a broken timer, not a measurement.
+        return;
+    }
+
+    // Keep Sorted in order by removing the sample that drops out of the window
+    // and inserting the new one; both are cheap at this window size.
+    int count = Count;
+    if ( count == WindowSize )
+    {
+        float expired = Samples[Oldest];
+        int   i = 0;
+        while ( Sorted[i] != expired )
+        {
+            i++;
+        }
+        OVR_ASSERT ( i < count );
+        memmove ( &Sorted[i], &Sorted[i + 1], ( count - i - 1 ) * sizeof(float) );
+        count--;
+
+        Samples[Oldest] = distortionTimeSeconds;
+        Oldest = ( Oldest + 1 ) % WindowSize;
+    }
+    else
+    {
+        Samples[Count] = distortionTimeSeconds;
+        Count++;
+    }
+
+    int insertAt = count;
+    while ( ( insertAt > 0 ) && ( Sorted[insertAt - 1] > distortionTimeSeconds ) )
+    {
+        Sorted[insertAt] = Sorted[insertAt - 1];
+        insertAt--;
+    }
+    Sorted[insertAt] = distortionTimeSeconds;
+}
+
+float TimewarpWaitScheduler::GetDistortionTimeQuantile ( float fraction ) const
+{
+    if ( Count == 0 )
+    {
+        return 0.0f;
+    }
+
+    // Nearest rank: the smallest sample that at least 'fraction' of the window is not above.
+    int rank = (int)ceilf ( fraction * (float)Count );
+    return Sorted[Alg::Clamp ( rank - 1, 0, Count - 1 )];
+}
+
+float TimewarpWaitScheduler::GetLeadTime() const
+{
+    if ( !IsReady() )
+    {
+        return 0.0f;
+    }
+    return GetDistortionTimeQuantile ( 1.0f - TargetMissProbability ) + SafetyMargin;
+}
+
+
+TimewarpWaitSimulationResult SimulateTimewarpWaitScheduling ( const float *distortionTimes, int numFrames,
+                                                              float targetMissProbability,
+                                                              float safetyMarginSeconds )
+{
+    TimewarpWaitScheduler scheduler;
+    scheduler.SetTargetMissProbability ( targetMissProbability );
+    scheduler.SetSafetyMargin ( safetyMarginSeconds );
+
+    TimewarpWaitSimulationResult result;
+    memset ( &result, 0, sizeof(result) );
+
+    double leadTimeSum = 0.0;
+
+    for ( int frame = 0; frame < numFrames; frame++ )
+    {
+        float distortionTime = distortionTimes[frame];
+
+        // Mirrors the distortion renderers: a frame either measures its distortion
+        // without waiting, or waits until the scheduled time and may overrun.
+        if ( scheduler.NeedMeasurement() )
+        {
+            scheduler.AddMeasurement ( distortionTime );
+            result.MeasuredFrames++;
+        }
+        else
+        {
+            double leadTime = scheduler.GetLeadTime();
+            leadTimeSum += leadTime;
+            result.MaxLeadTime = Alg::Max ( result.MaxLeadTime, leadTime );
+            result.ScheduledFrames++;
+            if ( distortionTime > leadTime )
+            {
+                result.MissedFrames++;
+            }
+        }
+    }
+
+    if ( result.ScheduledFrames > 0 )
+    {
+        result.MissRate     = (double)result.MissedFrames / (double)result.ScheduledFrames;
+        result.MeanLeadTime = leadTimeSum / (double)result.ScheduledFrames;
+    }
+    return result;
+}
+
+
+//-----------------------------------------------------------------------------------
+// ***** TimewarpMachine
+
 TimewarpMachine::TimewarpMachine()
   : VsyncEnabled(false),
     RenderInfo(),
     CurrentPredictionValues(),
-    DistortionTimeCount(0),
+    DistortionScheduler(),
     DistortionTimeCurrentStart(0.0),
-  //DistortionTimes[],
-    DistortionTimeAverage(0.f),
   //EyeRenderPoses[],
     LastFramePresentFlushTime(0.0),
     PresentFlushToPresentFlushSeconds(0.f),
     NextFramePresentFlushTime(0.0)
 {
-    #if defined(OVR_BUILD_DEBUG)
-        memset(DistortionTimes, 0, sizeof(DistortionTimes));
-    #endif
-
     for ( int i = 0; i < 2; i++ )
     {
         EyeRenderPoses[i] = Posef();
@@ -1374,8 +1709,7 @@ void TimewarpMachine::Reset(HmdRenderInfo& renderInfo, bool vsyncEnabled, double
     VsyncEnabled = vsyncEnabled;
     CurrentPredictionValues = PredictionGetDeviceValues ( renderInfo, true, VsyncEnabled );
     PresentFlushToPresentFlushSeconds = 0.0f;
-    DistortionTimeCount = 0;
-    DistortionTimeAverage = 0.0f;
+    DistortionScheduler.Reset();
     LastFramePresentFlushTime = timeNow;
     AfterPresentAndFlush(timeNow);
 }
@@ -1462,12 +1796,35 @@ bool TimewarpMachine::GetTimewarpDeltaEnd(SensorStateReader* reader, Posef const
 
 	return true;
 }
+bool TimewarpMachine::GetPredictedVisiblePixelPoses(SensorStateReader* reader, Posef poses[2])
+{
+    const double times[2] = { GetVisiblePixelTimeStart(), GetVisiblePixelTimeEnd() };
+	return reader->GetPosesAtTimes(times, poses, 2);
+}
+bool TimewarpMachine::GetTimewarpDeltas(SensorStateReader* reader, Posef const &renderedPose, Matrix4f transforms[2])
+{
+	Posef visiblePoses[2];
+	if (!GetPredictedVisiblePixelPoses(reader, visiblePoses))
+	{
+		return false;
+	}
+
+    Matrix4f renderedMatrix(renderedPose);
+    Matrix4f identity;  // doesn't matter for orientation-only timewarp
+    for ( int i = 0; i < 2; i++ )
+    {
+        Matrix4f visibleMatrix(visiblePoses[i]);
+        transforms[i] = TimewarpComputePoseDelta ( renderedMatrix, visibleMatrix, identity );
+    }
+
+	return true;
+}
 
 
 // What time should the app wait until before starting distortion?
 double  TimewarpMachine::JustInTime_GetDistortionWaitUntilTime()
 {
-    if ( !VsyncEnabled || ( DistortionTimeCount < NumDistortionTimes ) )
+    if ( !VsyncEnabled || !DistortionScheduler.IsReady() )
     {
         // Don't wait.
         return LastFramePresentFlushTime;
@@ -1477,7 +1834,7 @@ double  TimewarpMachine::JustInTime_GetDistortionWaitUntilTime()
     // because otherwise you end up adding multiple fudge factors!
     // So it's left for the calling app to add just one fudge factor.
 
-    float howLongBeforePresent = DistortionTimeAverage;
+    float howLongBeforePresent = DistortionScheduler.GetLeadTime();
     // Subtlety here. Technically, the correct time is NextFramePresentFlushTime - howLongBeforePresent.
     // However, if the app drops a frame, this then perpetuates it,
     // i.e. if the display is running at 60fps, but the last frame was slow,
@@ -1489,13 +1846,18 @@ double  TimewarpMachine::JustInTime_GetDistortionWaitUntilTime()
     return LastFramePresentFlushTime + (float)( CurrentPredictionValues.PresentFlushToPresentFlush - howLongBeforePresent );
 }
 
+void TimewarpMachine::JustInTime_SetTargetMissProbability ( float probability )
+{
+    DistortionScheduler.SetTargetMissProbability ( probability );
+}
+
 double TimewarpMachine::JustInTime_AverageDistortionTime()
 {
-    if ( JustInTime_NeedDistortionTimeMeasurement() )
+    if ( !DistortionScheduler.IsReady() )
     {
         return 0.0;
     }
-    return DistortionTimeAverage;
+    return DistortionScheduler.GetDistortionTimeQuantile ( 0.5f );
 }
 
 bool    TimewarpMachine::JustInTime_NeedDistortionTimeMeasurement() const
@@ -1504,7 +1866,7 @@ bool    TimewarpMachine::JustInTime_NeedDistortionTimeMeasurement() const
     {
         return false;
     }
-    return ( DistortionTimeCount < NumDistortionTimes );
+    return DistortionScheduler.NeedMeasurement();
 }
 
 void    TimewarpMachine::JustInTime_BeforeDistortionTimeMeasurement(double timeNow)
@@ -1514,39 +1876,7 @@ void    TimewarpMachine::JustInTime_BeforeDistortionTimeMeasurement(double timeN
 
 void    TimewarpMachine::JustInTime_AfterDistortionTimeMeasurement(double timeNow)
 {
-    float timeDelta = (float)( timeNow - DistortionTimeCurrentStart );
-    if ( DistortionTimeCount < NumDistortionTimes )
-    {
-        DistortionTimes[DistortionTimeCount] = timeDelta;
-        DistortionTimeCount++;
-        if ( DistortionTimeCount == NumDistortionTimes )
-        {
-            // Median.
-            float distortionTimeMedian = 0.0f;
-            for ( int i = 0; i < NumDistortionTimes/2; i++ )
-            {
-                // Find the maximum time of those remaining.
-                float maxTime = DistortionTimes[0];
-                int maxIndex = 0;
-                for ( int j = 1; j < NumDistortionTimes; j++ )
-                {
-                    if ( maxTime < DistortionTimes[j] )
-                    {
-                        maxTime = DistortionTimes[j];
-                        maxIndex = j;
-                    }
-                }
-                // Zero that max time, so we'll find the next-highest time.
-                DistortionTimes[maxIndex] = 0.0f;
-                distortionTimeMedian = maxTime;
-            }
-            DistortionTimeAverage = distortionTimeMedian;
-        }
-    }
-    else
-    {
-        OVR_ASSERT ( !"Really didn't need more measurements, thanks" );
-    }
+    DistortionScheduler.AddMeasurement ( (float)( timeNow - DistortionTimeCurrentStart ) );
 }
 
 
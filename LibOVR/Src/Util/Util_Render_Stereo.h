@@ -29,6 +29,9 @@ limitations under the License.
 
 #include "../OVR_Stereo.h"
 #include "../Tracking/Tracking_SensorStateReader.h"
+#include "../Kernel/OVR_Array.h"
+#include "../Kernel/OVR_Threads.h"
+#include "../Kernel/OVR_System.h"
 
 namespace OVR { namespace Util { namespace Render {
 
@@ -346,9 +349,119 @@ void DistortionMeshCreate( DistortionMeshVertexData **ppVertices, uint16_t **ppT
                            const HmdRenderInfo &hmdRenderInfo, 
                            const DistortionRenderDesc &distortion, const ScaleAndOffset2D &eyeToSourceNDC );
 
+// As above, with (1<<gridSizeLog2) quads along each side; the versions above use
+// DistortionMeshDefaultGridSizeLog2. Sets the outputs to NULL and 0 on failure.
+void DistortionMeshCreate( DistortionMeshVertexData **ppVertices, uint16_t **ppTriangleListIndices,
+                           int *pNumVertices, int *pNumTriangles,
+                           int gridSizeLog2, bool rightEye,
+                           const HmdRenderInfo &hmdRenderInfo, 
+                           const DistortionRenderDesc &distortion, const ScaleAndOffset2D &eyeToSourceNDC );
+
 void DistortionMeshDestroy ( DistortionMeshVertexData *pVertices, uint16_t *pTriangleMeshIndices );
 
 
+// Meshes have (1<<gridSizeLog2) quads along each side. The largest grid is limited by
+// the vertex count having to fit in uint16_t indices.
+// Pow2 for the Morton order to work!
+// 4 is too low - it is easy to see the "wobbles" in the HMD.
+// 5 is realllly close but you can see pixel differences with even/odd frame checking.
+// 6 is indistinguishable on a monitor on even/odd frames.
+static const int DistortionMeshDefaultGridSizeLog2 = 6;
+static const int DistortionMeshMaxGridSizeLog2     = 7;
+
+inline int DistortionMeshGetNumVertices ( int gridSizeLog2 )
+{
+    int gridSize = 1 << gridSizeLog2;
+    return ( gridSize + 1 ) * ( gridSize + 1 );
+}
+
+inline int DistortionMeshGetNumTriangles ( int gridSizeLog2 )
+{
+    int gridSize = 1 << gridSizeLog2;
+    return gridSize * gridSize * 2;
+}
+
+// Generates distortion meshes of any supported grid size into caller-provided buffers.
+// Vertex rows are spread across a pool of worker threads that is created once and reused
+// for every Generate() call, so regenerating meshes when IPD, eye relief or FOV change
+// neither allocates nor spawns threads. Indices are written in the same Morton order as
+// DistortionMeshCreate. A generator may only be used by one thread at a time.
+class DistortionMeshGenerator : public NewOverrideBase
+{
+public:
+    // numWorkerThreads < 0 uses one fewer than the number of CPUs.
+    // With 0 workers, or without OVR_ENABLE_THREADS, Generate() runs entirely on the calling thread.
+    DistortionMeshGenerator ( int numWorkerThreads = -1 );
+    ~DistortionMeshGenerator();
+
+    int  GetNumWorkerThreads() const { return NumWorkers; }
+
+    // Writes DistortionMeshGetNumVertices(gridSizeLog2) vertices and
+    // 3*DistortionMeshGetNumTriangles(gridSizeLog2) indices, blocking until both are complete.
+    // Returns false, writing nothing, if gridSizeLog2 is not in [1, DistortionMeshMaxGridSizeLog2]
+    // or either buffer is too small.
+    bool Generate ( DistortionMeshVertexData *pVertices, int vertexCapacity,
+                    uint16_t *pTriangleListIndices, int indexCapacity,
+                    int gridSizeLog2, bool rightEye,
+                    const HmdRenderInfo &hmdRenderInfo,
+                    const DistortionRenderDesc &distortion, const ScaleAndOffset2D &eyeToSourceNDC );
+
+private:
+    // Everything a worker needs to produce rows of the current mesh.
+    struct Job
+    {
+        DistortionMeshVertexData*   pVertices;
+        int                         GridSize;
+        bool                        RightEye;
+        const HmdRenderInfo*        pHmdRenderInfo;
+        const DistortionRenderDesc* pDistortion;
+        const ScaleAndOffset2D*     pEyeToSourceNDC;
+    };
+
+    // Claims and fills rows of the current job until none are left.
+    void processRows();
+
+    Job                 CurrentJob;
+    AtomicInt<int>      NextRow;
+    int                 NumWorkers;
+
+#ifdef OVR_ENABLE_THREADS
+    class Worker;
+    friend class Worker;
+
+    void workerLoop();
+
+    Array<Ptr<Worker> > Workers;
+    Mutex               JobLock;
+    WaitCondition       JobStart;
+    WaitCondition       JobDone;
+    int                 JobSerial;      // Incremented for each job; workers wait for it to change.
+    int                 WorkersBusy;    // Workers yet to finish the current job.
+    bool                Quit;
+#endif
+};
+
+// The generator DistortionMeshCreate uses, shared by the whole process so its workers are
+// started once. Created on first use and destroyed by System::Destroy; calls to Generate()
+// from different threads take turns.
+class SharedDistortionMeshGenerator : public SystemSingletonBase<SharedDistortionMeshGenerator>,
+                                      public NewOverrideBase
+{
+    OVR_DECLARE_SINGLETON(SharedDistortionMeshGenerator);
+
+public:
+    bool Generate ( DistortionMeshVertexData *pVertices, int vertexCapacity,
+                    uint16_t *pTriangleListIndices, int indexCapacity,
+                    int gridSizeLog2, bool rightEye,
+                    const HmdRenderInfo &hmdRenderInfo,
+                    const DistortionRenderDesc &distortion, const ScaleAndOffset2D &eyeToSourceNDC );
+
+private:
+    Lock                    GenerateLock;
+    DistortionMeshGenerator Generator;
+};
+
+
 //-----------------------------------------------------------------------------------
 // *****  Heightmap Mesh Rendering
 //
@@ -416,6 +529,78 @@ Matrix4f TimewarpComputePoseDeltaPosition ( Matrix4f const &renderedViewFromWorl
 
 
 
+// TimewarpWaitScheduler decides how long before the present deadline timewarp distortion
+// has to start. It keeps a sliding window of measured distortion render times and picks the
+// time that only the target fraction of frames is expected to exceed, so the trade-off
+// between latency and missed frames is an explicit setting rather than a fixed fudge factor:
+// a lower miss probability starts distortion earlier, with an older pose.
+// Measuring a frame means stalling on the GPU before and after distortion, so only the
+// first WindowSize frames after a Reset() are measured. The distortion work is fixed by
+// the rendering configuration, and reconfiguring rendering resets the scheduler.
+class TimewarpWaitScheduler
+{
+public:
+    enum
+    {
+        // Measurements kept; the oldest is dropped when a new one arrives.
+        WindowSize          = 64
+    };
+
+    TimewarpWaitScheduler();
+
+    // Forgets all measurements; the target and margin are kept.
+    void        Reset();
+
+    // Fraction of frames allowed to finish distortion after the deadline, clamped to [0, 0.5].
+    // Targets below 1/WindowSize select the slowest measurement in the window.
+    void        SetTargetMissProbability ( float probability );
+    float       GetTargetMissProbability() const    { return TargetMissProbability; }
+
+    // Added to the selected distortion time, to cover timer and scheduling jitter.
+    void        SetSafetyMargin ( float seconds )   { SafetyMargin = seconds; }
+    float       GetSafetyMargin() const             { return SafetyMargin; }
+
+    // True if distortion should be timed this frame instead of waited for.
+    bool        NeedMeasurement() const             { return Count < WindowSize; }
+    void        AddMeasurement ( float distortionTimeSeconds );
+
+    // No lead time is computed until the window has been filled once.
+    bool        IsReady() const                     { return Count == WindowSize; }
+    // Seconds before the deadline at which distortion should start; 0 if not ready.
+    float       GetLeadTime() const;
+    // Measured distortion time that the given fraction of the window does not exceed.
+    float       GetDistortionTimeQuantile ( float fraction ) const;
+
+private:
+    int         Count;
+    int         Oldest;                         // Next slot of Samples to overwrite once full
+    float       TargetMissProbability;
+    float       SafetyMargin;
+    float       Samples[WindowSize];            // In arrival order
+    float       Sorted[WindowSize];             // The same values, ascending
+};
+
+// Result of replaying distortion times through a TimewarpWaitScheduler.
+struct TimewarpWaitSimulationResult
+{
+    int         ScheduledFrames;    // Frames that waited for the scheduled start time
+    int         MeasuredFrames;     // Frames spent measuring instead (no wait, no miss)
+    int         MissedFrames;       // Scheduled frames whose distortion overran the deadline
+    double      MissRate;           // MissedFrames / ScheduledFrames
+    double      MeanLeadTime;       // Average added latency of scheduled frames, in seconds
+    double      MaxLeadTime;
+};
+
+// Replays per-frame distortion render times, as recorded in a frame timing trace, through a
+// scheduler with the given settings, the same way the distortion renderers drive it. A frame
+// misses when its distortion time exceeds the lead time it was given. The replay is
+// deterministic, so settings can be compared on the same recording.
+TimewarpWaitSimulationResult SimulateTimewarpWaitScheduling ( const float *distortionTimes, int numFrames,
+                                                              float targetMissProbability,
+                                                              float safetyMarginSeconds );
+
+
+
 // TimewarpMachine helps keep track of rendered frame timing and
 // handles predictions for time-warp rendering.
 class TimewarpMachine
@@ -454,6 +639,10 @@ public:
     // (usually the one returned by GetViewRenderPredictionPose() earlier)
 	bool        GetTimewarpDeltaStart(Tracking::SensorStateReader* reader, Posef const &renderedPose, Matrix4f& transform);
 	bool        GetTimewarpDeltaEnd(Tracking::SensorStateReader* reader, Posef const &renderedPose, Matrix4f& transform);
+    // Both of the above from a single sensor state, so the start and end can't come from
+    // different samples. Index 0 is the first pixel, index 1 the last.
+	bool        GetPredictedVisiblePixelPoses(Tracking::SensorStateReader* reader, Posef transforms[2]);
+	bool        GetTimewarpDeltas(Tracking::SensorStateReader* reader, Posef const &renderedPose, Matrix4f transforms[2]);
 
     // Just-In-Time distortion aims to delay the second sensor reading & distortion
     // until the very last moment to improve prediction. However, it is a little scary,
@@ -463,6 +652,8 @@ public:
 
     // What time should the app wait until before starting distortion?
     double      JustInTime_GetDistortionWaitUntilTime();
+    // How often the wait may be too long for distortion to finish in time; see TimewarpWaitScheduler.
+    void        JustInTime_SetTargetMissProbability ( float probability );
 
     // Used to time the distortion rendering
     bool        JustInTime_NeedDistortionTimeMeasurement() const;
@@ -475,11 +666,8 @@ private:
     HmdRenderInfo       RenderInfo;
     PredictionValues    CurrentPredictionValues;
 
-    enum { NumDistortionTimes = 100 };
-    int                 DistortionTimeCount;
+    TimewarpWaitScheduler DistortionScheduler;
     double              DistortionTimeCurrentStart;
-    float               DistortionTimes[NumDistortionTimes];
-    float               DistortionTimeAverage;
 
     // Pose at which last time the eye was rendered.
     Posef               EyeRenderPoses[2];
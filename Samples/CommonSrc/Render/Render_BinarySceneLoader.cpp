@@ -0,0 +1,335 @@
+/************************************************************************************
+
+Filename    :   Render_BinarySceneLoader.cpp
+Content     :   Loads and writes precompiled binary scene files - implementation
+Created     :   October 17, 2014
+
+Copyright   :   Copyright 2014 Oculus VR, LLC. All Rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+************************************************************************************/
+
+#include "Render_BinarySceneLoader.h"
+#include <Kernel/OVR_Log.h>
+
+namespace OVR { namespace Render {
+
+static const uint32_t BinarySceneMagic        = 0x5352564F;  // "OVRS"
+static const uint16_t BinarySceneMajorVersion = 1;
+static const uint16_t BinarySceneMinorVersion = 0;
+
+// The vertex blocks are copied into Model::Vertices as they are.
+OVR_COMPILER_ASSERT(sizeof(Vertex) == 44);
+OVR_COMPILER_ASSERT(sizeof(Planef) == 16);
+OVR_COMPILER_ASSERT(sizeof(BinarySceneHandler::Header) % 8 == 0);
+
+static inline uint32_t AlignBinarySceneOffset(uint32_t offset)
+{
+    return (offset + 7) & ~7u;
+}
+
+// Whether count items of the given size at offset lie within the file
+static inline bool IsInFile(uint32_t offset, uint32_t count, uint32_t itemSize, uint32_t fileSize)
+{
+    return (uint64_t)offset + (uint64_t)count * itemSize <= fileSize;
+}
+
+// Checks every record against the file before ReadFile creates anything.
+static bool ValidateBinaryScene(const uint8_t* data, uint32_t fileSize)
+{
+    typedef BinarySceneHandler::Header          Header;
+    typedef BinarySceneHandler::TextureRecord   TextureRecord;
+    typedef BinarySceneHandler::ModelRecord     ModelRecord;
+    typedef BinarySceneHandler::CollisionRecord CollisionRecord;
+
+    const Header& header = *(const Header*)data;
+
+    if (header.CollisionCount > fileSize || header.GroundCollisionCount > fileSize)
+        return false;
+
+    // Each table is checked before its end is used as the offset of the next one
+    uint32_t texturesOffset = sizeof(Header);
+    if (!IsInFile(texturesOffset, header.TextureCount, sizeof(TextureRecord), fileSize))
+        return false;
+    uint32_t modelsOffset = texturesOffset + header.TextureCount * sizeof(TextureRecord);
+    if (!IsInFile(modelsOffset, header.ModelCount, sizeof(ModelRecord), fileSize))
+        return false;
+    uint32_t collisionsOffset = modelsOffset + header.ModelCount * sizeof(ModelRecord);
+    uint32_t collisionCount   = header.CollisionCount + header.GroundCollisionCount;
+    if (!IsInFile(collisionsOffset, collisionCount, sizeof(CollisionRecord), fileSize))
+        return false;
+
+    const TextureRecord* textures = (const TextureRecord*)(data + texturesOffset);
+    for (uint32_t i = 0; i < header.TextureCount; i++)
+    {
+        if (textures[i].NameLength >= fileSize ||
+            !IsInFile(textures[i].NameOffset, textures[i].NameLength + 1, 1, fileSize) ||
+            data[textures[i].NameOffset + textures[i].NameLength] != 0)
+        {
+            return false;
+        }
+    }
+
+    const ModelRecord* models = (const ModelRecord*)(data + modelsOffset);
+    for (uint32_t i = 0; i < header.ModelCount; i++)
+    {
+        const ModelRecord& model = models[i];
+        if (model.DiffuseTextureIndex < -1 || model.DiffuseTextureIndex >= (int32_t)header.TextureCount ||
+            model.LightmapTextureIndex < -1 || model.LightmapTextureIndex >= (int32_t)header.TextureCount ||
+            model.VertexCount > 0x10000 ||
+            (model.VertexOffset & 7) || (model.IndexOffset & 7) ||
+            !IsInFile(model.VertexOffset, model.VertexCount, sizeof(Vertex), fileSize) ||
+            !IsInFile(model.IndexOffset, model.IndexCount, sizeof(uint16_t), fileSize))
+        {
+            return false;
+        }
+
+        // An index past the vertices would have the GPU read outside the vertex buffer
+        const uint16_t* indices = (const uint16_t*)(data + model.IndexOffset);
+        for (uint32_t j = 0; j < model.IndexCount; j++)
+        {
+            if (indices[j] >= model.VertexCount)
+                return false;
+        }
+    }
+
+    const CollisionRecord* collisions = (const CollisionRecord*)(data + collisionsOffset);
+    for (uint32_t i = 0; i < collisionCount; i++)
+    {
+        if ((collisions[i].PlaneOffset & 7) ||
+            !IsInFile(collisions[i].PlaneOffset, collisions[i].PlaneCount, sizeof(Planef), fileSize))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool BinarySceneHandler::ReadFile(const char* fileName, OVR::Render::RenderDevice* pRender,
+                                  OVR::Render::Scene* pScene,
+                                  OVR::Array<Ptr<CollisionModel> >* pCollisions,
+                                  OVR::Array<Ptr<CollisionModel> >* pGroundCollisions,
+                                  const FileStat* source)
+{
+    // The whole file is read with one call; everything after is copied from memory.
+    SysFile file;
+    if (!file.Open(fileName, File::Open_Read))
+        return false;
+
+    int fileSize = file.GetLength();
+    if (fileSize < (int)sizeof(Header))
+        return false;
+
+    uint8_t* data = (uint8_t*)OVR_ALLOC_ALIGNED(fileSize, 8);
+    bool     valid = (file.Read(data, fileSize) == fileSize);
+    file.Close();
+
+    const Header& header = *(const Header*)data;
+    valid = valid &&
+            header.Magic == BinarySceneMagic &&
+            header.MajorVersion == BinarySceneMajorVersion &&
+            header.FileSize == (uint32_t)fileSize &&
+            header.VertexSize == sizeof(Vertex) &&
+            (source == NULL || (header.SourceSize == source->FileSize &&
+                                header.SourceModifyTime == source->ModifyTime)) &&
+            ValidateBinaryScene(data, (uint32_t)fileSize);
+    if (!valid)
+    {
+        OVR_FREE_ALIGNED(data);
+        return false;
+    }
+
+    OVR_DEBUG_LOG(("Loading binary scene %s, %d models...", fileName, header.ModelCount));
+
+    // Textures are relative to the directory of the scene file
+    char     filePath[250];
+    intptr_t len = strlen(fileName);
+    filePath[0] = 0;
+    for (intptr_t i = len; i > 0; i--)
+    {
+        if ((fileName[i-1] == '\\' || fileName[i-1] == '/') && i < (intptr_t)sizeof(filePath))
+        {
+            memcpy(filePath, fileName, i);
+            filePath[i] = 0;
+            break;
+        }
+    }
+
+    const TextureRecord* textureRecords = (const TextureRecord*)(data + sizeof(Header));
+    Array<Ptr<Texture> > textures;
+    for (uint32_t i = 0; i < header.TextureCount; i++)
+    {
+        Ptr<Texture> texture = *XmlHandler::LoadTexture(pRender, filePath,
+                                                        (const char*)data + textureRecords[i].NameOffset);
+        textures.PushBack(texture);
+    }
+
+    const ModelRecord* modelRecords = (const ModelRecord*)(textureRecords + header.TextureCount);
+    for (uint32_t i = 0; i < header.ModelCount; i++)
+    {
+        const ModelRecord& record = modelRecords[i];
+
+        Ptr<ShaderFill> shader = *XmlHandler::CreateModelFill(pRender, textures, record.DiffuseTextureIndex,
+                                                              record.LightmapTextureIndex);
+        Ptr<Model>      model  = *new Model(Prim_Triangles);
+        model->Visible          = (record.Flags & Model_Visible) != 0;
+        model->IsCollisionModel = (record.Flags & Model_CollisionModel) != 0;
+        model->Fill             = shader;
+        model->Vertices.Append((const Vertex*)(data + record.VertexOffset), record.VertexCount);
+        model->Indices.Append((const uint16_t*)(data + record.IndexOffset), record.IndexCount);
+
+        pScene->World.Add(model);
+        pScene->Models.PushBack(model);
+    }
+
+    const CollisionRecord* collisionRecords = (const CollisionRecord*)(modelRecords + header.ModelCount);
+    for (uint32_t i = 0; i < header.CollisionCount + header.GroundCollisionCount; i++)
+    {
+        Ptr<CollisionModel> cm = *new CollisionModel();
+        cm->Planes.Append((const Planef*)(data + collisionRecords[i].PlaneOffset), collisionRecords[i].PlaneCount);
+
+        if (i < header.CollisionCount)
+            pCollisions->PushBack(cm);
+        else
+            pGroundCollisions->PushBack(cm);
+    }
+
+    OVR_FREE_ALIGNED(data);
+    OVR_DEBUG_LOG(("Done."));
+    return true;
+}
+
+// Appends size bytes, then zeros up to the next table boundary, and returns the offset.
+static uint32_t AppendBinarySceneBlock(ArrayPOD<uint8_t>& image, const void* data, size_t size)
+{
+    uint32_t offset = (uint32_t)image.GetSize();
+    image.Resize(AlignBinarySceneOffset((uint32_t)(offset + size)));
+    if (size)
+        memcpy(&image[offset], data, size);
+    memset(image.GetDataPtr() + offset + size, 0, image.GetSize() - offset - size);
+    return offset;
+}
+
+bool BinarySceneHandler::WriteFile(const char* fileName, const XmlHandler& xml,
+                                   const OVR::Array<Ptr<CollisionModel> >& collisions,
+                                   const OVR::Array<Ptr<CollisionModel> >& groundCollisions,
+                                   const FileStat& source)
+{
+    Header header;
+    memset(&header, 0, sizeof(header));
+    header.Magic                = BinarySceneMagic;
+    header.MajorVersion         = BinarySceneMajorVersion;
+    header.MinorVersion         = BinarySceneMinorVersion;
+    header.VertexSize           = sizeof(Vertex);
+    header.SourceSize           = source.FileSize;
+    header.SourceModifyTime     = source.ModifyTime;
+    header.TextureCount         = (uint32_t)xml.GetTextureCount();
+    header.ModelCount           = (uint32_t)xml.GetModelCount();
+    header.CollisionCount       = (uint32_t)collisions.GetSize();
+    header.GroundCollisionCount = (uint32_t)groundCollisions.GetSize();
+
+    // The tables are filled in as the data after them is added
+    uint32_t collisionCount = header.CollisionCount + header.GroundCollisionCount;
+    uint32_t tablesSize     = sizeof(Header) + header.TextureCount * sizeof(TextureRecord) +
+                              header.ModelCount * sizeof(ModelRecord) + collisionCount * sizeof(CollisionRecord);
+
+    ArrayPOD<uint8_t> image;
+    image.Resize(tablesSize);
+    memset(image.GetDataPtr(), 0, tablesSize);
+
+    for (uint32_t i = 0; i < header.ModelCount; i++)
+    {
+        Model* model = xml.GetModel(i);
+        if (model->Vertices.GetSize() > 0x10000)
+            return false;
+
+        ModelRecord record;
+        record.Flags                = (model->Visible ? Model_Visible : 0) |
+                                      (model->IsCollisionModel ? Model_CollisionModel : 0);
+        record.DiffuseTextureIndex  = xml.GetDiffuseTextureIndex(i);
+        record.LightmapTextureIndex = xml.GetLightmapTextureIndex(i);
+        record.VertexCount          = (uint32_t)model->Vertices.GetSize();
+        record.VertexOffset         = AppendBinarySceneBlock(image, model->Vertices.GetDataPtr(),
+                                                             record.VertexCount * sizeof(Vertex));
+        record.IndexCount           = (uint32_t)model->Indices.GetSize();
+        record.IndexOffset          = AppendBinarySceneBlock(image, model->Indices.GetDataPtr(),
+                                                             record.IndexCount * sizeof(uint16_t));
+        record.Reserved             = 0;
+
+        uint32_t recordOffset = sizeof(Header) + header.TextureCount * sizeof(TextureRecord) + i * sizeof(ModelRecord);
+        memcpy(&image[recordOffset], &record, sizeof(record));
+    }
+
+    for (uint32_t i = 0; i < collisionCount; i++)
+    {
+        CollisionModel* cm = (i < header.CollisionCount) ? collisions[i] : groundCollisions[i - header.CollisionCount];
+
+        CollisionRecord record;
+        record.PlaneCount  = (uint32_t)cm->Planes.GetSize();
+        record.PlaneOffset = AppendBinarySceneBlock(image, cm->Planes.GetDataPtr(), record.PlaneCount * sizeof(Planef));
+
+        uint32_t recordOffset = tablesSize - (collisionCount - i) * sizeof(CollisionRecord);
+        memcpy(&image[recordOffset], &record, sizeof(record));
+    }
+
+    for (uint32_t i = 0; i < header.TextureCount; i++)
+    {
+        const char*   name = xml.GetTextureFileName(i);
+        TextureRecord record;
+        record.NameLength = (uint32_t)strlen(name);
+        record.NameOffset = AppendBinarySceneBlock(image, name, record.NameLength + 1);
+        memcpy(&image[sizeof(Header) + i * sizeof(TextureRecord)], &record, sizeof(record));
+    }
+
+    header.FileSize = (uint32_t)image.GetSize();
+    memcpy(&image[0], &header, sizeof(header));
+
+    SysFile file;
+    if (!file.Open(fileName, File::Open_Write | File::Open_Create | File::Open_Truncate, File::Mode_ReadWrite))
+        return false;
+
+    bool result = (file.Write(image.GetDataPtr(), (int)image.GetSize()) == (int)image.GetSize());
+    return file.Close() && result;
+}
+
+String BinarySceneHandler::GetBinaryPath(const char* xmlFileName)
+{
+    String path(xmlFileName);
+    path.StripExtension();
+    return path + ".scene";
+}
+
+bool LoadScene(const char* xmlFileName, OVR::Render::RenderDevice* pRender,
+               OVR::Render::Scene* pScene,
+               OVR::Array<Ptr<CollisionModel> >* pCollisions,
+               OVR::Array<Ptr<CollisionModel> >* pGroundCollisions)
+{
+    FileStat source;
+    bool     haveSource = SysFile::GetFileStat(&source, xmlFileName);
+
+    if (BinarySceneHandler::ReadFile(BinarySceneHandler::GetBinaryPath(xmlFileName).ToCStr(), pRender, pScene,
+                                     pCollisions, pGroundCollisions, haveSource ? &source : NULL))
+    {
+        return true;
+    }
+
+    if (!haveSource)
+        return false;
+
+    XmlHandler xmlHandler;
+    return xmlHandler.ReadFile(xmlFileName, pRender, pScene, pCollisions, pGroundCollisions);
+}
+
+}} // OVR::Render
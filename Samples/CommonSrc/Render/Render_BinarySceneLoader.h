@@ -0,0 +1,121 @@
+/************************************************************************************
+
+Filename    :   Render_BinarySceneLoader.h
+Content     :   Loads and writes precompiled binary scene files
+Created     :   October 17, 2014
+
+Copyright   :   Copyright 2014 Oculus VR, LLC. All Rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+************************************************************************************/
+
+#ifndef OVR_Render_BinarySceneLoader_h
+#define OVR_Render_BinarySceneLoader_h
+
+#include "Render_XmlSceneLoader.h"
+
+namespace OVR { namespace Render {
+
+// A binary scene holds what XmlHandler builds from an XML scene, with vertices and
+// indices in their final form, so that loading it copies blocks instead of parsing
+// text. The file is in native (little-endian) byte order, with every table 8-byte
+// aligned so that it can be used in place from memory:
+//
+//   Header
+//   TextureRecord[TextureCount]
+//   ModelRecord[ModelCount]
+//   CollisionRecord[CollisionCount + GroundCollisionCount]
+//   Vertex data, index data, plane data (Planef) and texture names
+//
+// The header records the size and modification time of the XML file it was converted
+// from, so a binary scene left behind by an edit of the XML file isn't used.
+
+class BinarySceneHandler
+{
+public:
+    enum ModelFlags
+    {
+        Model_Visible        = 0x1,
+        Model_CollisionModel = 0x2
+    };
+
+    struct Header
+    {
+        uint32_t    Magic;
+        uint16_t    MajorVersion;
+        uint16_t    MinorVersion;
+        uint32_t    FileSize;
+        uint32_t    VertexSize;             // sizeof(Vertex)
+        int64_t     SourceSize;             // Of the XML file
+        int64_t     SourceModifyTime;
+        uint32_t    TextureCount;
+        uint32_t    ModelCount;
+        uint32_t    CollisionCount;
+        uint32_t    GroundCollisionCount;
+    };
+
+    struct TextureRecord
+    {
+        uint32_t    NameOffset;             // Null-terminated, relative to the scene file
+        uint32_t    NameLength;
+    };
+
+    struct ModelRecord
+    {
+        uint32_t    Flags;                  // ModelFlags
+        int32_t     DiffuseTextureIndex;    // -1 if unused
+        int32_t     LightmapTextureIndex;
+        uint32_t    VertexCount;
+        uint32_t    VertexOffset;
+        uint32_t    IndexCount;
+        uint32_t    IndexOffset;
+        uint32_t    Reserved;
+    };
+
+    struct CollisionRecord
+    {
+        uint32_t    PlaneCount;
+        uint32_t    PlaneOffset;
+    };
+
+    // Loads a binary scene into pScene and the collision arrays. If source isn't NULL,
+    // the file must have been converted from an XML file with these stats. Nothing is
+    // added unless the whole file is valid.
+    static bool ReadFile(const char* fileName, OVR::Render::RenderDevice* pRender,
+                         OVR::Render::Scene* pScene,
+                         OVR::Array<Ptr<CollisionModel> >* pCollisions,
+                         OVR::Array<Ptr<CollisionModel> >* pGroundCollisions,
+                         const FileStat* source = NULL);
+
+    // Writes the scene last read by xml, with the collision models it returned.
+    static bool WriteFile(const char* fileName, const XmlHandler& xml,
+                          const OVR::Array<Ptr<CollisionModel> >& collisions,
+                          const OVR::Array<Ptr<CollisionModel> >& groundCollisions,
+                          const FileStat& source);
+
+    // Path of the binary scene converted from an XML scene: the same name with a
+    // ".scene" extension.
+    static String GetBinaryPath(const char* xmlFileName);
+};
+
+// Loads an XML scene, using its binary scene instead while that matches it. The binary
+// scene is also used on its own if the XML file isn't there.
+bool LoadScene(const char* xmlFileName, OVR::Render::RenderDevice* pRender,
+               OVR::Render::Scene* pScene,
+               OVR::Array<Ptr<CollisionModel> >* pCollisions,
+               OVR::Array<Ptr<CollisionModel> >* pGroundCollisions);
+
+}} // OVR::Render
+
+#endif // OVR_Render_BinarySceneLoader_h
@@ -40,6 +40,18 @@ namespace OVR { namespace Render {
 		}
 	}
 
+	const Bounds3f& Model::GetBounds() const
+	{
+		if (!BoundsCurrent)
+		{
+			Bounds.Clear();
+			for (size_t i = 0; i < Vertices.GetSize(); i++)
+				Bounds.AddPoint(Vertices[i].Pos);
+			BoundsCurrent = true;
+		}
+		return Bounds;
+	}
+
 	void Container::Render(const Matrix4f& ltw, RenderDevice* ren)
 	{
 		Matrix4f m = ltw * GetMatrix();
@@ -75,6 +87,297 @@ namespace OVR { namespace Render {
 		World.Render(view, ren);
 	}
 
+	void Scene::Render(RenderDevice* ren, const Matrix4f& view, const Frustum& frustum)
+	{
+		Cull(view, frustum);
+		RenderVisible(ren, view);
+	}
+
+	void Scene::Cull(const Matrix4f& view, const Frustum& frustum)
+	{
+		if (BVH.IsEmpty())
+			BuildBVH();
+
+		BVH.Cull(frustum.Transformed(view), VisibleLeaves, &Stats);
+	}
+
+	void Scene::RenderVisible(RenderDevice* ren, const Matrix4f& view)
+	{
+		AutoGpuProf prof(ren, "Scene_Render");
+
+		Lighting.Update(view, LightPos);
+
+		ren->SetLighting(&Lighting);
+
+		for (size_t i = 0; i < VisibleLeaves.GetSize(); i++)
+		{
+			const SceneBVH::Leaf& leaf = BVH.GetLeaf(VisibleLeaves[i]);
+			if (leaf.pNode->GetType() == Node::Node_Model && !((Model*)leaf.pNode.GetPtr())->IsVisible())
+				continue;
+
+			leaf.pNode->Render(view * leaf.ParentMatrix, ren);
+			Stats.Submitted++;
+		}
+	}
+
+
+	//-------------------------------------------------------------------------------------
+	// ***** Frustum
+
+	static Vector3f GetBoundsCenter(const Bounds3f& b) { return (b.GetMins() + b.GetMaxs()) * 0.5f; }
+	static Vector3f GetBoundsExtent(const Bounds3f& b) { return (b.GetMaxs() - b.GetMins()) * 0.5f; }
+
+	// Bounds of the box b after the affine transform m.
+	static Bounds3f TransformBounds(const Matrix4f& m, const Bounds3f& b)
+	{
+		Vector3f center = m.Transform(GetBoundsCenter(b));
+		Vector3f extent = GetBoundsExtent(b);
+		Vector3f e;
+		for (int i = 0; i < 3; i++)
+		{
+			e[i] = fabsf(m.M[i][0]) * extent.x + fabsf(m.M[i][1]) * extent.y + fabsf(m.M[i][2]) * extent.z;
+		}
+		return Bounds3f(center - e, center + e);
+	}
+
+	static Planef NormalizedPlane(const Vector3f& n, float d)
+	{
+		float rcpLength = 1.0f / n.Length();
+		return Planef(n * rcpLength, d * rcpLength);
+	}
+
+	void Frustum::SetFromFov(const FovPort& fov, float zNear, float zFar)
+	{
+		// A point is inside the left plane when x >= -LeftTan * -z, and so on.
+		Planes[0] = NormalizedPlane(Vector3f( 1.0f,  0.0f, -fov.LeftTan),  0.0f);
+		Planes[1] = NormalizedPlane(Vector3f(-1.0f,  0.0f, -fov.RightTan), 0.0f);
+		Planes[2] = NormalizedPlane(Vector3f( 0.0f, -1.0f, -fov.UpTan),    0.0f);
+		Planes[3] = NormalizedPlane(Vector3f( 0.0f,  1.0f, -fov.DownTan),  0.0f);
+		Planes[4] = Planef(Vector3f(0.0f, 0.0f, -1.0f), -zNear);
+		Planes[5] = Planef(Vector3f(0.0f, 0.0f,  1.0f),  zFar);
+	}
+
+	void Frustum::SetFromStereoFov(const FovPort& leftFov, const FovPort& rightFov, float ipd,
+								   float zNear, float zFar)
+	{
+		// The widest sides of both eyes, with the left and right planes moved out to the
+		// eye on their side; each eye's frustum is then inside all six planes.
+		SetFromFov(FovPort::Max(leftFov, rightFov), zNear, zFar);
+		Planes[0].D = -Planes[0].N.Dot(Vector3f(-0.5f * ipd, 0.0f, 0.0f));
+		Planes[1].D = -Planes[1].N.Dot(Vector3f( 0.5f * ipd, 0.0f, 0.0f));
+	}
+
+	Frustum Frustum::Transformed(const Matrix4f& m) const
+	{
+		// A plane (n, d) that holds for m * p holds for p as (n, d) * m.
+		Frustum result;
+		for (int i = 0; i < PlaneCount; i++)
+		{
+			const Planef& p = Planes[i];
+			float         v[4];
+			for (int j = 0; j < 4; j++)
+			{
+				v[j] = p.N.x * m.M[0][j] + p.N.y * m.M[1][j] + p.N.z * m.M[2][j] + p.D * m.M[3][j];
+			}
+			result.Planes[i] = NormalizedPlane(Vector3f(v[0], v[1], v[2]), v[3]);
+		}
+		return result;
+	}
+
+	Frustum::TestResult Frustum::TestBounds(const Bounds3f& bounds) const
+	{
+		Vector3f   center = GetBoundsCenter(bounds);
+		Vector3f   extent = GetBoundsExtent(bounds);
+		TestResult result = Test_Inside;
+
+		for (int i = 0; i < PlaneCount; i++)
+		{
+			const Planef& p = Planes[i];
+			float distance  = p.TestSide(center);
+			float radius    = fabsf(p.N.x) * extent.x + fabsf(p.N.y) * extent.y + fabsf(p.N.z) * extent.z;
+
+			if (distance < -radius)
+				return Test_Outside;
+			if (distance < radius)
+				result = Test_Intersects;
+		}
+		return result;
+	}
+
+
+	//-------------------------------------------------------------------------------------
+	// ***** SceneBVH
+
+	struct BVHCenterLess
+	{
+		const Array<Vector3f>* pCenters;
+		int                    Axis;
+
+		BVHCenterLess(const Array<Vector3f>* centers, int axis) : pCenters(centers), Axis(axis) { }
+
+		bool operator()(uint32_t a, uint32_t b) const
+		{
+			return (*pCenters)[a][Axis] < (*pCenters)[b][Axis];
+		}
+	};
+
+	void SceneBVH::Build(Container* root)
+	{
+		Clear();
+		addNode(root, Matrix4f());
+
+		Array<Vector3f> centers;
+		centers.Resize(Leaves.GetSize());
+		for (uint32_t i = 0; i < (uint32_t)Leaves.GetSize(); i++)
+		{
+			if (Leaves[i].Unbounded)
+			{
+				Unbounded.PushBack(i);
+			}
+			else
+			{
+				centers[i] = GetBoundsCenter(Leaves[i].Bounds);
+				LeafOrder.PushBack(i);
+			}
+		}
+
+		if (LeafOrder.GetSize())
+			buildNode(0, (uint32_t)LeafOrder.GetSize(), centers);
+	}
+
+	void SceneBVH::Clear()
+	{
+		Leaves.Clear();
+		LeafOrder.Clear();
+		Unbounded.Clear();
+		Nodes.Clear();
+	}
+
+	void SceneBVH::addNode(Node* node, const Matrix4f& parentMatrix)
+	{
+		if (node->GetType() == Node::Node_Container)
+		{
+			Container* container = (Container*)node;
+			Matrix4f   m         = parentMatrix * container->GetMatrix();
+			for (size_t i = 0; i < container->Nodes.GetSize(); i++)
+				addNode(container->Nodes[i], m);
+			return;
+		}
+
+		Leaf leaf;
+		leaf.pNode        = node;
+		leaf.ParentMatrix = parentMatrix;
+		leaf.Unbounded    = true;
+
+		// Models without vertices are left to the renderer, like other nodes
+		if (node->GetType() == Node::Node_Model && ((Model*)node)->Vertices.GetSize())
+		{
+			Model* model   = (Model*)node;
+			leaf.Bounds    = TransformBounds(parentMatrix * model->GetMatrix(), model->GetBounds());
+			leaf.Unbounded = false;
+		}
+
+		Leaves.PushBack(leaf);
+	}
+
+	uint32_t SceneBVH::buildNode(uint32_t first, uint32_t count, const Array<Vector3f>& centers)
+	{
+		uint32_t index = (uint32_t)Nodes.GetSize();
+		Nodes.PushBack(BVHNode());
+
+		Bounds3f bounds, centerBounds;
+		bounds.Clear();
+		centerBounds.Clear();
+		for (uint32_t i = first; i < first + count; i++)
+		{
+			const Bounds3f& leafBounds = Leaves[LeafOrder[i]].Bounds;
+			bounds.AddPoint(leafBounds.GetMins());
+			bounds.AddPoint(leafBounds.GetMaxs());
+			centerBounds.AddPoint(centers[LeafOrder[i]]);
+		}
+
+		Nodes[index].Bounds = bounds;
+		Nodes[index].First  = first;
+		Nodes[index].Count  = count;
+		Nodes[index].Right  = 0;
+
+		if (count > MaxLeavesPerNode)
+		{
+			// Split at the median center along the axis the centers are most spread on
+			Vector3f size = centerBounds.GetMaxs() - centerBounds.GetMins();
+			int      axis = (size.x >= size.y && size.x >= size.z) ? 0 : (size.y >= size.z ? 1 : 2);
+
+			Alg::QuickSortSliced(LeafOrder, first, first + count, BVHCenterLess(&centers, axis));
+
+			uint32_t half = count / 2;
+			buildNode(first, half, centers);
+			uint32_t right = buildNode(first + half, count - half, centers);
+			Nodes[index].Right = right;
+		}
+		return index;
+	}
+
+	void SceneBVH::Cull(const Frustum& frustum, ArrayPOD<uint32_t>& visible, CullStats* stats) const
+	{
+		visible.Clear();
+		if (Nodes.GetSize())
+			cullNode(0, frustum, false, visible, stats);
+
+		for (size_t i = 0; i < Unbounded.GetSize(); i++)
+			visible.PushBack(Unbounded[i]);
+
+		// Keep the order of the scene, which alpha blended models depend on
+		Alg::QuickSort(visible);
+	}
+
+	void SceneBVH::cullNode(uint32_t index, const Frustum& frustum, bool inside,
+							ArrayPOD<uint32_t>& visible, CullStats* stats) const
+	{
+		const BVHNode& node = Nodes[index];
+
+		if (!inside)
+		{
+			Frustum::TestResult result = frustum.TestBounds(node.Bounds);
+			if (stats)
+				stats->BoundsTested++;
+
+			if (result == Frustum::Test_Outside)
+			{
+				if (stats)
+					stats->Culled += (int)node.Count;
+				return;
+			}
+			inside = (result == Frustum::Test_Inside);
+		}
+
+		// The leaves of a node are consecutive in LeafOrder
+		if (inside)
+		{
+			for (uint32_t i = node.First; i < node.First + node.Count; i++)
+				visible.PushBack(LeafOrder[i]);
+			return;
+		}
+
+		if (node.Right == 0)
+		{
+			for (uint32_t i = node.First; i < node.First + node.Count; i++)
+			{
+				uint32_t leaf = LeafOrder[i];
+				if (stats)
+					stats->BoundsTested++;
+
+				if (frustum.TestBounds(Leaves[leaf].Bounds) != Frustum::Test_Outside)
+					visible.PushBack(leaf);
+				else if (stats)
+					stats->Culled++;
+			}
+			return;
+		}
+
+		cullNode(index + 1, frustum, false, visible, stats);
+		cullNode(node.Right, frustum, false, visible, stats);
+	}
+
 
 
 	uint16_t CubeIndices[] =
@@ -534,7 +534,7 @@ public:
     Ptr<Buffer>       VertexBuffer;
     Ptr<Buffer>       IndexBuffer;
 
-    Model(PrimitiveType t = Prim_Triangles) : Type(t), Fill(NULL), Visible(true), IsCollisionModel(false) { }
+    Model(PrimitiveType t = Prim_Triangles) : Type(t), Fill(NULL), Visible(true), IsCollisionModel(false), BoundsCurrent(false) { }
     ~Model() { }
 
     virtual NodeType GetType() const { return Node_Model; }
@@ -546,6 +546,11 @@ public:
     void SetVisible(bool visible) { Visible = visible; }
     bool IsVisible() const        { return Visible; }
 
+    // Bounds of Vertices in model space, computed on first use. AddVertex updates them;
+    // call InvalidateBounds after changing Vertices directly.
+    const Bounds3f& GetBounds() const;
+    void            InvalidateBounds() { BoundsCurrent = false; }
+
     void ClearRenderer()
     {
         VertexBuffer.Clear();
@@ -565,6 +570,7 @@ public:
 		OVR_ASSERT(size <= USHRT_MAX);      // We only use a short to store vert indices.
 		uint16_t index = (uint16_t) size;
 		Vertices.PushBack(v);
+		BoundsCurrent = false;
 		return index;
     }
     uint16_t AddVertex(const Vector3f& v, const Color& c, float u_ = 0, float v_ = 0)
@@ -632,6 +638,10 @@ public:
     static Model* CreateGrid(Vector3f origin, Vector3f stepx, Vector3f stepy,
                              int halfx, int halfy, int nmajor = 5,
 							 Color minor = Color(64,64,64,192), Color major = Color(128,128,128,192));
+
+private:
+    mutable Bounds3f  Bounds;
+    mutable bool      BoundsCurrent;
 };
 
 class Container : public Node
@@ -664,6 +674,111 @@ public:
 	Container() : CollideChildren(1) {}
 };
 
+//-----------------------------------------------------------------------------------
+// ***** Frustum
+
+// Culling volume of an eye as six planes facing inwards, in the view space used by the
+// projection matrices: x right, y up, looking down -z.
+
+struct Frustum
+{
+    enum { PlaneCount = 6 };
+
+    enum TestResult
+    {
+        Test_Outside,
+        Test_Intersects,
+        Test_Inside
+    };
+
+    Planef Planes[PlaneCount];
+
+    Frustum() { }
+    Frustum(const FovPort& fov, float zNear, float zFar) { SetFromFov(fov, zNear, zFar); }
+
+    void SetFromFov(const FovPort& fov, float zNear, float zFar);
+
+    // Frustum of the view between two eyes that are ipd apart along x, containing the
+    // frustums of both; used to cull once for both eyes of a frame.
+    void SetFromStereoFov(const FovPort& leftFov, const FovPort& rightFov, float ipd,
+                          float zNear, float zFar);
+
+    // Returns the frustum in the space that m transforms into this one; for a view
+    // matrix, this is the world space frustum.
+    Frustum Transformed(const Matrix4f& m) const;
+
+    TestResult TestBounds(const Bounds3f& bounds) const;
+};
+
+// Draw counts of culled scene rendering, accumulated until Reset.
+struct CullStats
+{
+    int BoundsTested;   // Bounding boxes tested against the frustum
+    int Culled;         // Models skipped because they are outside the frustum
+    int Submitted;      // Nodes rendered
+
+    CullStats() { Reset(); }
+    void Reset() { BoundsTested = Culled = Submitted = 0; }
+};
+
+
+//-----------------------------------------------------------------------------------
+// ***** SceneBVH
+
+// Bounding volume hierarchy over the models under a container, for frustum culling.
+// It is a snapshot of the bounds and node matrices at Build time, so it has to be built
+// again after nodes are added or moved; the models' own matrices are still applied
+// when they are rendered.
+
+class SceneBVH
+{
+public:
+    struct Leaf
+    {
+        Ptr<Node>   pNode;
+        Matrix4f    ParentMatrix;   // Product of the container matrices above the node
+        Bounds3f    Bounds;         // In the space of the root container's parent
+        bool        Unbounded;      // Nodes other than models are never culled
+    };
+
+    SceneBVH() { }
+
+    void Build(Container* root);
+    void Clear();
+    bool IsEmpty() const { return Leaves.GetSize() == 0; }
+
+    // Replaces visible with the indices of the leaves that may be inside frustum,
+    // in the order the nodes appear under the root.
+    void Cull(const Frustum& frustum, ArrayPOD<uint32_t>& visible, CullStats* stats = NULL) const;
+
+    const Leaf& GetLeaf(uint32_t i) const { return Leaves[i]; }
+    size_t      GetLeafCount() const      { return Leaves.GetSize(); }
+
+private:
+    enum { MaxLeavesPerNode = 4 };
+
+    // The leaves under a node are the range First..First+Count of LeafOrder. Interior
+    // nodes have their left child next to them; Right is zero for leaf nodes.
+    struct BVHNode
+    {
+        Bounds3f    Bounds;
+        uint32_t    First;
+        uint32_t    Count;
+        uint32_t    Right;
+    };
+
+    void     addNode(Node* node, const Matrix4f& parentMatrix);
+    uint32_t buildNode(uint32_t first, uint32_t count, const Array<Vector3f>& centers);
+    void     cullNode(uint32_t index, const Frustum& frustum, bool inside,
+                      ArrayPOD<uint32_t>& visible, CullStats* stats) const;
+
+    Array<Leaf>         Leaves;
+    ArrayPOD<uint32_t>  LeafOrder;  // Leaves of each BVH node are consecutive here
+    ArrayPOD<uint32_t>  Unbounded;
+    Array<BVHNode>      Nodes;
+};
+
+
 class Scene
 {
 public:
@@ -672,9 +787,24 @@ public:
     LightingParams		Lighting;
 	Array<Ptr<Model> >	Models;
 
+    // Built from World on the first culled Render; call BuildBVH again after changing World.
+    SceneBVH            BVH;
+    ArrayPOD<uint32_t>  VisibleLeaves;
+    CullStats           Stats;
+
 public:
     void Render(RenderDevice* ren, const Matrix4f& view);
 
+    // Renders only the models that may be inside frustum, which is in view space.
+    void Render(RenderDevice* ren, const Matrix4f& view, const Frustum& frustum);
+
+    // Cull and RenderVisible split the above, so that one culling pass can be rendered for
+    // both eyes with a frustum from Frustum::SetFromStereoFov.
+    void Cull(const Matrix4f& view, const Frustum& frustum);
+    void RenderVisible(RenderDevice* ren, const Matrix4f& view);
+
+    void BuildBVH() { BVH.Build(&World); }
+
     void SetAmbient(Color4f color)
     {
         Lighting.Ambient = color;
@@ -692,6 +822,8 @@ public:
 	{
 		World.Clear();
 		Models.Clear();
+		BVH.Clear();
+		VisibleLeaves.Clear();
 		Lighting.Ambient = Color4f(0.0f, 0.0f, 0.0f, 0.0f);
 		Lighting.LightCount = 0;
 	}
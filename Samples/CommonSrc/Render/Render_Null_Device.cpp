@@ -0,0 +1,91 @@
+/************************************************************************************
+
+Filename    :   Render_Null_Device.cpp
+Content     :   RenderDevice implementation that draws nothing
+Created     :   October 17, 2014
+
+Copyright   :   Copyright 2014 Oculus VR, LLC. All Rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+************************************************************************************/
+
+#include "../Render/Render_Null_Device.h"
+
+namespace OVR { namespace Render { namespace Null {
+
+RenderDevice::RenderDevice(const RendererParams& p) :
+    DrawCount(0),
+    IndexCount(0)
+{
+    Params        = p;
+    WindowWidth   = p.Resolution.w;
+    WindowHeight  = p.Resolution.h;
+    VP            = Recti(0, 0, WindowWidth, WindowHeight);
+    DefaultFill   = *new ShaderFill(*CreateShaderSet());
+}
+
+ovrRenderAPIConfig RenderDevice::Get_ovrRenderAPIConfig() const
+{
+    ovrRenderAPIConfig config;
+    memset(&config, 0, sizeof(config));
+    config.Header.API            = ovrRenderAPI_None;
+    config.Header.BackBufferSize = Sizei(WindowWidth, WindowHeight);
+    config.Header.Multisample    = Params.Multisample;
+    return config;
+}
+
+void RenderDevice::Render(const Matrix4f& matrix, Model* model)
+{
+    OVR_UNUSED(matrix);
+    DrawCount++;
+    IndexCount += (int)model->Indices.GetSize();
+}
+
+void RenderDevice::Render(const Fill* fill, Render::Buffer* vertices, Render::Buffer* indices,
+                          const Matrix4f& matrix, int offset, int count, PrimitiveType prim, MeshType meshType)
+{
+    OVR_UNUSED5(fill, vertices, indices, matrix, offset);
+    OVR_UNUSED3(count, prim, meshType);
+    DrawCount++;
+}
+
+void RenderDevice::RenderWithAlpha(const Fill* fill, Render::Buffer* vertices, Render::Buffer* indices,
+                                   const Matrix4f& matrix, int offset, int count, PrimitiveType prim)
+{
+    OVR_UNUSED5(fill, vertices, indices, matrix, offset);
+    OVR_UNUSED2(count, prim);
+    DrawCount++;
+}
+
+void RenderDevice::RenderCompute(const Fill* fill, Render::Buffer* buffer, int invocationSizeInPixels)
+{
+    OVR_UNUSED3(fill, buffer, invocationSizeInPixels);
+}
+
+Fill* RenderDevice::CreateSimpleFill(int flags)
+{
+    OVR_UNUSED(flags);
+    return DefaultFill;
+}
+
+Shader* RenderDevice::LoadBuiltinShader(ShaderStage stage, int shader)
+{
+    OVR_ASSERT(stage < Shader_Count && shader < MaxBuiltinShaders);
+
+    if (!BuiltinShaders[stage][shader])
+        BuiltinShaders[stage][shader] = *new Shader(stage);
+    return BuiltinShaders[stage][shader];
+}
+
+}}}
@@ -0,0 +1,76 @@
+/************************************************************************************
+
+Filename    :   Render_Null_Device.h
+Content     :   RenderDevice implementation that draws nothing
+Created     :   October 17, 2014
+
+Copyright   :   Copyright 2014 Oculus VR, LLC. All Rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+************************************************************************************/
+
+#ifndef OVR_Render_Null_Device_h
+#define OVR_Render_Null_Device_h
+
+#include "../Render/Render_Device.h"
+
+namespace OVR { namespace Render { namespace Null {
+
+// Renderer without a GPU, for measuring the CPU side of scene traversal and for tools
+// that load scenes. Resources are placeholders; draws are only counted.
+
+class RenderDevice : public Render::RenderDevice
+{
+    enum { MaxBuiltinShaders = 16 };
+
+    Ptr<Shader>         BuiltinShaders[Shader_Count][MaxBuiltinShaders];
+    Ptr<ShaderFill>     DefaultFill;
+
+public:
+    int                 DrawCount;      // Draw calls since ResetCounters
+    int                 IndexCount;     // Indices of model draws
+
+    RenderDevice(const RendererParams& p);
+
+    void ResetCounters() { DrawCount = IndexCount = 0; }
+
+    virtual ovrRenderAPIConfig Get_ovrRenderAPIConfig() const;
+
+    virtual void SetViewport(const Recti& vp) { VP = vp; }
+    virtual void Clear(float r = 0, float g = 0, float b = 0, float a = 1, float depth = 1,
+                       bool clearColor = true, bool clearDepth = true)
+    { OVR_UNUSED5(r, g, b, a, depth); OVR_UNUSED2(clearColor, clearDepth); }
+    virtual void Rect(float left, float top, float right, float bottom) { OVR_UNUSED4(left, top, right, bottom); }
+
+    virtual void Present(bool withVsync) { OVR_UNUSED(withVsync); }
+    virtual void Flush() { }
+
+    virtual void SetDepthMode(bool enable, bool write, CompareFunc func = Compare_Less) { OVR_UNUSED3(enable, write, func); }
+    virtual void SetWorldUniforms(const Matrix4f& proj) { OVR_UNUSED(proj); }
+    virtual void SetLighting(const LightingParams* lt) { OVR_UNUSED(lt); }
+
+    virtual void Render(const Matrix4f& matrix, Model* model);
+    virtual void Render(const Fill* fill, Render::Buffer* vertices, Render::Buffer* indices,
+                        const Matrix4f& matrix, int offset, int count, PrimitiveType prim = Prim_Triangles, MeshType meshType = Mesh_Scene);
+    virtual void RenderWithAlpha(const Fill* fill, Render::Buffer* vertices, Render::Buffer* indices,
+                                 const Matrix4f& matrix, int offset, int count, PrimitiveType prim = Prim_Triangles);
+    virtual void RenderCompute(const Fill* fill, Render::Buffer* buffer, int invocationSizeInPixels);
+
+    virtual Fill*   CreateSimpleFill(int flags = Fill::F_Solid);
+    virtual Shader* LoadBuiltinShader(ShaderStage stage, int shader);
+};
+
+}}}
+
+#endif
@@ -53,7 +53,6 @@ bool XmlHandler::ReadFile(const char* fileName, OVR::Render::RenderDevice* pRend
 
     // Extract the relative path to our working directory for loading textures
     filePath[0] = 0;
-    intptr_t pos = 0;
 	intptr_t len = strlen(fileName);
     for(intptr_t i = len; i > 0; i--)
     {
@@ -77,34 +76,11 @@ bool XmlHandler::ReadFile(const char* fileName, OVR::Render::RenderDevice* pRend
 
     for(int i = 0; i < textureCount; ++i)
     {
-        const char* textureName = pXmlTexture->Attribute("fileName");
-		intptr_t    dotpos = strcspn(textureName, ".");
-        char        fname[300];
-
-		if (pos == len)
-		{            
-			OVR_sprintf(fname, 300, "%s", textureName);
-		}
-		else
-		{
-			OVR_sprintf(fname, 300, "%s%s", filePath, textureName);
-		}
-
-        SysFile* pFile = new SysFile(fname);
-		Ptr<Texture> texture;
-		if (textureName[dotpos + 1] == 'd' || textureName[dotpos + 1] == 'D')
-		{
-			// DDS file
-			texture.SetPtr(*LoadTextureDDS(pRender, pFile));
-		}
-		else
-		{
-			texture.SetPtr(*LoadTextureTga(pRender, pFile));
-		}
+        const char*  textureName = pXmlTexture->Attribute("fileName");
+        Ptr<Texture> texture     = *LoadTexture(pRender, filePath, textureName);
 
         Textures.PushBack(texture);
-		pFile->Close();
-		pFile->Release();
+        TextureFileNames.PushBack(textureName);
         pXmlTexture = pXmlTexture->NextSiblingElement("texture");
     }
 	OVR_DEBUG_LOG_TEXT(("Done.\n"));
@@ -196,26 +172,10 @@ bool XmlHandler::ReadFile(const char* fileName, OVR::Render::RenderDevice* pRend
         }
 
         //set up the shader
-        Ptr<ShaderFill> shader = *new ShaderFill(*pRender->CreateShaderSet());
-        shader->GetShaders()->SetShader(pRender->LoadBuiltinShader(Shader_Vertex, VShader_MVP));
-        if(diffuseTextureIndex > -1)
-        {
-            shader->SetTexture(0, Textures[diffuseTextureIndex]);
-            if(lightmapTextureIndex > -1)
-            {
-                shader->GetShaders()->SetShader(pRender->LoadBuiltinShader(Shader_Fragment, FShader_MultiTexture));
-                shader->SetTexture(1, Textures[lightmapTextureIndex]);
-            }
-            else
-            {
-                shader->GetShaders()->SetShader(pRender->LoadBuiltinShader(Shader_Fragment, FShader_Texture));
-            }
-        }
-        else
-        {
-            shader->GetShaders()->SetShader(pRender->LoadBuiltinShader(Shader_Fragment, FShader_LitGouraud));
-        }
+        Ptr<ShaderFill> shader = *CreateModelFill(pRender, Textures, diffuseTextureIndex, lightmapTextureIndex);
         Models[i]->Fill = shader;
+        DiffuseTextureIndices.PushBack(diffuseTextureIndex);
+        LightmapTextureIndices.PushBack(lightmapTextureIndex);
 
         //add all the vertices to the model
         const size_t numVerts = vertices->GetSize();
@@ -372,6 +332,56 @@ bool XmlHandler::ReadFile(const char* fileName, OVR::Render::RenderDevice* pRend
 	return true;
 }
 
+Texture* XmlHandler::LoadTexture(OVR::Render::RenderDevice* pRender, const char* path,
+                                 const char* fileName)
+{
+    intptr_t dotpos = strcspn(fileName, ".");
+    char     fname[300];
+    OVR_sprintf(fname, 300, "%s%s", path, fileName);
+
+    SysFile* pFile = new SysFile(fname);
+    Texture* texture;
+    if (fileName[dotpos + 1] == 'd' || fileName[dotpos + 1] == 'D')
+    {
+        // DDS file
+        texture = LoadTextureDDS(pRender, pFile);
+    }
+    else
+    {
+        texture = LoadTextureTga(pRender, pFile);
+    }
+
+    pFile->Close();
+    pFile->Release();
+    return texture;
+}
+
+ShaderFill* XmlHandler::CreateModelFill(OVR::Render::RenderDevice* pRender,
+                                        const OVR::Array<Ptr<Texture> >& textures,
+                                        int diffuseTextureIndex, int lightmapTextureIndex)
+{
+    ShaderFill* shader = new ShaderFill(*pRender->CreateShaderSet());
+    shader->GetShaders()->SetShader(pRender->LoadBuiltinShader(Shader_Vertex, VShader_MVP));
+    if(diffuseTextureIndex > -1)
+    {
+        shader->SetTexture(0, textures[diffuseTextureIndex]);
+        if(lightmapTextureIndex > -1)
+        {
+            shader->GetShaders()->SetShader(pRender->LoadBuiltinShader(Shader_Fragment, FShader_MultiTexture));
+            shader->SetTexture(1, textures[lightmapTextureIndex]);
+        }
+        else
+        {
+            shader->GetShaders()->SetShader(pRender->LoadBuiltinShader(Shader_Fragment, FShader_Texture));
+        }
+    }
+    else
+    {
+        shader->GetShaders()->SetShader(pRender->LoadBuiltinShader(Shader_Fragment, FShader_LitGouraud));
+    }
+    return shader;
+}
+
 void XmlHandler::ParseVectorString(const char* str, OVR::Array<OVR::Vector3f> *array,
 	                               bool is2element)
 {
@@ -46,6 +46,22 @@ public:
 		          OVR::Array<Ptr<CollisionModel> >* pColisions,
                   OVR::Array<Ptr<CollisionModel> >* pGroundCollisions);
 
+    // Contents of the last file read, for converting it to a binary scene.
+    int         GetTextureCount() const             { return (int)TextureFileNames.GetSize(); }
+    const char* GetTextureFileName(int i) const     { return TextureFileNames[i].ToCStr(); }
+    int         GetModelCount() const               { return (int)Models.GetSize(); }
+    Model*      GetModel(int i) const               { return Models[i]; }
+    int         GetDiffuseTextureIndex(int i) const  { return DiffuseTextureIndices[i]; }
+    int         GetLightmapTextureIndex(int i) const { return LightmapTextureIndices[i]; }
+
+    // Loads a scene texture; fileName is relative to the directory path, which may be empty.
+    static Texture*    LoadTexture(OVR::Render::RenderDevice* pRender, const char* path,
+                                   const char* fileName);
+    // Creates the fill of a scene model with the given textures, which are -1 if unused.
+    static ShaderFill* CreateModelFill(OVR::Render::RenderDevice* pRender,
+                                       const OVR::Array<Ptr<Texture> >& textures,
+                                       int diffuseTextureIndex, int lightmapTextureIndex);
+
 protected:
     void ParseVectorString(const char* str, OVR::Array<OVR::Vector3f> *array,
 		                   bool is2element = false);
@@ -55,8 +71,11 @@ private:
     char                   filePath[250];
     int                    textureCount;
     OVR::Array<Ptr<Texture> > Textures;
+    OVR::Array<String>     TextureFileNames;
     int                    modelCount;
     OVR::Array<Ptr<Model> > Models;
+    OVR::ArrayPOD<int>     DiffuseTextureIndices;
+    OVR::ArrayPOD<int>     LightmapTextureIndices;
     int                    collisionModelCount;
     int                    groundCollisionModelCount;
 };
@@ -98,6 +98,7 @@ OculusWorldDemoApp::OculusWorldDemoApp() :
     DynamicRezScalingEnabled(false),
 	EnableSensor(true),
     MonoscopicRender(false),
+    FrustumCullingEnabled(true),
     PositionTrackingScale(1.0f),
     ScaleAffectsEyeHeight(false),
     DesiredPixelDensity(1.0f),
@@ -447,6 +448,7 @@ void OculusWorldDemoApp::PopulateOptionMenu()
                  AddEnumValue("4-pixel RT-centered", Grid_Rendertarget4).
                  AddEnumValue("16-pixel RT-centered",Grid_Rendertarget16).
                  AddEnumValue("Lens-centered grid",  Grid_Lens);  
+    Menu.AddBool("Scene Content.Frustum Culling",   &FrustumCullingEnabled);
 
     // *** Scene Content Sub-Menu
     Menu.AddBool( "Render Target.Share RenderTarget",  &RendertargetIsSharedByBothEyes).
@@ -697,6 +699,8 @@ void OculusWorldDemoApp::CalculateHmdValues()
     // Calculate projections
     Projection[0] = ovrMatrix4f_Projection(EyeRenderDesc[0].Fov,  0.01f, 10000.0f, true);
     Projection[1] = ovrMatrix4f_Projection(EyeRenderDesc[1].Fov,  0.01f, 10000.0f, true);
+    EyeFrustum[0].SetFromFov(EyeRenderDesc[0].Fov, 0.01f, 10000.0f);
+    EyeFrustum[1].SetFromFov(EyeRenderDesc[1].Fov, 0.01f, 10000.0f);
 
     float    orthoDistance = 0.8f; // 2D is 0.8 meter from camera
     Vector2f orthoScale0   = Vector2f(1.0f) / Vector2f(EyeRenderDesc[0].PixelsPerTanAngleAtCenter);
@@ -1033,6 +1037,9 @@ void OculusWorldDemoApp::OnIdle()
 
         pRender->BeginScene(PostProcess_None);
 
+        MainSceneStats = MainScene.Stats;
+        MainScene.Stats.Reset();
+
         ovrTrackingState hmdState;
         ovrVector3f hmdToEyeViewOffset[2] = { EyeRenderDesc[0].HmdToEyeViewOffset, EyeRenderDesc[1].HmdToEyeViewOffset };
         ovrHmd_GetEyePoses(Hmd, 0, hmdToEyeViewOffset, EyeRenderPose, &hmdState);
@@ -1274,7 +1281,10 @@ void OculusWorldDemoApp::RenderEyeView(ovrEyeType eye)
     {
         if (SceneMode != Scene_OculusCubes)
         {
-            MainScene.Render(pRender, View);        
+            if (FrustumCullingEnabled)
+                MainScene.Render(pRender, View, EyeFrustum[eye]);
+            else
+                MainScene.Render(pRender, View);
             RenderAnimatedBlocks(eye, ovr_GetTimeInSeconds());
         }
 	    
@@ -1410,6 +1420,7 @@ void OculusWorldDemoApp::RenderTextInfoHud(float textHeight)
                     " Pos: %3.2f, %3.2f, %3.2f  HMD: %s\n"
                     " EyeHeight: %3.2f, IPD: %3.1fmm\n" //", Lens: %s\n"
                     " FOV %3.1fx%3.1f, Resolution: %ix%i\n"
+                    " Scene Draws: %d, Culled: %d\n"
                     "%s",
                     RadToDegree(hmdYaw), RadToDegree(hmdPitch), RadToDegree(hmdRoll),
                     RadToDegree(ThePlayer.BodyYaw.Get()),
@@ -1427,6 +1438,8 @@ void OculusWorldDemoApp::RenderTextInfoHud(float textHeight)
 
                     pixelSizeWidth, pixelSizeHeight,
 
+                    MainSceneStats.Submitted, MainSceneStats.Culled,
+
                     latency2Text
                     );
 
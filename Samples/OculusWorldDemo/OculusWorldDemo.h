@@ -29,7 +29,7 @@ limitations under the License.
 
 #include "../CommonSrc/Platform/Platform_Default.h"
 #include "../CommonSrc/Render/Render_Device.h"
-#include "../CommonSrc/Render/Render_XmlSceneLoader.h"
+#include "../CommonSrc/Render/Render_BinarySceneLoader.h"
 #include "../CommonSrc/Platform/Gamepad.h"
 #include "../CommonSrc/Util/OptionMenu.h"
 #include "../CommonSrc/Util/RenderProfiler.h"
@@ -211,6 +211,7 @@ protected:
     ovrEyeRenderDesc    EyeRenderDesc[2];
     Matrix4f            Projection[2];          // Projection matrix for eye.
     Matrix4f            OrthoProjection[2];     // Projection for 2D.
+    Frustum             EyeFrustum[2];          // Culling volume for eye, in view space.
     ovrPosef            EyeRenderPose[2];       // Poses we used for rendering.
     ovrTexture          EyeTexture[2];
     Sizei               EyeRenderSize[2];       // Saved render eye sizes; base for dynamic sizing.
@@ -253,6 +254,7 @@ protected:
     Player				ThePlayer;
     Matrix4f            View;
     Scene               MainScene;
+    CullStats           MainSceneStats;         // Culling of MainScene in the last rendered frame.
     Scene               LoadingScene;
     Scene               SmallGreenCube;
 
@@ -277,6 +279,7 @@ protected:
     bool                DynamicRezScalingEnabled;
 	bool                EnableSensor;
     bool                MonoscopicRender;
+    bool                FrustumCullingEnabled;
     float               PositionTrackingScale;
     bool                ScaleAffectsEyeHeight;
     float               DesiredPixelDensity;    
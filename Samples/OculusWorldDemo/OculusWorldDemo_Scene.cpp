@@ -119,14 +119,15 @@ Fill* CreateTextureFill(RenderDevice* prender, const String& filename)
 // Loads the scene data
 void OculusWorldDemoApp::PopulateScene(const char *fileName)
 {    
-    XmlHandler xmlHandler;         
-    if(!xmlHandler.ReadFile(fileName, pRender, &MainScene, &CollisionModels, &GroundCollisionModels))
+    // Uses the binary scene converted from the XML file by SceneConverter when it's there
+    if(!LoadScene(fileName, pRender, &MainScene, &CollisionModels, &GroundCollisionModels))
     {
         Menu.SetPopupMessage("FILE LOAD FAILED");
         Menu.SetPopupTimeout(10.0f, true);
     }    
 
     MainScene.SetAmbient(Color4f(1.0f, 1.0f, 1.0f, 1.0f));
+    MainScene.BuildBVH();
     
     // Handy cube.
     Ptr<Model> smallGreenCubeModel = *Model::CreateBox(Color(0, 255, 0, 255), Vector3f(0.0f, 0.0f, 0.0f), Vector3f(0.004f, 0.004f, 0.004f));
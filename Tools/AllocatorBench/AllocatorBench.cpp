@@ -0,0 +1,283 @@
+/************************************************************************************
+
+Filename    :   AllocatorBench.cpp
+Content     :   Compares PoolAllocator with DefaultAllocator on LibOVR workloads
+Created     :   October 17, 2014
+
+Copyright   :   Copyright 2014 Oculus VR, LLC All Rights reserved.
+
+Licensed under the Oculus VR Rift SDK License Version 3.2 (the "License");
+you may not use the Oculus VR Rift SDK except in compliance with the License,
+which is provided at the time of installation or download, or which
+otherwise accompanies this software in either electronic or hard copy form.
+
+You may obtain a copy of the License at
+
+http://www.oculusvr.com/licenses/LICENSE-3.2
+
+Unless required by applicable law or agreed to in writing, the Oculus VR SDK
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+************************************************************************************/
+
+// Built by the AllocatorBench project under Tools in the Samples solution.
+// Usage:
+//
+//   AllocatorBench [-threads <count>] [-iterations <count>]
+//
+// Each workload is run with System initialized with DefaultAllocator and then with
+// PoolAllocator, on the given number of threads at once (1 by default):
+//
+//   JSON    parses and releases a profile database of 100 users
+//   String  builds, copies, appends to and splits short Strings
+//   Array   grows Arrays of ints and of Strings by PushBack
+//
+// The best time of several runs is printed for each, followed by the PoolAllocator
+// statistics after the workload: bytes in use and reserved, and the size classes with
+// the highest allocation rates.
+
+#include "Kernel/OVR_System.h"
+#include "Kernel/OVR_Timer.h"
+#include "Kernel/OVR_Threads.h"
+#include "Kernel/OVR_String.h"
+#include "Kernel/OVR_Array.h"
+#include "Kernel/OVR_PoolAllocator.h"
+#include "OVR_JSON.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+using namespace OVR;
+
+static const int Repeats = 5;
+
+typedef double (*WorkloadFn)(const char* jsonText, int iterations);
+
+// Profile database text in the layout of ProfileManager's ProfileDB.json.
+static void BuildProfileText(StringBuffer& text, int userCount)
+{
+    text.AppendString("{\"Oculus Profile Version\":2,\"Users\":[");
+    for (int u = 0; u < userCount; u++)
+        text.AppendFormat("%s{\"User\":\"User%d\",\"Name\":\"User%d\"}", u ? "," : "", u, u);
+
+    text.AppendString("],\"TaggedData\":[");
+    for (int u = 0; u < userCount; u++)
+    {
+        text.AppendFormat("%s{\"tags\":[{\"User\":\"User%d\"},{\"Product\":\"RiftDK2\"}],\"vals\":{", u ? "," : "", u);
+        for (int v = 0; v < 24; v++)
+            text.AppendFormat("%s\"Value%d\":%d.5", v ? "," : "", v, u * 100 + v);
+        text.AppendString(",\"EyeToNose\":[0.032,0.032],\"Gender\":\"Male\"}}");
+    }
+    text.AppendString("]}");
+}
+
+static double RunJSON(const char* jsonText, int iterations)
+{
+    double sum = 0;
+    for (int i = 0; i < iterations / 500; i++)
+    {
+        JSON* json = JSON::Parse(jsonText);
+        if (json)
+        {
+            sum += json->GetItemByName("Users")->GetArraySize();
+            json->Release();
+        }
+    }
+    return sum;
+}
+
+static double RunString(const char* jsonText, int iterations)
+{
+    OVR_UNUSED(jsonText);
+
+    double sum = 0;
+    char   number[32];
+    for (int i = 0; i < iterations * 10; i++)
+    {
+        OVR_sprintf(number, sizeof(number), "%d", i);
+
+        String name = "Device";
+        name += number;
+        String path = String("/dev/oculus/") + name + "/pose";
+        String copy = path;
+        copy.AppendString("?latest");
+
+        String left = copy.Substring(0, 12);
+        String ext  = copy.Substring(12, copy.GetLength());
+        sum += (double)(left.GetSize() + ext.GetSize());
+    }
+    return sum;
+}
+
+static double RunArray(const char* jsonText, int iterations)
+{
+    OVR_UNUSED(jsonText);
+
+    double sum = 0;
+    for (int i = 0; i < iterations / 2; i++)
+    {
+        Array<int> values;
+        for (int k = 0; k < 500; k++)
+            values.PushBack(k);
+
+        Array<String> names;
+        for (int k = 0; k < 20; k++)
+            names.PushBack(String("Item"));
+
+        sum += (double)(values.GetSize() + names.GetSize());
+    }
+    return sum;
+}
+
+class WorkloadThread : public Thread
+{
+public:
+    WorkloadThread(WorkloadFn workload, const char* jsonText, int iterations) :
+        Workload(workload), JSONText(jsonText), Iterations(iterations), Result(0) { }
+
+    virtual int Run()
+    {
+        Result = Workload(JSONText, Iterations);
+        return 0;
+    }
+
+    WorkloadFn  Workload;
+    const char* JSONText;
+    int         Iterations;
+    double      Result;
+};
+
+// Best time of Repeats runs of the workload on threadCount threads at once.
+static double TimeWorkload(WorkloadFn workload, const char* jsonText, int iterations, int threadCount)
+{
+    double best = 1e30;
+    for (int r = 0; r < Repeats; r++)
+    {
+        Array<Ptr<WorkloadThread> > threads;
+        for (int t = 0; t < threadCount; t++)
+            threads.PushBack(*new WorkloadThread(workload, jsonText, iterations));
+
+        double start = Timer::GetSeconds();
+        for (int t = 0; t < threadCount; t++)
+            threads[t]->Start();
+        for (int t = 0; t < threadCount; t++)
+            threads[t]->Join();
+        double elapsed = Timer::GetSeconds() - start;
+
+        if (elapsed < best)
+            best = elapsed;
+    }
+    return best;
+}
+
+static void PrintPoolStats(PoolAllocator* pool, const PoolAllocatorStats& before)
+{
+    PoolAllocatorStats stats;
+    pool->GetStats(&stats);
+
+    printf("    in use %.1f KB, reserved %.1f KB, %llu large allocations\n",
+           stats.BytesInUse / 1024.0, stats.BytesReserved / 1024.0, (unsigned long long)stats.LargeAllocs);
+
+    // The three busiest size classes
+    bool shown[PoolAllocatorStats::MaxSizeClasses] = { false };
+    for (int n = 0; n < 3; n++)
+    {
+        int    busiest = -1;
+        double rate    = 0;
+        for (int i = 0; i < stats.SizeClassCount; i++)
+        {
+            double classRate = stats.GetAllocRate(before, i);
+            if (!shown[i] && classRate > rate)
+            {
+                busiest = i;
+                rate    = classRate;
+            }
+        }
+        if (busiest < 0)
+            break;
+
+        shown[busiest] = true;
+        printf("    %4d byte blocks: %.2f M allocations/s, %.1f KB reserved\n",
+               (int)stats.SizeClasses[busiest].BlockSize, rate / 1e6,
+               stats.SizeClasses[busiest].BytesReserved / 1024.0);
+    }
+}
+
+static int RunBenchmark(int threadCount, int iterations)
+{
+    static const char*      names[]     = { "JSON", "String", "Array" };
+    static const WorkloadFn workloads[] = { RunJSON, RunString, RunArray };
+    const int               count       = sizeof(workloads) / sizeof(workloads[0]);
+
+    double defaultTimes[count];
+
+    printf("%d thread(s), %d iterations\n\n", threadCount, iterations);
+
+    // Each allocator gets its own System, and its own copy of the text
+    for (int pass = 0; pass < 2; pass++)
+    {
+        PoolAllocator* pool = (pass == 1) ? PoolAllocator::InitSystemSingleton() : NULL;
+        if (pool)
+            System::Init(Log::ConfigureDefaultLog(), pool);
+        else
+            System::Init();
+
+        {
+            StringBuffer jsonText;
+            BuildProfileText(jsonText, 100);
+
+            for (int w = 0; w < count; w++)
+            {
+                PoolAllocatorStats before;
+                if (pool)
+                    pool->GetStats(&before);
+
+                double seconds = TimeWorkload(workloads[w], jsonText.ToCStr(), iterations, threadCount);
+
+                if (!pool)
+                {
+                    defaultTimes[w] = seconds;
+                    continue;
+                }
+
+                printf("%-8s default %9.3f ms   pool %9.3f ms   %5.2fx\n", names[w],
+                       defaultTimes[w] * 1000.0, seconds * 1000.0, defaultTimes[w] / seconds);
+                PrintPoolStats(pool, before);
+            }
+        }
+
+        System::Destroy();
+    }
+    return 0;
+}
+
+int main(int argc, char** argv)
+{
+    int threadCount = 1;
+    int iterations  = 100000;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (i + 1 < argc && strcmp(argv[i], "-threads") == 0)
+            threadCount = atoi(argv[++i]);
+        else if (i + 1 < argc && strcmp(argv[i], "-iterations") == 0)
+            iterations = atoi(argv[++i]);
+        else
+        {
+            fprintf(stderr, "Usage: %s [-threads <count>] [-iterations <count>]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    if (threadCount < 1 || iterations < 500)
+    {
+        fprintf(stderr, "Need at least one thread and 500 iterations\n");
+        return 1;
+    }
+
+    return RunBenchmark(threadCount, iterations);
+}
@@ -0,0 +1,68 @@
+/************************************************************************************
+
+Filename    :   FrameTimeTraceToChrome.cpp
+Content     :   Converts frame timing traces recorded by ovrHmd_StartFrameTimeTrace
+                into Chrome trace event JSON, for viewing in chrome://tracing
+Created     :   October 17, 2014
+
+Copyright   :   Copyright 2014 Oculus VR, LLC All Rights reserved.
+
+Licensed under the Oculus VR Rift SDK License Version 3.2 (the "License");
+you may not use the Oculus VR Rift SDK except in compliance with the License,
+which is provided at the time of installation or download, or which
+otherwise accompanies this software in either electronic or hard copy form.
+
+You may obtain a copy of the License at
+
+http://www.oculusvr.com/licenses/LICENSE-3.2
+
+Unless required by applicable law or agreed to in writing, the Oculus VR SDK
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+************************************************************************************/
+
+// Built by the FrameTimeTraceToChrome project under Tools in the Samples solution.
+// Usage:
+//
+//   FrameTimeTraceToChrome <trace file> [output.json]
+//
+// The output defaults to the trace file name with ".json" appended.
+
+#include "Kernel/OVR_System.h"
+#include "CAPI/CAPI_FrameTimeTrace.h"
+
+#include <stdio.h>
+
+int main(int argc, char** argv)
+{
+    if (argc < 2 || argc > 3)
+    {
+        fprintf(stderr, "Usage: %s <trace file> [output.json]\n", argv[0]);
+        return 1;
+    }
+
+    OVR::System::Init();
+
+    OVR::String outputPath;
+    if (argc == 3)
+    {
+        outputPath = argv[2];
+    }
+    else
+    {
+        outputPath = argv[1];
+        outputPath.AppendString(".json");
+    }
+
+    bool converted = OVR::CAPI::ConvertFrameTimeTraceToChromeJSON(argv[1], outputPath.ToCStr());
+    if (converted)
+        printf("Wrote %s\n", outputPath.ToCStr());
+    else
+        fprintf(stderr, "Unable to convert %s: not a frame timing trace, or output not writable\n", argv[1]);
+
+    OVR::System::Destroy();
+    return converted ? 0 : 1;
+}
@@ -0,0 +1,102 @@
+/************************************************************************************
+
+Filename    :   TimewarpWaitSimulator.cpp
+Content     :   Replays distortion render times from a frame timing trace through the
+                timewarp wait scheduler and reports miss rate against added latency
+Created     :   October 17, 2014
+
+Copyright   :   Copyright 2014 Oculus VR, LLC All Rights reserved.
+
+Licensed under the Oculus VR Rift SDK License Version 3.2 (the "License");
+you may not use the Oculus VR Rift SDK except in compliance with the License,
+which is provided at the time of installation or download, or which
+otherwise accompanies this software in either electronic or hard copy form.
+
+You may obtain a copy of the License at
+
+http://www.oculusvr.com/licenses/LICENSE-3.2
+
+Unless required by applicable law or agreed to in writing, the Oculus VR SDK
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+************************************************************************************/
+
+// Built by the TimewarpWaitSimulator project under Tools in the Samples solution.
+// Usage:
+//
+//   TimewarpWaitSimulator <trace file> [safety margin ms]
+//
+// The trace must have been recorded with SDK distortion rendering, so that it contains
+// distortion time measurements. The measurements are replayed in order as if every frame
+// took that long, for a range of miss probability targets.
+
+#include "Kernel/OVR_System.h"
+#include "CAPI/CAPI_FrameTimeTrace.h"
+#include "Util/Util_Render_Stereo.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+using namespace OVR;
+
+int main(int argc, char** argv)
+{
+    if (argc < 2 || argc > 3)
+    {
+        fprintf(stderr, "Usage: %s <trace file> [safety margin ms]\n", argv[0]);
+        return 1;
+    }
+
+    float safetyMargin = (argc == 3) ? (float)atof(argv[2]) * 0.001f : 0.002f;
+
+    System::Init();
+    int result = 0;
+    {
+        Array<CAPI::FrameTimeTraceRecord> records;
+        Array<float>                      distortionTimes;
+
+        if (!CAPI::LoadFrameTimeTrace(argv[1], records))
+        {
+            fprintf(stderr, "Unable to read frame timing trace %s\n", argv[1]);
+            result = 1;
+        }
+        else
+        {
+            for (size_t i = 0; i < records.GetSize(); i++)
+            {
+                if (records[i].Type == CAPI::FrameTimeTrace_DistortionTime)
+                    distortionTimes.PushBack((float)records[i].Values[0]);
+            }
+        }
+
+        if (result == 0 && distortionTimes.GetSize() <= Util::Render::TimewarpWaitScheduler::WindowSize)
+        {
+            fprintf(stderr, "%s has %d distortion time measurements; more than %d are needed\n",
+                    argv[1], (int)distortionTimes.GetSize(), (int)Util::Render::TimewarpWaitScheduler::WindowSize);
+            result = 1;
+        }
+
+        if (result == 0)
+        {
+            static const float targets[] = { 0.2f, 0.1f, 0.05f, 0.02f, 0.01f, 0.005f, 0.001f, 0.0f };
+
+            printf("%d frames, safety margin %.2f ms\n\n", (int)distortionTimes.GetSize(), safetyMargin * 1000.0f);
+            printf("  target miss   miss rate   mean lead ms   max lead ms\n");
+
+            for (size_t i = 0; i < sizeof(targets) / sizeof(targets[0]); i++)
+            {
+                Util::Render::TimewarpWaitSimulationResult r =
+                    Util::Render::SimulateTimewarpWaitScheduling(&distortionTimes[0], (int)distortionTimes.GetSize(),
+                                                                 targets[i], safetyMargin);
+
+                printf("  %10.2f%%  %9.3f%%   %12.3f   %11.3f\n",
+                       targets[i] * 100.0f, r.MissRate * 100.0, r.MeanLeadTime * 1000.0, r.MaxLeadTime * 1000.0);
+            }
+        }
+    }
+    System::Destroy();
+    return result;
+}
@@ -0,0 +1,315 @@
+/************************************************************************************
+
+Filename    :   JSONDocumentBenchmark.cpp
+Content     :   Compares JSON and JSONDocument load and lookup times on a profile database
+Created     :   October 17, 2014
+
+Copyright   :   Copyright 2014 Oculus VR, LLC All Rights reserved.
+
+Licensed under the Oculus VR Rift SDK License Version 3.2 (the "License");
+you may not use the Oculus VR Rift SDK except in compliance with the License,
+which is provided at the time of installation or download, or which
+otherwise accompanies this software in either electronic or hard copy form.
+
+You may obtain a copy of the License at
+
+http://www.oculusvr.com/licenses/LICENSE-3.2
+
+Unless required by applicable law or agreed to in writing, the Oculus VR SDK
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+************************************************************************************/
+
+// Built by the JSONDocumentBenchmark project under Tools in the Samples solution.
+// Usage:
+//
+//   JSONDocumentBenchmark [ProfileDB.json | -users <count>]
+//
+// Without a file, a database with 500 users is generated, each with a user entry,
+// per-user tagged data and per-user-and-product tagged data like ProfileManager writes.
+// Parse, lookup and release are timed for both the JSON tree and JSONDocument, and the
+// lookups are checked to find the same values.
+
+#include "Kernel/OVR_System.h"
+#include "Kernel/OVR_Timer.h"
+#include "Kernel/OVR_SysFile.h"
+#include "OVR_JSON.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+using namespace OVR;
+
+static const char* ProductNames[] = { "RiftDK1", "RiftDKHD", "RiftDK2" };
+static const int   ProductCount   = 3;
+static const int   ValueCount     = 24;
+static const int   Repeats        = 5;
+
+// Builds a profile database in the layout of ProfileManager's ProfileDB.json.
+static JSON* GenerateProfileDB(int userCount)
+{
+    JSON* root = JSON::CreateObject();
+    root->AddNumberItem("Oculus Profile Version", 2.0);
+
+    JSON* users = JSON::CreateArray();
+    JSON* tagged = JSON::CreateArray();
+    root->AddItem("Users", users);
+    root->AddItem("TaggedData", tagged);
+
+    char name[64], key[64];
+    for (int u = 0; u < userCount; u++)
+    {
+        OVR_sprintf(name, sizeof(name), "User%d", u);
+
+        JSON* user = JSON::CreateObject();
+        user->AddStringItem("User", name);
+        user->AddStringItem("Name", name);
+        users->AddArrayElement(user);
+
+        for (int p = -1; p < ProductCount; p++)
+        {
+            JSON* item = JSON::CreateObject();
+            JSON* tags = JSON::CreateArray();
+            JSON* vals = JSON::CreateObject();
+
+            JSON* userTag = JSON::CreateObject();
+            userTag->AddStringItem("User", name);
+            tags->AddArrayElement(userTag);
+            if (p >= 0)
+            {
+                JSON* productTag = JSON::CreateObject();
+                productTag->AddStringItem("Product", ProductNames[p]);
+                tags->AddArrayElement(productTag);
+            }
+
+            for (int v = 0; v < ValueCount; v++)
+            {
+                OVR_sprintf(key, sizeof(key), "Value%d", v);
+                vals->AddNumberItem(key, u * 1000 + (p + 1) * 100 + v + 0.5);
+            }
+            JSON* ipd = JSON::CreateArray();
+            ipd->AddArrayNumber(0.032);
+            ipd->AddArrayNumber(0.032);
+            vals->AddItem("EyeToNose", ipd);
+            vals->AddStringItem("Gender", (u & 1) ? "Female" : "Male");
+
+            item->AddItem("tags", tags);
+            item->AddItem("vals", vals);
+            tagged->AddArrayElement(item);
+        }
+    }
+    return root;
+}
+
+// The lookups below follow FindTaggedData in OVR_Profile.cpp: find the tagged item whose
+// tags match every query tag, then read values from it by name.
+template<class Node>
+static Node* FindTagged(Node* data, const char** tagNames, const char** tags, int tagCount)
+{
+    for (Node* item = data->GetFirstItem(); item; item = data->GetNextItem(item))
+    {
+        Node* itemTags = item->GetItemByName("tags");
+        if (!itemTags || itemTags->GetArraySize() != tagCount)
+            continue;
+
+        int matches = 0;
+        for (int k = 0; k < tagCount; k++)
+        {
+            for (Node* tag = itemTags->GetFirstItem(); tag; tag = itemTags->GetNextItem(tag))
+            {
+                Node* tagval = tag->GetFirstItem();
+                if (tagval && strcmp(tagval->Name, tagNames[k]) == 0)
+                {
+                    if (strcmp(tagval->Value, tags[k]) == 0)
+                        matches++;
+                    break;
+                }
+            }
+        }
+        if (matches == tagCount)
+            return item->GetItemByName("vals");
+    }
+    return 0;
+}
+
+// Looks up every user by name, then each of its values for every product.
+// Returns the sum of the values found, to compare the two implementations.
+template<class Node>
+static double RunLookups(Node* root, int userCount)
+{
+    const char* tagNames[2] = { "User", "Product" };
+    const char* tags[2];
+    char        name[64], key[64];
+    double      sum = 0;
+
+    Node* users  = root->GetItemByName("Users");
+    Node* tagged = root->GetItemByName("TaggedData");
+    if (!users || !tagged)
+        return 0;
+
+    for (int u = 0; u < userCount; u++)
+    {
+        OVR_sprintf(name, sizeof(name), "User%d", (u * 7919) % userCount);
+
+        for (Node* user = users->GetFirstItem(); user; user = users->GetNextItem(user))
+        {
+            Node* id = user->GetItemByName("User");
+            if (id && strcmp(id->Value, name) == 0)
+            {
+                sum += 1;
+                break;
+            }
+        }
+
+        tags[0] = name;
+        for (int p = 0; p < ProductCount; p++)
+        {
+            tags[1] = ProductNames[p];
+            Node* vals = FindTagged(tagged, tagNames, tags, 2);
+            if (!vals)
+                continue;
+
+            for (int v = 0; v < ValueCount; v++)
+            {
+                OVR_sprintf(key, sizeof(key), "Value%d", v);
+                sum += vals->GetNumberByName(key);
+            }
+            Node* ipd = vals->GetItemByName("EyeToNose");
+            if (ipd)
+                sum += ipd->GetArrayNumber(1);
+        }
+    }
+    return sum;
+}
+
+static char* ReadFile(const char* path)
+{
+    SysFile f;
+    if (!f.Open(path, File::Open_Read, File::Mode_Read))
+        return 0;
+
+    int   len  = f.GetLength();
+    char* text = (char*)OVR_ALLOC(len + 1);
+    int   read = f.Read((uint8_t*)text, len);
+    f.Close();
+    if (read != len)
+    {
+        OVR_FREE(text);
+        return 0;
+    }
+    text[len] = 0;
+    return text;
+}
+
+static void PrintRow(const char* step, double jsonSeconds, double docSeconds)
+{
+    printf("%-10s %12.3f %14.3f %9.1fx\n", step, jsonSeconds * 1000.0, docSeconds * 1000.0,
+           docSeconds > 0 ? jsonSeconds / docSeconds : 0.0);
+}
+
+int main(int argc, char** argv)
+{
+    System::Init();
+
+    int   userCount = 500;
+    char* text      = 0;
+
+    if (argc == 3 && strcmp(argv[1], "-users") == 0)
+    {
+        userCount = atoi(argv[2]);
+    }
+    else if (argc == 2)
+    {
+        text = ReadFile(argv[1]);
+        if (!text)
+        {
+            fprintf(stderr, "Unable to read %s\n", argv[1]);
+            System::Destroy();
+            return 1;
+        }
+    }
+    else if (argc != 1)
+    {
+        fprintf(stderr, "Usage: %s [ProfileDB.json | -users <count>]\n", argv[0]);
+        System::Destroy();
+        return 1;
+    }
+
+    if (!text)
+    {
+        JSON* generated = GenerateProfileDB(userCount);
+        String path     = "JSONDocumentBenchmark.json";
+        generated->Save(path);
+        generated->Release();
+        text = ReadFile(path);
+    }
+    else
+    {   // Count the users of the loaded database for the lookups.
+        JSON* json  = JSON::Parse(text);
+        JSON* users = json ? json->GetItemByName("Users") : 0;
+        userCount   = users ? users->GetArraySize() : 0;
+        if (json)
+            json->Release();
+    }
+
+    if (!text)
+    {
+        fprintf(stderr, "Unable to write the generated database\n");
+        System::Destroy();
+        return 1;
+    }
+
+    // Best of several runs of each step.
+    double best[2][3] = { { 1e9, 1e9, 1e9 }, { 1e9, 1e9, 1e9 } };
+    double sums[2]    = { 0, 0 };
+    size_t docBytes   = 0;
+
+    for (int r = 0; r < Repeats; r++)
+    {
+        double t0   = Timer::GetSeconds();
+        JSON*  json = JSON::Parse(text);
+        double t1   = Timer::GetSeconds();
+        sums[0]     = json ? RunLookups(json, userCount) : 0;
+        double t2   = Timer::GetSeconds();
+        if (json)
+            json->Release();
+        double t3   = Timer::GetSeconds();
+
+        best[0][0] = Alg::Min(best[0][0], t1 - t0);
+        best[0][1] = Alg::Min(best[0][1], t2 - t1);
+        best[0][2] = Alg::Min(best[0][2], t3 - t2);
+
+        t0                 = Timer::GetSeconds();
+        JSONDocument* doc  = JSONDocument::Parse(text);
+        t1                 = Timer::GetSeconds();
+        sums[1]            = (doc && doc->GetRoot()) ? RunLookups(doc->GetRoot(), userCount) : 0;
+        t2                 = Timer::GetSeconds();
+        docBytes           = doc ? doc->GetBytesReserved() : 0;
+        if (doc)
+            doc->Release();
+        t3                 = Timer::GetSeconds();
+
+        best[1][0] = Alg::Min(best[1][0], t1 - t0);
+        best[1][1] = Alg::Min(best[1][1], t2 - t1);
+        best[1][2] = Alg::Min(best[1][2], t3 - t2);
+    }
+
+    printf("%d users, %d bytes of JSON, document arena %d bytes\n\n",
+           userCount, (int)OVR_strlen(text), (int)docBytes);
+    printf("%-10s %12s %14s %10s\n", "Step", "JSON (ms)", "Document (ms)", "Speedup");
+    PrintRow("Parse",   best[0][0], best[1][0]);
+    PrintRow("Lookups", best[0][1], best[1][1]);
+    PrintRow("Release", best[0][2], best[1][2]);
+
+    bool match = (sums[0] == sums[1]);
+    if (!match)
+        fprintf(stderr, "\nLookup results differ: %f vs %f\n", sums[0], sums[1]);
+
+    OVR_FREE(text);
+    System::Destroy();
+    return match ? 0 : 1;
+}
@@ -0,0 +1,208 @@
+/************************************************************************************
+
+Filename    :   PoseStream.cpp
+Content     :   Records the shared sensor state stream and replays it without hardware
+Created     :   October 17, 2014
+
+Copyright   :   Copyright 2014 Oculus VR, LLC All Rights reserved.
+
+Licensed under the Oculus VR Rift SDK License Version 3.2 (the "License");
+you may not use the Oculus VR Rift SDK except in compliance with the License,
+which is provided at the time of installation or download, or which
+otherwise accompanies this software in either electronic or hard copy form.
+
+You may obtain a copy of the License at
+
+http://www.oculusvr.com/licenses/LICENSE-3.2
+
+Unless required by applicable law or agreed to in writing, the Oculus VR SDK
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+************************************************************************************/
+
+// Built by the PoseStream project under Tools in the Samples solution.
+// Usage:
+//
+//   PoseStream record <shared memory name> <stream file> [seconds]
+//   PoseStream replay <stream file> <shared memory name> [-speed <factor>] [-loop]
+//   PoseStream info <stream file>
+//
+// record reads the regions the tracking service publishes under the given name, which
+// is the SharedMemoryName it reports to clients. replay creates those regions and
+// publishes the stream into them in place of the service, so readers can be run and
+// benchmarked on machines without an HMD. A speed of 0 publishes as fast as possible.
+
+#include "Kernel/OVR_System.h"
+#include "Kernel/OVR_Timer.h"
+#include "Kernel/OVR_Threads.h"
+#include "Kernel/OVR_Alg.h"
+#include "Tracking/Tracking_PoseStream.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+using namespace OVR;
+using namespace OVR::Tracking;
+
+static int RecordStream(const char* sharedMemoryName, const char* path, double seconds)
+{
+    CombinedSharedStateReader stateReader;
+    SensorStateHistoryReader  historyReader;
+    if (!stateReader.Open(sharedMemoryName))
+    {
+        fprintf(stderr, "Unable to open shared memory %s\n", sharedMemoryName);
+        return 1;
+    }
+
+    String historyName = String(sharedMemoryName) + SensorStateHistoryNameSuffix;
+    const SensorStateHistoryUpdater* history = historyReader.Open(historyName.ToCStr()) ? historyReader.Get() : NULL;
+    if (!history)
+        printf("No pose history is published; only states seen by polling are recorded.\n");
+
+    PoseStreamRecorder recorder;
+    if (!recorder.Start(path))
+    {
+        fprintf(stderr, "Unable to create %s\n", path);
+        return 1;
+    }
+
+    // The history holds a quarter second at 1 kHz, so polling every millisecond loses nothing
+    double endTime = Timer::GetSeconds() + seconds;
+    while (Timer::GetSeconds() < endTime)
+    {
+        recorder.Poll(stateReader.Get(), history);
+        Thread::MSleep(1);
+    }
+
+    uint32_t recorded = recorder.GetRecordCount();
+    uint32_t lost     = recorder.GetLostCount();
+    if (!recorder.Stop())
+    {
+        fprintf(stderr, "Unable to write %s\n", path);
+        return 1;
+    }
+
+    printf("Recorded %u states, %u lost\n", recorded, lost);
+    return 0;
+}
+
+static int ReplayStream(const char* path, const char* sharedMemoryName, double speed, bool loop)
+{
+    PoseStreamPlayer player;
+    if (!player.Load(path))
+    {
+        fprintf(stderr, "Unable to read %s\n", path);
+        return 1;
+    }
+
+    PoseStreamPublisher publisher;
+    if (!publisher.Open(sharedMemoryName))
+    {
+        fprintf(stderr, "Unable to create shared memory %s\n", sharedMemoryName);
+        return 1;
+    }
+
+    printf("Replaying %d states to %s%s\n", (int)player.GetRecords().GetSize(), sharedMemoryName,
+           publisher.HasHistory() ? " with history" : "");
+
+    double   startTime = Timer::GetSeconds();
+    double   maxLate   = 0.0;
+    uint64_t published = 0;
+
+    player.Start(startTime, speed, loop);
+    while (!player.IsFinished())
+    {
+        // Sleep while the next state is more than a couple of milliseconds away, then spin
+        double now  = Timer::GetSeconds();
+        double wait = player.GetNextTime() - now;
+        if (wait > 0.002)
+        {
+            Thread::MSleep(1);
+            continue;
+        }
+        if (wait > 0.0)
+            continue;
+
+        if (speed > 0.0)
+            maxLate = Alg::Max(maxLate, -wait);
+        published += player.Update(publisher, now);
+    }
+
+    double elapsed = Timer::GetSeconds() - startTime;
+    printf("Published %llu states in %.3f s (%.0f/s), at most %.3f ms late\n", (unsigned long long)published,
+           elapsed, elapsed > 0.0 ? published / elapsed : 0.0, maxLate * 1000.0);
+    return 0;
+}
+
+static int PrintStreamInfo(const char* path)
+{
+    PoseStreamPlayer player;
+    if (!player.Load(path))
+    {
+        fprintf(stderr, "Unable to read %s\n", path);
+        return 1;
+    }
+
+    const Array<PoseStreamRecord>& records = player.GetRecords();
+    size_t   count = records.GetSize();
+    uint64_t lost  = 0;
+    double   maxInterval = 0.0;
+    for (size_t i = 0; i < count; i++)
+    {
+        lost += records[i].Lost;
+        if (i > 0)
+            maxInterval = Alg::Max(maxInterval, records[i].Time - records[i - 1].Time);
+    }
+
+    double span = (count >= 2) ? records[count - 1].Time - records[0].Time : 0.0;
+    printf("%d states over %.3f s (%.0f/s), %llu lost, longest interval %.3f ms\n", (int)count, span,
+           span > 0.0 ? (count - 1) / span : 0.0, (unsigned long long)lost, maxInterval * 1000.0);
+    return 0;
+}
+
+static int Usage(const char* program)
+{
+    fprintf(stderr, "Usage: %s record <shared memory name> <stream file> [seconds]\n"
+                    "       %s replay <stream file> <shared memory name> [-speed <factor>] [-loop]\n"
+                    "       %s info <stream file>\n", program, program, program);
+    return 1;
+}
+
+static int RunPoseStream(int argc, char** argv)
+{
+    if (argc >= 4 && argc <= 5 && strcmp(argv[1], "record") == 0)
+        return RecordStream(argv[2], argv[3], (argc == 5) ? atof(argv[4]) : 10.0);
+
+    if (argc == 3 && strcmp(argv[1], "info") == 0)
+        return PrintStreamInfo(argv[2]);
+
+    if (argc >= 4 && strcmp(argv[1], "replay") == 0)
+    {
+        double speed = 1.0;
+        bool   loop  = false;
+        for (int i = 4; i < argc; i++)
+        {
+            if (strcmp(argv[i], "-speed") == 0 && i + 1 < argc)
+                speed = atof(argv[++i]);
+            else if (strcmp(argv[i], "-loop") == 0)
+                loop = true;
+            else
+                return Usage(argv[0]);
+        }
+        return ReplayStream(argv[2], argv[3], speed, loop);
+    }
+
+    return Usage(argv[0]);
+}
+
+int main(int argc, char** argv)
+{
+    System::Init();
+    int result = RunPoseStream(argc, argv);
+    System::Destroy();
+    return result;
+}
@@ -0,0 +1,218 @@
+/************************************************************************************
+
+Filename    :   PredictionBench.cpp
+Content     :   Measures the accuracy and cost of pose prediction filters on pose streams
+Created     :   October 17, 2014
+
+Copyright   :   Copyright 2014 Oculus VR, LLC All Rights reserved.
+
+Licensed under the Oculus VR Rift SDK License Version 3.2 (the "License");
+you may not use the Oculus VR Rift SDK except in compliance with the License,
+which is provided at the time of installation or download, or which
+otherwise accompanies this software in either electronic or hard copy form.
+
+You may obtain a copy of the License at
+
+http://www.oculusvr.com/licenses/LICENSE-3.2
+
+Unless required by applicable law or agreed to in writing, the Oculus VR SDK
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+************************************************************************************/
+
+// Built by the PredictionBench project under Tools in the Samples solution.
+// Usage:
+//
+//   PredictionBench <stream file> [-horizons <ms>,<ms>,...] [-slope <s>] [-alpha <a>] [-beta <b>]
+//
+// The stream file is a pose stream recorded with the PoseStream tool. Each filter is run
+// over the stream as SensorStateReader would run it, predicting the IMU pose of every
+// state at each horizon (by default 10, 20, 30 and 50 ms). The prediction is compared
+// with the recorded pose at that time, interpolated between the two states around it, and
+// the percentiles of the angular and positional errors are printed together with the
+// time each filter takes per prediction. The recorded poses are themselves sensor fusion
+// estimates, so the errors are relative to what the tracker reported later, not to ground
+// truth. -slope sets the dynamic interval slope of all filters; a large slope disables it.
+
+#include "Kernel/OVR_System.h"
+#include "Kernel/OVR_Timer.h"
+#include "Kernel/OVR_Alg.h"
+#include "Tracking/Tracking_PoseStream.h"
+#include "Tracking/Tracking_PredictionFilter.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+using namespace OVR;
+using namespace OVR::Tracking;
+
+// Recorded pose at time, or false if time is outside the recording. searchIndex is the
+// record to start searching from, for times that only increase.
+static bool GetRecordedPose(const Array<PoseStreamRecord>& records, double time, size_t& searchIndex, Posed& pose)
+{
+    const size_t count = records.GetSize();
+    while (searchIndex + 1 < count && records[searchIndex + 1].State.WorldFromImu.TimeInSeconds < time)
+        searchIndex++;
+    if (searchIndex + 1 >= count || records[searchIndex].State.WorldFromImu.TimeInSeconds > time)
+        return false;
+
+    const PoseState<double>& older = records[searchIndex].State.WorldFromImu;
+    const PoseState<double>& newer = records[searchIndex + 1].State.WorldFromImu;
+    const double span = newer.TimeInSeconds - older.TimeInSeconds;
+    const double f    = (span > 0.0) ? (time - older.TimeInSeconds) / span : 1.0;
+
+    // Nlerp weights 'this' by f and the argument by (1 - f)
+    Quatd rotation   = newer.ThePose.Rotation;
+    pose.Rotation    = rotation.Nlerp(older.ThePose.Rotation, f);
+    pose.Translation = older.ThePose.Translation.Lerp(newer.ThePose.Translation, f);
+    return true;
+}
+
+static double Percentile(const Array<double>& sorted, double p)
+{
+    if (sorted.GetSize() == 0)
+        return 0.0;
+    size_t index = (size_t)(p * sorted.GetSize());
+    return sorted[Alg::Min(index, sorted.GetSize() - 1)];
+}
+
+static void MeasureFilter(PredictionFilter& filter, const Array<PoseStreamRecord>& records, double horizon)
+{
+    const size_t  count = records.GetSize();
+    Array<double> angularErrors, positionErrors;
+    size_t        searchIndex = 0;
+
+    filter.Reset();
+    for (size_t i = 0; i < count; i++)
+    {
+        const PoseState<double>& sample = records[i].State.WorldFromImu;
+        filter.Observe(sample);
+
+        Posed actual;
+        if (!GetRecordedPose(records, sample.TimeInSeconds + horizon, searchIndex, actual))
+            continue;
+
+        Posed predicted = filter.Predict(sample, horizon);
+        angularErrors.PushBack(predicted.Rotation.Angle(actual.Rotation) * MATH_DOUBLE_RADTODEGREEFACTOR);
+        positionErrors.PushBack((predicted.Translation - actual.Translation).Length() * 1000.0);
+    }
+
+    // Time the filter alone, over enough passes for the timer
+    int    passes      = 0;
+    double predictions = 0.0;
+    double checksum    = 0.0;
+    double startTime   = Timer::GetSeconds();
+    double elapsed     = 0.0;
+    do
+    {
+        filter.Reset();
+        for (size_t i = 0; i < count; i++)
+        {
+            const PoseState<double>& sample = records[i].State.WorldFromImu;
+            filter.Observe(sample);
+            checksum += filter.Predict(sample, horizon).Translation.x;
+        }
+        predictions += (double)count;
+        elapsed      = Timer::GetSeconds() - startTime;
+    } while (++passes < 3 || elapsed < 0.2);
+
+    Alg::QuickSort(angularErrors);
+    Alg::QuickSort(positionErrors);
+
+    printf("%-20s %5.0f %8.3f %8.3f %8.3f %8.3f %8.2f %8.2f %8.2f %8.2f %8.1f%s\n", filter.GetName(), horizon * 1000.0,
+           Percentile(angularErrors, 0.5), Percentile(angularErrors, 0.9), Percentile(angularErrors, 0.99),
+           Percentile(angularErrors, 1.0), Percentile(positionErrors, 0.5), Percentile(positionErrors, 0.9),
+           Percentile(positionErrors, 0.99), Percentile(positionErrors, 1.0), elapsed * 1e9 / predictions,
+           (checksum != checksum) ? " (NaN)" : "");
+}
+
+static int Usage(const char* program)
+{
+    fprintf(stderr, "Usage: %s <stream file> [-horizons <ms>,<ms>,...] [-slope <s>] [-alpha <a>] [-beta <b>]\n",
+            program);
+    return 1;
+}
+
+static int RunBenchmark(int argc, char** argv)
+{
+    if (argc < 2)
+        return Usage(argv[0]);
+
+    Array<double> horizons;
+    double        slope = 0.2, alpha = 0.5, beta = 0.05;
+
+    for (int i = 2; i < argc; i++)
+    {
+        if (i + 1 >= argc)
+            return Usage(argv[0]);
+
+        if (strcmp(argv[i], "-horizons") == 0)
+        {
+            for (const char* p = argv[++i]; *p; )
+            {
+                char* end;
+                horizons.PushBack(strtod(p, &end) / 1000.0);
+                if (end == p || (*end != ',' && *end != 0))
+                    return Usage(argv[0]);
+                p = (*end == ',') ? end + 1 : end;
+            }
+        }
+        else if (strcmp(argv[i], "-slope") == 0)
+            slope = atof(argv[++i]);
+        else if (strcmp(argv[i], "-alpha") == 0)
+            alpha = atof(argv[++i]);
+        else if (strcmp(argv[i], "-beta") == 0)
+            beta = atof(argv[++i]);
+        else
+            return Usage(argv[0]);
+    }
+
+    if (horizons.GetSize() == 0)
+    {
+        static const double defaultHorizons[] = { 0.010, 0.020, 0.030, 0.050 };
+        horizons.Append(defaultHorizons, sizeof(defaultHorizons) / sizeof(defaultHorizons[0]));
+    }
+
+    PoseStreamPlayer stream;
+    if (!stream.Load(argv[1]))
+    {
+        fprintf(stderr, "Unable to read %s\n", argv[1]);
+        return 1;
+    }
+
+    const Array<PoseStreamRecord>& records = stream.GetRecords();
+    if (records.GetSize() < 2)
+    {
+        fprintf(stderr, "%s holds fewer than two states\n", argv[1]);
+        return 1;
+    }
+
+    ConstantVelocityFilter     constantVelocity(slope);
+    ConstantAccelerationFilter constantAcceleration(slope);
+    AlphaBetaFilter            alphaBeta(alpha, beta, slope);
+    PredictionFilter*          filters[] = { &constantVelocity, &constantAcceleration, &alphaBeta };
+
+    printf("%d states over %.3f s\n", (int)records.GetSize(),
+           records[records.GetSize() - 1].State.WorldFromImu.TimeInSeconds - records[0].State.WorldFromImu.TimeInSeconds);
+    printf("%-20s %5s %8s %8s %8s %8s %8s %8s %8s %8s %8s\n", "Filter", "ms", "deg p50", "deg p90", "deg p99",
+           "deg max", "mm p50", "mm p90", "mm p99", "mm max", "ns");
+
+    for (size_t h = 0; h < horizons.GetSize(); h++)
+    {
+        for (size_t f = 0; f < sizeof(filters) / sizeof(filters[0]); f++)
+            MeasureFilter(*filters[f], records, horizons[h]);
+    }
+    return 0;
+}
+
+int main(int argc, char** argv)
+{
+    System::Init();
+    int result = RunBenchmark(argc, argv);
+    System::Destroy();
+    return result;
+}
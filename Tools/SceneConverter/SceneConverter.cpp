@@ -0,0 +1,162 @@
+/************************************************************************************
+
+Filename    :   SceneConverter.cpp
+Content     :   Converts XML scenes to binary scenes for Render::LoadScene
+Created     :   October 17, 2014
+
+Copyright   :   Copyright 2014 Oculus VR, LLC All Rights reserved.
+
+Licensed under the Oculus VR Rift SDK License Version 3.2 (the "License");
+you may not use the Oculus VR Rift SDK except in compliance with the License,
+which is provided at the time of installation or download, or which
+otherwise accompanies this software in either electronic or hard copy form.
+
+You may obtain a copy of the License at
+
+http://www.oculusvr.com/licenses/LICENSE-3.2
+
+Unless required by applicable law or agreed to in writing, the Oculus VR SDK
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+************************************************************************************/
+
+// Built by the SceneConverter project under Tools in the Samples solution.
+// Usage:
+//
+//   SceneConverter scene.xml [scene.scene]
+//
+// The scene is loaded with XmlHandler on a null RenderDevice and written next to the
+// XML file, where LoadScene looks for it, unless another output file is given. The
+// written file is then loaded back and compared with the XML scene, and the time of
+// both loads is printed. Convert the scene again after each change to the XML file;
+// until then LoadScene uses the XML file.
+
+#include "Kernel/OVR_System.h"
+#include "Kernel/OVR_Timer.h"
+
+#include "../../Samples/CommonSrc/Render/Render_Null_Device.h"
+#include "../../Samples/CommonSrc/Render/Render_BinarySceneLoader.h"
+
+#include <stdio.h>
+#include <string.h>
+
+using namespace OVR;
+using namespace OVR::Render;
+
+static bool SameCollisions(const Array<Ptr<CollisionModel> >& a, const Array<Ptr<CollisionModel> >& b)
+{
+    if (a.GetSize() != b.GetSize())
+        return false;
+
+    for (size_t i = 0; i < a.GetSize(); i++)
+    {
+        if (a[i]->Planes.GetSize() != b[i]->Planes.GetSize() ||
+            (a[i]->Planes.GetSize() &&
+             memcmp(&a[i]->Planes[0], &b[i]->Planes[0], a[i]->Planes.GetSize() * sizeof(Planef)) != 0))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool SameModels(const Scene& a, const Scene& b)
+{
+    if (a.Models.GetSize() != b.Models.GetSize())
+        return false;
+
+    for (size_t i = 0; i < a.Models.GetSize(); i++)
+    {
+        const Model* ma = a.Models[i];
+        const Model* mb = b.Models[i];
+        if (ma->Visible != mb->Visible || ma->IsCollisionModel != mb->IsCollisionModel ||
+            ma->Vertices.GetSize() != mb->Vertices.GetSize() || ma->Indices.GetSize() != mb->Indices.GetSize() ||
+            (ma->Vertices.GetSize() &&
+             memcmp(&ma->Vertices[0], &mb->Vertices[0], ma->Vertices.GetSize() * sizeof(Vertex)) != 0) ||
+            (ma->Indices.GetSize() &&
+             memcmp(&ma->Indices[0], &mb->Indices[0], ma->Indices.GetSize() * sizeof(uint16_t)) != 0))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Kept apart from main so that the scenes are released before System::Destroy.
+static int ConvertScene(int argc, char** argv)
+{
+    if (argc != 2 && argc != 3)
+    {
+        fprintf(stderr, "Usage: %s scene.xml [scene.scene]\n", argv[0]);
+        return 1;
+    }
+
+    const char* xmlFile    = argv[1];
+    String      binaryFile = (argc == 3) ? String(argv[2]) : BinarySceneHandler::GetBinaryPath(xmlFile);
+
+    FileStat source;
+    if (!SysFile::GetFileStat(&source, xmlFile))
+    {
+        fprintf(stderr, "Unable to find %s\n", xmlFile);
+        return 1;
+    }
+
+    RendererParams params;
+    Ptr<Null::RenderDevice> ren = *new Null::RenderDevice(params);
+
+    Scene                       xmlScene;
+    Array<Ptr<CollisionModel> > xmlCollisions, xmlGroundCollisions;
+    XmlHandler                  xmlHandler;
+
+    double t0 = Timer::GetSeconds();
+    if (!xmlHandler.ReadFile(xmlFile, ren, &xmlScene, &xmlCollisions, &xmlGroundCollisions))
+    {
+        fprintf(stderr, "Unable to load %s\n", xmlFile);
+        return 1;
+    }
+    double xmlSeconds = Timer::GetSeconds() - t0;
+
+    if (!BinarySceneHandler::WriteFile(binaryFile, xmlHandler, xmlCollisions, xmlGroundCollisions, source))
+    {
+        fprintf(stderr, "Unable to write %s\n", binaryFile.ToCStr());
+        return 1;
+    }
+
+    Scene                       binaryScene;
+    Array<Ptr<CollisionModel> > binaryCollisions, binaryGroundCollisions;
+
+    t0 = Timer::GetSeconds();
+    if (!BinarySceneHandler::ReadFile(binaryFile, ren, &binaryScene, &binaryCollisions, &binaryGroundCollisions, &source))
+    {
+        fprintf(stderr, "Unable to load %s\n", binaryFile.ToCStr());
+        return 1;
+    }
+    double binarySeconds = Timer::GetSeconds() - t0;
+
+    if (!SameModels(xmlScene, binaryScene) ||
+        !SameCollisions(xmlCollisions, binaryCollisions) ||
+        !SameCollisions(xmlGroundCollisions, binaryGroundCollisions))
+    {
+        fprintf(stderr, "%s doesn't match %s\n", binaryFile.ToCStr(), xmlFile);
+        return 1;
+    }
+
+    FileStat binaryStat;
+    SysFile::GetFileStat(&binaryStat, binaryFile);
+    printf("Wrote %s: %d models, %d collision models, %d bytes\n", binaryFile.ToCStr(),
+           (int)binaryScene.Models.GetSize(), (int)(binaryCollisions.GetSize() + binaryGroundCollisions.GetSize()),
+           (int)binaryStat.FileSize);
+    printf("Load time: XML %.1f ms, binary %.1f ms\n", xmlSeconds * 1000.0, binarySeconds * 1000.0);
+    return 0;
+}
+
+int main(int argc, char** argv)
+{
+    System::Init();
+    int result = ConvertScene(argc, argv);
+    System::Destroy();
+    return result;
+}
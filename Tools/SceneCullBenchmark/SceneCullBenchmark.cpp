@@ -0,0 +1,261 @@
+/************************************************************************************
+
+Filename    :   SceneCullBenchmark.cpp
+Content     :   Measures scene traversal with and without frustum culling on a null renderer
+Created     :   October 17, 2014
+
+Copyright   :   Copyright 2014 Oculus VR, LLC All Rights reserved.
+
+Licensed under the Oculus VR Rift SDK License Version 3.2 (the "License");
+you may not use the Oculus VR Rift SDK except in compliance with the License,
+which is provided at the time of installation or download, or which
+otherwise accompanies this software in either electronic or hard copy form.
+
+You may obtain a copy of the License at
+
+http://www.oculusvr.com/licenses/LICENSE-3.2
+
+Unless required by applicable law or agreed to in writing, the Oculus VR SDK
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+************************************************************************************/
+
+// Built by the SceneCullBenchmark project under Tools in the Samples solution.
+// Usage:
+//
+//   SceneCullBenchmark [scene.xml | -grid <size>]
+//
+// Without a file, a city of size x size blocks of boxes is generated. The viewer turns
+// around in one degree steps, and each frame is rendered for both eyes to a null
+// RenderDevice three ways: the whole scene, culled per eye, and culled once with the
+// frustum around both eyes. The per-eye results are checked against testing every model.
+
+#include "Kernel/OVR_System.h"
+#include "Kernel/OVR_Timer.h"
+#include "Kernel/OVR_Alg.h"
+
+#include "../../Samples/CommonSrc/Render/Render_Null_Device.h"
+#include "../../Samples/CommonSrc/Render/Render_XmlSceneLoader.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+using namespace OVR;
+using namespace OVR::Render;
+
+static const int   FrameCount = 360;
+static const int   Repeats    = 5;
+static const float EyeHeight  = 1.7f;
+static const float Ipd        = 0.064f;
+static const float ZNear      = 0.01f;
+static const float ZFar       = 10000.0f;
+
+// Blocks of four boxes 10 meters apart, with a ground plane under them.
+static void GenerateCity(Scene* scene, int size)
+{
+    float half = size * 5.0f;
+
+    Ptr<Model> ground = *Model::CreateBox(Color(96, 96, 96), Vector3f(0, -0.05f, 0), Vector3f(size * 10.0f, 0.1f, size * 10.0f));
+    scene->World.Add(ground);
+    scene->Models.PushBack(ground);
+
+    for (int x = 0; x < size; x++)
+    {
+        for (int z = 0; z < size; z++)
+        {
+            for (int i = 0; i < 4; i++)
+            {
+                float height = 3.0f + (float)((x * 7 + z * 13 + i * 5) % 17);
+                Vector3f origin(x * 10.0f - half + 2.5f + (i & 1) * 4.0f, height * 0.5f,
+                                z * 10.0f - half + 2.5f + (i >> 1) * 4.0f);
+
+                Ptr<Model> box = *Model::CreateBox(Color(200, 180, 160), origin, Vector3f(3.0f, height, 3.0f));
+                scene->World.Add(box);
+                scene->Models.PushBack(box);
+            }
+        }
+    }
+}
+
+struct ViewerFrame
+{
+    Matrix4f CenterView;
+    Matrix4f EyeView[2];
+};
+
+static void GetViewerFrame(int frame, ViewerFrame* out)
+{
+    Quatf    rotation(Vector3f(0, 1, 0), DegreeToRad((float)frame));
+    Vector3f forward = rotation.Rotate(Vector3f(0, 0, -1));
+    Vector3f right   = rotation.Rotate(Vector3f(1, 0, 0));
+    Vector3f up(0, 1, 0);
+    Vector3f center(0, EyeHeight, 0);
+
+    out->CenterView = Matrix4f::LookAtRH(center, center + forward, up);
+    for (int eye = 0; eye < 2; eye++)
+    {
+        Vector3f pos = center + right * (eye == 0 ? -0.5f * Ipd : 0.5f * Ipd);
+        out->EyeView[eye] = Matrix4f::LookAtRH(pos, pos + forward, up);
+    }
+}
+
+// Indices of the world models that touch frustum, found by testing each one.
+static void FindVisibleModels(Scene* scene, const Frustum& worldFrustum, ArrayPOD<uint32_t>& visible)
+{
+    visible.Clear();
+    for (uint32_t i = 0; i < (uint32_t)scene->BVH.GetLeafCount(); i++)
+    {
+        const SceneBVH::Leaf& leaf = scene->BVH.GetLeaf(i);
+        if (leaf.Unbounded || worldFrustum.TestBounds(leaf.Bounds) != Frustum::Test_Outside)
+            visible.PushBack(i);
+    }
+}
+
+// Kept apart from main so that the scene is released before System::Destroy.
+static int RunBenchmark(int argc, char** argv)
+{
+    int         gridSize  = 40;
+    const char* sceneFile = 0;
+
+    if (argc == 3 && strcmp(argv[1], "-grid") == 0)
+        gridSize = atoi(argv[2]);
+    else if (argc == 2)
+        sceneFile = argv[1];
+    else if (argc != 1)
+    {
+        fprintf(stderr, "Usage: %s [scene.xml | -grid <size>]\n", argv[0]);
+        return 1;
+    }
+
+    RendererParams params;
+    params.Resolution = Sizei(1920, 1080);
+    Ptr<Null::RenderDevice> ren = *new Null::RenderDevice(params);
+
+    Scene scene;
+    if (sceneFile)
+    {
+        XmlHandler                  xmlHandler;
+        Array<Ptr<CollisionModel> > collisions, groundCollisions;
+        if (!xmlHandler.ReadFile(sceneFile, ren, &scene, &collisions, &groundCollisions))
+        {
+            fprintf(stderr, "Unable to load %s\n", sceneFile);
+            return 1;
+        }
+    }
+    else
+    {
+        GenerateCity(&scene, gridSize);
+    }
+
+    double t0 = Timer::GetSeconds();
+    scene.BuildBVH();
+    double buildSeconds = Timer::GetSeconds() - t0;
+
+    // DK2-like eye fields of view; the inner side is narrower.
+    FovPort eyeFov[2] = { FovPort(1.33f, 1.33f, 1.06f, 1.09f), FovPort(1.33f, 1.33f, 1.09f, 1.06f) };
+    Frustum eyeFrustum[2] = { Frustum(eyeFov[0], ZNear, ZFar), Frustum(eyeFov[1], ZNear, ZFar) };
+    Frustum stereoFrustum;
+    stereoFrustum.SetFromStereoFov(eyeFov[0], eyeFov[1], Ipd, ZNear, ZFar);
+
+    // Check the culled sets first: per eye they must match testing every model, and the
+    // stereo set must hold both eye sets.
+    int                errors = 0;
+    ArrayPOD<uint32_t> expected, stereo;
+    for (int frame = 0; frame < FrameCount; frame++)
+    {
+        ViewerFrame v;
+        GetViewerFrame(frame, &v);
+
+        scene.Cull(v.CenterView, stereoFrustum);
+        stereo = scene.VisibleLeaves;
+
+        for (int eye = 0; eye < 2; eye++)
+        {
+            scene.Cull(v.EyeView[eye], eyeFrustum[eye]);
+            FindVisibleModels(&scene, eyeFrustum[eye].Transformed(v.EyeView[eye]), expected);
+
+            bool same = (expected.GetSize() == scene.VisibleLeaves.GetSize());
+            for (size_t i = 0; same && i < expected.GetSize(); i++)
+                same = (expected[i] == scene.VisibleLeaves[i]);
+
+            size_t s = 0;
+            for (size_t i = 0; i < expected.GetSize(); i++)
+            {
+                while (s < stereo.GetSize() && stereo[s] < expected[i])
+                    s++;
+                if (s == stereo.GetSize() || stereo[s] != expected[i])
+                    same = false;
+            }
+
+            if (!same && errors++ < 10)
+                fprintf(stderr, "Frame %d eye %d: culled models differ\n", frame, eye);
+        }
+    }
+
+    // Best of several runs of each way of rendering the frames.
+    const char* names[3] = { "Full", "Per eye", "Stereo" };
+    double      best[3]  = { 1e9, 1e9, 1e9 };
+    CullStats   stats[3];
+    int         draws[3] = { 0, 0, 0 };
+
+    for (int r = 0; r < Repeats; r++)
+    {
+        for (int mode = 0; mode < 3; mode++)
+        {
+            scene.Stats.Reset();
+            ren->ResetCounters();
+
+            t0 = Timer::GetSeconds();
+            for (int frame = 0; frame < FrameCount; frame++)
+            {
+                ViewerFrame v;
+                GetViewerFrame(frame, &v);
+
+                if (mode == 2)
+                    scene.Cull(v.CenterView, stereoFrustum);
+
+                for (int eye = 0; eye < 2; eye++)
+                {
+                    if (mode == 0)
+                        scene.Render(ren, v.EyeView[eye]);
+                    else if (mode == 1)
+                        scene.Render(ren, v.EyeView[eye], eyeFrustum[eye]);
+                    else
+                        scene.RenderVisible(ren, v.EyeView[eye]);
+                }
+            }
+            double seconds = Timer::GetSeconds() - t0;
+
+            best[mode]  = Alg::Min(best[mode], seconds);
+            stats[mode] = scene.Stats;
+            draws[mode] = ren->DrawCount;
+        }
+    }
+
+    printf("%d models, %d frames of two eyes, BVH built in %.3f ms\n\n",
+           (int)scene.BVH.GetLeafCount(), FrameCount, buildSeconds * 1000.0);
+    printf("%-8s %12s %12s %12s %12s\n", "Mode", "ms/frame", "Draws/frame", "Culled/frame", "Tests/frame");
+    for (int mode = 0; mode < 3; mode++)
+    {
+        printf("%-8s %12.4f %12.1f %12.1f %12.1f\n", names[mode], best[mode] * 1000.0 / FrameCount,
+               (double)draws[mode] / FrameCount, (double)stats[mode].Culled / FrameCount,
+               (double)stats[mode].BoundsTested / FrameCount);
+    }
+
+    if (errors)
+        fprintf(stderr, "\n%d culling mismatches\n", errors);
+
+    return errors ? 1 : 0;
+}
+
+int main(int argc, char** argv)
+{
+    System::Init();
+    int result = RunBenchmark(argc, argv);
+    System::Destroy();
+    return result;
+}